@@ -151,6 +151,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_timer *aux_timer;
 	indigo_timer *focuser_timer;
 	indigo_property *outlet_names_property;
@@ -179,10 +180,11 @@ typedef struct {
 
 static bool upb_command(indigo_device *device, char *command, char *response, int max) {
 	tcflush(PRIVATE_DATA->handle, TCIOFLUSH);
+	indigo_reader_discard(&PRIVATE_DATA->reader);
 	indigo_write(PRIVATE_DATA->handle, command, strlen(command));
 	indigo_write(PRIVATE_DATA->handle, "\n", 1);
 	if (response != NULL) {
-		if (indigo_read_line(PRIVATE_DATA->handle, response, max) == -1) {
+		if (indigo_reader_read_line(&PRIVATE_DATA->reader, response, max) == -1) {
 			INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Command %s -> no response", command);
 			return false;
 		}
@@ -196,6 +198,7 @@ static void upb_open(indigo_device *device) {
 	PRIVATE_DATA->handle = indigo_open_serial(DEVICE_PORT_ITEM->text.value);
 	if (PRIVATE_DATA->handle > 0) {
 		int attempt = 0;
+		indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle);
 		while (true) {
 			if (upb_command(device, "P#", response, sizeof(response))) {
 				if (!strcmp(response, "UPB_OK")) {
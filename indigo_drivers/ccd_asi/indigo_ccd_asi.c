@@ -26,7 +26,7 @@
  \file indigo_ccd_asi.c
  */
 
-#define DRIVER_VERSION 0x002A
+#define DRIVER_VERSION 0x002B
 #define DRIVER_NAME "indigo_ccd_asi"
 
 #include <stdlib.h>
@@ -588,11 +588,18 @@ static void streaming_timer_callback(indigo_device *device) {
 					indigo_usleep(ONE_SECOND_DELAY);
 					indigo_update_property(device, CCD_STREAMING_PROPERTY, NULL);
 				}
+				long frame_size = FITS_HEADER_SIZE + (long)(PRIVATE_DATA->exp_frame_width / PRIVATE_DATA->exp_bin_x) * (PRIVATE_DATA->exp_frame_height / PRIVATE_DATA->exp_bin_y) * (PRIVATE_DATA->exp_bpp / 8);
+				/* count limited stream waits for a free pipeline buffer, so that every requested frame is delivered */
+				unsigned char *frame = indigo_ccd_acquire_frame_buffer(device, frame_size, CCD_STREAMING_COUNT_ITEM->number.value > 0);
+				/* if all pipeline buffers are busy, frame of endless stream is still read out to keep the stream going, but it is dropped */
+				unsigned char *target = frame ? frame : PRIVATE_DATA->buffer;
 				pthread_mutex_lock(&PRIVATE_DATA->usb_mutex);
-				res = ASIGetVideoData(id, PRIVATE_DATA->buffer + FITS_HEADER_SIZE, PRIVATE_DATA->buffer_size - FITS_HEADER_SIZE, timeout);
+				res = ASIGetVideoData(id, target + FITS_HEADER_SIZE, frame_size - FITS_HEADER_SIZE, timeout);
 				pthread_mutex_unlock(&PRIVATE_DATA->usb_mutex);
 				if (res) {
 					INDIGO_DRIVER_ERROR(DRIVER_NAME, "ASIGetVideoData((%d) = %d", id, res);
+					if (frame)
+						indigo_ccd_release_frame_buffer(device, frame);
 					break;
 				}
 				INDIGO_DRIVER_DEBUG(DRIVER_NAME, "ASIGetVideoData((%d) = %d", id, res);
@@ -600,14 +607,16 @@ static void streaming_timer_callback(indigo_device *device) {
 				CCD_STREAMING_EXPOSURE_ITEM->number.value = 0;
 				indigo_update_property(device, CCD_STREAMING_PROPERTY, NULL);
 
-				if ((color_string) &&   /* if colour (bayer) image but not RGB */
+				if (frame == NULL) {
+					INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Frame dropped, image pipeline is full");
+				} else if ((color_string) &&   /* if colour (bayer) image but not RGB */
 				    (PRIVATE_DATA->exp_bpp != 24) &&
 				    (PRIVATE_DATA->exp_bpp != 48)) {
-					indigo_process_image(device, PRIVATE_DATA->buffer, (int)(PRIVATE_DATA->exp_frame_width / PRIVATE_DATA->exp_bin_x), (int)(PRIVATE_DATA->exp_frame_height / PRIVATE_DATA->exp_bin_y), PRIVATE_DATA->exp_bpp, true, false, keywords, true);
+					indigo_ccd_submit_frame(device, frame, (int)(PRIVATE_DATA->exp_frame_width / PRIVATE_DATA->exp_bin_x), (int)(PRIVATE_DATA->exp_frame_height / PRIVATE_DATA->exp_bin_y), PRIVATE_DATA->exp_bpp, true, false, keywords, true);
 				} else {
-					indigo_process_image(device, PRIVATE_DATA->buffer, (int)(PRIVATE_DATA->exp_frame_width / PRIVATE_DATA->exp_bin_x), (int)(PRIVATE_DATA->exp_frame_height / PRIVATE_DATA->exp_bin_y), PRIVATE_DATA->exp_bpp, true, false, NULL, true);
+					indigo_ccd_submit_frame(device, frame, (int)(PRIVATE_DATA->exp_frame_width / PRIVATE_DATA->exp_bin_x), (int)(PRIVATE_DATA->exp_frame_height / PRIVATE_DATA->exp_bin_y), PRIVATE_DATA->exp_bpp, true, false, NULL, true);
 				}
-				if (CCD_STREAMING_COUNT_ITEM->number.value > 0) {
+				if (frame && CCD_STREAMING_COUNT_ITEM->number.value > 0) {
 					CCD_STREAMING_COUNT_ITEM->number.value -= 1;
 				}
 				if (CCD_ABORT_EXPOSURE_PROPERTY->state == INDIGO_BUSY_STATE) {
@@ -719,6 +728,8 @@ static indigo_result ccd_attach(indigo_device *device) {
 	assert(PRIVATE_DATA != NULL);
 	if (indigo_ccd_attach(device, DRIVER_NAME, DRIVER_VERSION) == INDIGO_OK) {
 		pthread_mutex_init(&PRIVATE_DATA->usb_mutex, NULL);
+		/* streamed frames are processed asynchronously, so the next one can be read out meanwhile */
+		indigo_ccd_enable_pipeline(device, 3);
 		// -------------------------------------------------------------------------------- PIXEL_FORMAT_PROPERTY
 		PIXEL_FORMAT_PROPERTY = indigo_init_switch_property(NULL, device->name, "PIXEL_FORMAT", CCD_ADVANCED_GROUP, "Pixel Format", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, ASI_MAX_FORMATS);
 		if (PIXEL_FORMAT_PROPERTY == NULL)
@@ -0,0 +1,130 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO binary wire protocol
+ \file indigo_binary.h
+
+ Stream of frames, each frame starts with 8 byte header (marker, type, 2 reserved bytes, 32-bit payload length), all integers and IEEE doubles are little endian,
+ strings are prefixed with 16-bit length, long text values with 32-bit length. Session is opened by client with HELLO frame, so the first byte of the stream
+ is INDIGO_BINARY_MARKER, peer announcing different major protocol version is disconnected. Server assigns 32-bit id to property in DEFINE frame (ids are dense, starting with 1) and refers to it (and to items by index) in UPDATE and DELETE frames.
+ Raw BLOB payloads follow UPDATE and NEW frames in item order, they are not included in frame length and they are limited to 1GB.
+ */
+
+#ifndef indigo_binary_h
+#define indigo_binary_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <indigo/indigo_bus.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** First byte of each frame.
+ */
+#define INDIGO_BINARY_MARKER	0xB1
+
+/** Size of frame header.
+ */
+#define INDIGO_BINARY_HEADER_SIZE	8
+
+/** Frame types.
+ */
+typedef enum {
+	INDIGO_BINARY_HELLO = 1,					///< both directions: version (u16), client or server name
+	INDIGO_BINARY_GET_PROPERTIES = 2,	///< client to server: device, property name
+	INDIGO_BINARY_ENABLE_BLOB = 3,		///< client to server: device, property name, mode (u8)
+	INDIGO_BINARY_NEW = 4,						///< client to server: device, property name, type (u8), token (u64), items
+	INDIGO_BINARY_DEFINE = 5,					///< server to client: id (u32), type, perm, state, rule (u8), device, name, group, label, hints, message, items
+	INDIGO_BINARY_UPDATE = 6,					///< server to client: id (u32), state (u8), message, item indices and values
+	INDIGO_BINARY_DELETE = 7,					///< server to client: id (u32, 0 for all properties of device), device, message
+	INDIGO_BINARY_MESSAGE = 8					///< server to client: device, message
+} indigo_binary_frame_type;
+
+/** BLOB item value kinds.
+ */
+typedef enum {
+	INDIGO_BINARY_BLOB_NONE = 0,			///< no value
+	INDIGO_BINARY_BLOB_PATH = 1,			///< path on the server (prefixed with server URL by client)
+	INDIGO_BINARY_BLOB_URL = 2,				///< absolute URL
+	INDIGO_BINARY_BLOB_DATA = 3				///< format and size (u64), raw payload follows the frame
+} indigo_binary_blob_kind;
+
+/** Frame builder.
+ */
+typedef struct {
+	unsigned char *data;							///< header and payload
+	long length;											///< used bytes
+	long size;												///< allocated bytes
+} indigo_binary_frame;
+
+/** Start new frame of given type (allocates data on first use, reuses it afterwards).
+ */
+extern void indigo_binary_frame_begin(indigo_binary_frame *frame, indigo_binary_frame_type type);
+
+/** Append unsigned 8-bit value.
+ */
+extern void indigo_binary_put_u8(indigo_binary_frame *frame, uint8_t value);
+
+/** Append unsigned 16-bit value.
+ */
+extern void indigo_binary_put_u16(indigo_binary_frame *frame, uint16_t value);
+
+/** Append unsigned 32-bit value.
+ */
+extern void indigo_binary_put_u32(indigo_binary_frame *frame, uint32_t value);
+
+/** Append unsigned 64-bit value.
+ */
+extern void indigo_binary_put_u64(indigo_binary_frame *frame, uint64_t value);
+
+/** Append IEEE double.
+ */
+extern void indigo_binary_put_double(indigo_binary_frame *frame, double value);
+
+/** Append string with 16-bit length (truncated to INDIGO_VALUE_SIZE).
+ */
+extern void indigo_binary_put_string(indigo_binary_frame *frame, const char *value);
+
+/** Append text with 32-bit length.
+ */
+extern void indigo_binary_put_text(indigo_binary_frame *frame, const char *value);
+
+/** Store payload length to the header, frame data are ready to be sent.
+ */
+extern void indigo_binary_frame_end(indigo_binary_frame *frame);
+
+/** Release frame data.
+ */
+extern void indigo_binary_frame_release(indigo_binary_frame *frame);
+
+/** Binary wire protocol parser.
+ */
+extern void indigo_binary_parse(indigo_device *device, indigo_client *client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* indigo_binary_h */
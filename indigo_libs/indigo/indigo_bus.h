@@ -210,6 +210,15 @@ typedef enum {
 	INDIGO_LOG_TRACE
 } indigo_log_levels;
 
+/** Reference counted immutable BLOB buffer shared by device, BLOB cache and protocol adapters without copying.
+ */
+typedef struct indigo_blob_buffer {
+	void *data;													///< content
+	long size;													///< content size
+	int reference_count;								///< number of owners, buffer is freed when the last one releases it
+	void *allocated;										///< separately allocated content or NULL
+} indigo_blob_buffer;
+
 /** Property item definition.
  */
 typedef struct {/* there is no .name =  because of g++ C99 bug affecting string initialier */
@@ -251,6 +260,7 @@ typedef struct {/* there is no .name =  because of g++ C99 bug affecting string
 			char url[INDIGO_VALUE_SIZE];		///< item URL on source server
 			long size;                      ///< item size (for blob properties) in bytes
 			void *value;                    ///< item value (for blob properties)
+			struct indigo_blob_buffer *buffer;	///< shared buffer holding value or NULL (retained by indigo_copy_property, released by indigo_release_property)
 		} blob;
 	};
 } indigo_item;
@@ -362,6 +372,7 @@ typedef struct {
 	int output;													///< output handle
 	bool web_socket;										///< connection over WebSocket (RFC6455)
 	char url_prefix[INDIGO_NAME_SIZE];	///< server url prefix (for BLOB download)
+	struct indigo_queue *queue;					///< outbound queue (device side adapters only)
 } indigo_adapter_context;
 
 /** BLOB entry type.
@@ -373,6 +384,7 @@ typedef struct {
 	long size;              						///< BLOB size
 	char format[INDIGO_NAME_SIZE];  		///< BLOB format, known file type suffix like ".fits" or ".jpeg"
 	pthread_mutex_t mutext;							///< BLOB mutex
+	indigo_blob_buffer *buffer;					///< shared buffer holding content (retain it under mutex to use content after unlock)
 } indigo_blob_entry;
 
 /** Last diagnostic messages.
@@ -438,6 +450,7 @@ extern indigo_log_levels indigo_get_log_level(void);
 
 /** Attach device to bus.
  Return value of attach() callback function is assigned to last_result in device structure.
+ Device name is used as a routing key and must not be changed while the device is attached.
  */
 extern indigo_result indigo_attach_device(indigo_device *device);
 
@@ -510,7 +523,7 @@ extern indigo_property *indigo_init_blob_property(indigo_property *property, con
 /** Resize property.
  */
 extern indigo_property *indigo_resize_property(indigo_property *property, int count);
-/** Copy "property" to "copy". Allocate, if copy is NULL.
+/** Copy "property" to "copy". Allocate, if copy is NULL. Shared BLOB buffers are retained by the copy.
  */
 extern indigo_property *indigo_copy_property(indigo_property *copy, indigo_property *property);
 /** Clear property.
@@ -519,6 +532,24 @@ extern indigo_property *indigo_clear_property(indigo_property *property);
 /** Allocate blob buffer (rounded up to 2880 bytes).
  */
 extern void *indigo_alloc_blob_buffer(long size);
+/** Create shared BLOB buffer with reference count 1.
+ */
+extern indigo_blob_buffer *indigo_create_blob_buffer(long size);
+/** Create shared BLOB buffer with reference count 1 taking ownership of malloc-ed data.
+ */
+extern indigo_blob_buffer *indigo_wrap_blob_buffer(void *data, long size);
+/** Add reference to shared BLOB buffer.
+ */
+extern indigo_blob_buffer *indigo_retain_blob_buffer(indigo_blob_buffer *buffer);
+/** Remove reference from shared BLOB buffer, free it if it was the last one.
+ */
+extern void indigo_release_blob_buffer(indigo_blob_buffer *buffer);
+/** Replace shared buffer of BLOB item (item takes over the reference) and point item value to its content.
+ */
+extern void indigo_set_blob_item_buffer(indigo_item *item, indigo_blob_buffer *buffer);
+/** Get shared buffer of BLOB item if it still holds item value, NULL otherwise.
+ */
+extern indigo_blob_buffer *indigo_get_blob_item_buffer(indigo_item *item);
 /** Resize property.
  */
 extern void indigo_release_property(indigo_property *property);
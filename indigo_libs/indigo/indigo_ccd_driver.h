@@ -29,6 +29,7 @@
 #include <indigo/indigo_bus.h>
 #include <indigo/indigo_driver.h>
 #include <indigo/indigo_fits.h>
+#include <indigo/indigo_file_writer.h>
 
 typedef enum {
 	CCD_JPEG_STRETCH_SLIGHT = 0,
@@ -348,6 +349,42 @@ extern "C" {
  */
 #define CCD_IMAGE_FORMAT_NATIVE_AVI_ITEM  (CCD_IMAGE_FORMAT_PROPERTY->items+4)
 
+/** CCD_FITS_COMPRESSION property pointer, property is mandatory, property change request is fully handled by indigo_ccd_change_property().
+ */
+#define CCD_FITS_COMPRESSION_PROPERTY     (CCD_CONTEXT->ccd_fits_compression_property)
+
+/** CCD_FITS_COMPRESSION.NONE property item pointer.
+ */
+#define CCD_FITS_COMPRESSION_NONE_ITEM    (CCD_FITS_COMPRESSION_PROPERTY->items+0)
+
+/** CCD_FITS_COMPRESSION.RICE property item pointer.
+ */
+#define CCD_FITS_COMPRESSION_RICE_ITEM    (CCD_FITS_COMPRESSION_PROPERTY->items+1)
+
+/** CCD_FITS_COMPRESSION.GZIP property item pointer.
+ */
+#define CCD_FITS_COMPRESSION_GZIP_ITEM    (CCD_FITS_COMPRESSION_PROPERTY->items+2)
+
+/** CCD_XISF_COMPRESSION property pointer, property is mandatory, property change request is fully handled by indigo_ccd_change_property().
+ */
+#define CCD_XISF_COMPRESSION_PROPERTY     (CCD_CONTEXT->ccd_xisf_compression_property)
+
+/** CCD_XISF_COMPRESSION.NONE property item pointer.
+ */
+#define CCD_XISF_COMPRESSION_NONE_ITEM    (CCD_XISF_COMPRESSION_PROPERTY->items+0)
+
+/** CCD_XISF_COMPRESSION.ZLIB property item pointer.
+ */
+#define CCD_XISF_COMPRESSION_ZLIB_ITEM    (CCD_XISF_COMPRESSION_PROPERTY->items+1)
+
+/** CCD_XISF_COMPRESSION.LZ4 property item pointer.
+ */
+#define CCD_XISF_COMPRESSION_LZ4_ITEM     (CCD_XISF_COMPRESSION_PROPERTY->items+2)
+
+/** CCD_XISF_COMPRESSION.LZ4HC property item pointer.
+ */
+#define CCD_XISF_COMPRESSION_LZ4HC_ITEM   (CCD_XISF_COMPRESSION_PROPERTY->items+3)
+
 
 
 /** CCD_IMAGE_FILE property pointer, property is mandatory, read-only property.
@@ -462,6 +499,10 @@ extern "C" {
  */
 #define CCD_JPEG_SETTINGS_CLIPPING_POINT_ITEM     (CCD_JPEG_SETTINGS_PROPERTY->items+2)
 
+/** CCD_JPEG_SETTINGS.MAX_PREVIEW_SIZE property item pointer.
+ */
+#define CCD_JPEG_SETTINGS_MAX_PREVIEW_SIZE_ITEM     (CCD_JPEG_SETTINGS_PROPERTY->items+3)
+
 /** CCD_JPEG_STRETCH_PRESETS property pointer, property is mandatory, read-write property, property change request is fully handled by indigo_ccd_change_property().
  */
 #define CCD_JPEG_STRETCH_PRESETS_PROPERTY         (CCD_CONTEXT->ccd_jpeg_stretch_presets)
@@ -505,6 +546,68 @@ extern "C" {
  */
 #define CCD_RBI_FLUSH_DISABLED_ITEM     (CCD_RBI_FLUSH_ENABLE_PROPERTY->items + 1)
 
+/** CCD_PIPELINE property pointer.
+ */
+#define CCD_PIPELINE_PROPERTY           (CCD_CONTEXT->ccd_pipeline_property)
+
+/** CCD_PIPELINE.BUFFERS property item pointer.
+ */
+#define CCD_PIPELINE_BUFFERS_ITEM       (CCD_PIPELINE_PROPERTY->items + 0)
+
+/** CCD_PIPELINE.QUEUED property item pointer.
+ */
+#define CCD_PIPELINE_QUEUED_ITEM        (CCD_PIPELINE_PROPERTY->items + 1)
+
+/** CCD_PIPELINE.DROPPED property item pointer.
+ */
+#define CCD_PIPELINE_DROPPED_ITEM       (CCD_PIPELINE_PROPERTY->items + 2)
+
+/** Maximal number of frame buffers in asynchronous image pipeline.
+ */
+#define CCD_PIPELINE_MAX_BUFFERS        8
+
+/** CCD_LOCAL_WRITER property pointer, property is mandatory, property change request is fully handled by indigo_ccd_change_property().
+ */
+#define CCD_LOCAL_WRITER_PROPERTY       (CCD_CONTEXT->ccd_local_writer_property)
+
+/** CCD_LOCAL_WRITER.BACKGROUND property item pointer.
+ */
+#define CCD_LOCAL_WRITER_BACKGROUND_ITEM (CCD_LOCAL_WRITER_PROPERTY->items + 0)
+
+/** CCD_LOCAL_WRITER.SYNC property item pointer.
+ */
+#define CCD_LOCAL_WRITER_SYNC_ITEM      (CCD_LOCAL_WRITER_PROPERTY->items + 1)
+
+/** CCD_LOCAL_WRITER.PREALLOCATE property item pointer.
+ */
+#define CCD_LOCAL_WRITER_PREALLOCATE_ITEM (CCD_LOCAL_WRITER_PROPERTY->items + 2)
+
+/** CCD_LOCAL_WRITER.WAIT property item pointer.
+ */
+#define CCD_LOCAL_WRITER_WAIT_ITEM      (CCD_LOCAL_WRITER_PROPERTY->items + 3)
+
+/** CCD_LOCAL_WRITER_QUEUE property pointer, property is mandatory, property change request is fully handled by indigo_ccd_change_property().
+ */
+#define CCD_LOCAL_WRITER_QUEUE_PROPERTY (CCD_CONTEXT->ccd_local_writer_queue_property)
+
+/** CCD_LOCAL_WRITER_QUEUE.SIZE property item pointer.
+ */
+#define CCD_LOCAL_WRITER_QUEUE_SIZE_ITEM (CCD_LOCAL_WRITER_QUEUE_PROPERTY->items + 0)
+
+/** CCD_LOCAL_WRITER_PENDING property pointer, property is mandatory, property is read only.
+ */
+#define CCD_LOCAL_WRITER_PENDING_PROPERTY (CCD_CONTEXT->ccd_local_writer_pending_property)
+
+/** CCD_LOCAL_WRITER_PENDING.FILES property item pointer.
+ */
+#define CCD_LOCAL_WRITER_PENDING_FILES_ITEM (CCD_LOCAL_WRITER_PENDING_PROPERTY->items + 0)
+
+/** CCD_LOCAL_WRITER_PENDING.BYTES property item pointer.
+ */
+#define CCD_LOCAL_WRITER_PENDING_BYTES_ITEM (CCD_LOCAL_WRITER_PENDING_PROPERTY->items + 1)
+
+typedef struct indigo_ccd_pipeline indigo_ccd_pipeline;
+
 
 /** CCD device context structure.
  */
@@ -519,6 +622,12 @@ typedef struct {
 	void *preview_histogram;											///< preview histogram buffer
 	unsigned long preview_histogram_size;					///< preview histogram buffer size
 	void *video_stream;														///< video stream control structure
+	indigo_ccd_pipeline *pipeline;								///< asynchronous image pipeline (if enabled by driver)
+	indigo_file_writer *file_writer;							///< background writer for local save (created on first use)
+	bool file_writer_busy;												///< CCD_IMAGE_FILE is busy until the last queued file is written
+	pthread_mutex_t file_writer_mutex;						///< guards CCD_IMAGE_FILE, CCD_LOCAL_WRITER_PENDING values and file_writer_busy, never held during file IO or property update
+	char *sequence_template;											///< file name template of the last sequence numbered local save
+	int sequence_index;														///< last index used with sequence_template
 	indigo_property *ccd_info_property;           ///< CCD_INFO property pointer
 	indigo_property *ccd_lens_property;						///< CCD_LENS property pointer
 	indigo_property *ccd_upload_mode_property;    ///< CCD_UPLOAD_MODE property pointer
@@ -551,6 +660,12 @@ typedef struct {
 	indigo_property *ccd_jpeg_stretch_presets;				///< CCD_JPEG_STRETCH_PRESETS property pointer
 	indigo_property *ccd_rbi_flush_enable_property; ///< CCD_RBI_FLUSH_ENABLE property pointer
 	indigo_property *ccd_rbi_flush_property;			///< CCD_RBI_FLUSH property pointer
+	indigo_property *ccd_pipeline_property;				///< CCD_PIPELINE property pointer
+	indigo_property *ccd_local_writer_property;		///< CCD_LOCAL_WRITER property pointer
+	indigo_property *ccd_local_writer_queue_property;	///< CCD_LOCAL_WRITER_QUEUE property pointer
+	indigo_property *ccd_local_writer_pending_property;	///< CCD_LOCAL_WRITER_PENDING property pointer
+	indigo_property *ccd_fits_compression_property;	///< CCD_FITS_COMPRESSION property pointer
+	indigo_property *ccd_xisf_compression_property;	///< CCD_XISF_COMPRESSION property pointer
 } indigo_ccd_context;
 
 /** Suspend countdown.
@@ -583,10 +698,35 @@ extern indigo_result indigo_ccd_detach(indigo_device *device);
  */
 extern void indigo_raw_to_jpeg(indigo_device *device, void *data_in, int frame_width, int frame_height, int bpp, const char *bayerpat, void **data_out, unsigned long *size_out, void **histogram_data, unsigned long *histogram_size, double B, double C);
 
+/** Convert RAW data to JPEG binned so that neither dimension exceeds max_size (0 means full resolution), histogram is computed from binned data.
+ */
+extern void indigo_raw_to_scaled_jpeg(indigo_device *device, void *data_in, int frame_width, int frame_height, int bpp, const char *bayerpat, int max_size, void **data_out, unsigned long *size_out, void **histogram_data, unsigned long *histogram_size, double B, double C);
+
 /** Process raw image in image buffer (starting on data + FITS_HEADER_SIZE offset).
  */
 extern void indigo_process_image(indigo_device *device, void *data, int frame_width, int frame_height, int bpp, bool little_endian, bool byte_order_rgb, indigo_fits_keyword *keywords, bool streaming);
 
+/** Enable asynchronous image pipeline with given number of frame buffers, should be called from attach callback after indigo_ccd_attach().
+ Frames acquired from the pipeline are processed by indigo_process_image() in the pipeline thread, so the driver can continue capturing.
+ */
+extern void indigo_ccd_enable_pipeline(indigo_device *device, int buffers);
+
+/** Acquire frame buffer of given size (including FITS_HEADER_SIZE) from the pipeline. If all buffers are in use, either wait for one or return NULL and count dropped frame.
+ */
+extern void *indigo_ccd_acquire_frame_buffer(indigo_device *device, long size, bool wait);
+
+/** Return acquired frame buffer to the pipeline without processing it.
+ */
+extern void indigo_ccd_release_frame_buffer(indigo_device *device, void *data);
+
+/** Hand acquired and filled frame buffer over to the pipeline, arguments have the same meaning as for indigo_process_image().
+ */
+extern void indigo_ccd_submit_frame(indigo_device *device, void *data, int frame_width, int frame_height, int bpp, bool little_endian, bool byte_order_rgb, indigo_fits_keyword *keywords, bool streaming);
+
+/** Wait until all submitted frames are processed.
+ */
+extern void indigo_ccd_flush_pipeline(indigo_device *device);
+
 /** Process DSLR image in image buffer (starting on data).
  */
 extern void indigo_process_dslr_image(indigo_device *device, void *data, int blobsize, const char *suffix, bool streaming);
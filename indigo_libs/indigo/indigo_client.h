@@ -53,6 +53,12 @@ extern bool indigo_use_blob_urls;
 
 extern char *indigo_client_name;
 
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+/** Use binary wire protocol instead of XML for remote INDIGO servers (interned names, IEEE doubles, raw BLOB payloads).
+ */
+extern bool indigo_use_binary_protocol;
+#endif
+
 #if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
 #define INDIGO_MAX_DRIVERS    256
 
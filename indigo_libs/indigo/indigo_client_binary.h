@@ -0,0 +1,45 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO binary wire protocol driver side adapter
+ \file indigo_client_binary.h
+ */
+
+#ifndef indigo_client_binary_h
+#define indigo_client_binary_h
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_binary.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Create initialized instance of binary wire protocol driver side adapter, HELLO frame is sent immediately.
+ */
+extern indigo_device *indigo_binary_client_adapter(char *name, char *url_prefix, int input, int output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* indigo_client_binary_h */
@@ -0,0 +1,85 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO background file writer
+ \file indigo_file_writer.h
+ */
+
+#ifndef indigo_file_writer_h
+#define indigo_file_writer_h
+
+#include <stdbool.h>
+
+#include <indigo/indigo_bus.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Writer statistics.
+ */
+typedef struct {
+	int files;										///< number of queued files (including file being written)
+	long bytes;										///< number of queued bytes (including file being written)
+	long written;									///< number of written files
+	long failed;									///< number of files failed to write
+} indigo_file_writer_stats;
+
+typedef struct indigo_file_writer indigo_file_writer;
+
+/** Called by writer thread when file is written (error is 0) or writing failed (error is errno value, file is already removed).
+ */
+typedef void (*indigo_file_writer_callback)(void *context, const char *file_name, int error);
+
+/** Write data to open file, preallocate space first and flush data to disk after write if requested. Returns false and sets errno on failure.
+ */
+extern bool indigo_write_file(int handle, const void *data, long size, bool sync, bool preallocate);
+
+/** Create writer with its own thread, callback (may be NULL) is called for each file.
+ */
+extern indigo_file_writer *indigo_file_writer_create(indigo_file_writer_callback callback, void *context);
+
+/** Set maximal number of queued bytes and write options applied to files queued later.
+ */
+extern void indigo_file_writer_configure(indigo_file_writer *writer, long max_bytes, bool sync, bool preallocate);
+
+/** Queue content of buffer to be written to open file, writer retains buffer and closes handle.
+ If queue is full and wait is false, nothing is queued and false is returned, otherwise call waits for enough space. Single file larger than queue is accepted if queue is empty.
+ */
+extern bool indigo_file_writer_push(indigo_file_writer *writer, int handle, const char *file_name, indigo_blob_buffer *buffer, bool wait);
+
+/** Wait until all queued files are written.
+ */
+extern void indigo_file_writer_flush(indigo_file_writer *writer);
+
+/** Get copy of writer statistics.
+ */
+extern void indigo_file_writer_get_stats(indigo_file_writer *writer, indigo_file_writer_stats *stats);
+
+/** Write remaining files, stop writer thread and release writer.
+ */
+extern void indigo_file_writer_release(indigo_file_writer *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* indigo_file_writer_h */
@@ -49,6 +49,24 @@ typedef struct {
 
 extern indigo_result indigo_raw_to_fits(char *image, int in_size, char **fits, int *fits_size, indigo_fits_keyword *keywords);
 
+/** Convert raw pixels to FITS data in single pass (RGB is split to planes, 16 bit samples are offset by BZERO 32768 and stored as big endian).
+ Input is interleaved RGB or BGR (as given by byte_order_rgb) with 16 bit samples in little or big endian order. Conversion is done in place for mono frames
+ if input and output are the same buffer, RGB frames require separate output buffer. Rows are processed in parallel.
+ */
+extern void indigo_raw_to_fits_payload(const void *input, void *output, int width, int height, int bytes_per_sample, int components, bool little_endian, bool byte_order_rgb);
+
+/** Tile compression algorithm (FITS tiled image convention).
+ */
+typedef enum {
+	INDIGO_FITS_RICE = 1,			///< RICE_1, lossless
+	INDIGO_FITS_GZIP					///< GZIP_1, lossless
+} indigo_fits_compression;
+
+/** Convert FITS with 8 or 16 bit image (2 or 3 axes) in primary HDU to fpack compatible tile-compressed FITS (empty primary HDU and ZIMAGE binary table extension).
+ Each image row is a tile, tiles are compressed in parallel. Header keywords are copied to compressed HDU. Returns new shared BLOB buffer or NULL if image can't be compressed.
+ */
+extern indigo_blob_buffer *indigo_fits_compress(const void *fits, long size, indigo_fits_compression compression);
+
 #ifdef __cplusplus
 }
 #endif
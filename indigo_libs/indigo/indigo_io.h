@@ -84,10 +84,48 @@ extern int indigo_recv(int handle, char *buffer, long length);
 extern int indigo_close(int handle);
 #endif
 
-/** Read line.
+/** Read line. On sockets only the line itself is consumed, on other handles it is read byte by byte, use indigo_reader if handle is not shared.
  */
 extern int indigo_read_line(int handle, char *buffer, int length);
 
+/** Size of buffered reader buffer.
+ */
+#define INDIGO_READER_BUFFER_SIZE	4096
+
+/** Buffered reader, once handle is read through the reader, all reads must go through it.
+ */
+typedef struct {
+	int handle;										///< file, tty or socket handle
+	int start;										///< index of the first unread byte
+	int end;											///< index behind the last buffered byte
+	long reads;										///< number of read calls issued
+	char buffer[INDIGO_READER_BUFFER_SIZE];
+} indigo_reader;
+
+/** Initialize buffered reader for handle.
+ */
+extern void indigo_init_reader(indigo_reader *reader, int handle);
+
+/** Read line through buffered reader (same semantics as indigo_read_line()).
+ */
+extern int indigo_reader_read_line(indigo_reader *reader, char *buffer, int length);
+
+/** Read exactly length bytes through buffered reader (same semantics as indigo_read()).
+ */
+extern int indigo_reader_read(indigo_reader *reader, char *buffer, long length);
+
+/** Return next byte without consuming it or -1 on error.
+ */
+extern int indigo_reader_peek(indigo_reader *reader);
+
+/** Wait for data available in reader buffer or handle.
+ */
+extern int indigo_reader_select(indigo_reader *reader, long usec);
+
+/** Discard buffered data (e.g. after tcflush()).
+ */
+extern void indigo_reader_discard(indigo_reader *reader);
+
 /** Write buffer.
  */
 extern bool indigo_write(int handle, const char *buffer, long length);
@@ -43,6 +43,22 @@ extern "C" {
 #define ntohll(x) ((1==ntohl(1)) ? (x) : ((uint64_t)ntohl((x) & 0xFFFFFFFF) << 32) | ntohl((x) >> 32))
 #endif
 
+/** JSON wire protocol parser state.
+ */
+typedef struct indigo_json_parser indigo_json_parser;
+
+/** Create incremental JSON parser, parsed requests are sent to the bus on behalf of the client.
+ */
+extern indigo_json_parser *indigo_json_parser_create(indigo_device *device, indigo_client *client);
+
+/** Parse next chunk of JSON stream, data may end or start anywhere in the message. Returns false on syntax error.
+ */
+extern bool indigo_json_parser_parse(indigo_json_parser *parser, const char *data, long length);
+
+/** Release incremental JSON parser.
+ */
+extern void indigo_json_parser_release(indigo_json_parser *parser);
+
 /** JSON wire protocol parser.
  */
 extern void indigo_json_parse(indigo_device *device, indigo_client *client);
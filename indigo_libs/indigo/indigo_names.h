@@ -561,6 +561,43 @@
  */
 #define CCD_IMAGE_FORMAT_NATIVE_AVI_ITEM_NAME  "NATIVE_AVI"
 
+//----------------------------------------------------------------------
+/** CCD_FITS_COMPRESSION property name.
+ */
+#define CCD_FITS_COMPRESSION_PROPERTY_NAME    "CCD_FITS_COMPRESSION"
+
+/** CCD_FITS_COMPRESSION.NONE property item name.
+ */
+#define CCD_FITS_COMPRESSION_NONE_ITEM_NAME   "NONE"
+
+/** CCD_FITS_COMPRESSION.RICE property item name.
+ */
+#define CCD_FITS_COMPRESSION_RICE_ITEM_NAME   "RICE"
+
+/** CCD_FITS_COMPRESSION.GZIP property item name.
+ */
+#define CCD_FITS_COMPRESSION_GZIP_ITEM_NAME   "GZIP"
+
+//----------------------------------------------------------------------
+/** CCD_XISF_COMPRESSION property name.
+ */
+#define CCD_XISF_COMPRESSION_PROPERTY_NAME    "CCD_XISF_COMPRESSION"
+
+/** CCD_XISF_COMPRESSION.NONE property item name.
+ */
+#define CCD_XISF_COMPRESSION_NONE_ITEM_NAME   "NONE"
+
+/** CCD_XISF_COMPRESSION.ZLIB property item name.
+ */
+#define CCD_XISF_COMPRESSION_ZLIB_ITEM_NAME   "ZLIB"
+
+/** CCD_XISF_COMPRESSION.LZ4 property item name.
+ */
+#define CCD_XISF_COMPRESSION_LZ4_ITEM_NAME    "LZ4"
+
+/** CCD_XISF_COMPRESSION.LZ4HC property item name.
+ */
+#define CCD_XISF_COMPRESSION_LZ4HC_ITEM_NAME  "LZ4HC"
 
 //----------------------------------------------------------------------
 /** CCD_IMAGE_FILE property name.
@@ -655,6 +692,10 @@
  */
 #define CCD_JPEG_SETTINGS_CLIPPING_POINT_ITEM_NAME     "CLIPPING_POINT"
 
+/** CCD_JPEG_SETTINGS.MAX_PREVIEW_SIZE property item name.
+ */
+#define CCD_JPEG_SETTINGS_MAX_PREVIEW_SIZE_ITEM_NAME     "MAX_PREVIEW_SIZE"
+
 // obsolete CCD_JPEG_SETTINGS item names kept for backward compatibility
 
 /** (obsolete) CCD_JPEG_SETTINGS.BLACK property item name.
@@ -718,6 +759,66 @@
  */
 #define CCD_RBI_FLUSH_DISABLED_ITEM_NAME     "DISABLED"
 
+//------------------------------------------------------------------------
+/** CCD_PIPELINE property name.
+ */
+#define CCD_PIPELINE_PROPERTY_NAME           "CCD_PIPELINE"
+
+/** CCD_PIPELINE.BUFFERS property item name.
+ */
+#define CCD_PIPELINE_BUFFERS_ITEM_NAME       "BUFFERS"
+
+/** CCD_PIPELINE.QUEUED property item name.
+ */
+#define CCD_PIPELINE_QUEUED_ITEM_NAME        "QUEUED"
+
+/** CCD_PIPELINE.DROPPED property item name.
+ */
+#define CCD_PIPELINE_DROPPED_ITEM_NAME       "DROPPED"
+
+//------------------------------------------------------------------------
+/** CCD_LOCAL_WRITER property name.
+ */
+#define CCD_LOCAL_WRITER_PROPERTY_NAME       "CCD_LOCAL_WRITER"
+
+/** CCD_LOCAL_WRITER.BACKGROUND property item name.
+ */
+#define CCD_LOCAL_WRITER_BACKGROUND_ITEM_NAME "BACKGROUND"
+
+/** CCD_LOCAL_WRITER.SYNC property item name.
+ */
+#define CCD_LOCAL_WRITER_SYNC_ITEM_NAME      "SYNC"
+
+/** CCD_LOCAL_WRITER.PREALLOCATE property item name.
+ */
+#define CCD_LOCAL_WRITER_PREALLOCATE_ITEM_NAME "PREALLOCATE"
+
+/** CCD_LOCAL_WRITER.WAIT property item name.
+ */
+#define CCD_LOCAL_WRITER_WAIT_ITEM_NAME      "WAIT"
+
+//------------------------------------------------------------------------
+/** CCD_LOCAL_WRITER_QUEUE property name.
+ */
+#define CCD_LOCAL_WRITER_QUEUE_PROPERTY_NAME "CCD_LOCAL_WRITER_QUEUE"
+
+/** CCD_LOCAL_WRITER_QUEUE.SIZE property item name.
+ */
+#define CCD_LOCAL_WRITER_QUEUE_SIZE_ITEM_NAME "SIZE"
+
+//------------------------------------------------------------------------
+/** CCD_LOCAL_WRITER_PENDING property name.
+ */
+#define CCD_LOCAL_WRITER_PENDING_PROPERTY_NAME "CCD_LOCAL_WRITER_PENDING"
+
+/** CCD_LOCAL_WRITER_PENDING.FILES property item name.
+ */
+#define CCD_LOCAL_WRITER_PENDING_FILES_ITEM_NAME "FILES"
+
+/** CCD_LOCAL_WRITER_PENDING.BYTES property item name.
+ */
+#define CCD_LOCAL_WRITER_PENDING_BYTES_ITEM_NAME "BYTES"
+
 //----------------------------------------------------------------------
 /** DSLR_PROGRAM property name.
  */
@@ -3032,6 +3133,26 @@ typedef enum {
 #define SERVER_CTRL_PANEL_ITEM_NAME										"CTRL_PANEL"
 #define SERVER_WEB_APPS_ITEM_NAME											"WEB_APPS"
 
+#define SERVER_TIMERS_PROPERTY_NAME										"TIMERS"
+#define SERVER_TIMERS_ALLOCATED_ITEM_NAME							"ALLOCATED"
+#define SERVER_TIMERS_PENDING_ITEM_NAME								"PENDING"
+#define SERVER_TIMERS_READY_ITEM_NAME									"READY"
+#define SERVER_TIMERS_WORKERS_ITEM_NAME								"WORKERS"
+#define SERVER_TIMERS_BUSY_WORKERS_ITEM_NAME					"BUSY_WORKERS"
+#define SERVER_TIMERS_AVG_LATENESS_ITEM_NAME					"AVG_LATENESS"
+#define SERVER_TIMERS_MAX_LATENESS_ITEM_NAME					"MAX_LATENESS"
+#define SERVER_TIMERS_AVG_DURATION_ITEM_NAME					"AVG_DURATION"
+#define SERVER_TIMERS_MAX_DURATION_ITEM_NAME					"MAX_DURATION"
+
+#define SERVER_QUEUES_PROPERTY_NAME										"QUEUES"
+#define SERVER_QUEUES_CLIENTS_ITEM_NAME								"CLIENTS"
+#define SERVER_QUEUES_DEPTH_ITEM_NAME									"DEPTH"
+#define SERVER_QUEUES_BYTES_ITEM_NAME									"BYTES"
+#define SERVER_QUEUES_MAX_DEPTH_ITEM_NAME							"MAX_DEPTH"
+#define SERVER_QUEUES_SENT_ITEM_NAME									"SENT"
+#define SERVER_QUEUES_COALESCED_ITEM_NAME							"COALESCED"
+#define SERVER_QUEUES_DROPPED_ITEM_NAME								"DROPPED"
+
 #define SERVER_WIFI_COUNTRY_CODE_PROPERTY_NAME							"WIFI_COUNTRY_CODE"
 #define SERVER_WIFI_COUNTRY_CODE_ITEM_NAME								"COUNTRY_CODE"
 
@@ -0,0 +1,53 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO shared worker pool for data parallel image processing
+ \file indigo_parallel.h
+ */
+
+#ifndef indigo_parallel_h
+#define indigo_parallel_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of threads used by indigo_parallel_for() including the calling thread, 0 means number of online CPUs.
+ Must be set before the first call of indigo_parallel_for(), the pool is started lazily and never resized.
+ */
+extern int indigo_parallel_threads;
+
+/** Get number of threads used by indigo_parallel_for() (resolved value of indigo_parallel_threads).
+ */
+extern int indigo_parallel_size(void);
+
+/** Split range 0..count-1 into at most indigo_parallel_size() contiguous chunks and call body(data, start, end) for each chunk (end is exclusive).
+ Chunks are executed by the pool workers and by the calling thread, the function returns when all chunks are done.
+ Chunk boundaries depend only on count and pool size. It is safe to call it concurrently and from within body.
+ */
+extern void indigo_parallel_for(int count, void (*body)(void *data, int start, int end), void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* indigo_parallel_h */
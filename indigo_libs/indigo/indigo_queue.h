@@ -0,0 +1,153 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO protocol adapter outbound queue
+ \file indigo_queue.h
+ */
+
+#ifndef indigo_queue_h
+#define indigo_queue_h
+
+#include <stdbool.h>
+
+#include <indigo/indigo_bus.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Overflow policy applied when client queue is full.
+ */
+typedef enum {
+	INDIGO_QUEUE_DROP_STALE = 0,	///< drop older queued update of the same property, disconnect if there is nothing to drop
+	INDIGO_QUEUE_DISCONNECT = 1		///< disconnect client
+} indigo_queue_overflow_policy;
+
+/** Encoding of the queued segment.
+ */
+typedef enum {
+	INDIGO_QUEUE_RAW = 0,					///< write as is
+	INDIGO_QUEUE_BASE64 = 1				///< base64 encode in writer thread
+} indigo_queue_encoding;
+
+/** Queue statistics.
+ */
+typedef struct {
+	int depth;										///< number of queued messages
+	int max_depth;								///< high-water mark of depth
+	long bytes;										///< number of queued bytes
+	long sent;										///< number of sent messages
+	long dropped;									///< number of stale messages dropped on overflow
+	long coalesced;								///< number of updates merged into pending update of the same property
+} indigo_queue_stats;
+
+typedef struct indigo_queue indigo_queue;
+typedef struct indigo_queue_entry indigo_queue_entry;
+
+/** Maximal number of messages queued per client.
+ */
+extern int indigo_queue_size;
+
+/** Maximal number of bytes queued per client.
+ */
+extern long indigo_queue_max_bytes;
+
+/** Queue overflow policy.
+ */
+extern indigo_queue_overflow_policy indigo_queue_policy;
+
+/** Coalesce updates of the same property waiting in the queue, only the latest values are sent.
+ */
+extern bool indigo_queue_coalesce;
+
+/** Default maximal update rate (Hz) of a single property sent to a client, 0 means unlimited.
+ */
+extern double indigo_queue_update_rate;
+
+/** Number of writer threads shared by queues created with indigo_queue_create_shared().
+ */
+extern int indigo_queue_shared_writers;
+
+/** Set maximal update rate (Hz) for properties matching device and property name (NULL, "" or "*" matches any name, trailing "*" matches prefix).
+ If queue is NULL, policy is applied to all clients, otherwise only to the client served by the queue. Rate 0 means unlimited.
+ Rate limited updates are coalesced, state transitions are always delivered and BLOBs are never delayed. Synchronous queues are not rate limited.
+ */
+extern void indigo_queue_set_update_rate(indigo_queue *queue, const char *device, const char *property, double rate);
+
+/** Create queue for adapter context. If asynchronous, messages are written by dedicated writer thread, otherwise directly by the thread calling indigo_queue_push().
+ Write function is called for each (encoded) segment of the message, if it fails, connection is closed.
+ */
+extern indigo_queue *indigo_queue_create(indigo_adapter_context *context, bool (*write)(int handle, const char *buffer, long length), bool asynchronous);
+
+/** Create asynchronous queue for adapter context served by the pool of shared writer threads instead of a dedicated one.
+ Each queue is served by at most one writer at a time, so the order of messages is preserved.
+ */
+extern indigo_queue *indigo_queue_create_shared(indigo_adapter_context *context, bool (*write)(int handle, const char *buffer, long length));
+
+/** Stop writer thread, discard remaining messages and release queue.
+ */
+extern void indigo_queue_release(indigo_queue *queue);
+
+/** Get copy of queue statistics.
+ */
+extern void indigo_queue_get_stats(indigo_queue *queue, indigo_queue_stats *stats);
+
+/** Sum statistics of all live queues (max_depth is the highest high-water mark), trace statistics of each queue and return number of queues.
+ */
+extern int indigo_queue_get_total_stats(indigo_queue_stats *total);
+
+/** Create new message. Key identifies property for stale update dropping, if droppable is false, message itself is never dropped.
+ */
+extern indigo_queue_entry *indigo_queue_entry_create(const void *key, bool droppable);
+
+/** Create new property update message. Updates of the same property in the same state without message may be coalesced or delayed according to the update policy.
+ */
+extern indigo_queue_entry *indigo_queue_entry_create_update(indigo_property *property, const char *message);
+
+/** Create new property deletion message. If property name is empty, delayed updates of all properties of the device are sent before it.
+ */
+extern indigo_queue_entry *indigo_queue_entry_create_delete(indigo_property *property, const char *device);
+
+/** Append formatted text to the message.
+ */
+extern void indigo_queue_entry_printf(indigo_queue_entry *entry, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+/** Append copy of data to the message.
+ */
+extern void indigo_queue_entry_append(indigo_queue_entry *entry, const void *data, long length, indigo_queue_encoding encoding);
+
+/** Append shared BLOB buffer to the message without copying it.
+ */
+extern void indigo_queue_entry_append_buffer(indigo_queue_entry *entry, indigo_blob_buffer *buffer, indigo_queue_encoding encoding);
+
+/** Discard message without sending it.
+ */
+extern void indigo_queue_entry_release(indigo_queue_entry *entry);
+
+/** Enqueue message, queue takes ownership of entry. Returns false if message was rejected and client disconnected.
+ */
+extern bool indigo_queue_push(indigo_queue *queue, indigo_queue_entry *entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* indigo_queue_h */
@@ -64,6 +64,17 @@ typedef struct {
 	double snr;
 } indigo_frame_digest;
 
+#define INDIGO_BACKGROUND_MESH_CELL 64
+
+typedef struct {
+	int width;            /* Frame width */
+	int height;           /* Frame height */
+	int columns;          /* Number of mesh cells in X */
+	int rows;             /* Number of mesh cells in Y */
+	float *background;    /* Sigma-clipped background level of cells */
+	float *noise;         /* Sigma-clipped standard deviation of cells */
+} indigo_background_mesh;
+
 
 extern double indigo_stddev(double set[], const int count);
 extern double indigo_rmse(double set[], const int count);
@@ -73,6 +84,7 @@ extern indigo_result indigo_equalize_bayer_channels(indigo_raw_type raw_type, vo
 
 extern indigo_result indigo_find_stars(indigo_raw_type raw_type, const void *data, const int width, const int height, const int stars_max, indigo_star_detection star_list[], int *stars_found);
 extern indigo_result indigo_find_stars_precise(indigo_raw_type raw_type, const void *data, const uint16_t radius, const int width, const int height, const int stars_max, indigo_star_detection star_list[], int *stars_found);
+extern indigo_result indigo_find_stars_with_background(indigo_raw_type raw_type, const void *data, const uint16_t radius, const int width, const int height, const indigo_background_mesh *background_mesh, const int stars_max, indigo_star_detection star_list[], int *stars_found);
 extern indigo_result indigo_selection_psf(indigo_raw_type raw_type, const void *data, double x, double y, const int radius, const int width, const int height, double *fwhm, double *hfd, double *peak);
 
 extern indigo_result indigo_selection_frame_digest(indigo_raw_type raw_type, const void *data, double *x, double *y, const int radius, const int width, const int height, indigo_frame_digest *digest);
@@ -85,6 +97,10 @@ extern indigo_result indigo_calculate_drift(const indigo_frame_digest *ref, cons
 extern double indigo_guider_reponse(double p_gain, double i_gain, double guide_cycle_time, double drift, double avg_drift);
 extern indigo_result indigo_delete_frame_digest(indigo_frame_digest *fdigest);
 
+extern indigo_result indigo_make_background_mesh(indigo_raw_type raw_type, const void *data, const int width, const int height, const int cell_size, indigo_background_mesh *mesh);
+extern indigo_result indigo_background_at(const indigo_background_mesh *mesh, const double x, const double y, double *background, double *noise);
+extern indigo_result indigo_delete_background_mesh(indigo_background_mesh *mesh);
+
 //RMSE focus related
 extern double indigo_contrast(indigo_raw_type raw_type, const void *data, const uint8_t *saturation_mask, const int width, const int height, bool *saturated);
 extern indigo_result indigo_init_saturation_mask(const int width, const int height, uint8_t **mask);
@@ -59,6 +59,14 @@ extern bool indigo_use_blob_buffering;
  */
 extern bool indigo_use_blob_compression;
 
+/** Number of network threads serving HTTP connections (Linux only, 0 = thread per connection).
+ */
+extern int indigo_server_tcp_threads;
+
+/** Maximal number of threads serving HTTP requests and JSON sessions picked up by network threads (Linux only).
+ */
+extern int indigo_server_tcp_workers;
+
 /** Add static document.
  */
 extern void indigo_server_add_resource(const char *path, unsigned char *data, unsigned length, const char *content_type);
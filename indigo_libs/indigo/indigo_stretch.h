@@ -65,6 +65,21 @@ extern void indigo_debayer_8_gbrg(const uint8_t *input_buffer, int width, int he
 extern void indigo_debayer_8_grbg(const uint8_t *input_buffer, int width, int height, uint8_t *output_buffer);
 extern void indigo_debayer_8_bggr(const uint8_t *input_buffer, int width, int height, uint8_t *output_buffer);
 
+extern void indigo_bin_8(const uint8_t *input_buffer, int width, int height, int components, int factor, uint8_t *output_buffer);
+extern void indigo_bin_16(const uint16_t *input_buffer, int width, int height, int components, int factor, uint16_t *output_buffer);
+
+extern void indigo_debayer_bin_8_rggb(const uint8_t *input_buffer, int width, int height, int factor, uint8_t *output_buffer); // factor must be even
+extern void indigo_debayer_bin_8_gbrg(const uint8_t *input_buffer, int width, int height, int factor, uint8_t *output_buffer);
+extern void indigo_debayer_bin_8_grbg(const uint8_t *input_buffer, int width, int height, int factor, uint8_t *output_buffer);
+extern void indigo_debayer_bin_8_bggr(const uint8_t *input_buffer, int width, int height, int factor, uint8_t *output_buffer);
+extern void indigo_debayer_bin_16_rggb(const uint16_t *input_buffer, int width, int height, int factor, uint16_t *output_buffer);
+extern void indigo_debayer_bin_16_gbrg(const uint16_t *input_buffer, int width, int height, int factor, uint16_t *output_buffer);
+extern void indigo_debayer_bin_16_grbg(const uint16_t *input_buffer, int width, int height, int factor, uint16_t *output_buffer);
+extern void indigo_debayer_bin_16_bggr(const uint16_t *input_buffer, int width, int height, int factor, uint16_t *output_buffer);
+
+extern void indigo_stretch_24_debayered(const uint8_t *input_buffer, int width, int height, uint8_t *output_buffer, double *shadows, double *midtones, double *highlights, unsigned long *totals);
+extern void indigo_stretch_48_debayered(const uint16_t *input_buffer, int width, int height, uint8_t *output_buffer, double *shadows, double *midtones, double *highlights, unsigned long *totals);
+
 
 #ifdef __cplusplus
 }
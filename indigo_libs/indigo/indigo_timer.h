@@ -27,6 +27,7 @@
 #define indigo_timer_h
 
 #include <stdio.h>
+#include <stdint.h>
 #include <pthread.h>
 
 #include <indigo/indigo_bus.h>
@@ -45,21 +46,42 @@ typedef void (*indigo_timer_with_data_callback)(indigo_device *device, void *dat
 typedef struct indigo_timer {
 	indigo_device *device;                    ///< device associated with timer
 	void *callback;           								///< callback function pointer
-	bool canceled;                            ///< timer is canceled (darwin only)
-	bool scheduled;
-	bool callback_running;
-	double delay;
-	bool wake;
-	int timer_id;
-	pthread_cond_t cond;
-	pthread_mutex_t mutex;
-	pthread_mutex_t callback_mutex;
-	pthread_t thread;
+	bool canceled;                            ///< timer is canceled
+	bool scheduled;														///< timer is scheduled to be executed (again)
+	bool callback_running;										///< callback is being executed
+	double delay;															///< delay in seconds
+	int timer_id;															///< timer id (for tracing)
+	int state;																///< state of timer in scheduler
+	uint64_t due;															///< due time (CLOCK_MONOTONIC, ns)
+	uint64_t expires;													///< due time rounded up to scheduler tick
+	pthread_mutex_t callback_mutex;						///< locked while callback is executed
 	struct indigo_timer **reference;
-	struct indigo_timer *next;
+	struct indigo_timer *next;								///< next timer of the same device
+	struct indigo_timer **slot;								///< timer wheel slot
+	struct indigo_timer *wheel_prev;					///< previous timer in timer wheel slot
+	struct indigo_timer *wheel_next;					///< next timer in timer wheel slot or ready queue
 	void *data;
 } indigo_timer;
 
+/** Timer statistics.
+ */
+typedef struct {
+	int allocated;														///< number of allocated timers
+	int pending;															///< number of timers waiting in timer wheel
+	int ready;																///< number of expired timers waiting for worker
+	int workers;															///< number of worker threads
+	int busy_workers;													///< number of workers executing callback
+	long fired;																///< number of executed timers
+	double max_lateness;											///< maximal delay between due time and execution (s)
+	double avg_lateness;											///< average delay between due time and execution (s)
+	double max_duration;											///< maximal callback duration (s)
+	double avg_duration;											///< average callback duration (s)
+} indigo_timer_stats;
+
+/** Number of timer worker threads kept when idle.
+ */
+extern int indigo_timer_pool_size;
+
 /* fix timespec so that abs(tv_nsec) < 1s */
 #define SEC_NS    1000000000LL       /* 1 sec in nanoseconds */
 static inline void normalize_timespec(struct timespec *ts) {
@@ -112,6 +134,10 @@ extern bool indigo_cancel_timer_sync(indigo_device *device, indigo_timer **timer
  */
 extern void indigo_cancel_all_timers(indigo_device *device);
 
+/** Get copy of timer statistics.
+ */
+extern void indigo_get_timer_stats(indigo_timer_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,60 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO XISF block compression
+ \file indigo_xisf.h
+ */
+
+#ifndef indigo_xisf_h
+#define indigo_xisf_h
+
+#include <stdbool.h>
+
+#include <indigo/indigo_bus.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size of independently compressed subblock (bytes).
+ */
+#define INDIGO_XISF_SUBBLOCK_SIZE	(1024 * 1024)
+
+/** XISF 1.0 block compression codec.
+ */
+typedef enum {
+	INDIGO_XISF_ZLIB = 1,			///< zlib (RFC 1950)
+	INDIGO_XISF_LZ4,					///< LZ4 block format, fast encoder
+	INDIGO_XISF_LZ4HC					///< LZ4 block format, high compression encoder
+} indigo_xisf_codec;
+
+/** Convert XISF with uncompressed image attachment to XISF with compressed attachment.
+ If shuffle is true and samples are wider than one byte, bytes are shuffled before compression. Attachment is split to INDIGO_XISF_SUBBLOCK_SIZE subblocks compressed in parallel
+ and header is rewritten with location, compression and subblocks attributes. Returns new shared BLOB buffer or NULL if image can't be compressed.
+ */
+extern indigo_blob_buffer *indigo_xisf_compress(const void *xisf, long size, indigo_xisf_codec codec, bool shuffle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* indigo_xisf_h */
@@ -38,6 +38,11 @@ extern "C" {
 
 extern bool indigo_use_blob_urls;
 
+/** Timeout (ms) after which idle connection releases parser buffers grown over their initial size, 0 disables it.
+ */
+
+extern int indigo_xml_idle_timeout;
+
 /** XML wire protocol parser.
  */
 extern void indigo_xml_parse(indigo_device *device, indigo_client *client);
@@ -0,0 +1,831 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO binary wire protocol parser
+ \file indigo_binary.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <indigo/indigo_binary.h>
+#include <indigo/indigo_io.h>
+#include <indigo/indigo_queue.h>
+#include <indigo/indigo_version.h>
+#include <indigo/indigo_xml.h>
+
+#define MAX_FRAME_SIZE	(64 * 1024 * 1024)
+#define MAX_BLOB_SIZE	(1024L * 1024 * 1024)
+#define MAX_ID_GAP	65536
+#define MAX_ID	(16 * 1024 * 1024)
+#define SKIP_BUFFER_SIZE	4096
+
+// frame builder
+
+static void frame_reserve(indigo_binary_frame *frame, long length) {
+	if (frame->length + length > frame->size) {
+		long size = frame->size ? frame->size : 1024;
+		while (frame->length + length > size)
+			size *= 2;
+		frame->data = indigo_safe_realloc(frame->data, size);
+		frame->size = size;
+	}
+}
+
+void indigo_binary_frame_begin(indigo_binary_frame *frame, indigo_binary_frame_type type) {
+	frame->length = 0;
+	frame_reserve(frame, INDIGO_BINARY_HEADER_SIZE);
+	frame->data[0] = INDIGO_BINARY_MARKER;
+	frame->data[1] = type;
+	frame->data[2] = frame->data[3] = 0;
+	frame->length = INDIGO_BINARY_HEADER_SIZE;
+}
+
+void indigo_binary_put_u8(indigo_binary_frame *frame, uint8_t value) {
+	frame_reserve(frame, 1);
+	frame->data[frame->length++] = value;
+}
+
+void indigo_binary_put_u16(indigo_binary_frame *frame, uint16_t value) {
+	frame_reserve(frame, 2);
+	unsigned char *data = frame->data + frame->length;
+	data[0] = value;
+	data[1] = value >> 8;
+	frame->length += 2;
+}
+
+void indigo_binary_put_u32(indigo_binary_frame *frame, uint32_t value) {
+	frame_reserve(frame, 4);
+	unsigned char *data = frame->data + frame->length;
+	for (int i = 0; i < 4; i++, value >>= 8)
+		data[i] = value;
+	frame->length += 4;
+}
+
+void indigo_binary_put_u64(indigo_binary_frame *frame, uint64_t value) {
+	frame_reserve(frame, 8);
+	unsigned char *data = frame->data + frame->length;
+	for (int i = 0; i < 8; i++, value >>= 8)
+		data[i] = value;
+	frame->length += 8;
+}
+
+void indigo_binary_put_double(indigo_binary_frame *frame, double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	indigo_binary_put_u64(frame, bits);
+}
+
+void indigo_binary_put_string(indigo_binary_frame *frame, const char *value) {
+	long length = value ? strnlen(value, INDIGO_VALUE_SIZE) : 0;
+	indigo_binary_put_u16(frame, length);
+	frame_reserve(frame, length);
+	memcpy(frame->data + frame->length, value, length);
+	frame->length += length;
+}
+
+void indigo_binary_put_text(indigo_binary_frame *frame, const char *value) {
+	long length = value ? strlen(value) : 0;
+	indigo_binary_put_u32(frame, (uint32_t)length);
+	frame_reserve(frame, length);
+	memcpy(frame->data + frame->length, value, length);
+	frame->length += length;
+}
+
+void indigo_binary_frame_end(indigo_binary_frame *frame) {
+	uint32_t length = (uint32_t)(frame->length - INDIGO_BINARY_HEADER_SIZE);
+	for (int i = 4; i < 8; i++, length >>= 8)
+		frame->data[i] = length;
+}
+
+void indigo_binary_frame_release(indigo_binary_frame *frame) {
+	indigo_safe_free(frame->data);
+	frame->data = NULL;
+	frame->length = frame->size = 0;
+}
+
+// parser
+
+typedef struct {
+	indigo_device *device;
+	indigo_client *client;
+	indigo_reader *reader;
+	unsigned char *payload;
+	long payload_size;
+	const unsigned char *pointer;
+	const unsigned char *end;
+	bool failed;
+	indigo_property *request;
+	indigo_property **properties;
+	uint32_t count;
+} parser_context;
+
+static bool get_bytes(parser_context *context, void *buffer, long length) {
+	if (context->failed || context->end - context->pointer < length) {
+		context->failed = true;
+		memset(buffer, 0, length);
+		return false;
+	}
+	memcpy(buffer, context->pointer, length);
+	context->pointer += length;
+	return true;
+}
+
+static uint8_t get_u8(parser_context *context) {
+	uint8_t value;
+	get_bytes(context, &value, 1);
+	return value;
+}
+
+static uint16_t get_u16(parser_context *context) {
+	unsigned char data[2];
+	get_bytes(context, data, 2);
+	return data[0] | data[1] << 8;
+}
+
+static uint32_t get_u32(parser_context *context) {
+	unsigned char data[4];
+	get_bytes(context, data, 4);
+	return (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+static uint64_t get_u64(parser_context *context) {
+	unsigned char data[8];
+	get_bytes(context, data, 8);
+	uint64_t value = 0;
+	for (int i = 7; i >= 0; i--)
+		value = value << 8 | data[i];
+	return value;
+}
+
+static double get_double(parser_context *context) {
+	uint64_t bits = get_u64(context);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static void get_string(parser_context *context, char *buffer, long size) {
+	long length = get_u16(context);
+	if (context->failed || context->end - context->pointer < length) {
+		context->failed = true;
+		*buffer = 0;
+		return;
+	}
+	long copy = length < size ? length : size - 1;
+	memcpy(buffer, context->pointer, copy);
+	buffer[copy] = 0;
+	context->pointer += length;
+}
+
+static char *get_text(parser_context *context) {
+	long length = get_u32(context);
+	if (context->failed || context->end - context->pointer < length) {
+		context->failed = true;
+		return NULL;
+	}
+	char *text = indigo_safe_malloc(length + 1);
+	memcpy(text, context->pointer, length);
+	text[length] = 0;
+	context->pointer += length;
+	return text;
+}
+
+static void get_text_item_value(parser_context *context, indigo_item *item) {
+	char *text = get_text(context);
+	if (text) {
+		indigo_set_text_item_value(item, text);
+		free(text);
+	}
+}
+
+static void get_device_name(parser_context *context, char *buffer) {
+	char name[INDIGO_NAME_SIZE];
+	get_string(context, name, INDIGO_NAME_SIZE);
+	if (indigo_use_host_suffix && *name)
+		snprintf(buffer, INDIGO_NAME_SIZE, "%s %s", name, context->device->name);
+	else
+		indigo_copy_name(buffer, name);
+}
+
+// BLOB payload announced in vector header, item is NULL for payload of unknown property or item
+
+typedef struct {
+	indigo_item *item;
+	long size;
+} blob_payload;
+
+static bool skip_payload(parser_context *context, long size) {
+	char buffer[SKIP_BUFFER_SIZE];
+	while (size > 0) {
+		long length = size < SKIP_BUFFER_SIZE ? size : SKIP_BUFFER_SIZE;
+		if (indigo_reader_read(context->reader, buffer, length) != length)
+			return false;
+		size -= length;
+	}
+	return true;
+}
+
+static bool read_payloads(parser_context *context, blob_payload *payloads, int count) {
+	for (int i = 0; i < count; i++) {
+		indigo_item *item = payloads[i].item;
+		long size = payloads[i].size;
+		if (item == NULL) {
+			if (!skip_payload(context, size))
+				return false;
+			continue;
+		}
+		/* the same item may be sent more than once, the last payload wins */
+		indigo_safe_free(item->blob.value);
+		item->blob.value = indigo_safe_malloc(item->blob.size = size);
+		if (indigo_reader_read(context->reader, item->blob.value, size) != size)
+			return false;
+	}
+	return true;
+}
+
+static void release_remote_property(indigo_property *property) {
+	if (property->type == INDIGO_BLOB_VECTOR) {
+		for (int i = 0; i < property->count; i++) {
+			indigo_safe_free(property->items[i].blob.value);
+			property->items[i].blob.value = NULL;
+		}
+	}
+	indigo_release_property(property);
+}
+
+// server side, requests from client
+
+static void send_hello(parser_context *context) {
+	indigo_adapter_context *client_context = (indigo_adapter_context *)context->client->client_context;
+	indigo_binary_frame frame = { 0 };
+	indigo_binary_frame_begin(&frame, INDIGO_BINARY_HELLO);
+	indigo_binary_put_u16(&frame, INDIGO_VERSION_CURRENT);
+	indigo_binary_put_string(&frame, "INDIGO");
+	indigo_binary_frame_end(&frame);
+	indigo_queue_entry *entry = indigo_queue_entry_create(NULL, false);
+	indigo_queue_entry_append(entry, frame.data, frame.length, INDIGO_QUEUE_RAW);
+	indigo_queue_push(client_context->queue, entry);
+	indigo_binary_frame_release(&frame);
+}
+
+static bool supported_version(indigo_version version, const char *name) {
+	if ((version & 0xFF00) == (INDIGO_VERSION_CURRENT & 0xFF00))
+		return true;
+	indigo_error("Binary Parser: '%s' uses unsupported protocol version %04x", name, version);
+	return false;
+}
+
+static bool hello_request(parser_context *context) {
+	indigo_client *client = context->client;
+	indigo_version version = get_u16(context);
+	char name[INDIGO_NAME_SIZE];
+	get_string(context, name, INDIGO_NAME_SIZE);
+	if (context->failed)
+		return true;
+	INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: hello %04x '%s'", version, name));
+	if (!supported_version(version, name))
+		return false;
+	if (*name)
+		indigo_copy_name(client->name, name);
+	send_hello(context);
+	/* names are never translated, binary protocol is always INDIGO 2.0 */
+	client->version = INDIGO_VERSION_CURRENT;
+	return true;
+}
+
+static void get_properties_request(parser_context *context) {
+	indigo_property *property = context->request;
+	get_string(context, property->device, INDIGO_NAME_SIZE);
+	get_string(context, property->name, INDIGO_NAME_SIZE);
+	if (context->failed)
+		return;
+	INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: get properties '%s' '%s'", property->device, property->name));
+	indigo_enumerate_properties(context->client, property);
+}
+
+static void enable_blob_request(parser_context *context) {
+	indigo_client *client = context->client;
+	indigo_property *property = context->request;
+	get_string(context, property->device, INDIGO_NAME_SIZE);
+	get_string(context, property->name, INDIGO_NAME_SIZE);
+	indigo_enable_blob_mode mode = get_u8(context);
+	if (context->failed)
+		return;
+	INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: enable BLOB '%s' '%s' %d", property->device, property->name, mode));
+	indigo_enable_blob_mode_record *record = client->enable_blob_mode_records;
+	indigo_enable_blob_mode_record *prev = NULL;
+	while (record) {
+		if (!strcmp(property->device, record->device) && (*record->name == 0 || !strcmp(property->name, record->name))) {
+			if (prev) {
+				prev->next = record->next;
+				free(record);
+				record = prev->next;
+			} else {
+				client->enable_blob_mode_records = record->next;
+				free(record);
+				record = client->enable_blob_mode_records;
+			}
+		} else {
+			prev = record;
+			record = record->next;
+		}
+	}
+	if (mode != INDIGO_ENABLE_BLOB_NEVER) {
+		record = indigo_safe_malloc(sizeof(indigo_enable_blob_mode_record));
+		indigo_copy_name(record->device, property->device);
+		indigo_copy_name(record->name, property->name);
+		if (mode == INDIGO_ENABLE_BLOB_URL && indigo_use_blob_urls)
+			record->mode = INDIGO_ENABLE_BLOB_URL;
+		else
+			record->mode = INDIGO_ENABLE_BLOB_ALSO;
+		record->next = client->enable_blob_mode_records;
+		client->enable_blob_mode_records = record;
+		indigo_enable_blob(client, property, record->mode);
+	} else {
+		indigo_enable_blob(client, property, INDIGO_ENABLE_BLOB_NEVER);
+	}
+}
+
+static bool new_request(parser_context *context) {
+	char device[INDIGO_NAME_SIZE], name[INDIGO_NAME_SIZE];
+	get_string(context, device, INDIGO_NAME_SIZE);
+	get_string(context, name, INDIGO_NAME_SIZE);
+	indigo_property_type type = get_u8(context);
+	indigo_token token = get_u64(context);
+	int count = get_u16(context);
+	if (context->failed)
+		return true;
+	indigo_property *property = NULL;
+	switch (type) {
+		case INDIGO_TEXT_VECTOR:
+			property = indigo_init_text_property(NULL, device, name, NULL, NULL, INDIGO_IDLE_STATE, INDIGO_RW_PERM, count);
+			break;
+		case INDIGO_NUMBER_VECTOR:
+			property = indigo_init_number_property(NULL, device, name, NULL, NULL, INDIGO_IDLE_STATE, INDIGO_RW_PERM, count);
+			break;
+		case INDIGO_SWITCH_VECTOR:
+			property = indigo_init_switch_property(NULL, device, name, NULL, NULL, INDIGO_IDLE_STATE, INDIGO_RW_PERM, INDIGO_ANY_OF_MANY_RULE, count);
+			break;
+		case INDIGO_BLOB_VECTOR:
+			property = indigo_init_blob_property(NULL, device, name, NULL, NULL, INDIGO_IDLE_STATE, count);
+			break;
+		default:
+			context->failed = true;
+			return true;
+	}
+	property->access_token = token;
+	property->version = INDIGO_VERSION_CURRENT;
+	blob_payload *payloads = indigo_safe_malloc((count + 1) * sizeof(blob_payload));
+	int payload_count = 0;
+	for (int i = 0; i < count; i++) {
+		indigo_item *item = property->items + i;
+		get_string(context, item->name, INDIGO_NAME_SIZE);
+		switch (type) {
+			case INDIGO_TEXT_VECTOR:
+				get_text_item_value(context, item);
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				item->number.value = item->number.target = get_double(context);
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				item->sw.value = get_u8(context);
+				break;
+			case INDIGO_BLOB_VECTOR:
+				switch (get_u8(context)) {
+					case INDIGO_BINARY_BLOB_DATA:
+						get_string(context, item->blob.format, INDIGO_NAME_SIZE);
+						item->blob.size = (long)get_u64(context);
+						if (item->blob.size < 0 || item->blob.size > MAX_BLOB_SIZE)
+							context->failed = true;
+						else if (item->blob.size > 0)
+							payloads[payload_count++] = (blob_payload){ item, item->blob.size };
+						break;
+					case INDIGO_BINARY_BLOB_URL:
+						get_string(context, item->blob.url, INDIGO_VALUE_SIZE);
+						break;
+					default:
+						get_string(context, item->blob.format, INDIGO_NAME_SIZE);
+						break;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	bool result = true;
+	if (!context->failed) {
+		INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: new '%s' '%s' %d items", device, name, count));
+		result = read_payloads(context, payloads, payload_count);
+		if (result) {
+			if (type == INDIGO_BLOB_VECTOR) {
+				/* BLOB without payload was uploaded to /blob/ over HTTP */
+				for (int i = 0; i < count; i++) {
+					indigo_item *item = property->items + i;
+					if (item->blob.value == NULL && *item->blob.url == 0) {
+						indigo_blob_entry *entry = indigo_find_blob(property, item);
+						if (entry) {
+							pthread_mutex_lock(&entry->mutext);
+							item->blob.value = indigo_safe_malloc_copy(item->blob.size = entry->size, entry->content);
+							pthread_mutex_unlock(&entry->mutext);
+						}
+					}
+				}
+			}
+			indigo_change_property(context->client, property);
+		}
+	}
+	indigo_safe_free(payloads);
+	release_remote_property(property);
+	return result;
+}
+
+// client side, messages from server
+
+static bool hello_response(parser_context *context) {
+	indigo_version version = get_u16(context);
+	char name[INDIGO_NAME_SIZE];
+	get_string(context, name, INDIGO_NAME_SIZE);
+	if (context->failed)
+		return true;
+	INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: hello %04x '%s'", version, name));
+	if (!supported_version(version, name))
+		return false;
+	context->device->version = INDIGO_VERSION_CURRENT;
+	return true;
+}
+
+static void get_item_value(parser_context *context, indigo_property *property, indigo_item *item, bool definition) {
+	switch (property->type) {
+		case INDIGO_TEXT_VECTOR:
+			get_text_item_value(context, item);
+			break;
+		case INDIGO_NUMBER_VECTOR:
+			if (definition) {
+				get_string(context, item->number.format, INDIGO_VALUE_SIZE);
+				item->number.min = get_double(context);
+				item->number.max = get_double(context);
+				item->number.step = get_double(context);
+			}
+			item->number.value = get_double(context);
+			item->number.target = get_double(context);
+			break;
+		case INDIGO_SWITCH_VECTOR:
+			item->sw.value = get_u8(context);
+			break;
+		case INDIGO_LIGHT_VECTOR:
+			item->light.value = get_u8(context);
+			break;
+		default:
+			break;
+	}
+}
+
+static void get_blob_url(parser_context *context, indigo_item *item, indigo_binary_blob_kind kind) {
+	char value[INDIGO_VALUE_SIZE];
+	get_string(context, value, INDIGO_VALUE_SIZE);
+	if (kind == INDIGO_BINARY_BLOB_PATH)
+		snprintf(item->blob.url, INDIGO_VALUE_SIZE, "%s%s", ((indigo_adapter_context *)context->device->device_context)->url_prefix, value);
+	else
+		indigo_copy_value(item->blob.url, value);
+}
+
+static void define_response(parser_context *context) {
+	uint32_t id = get_u32(context);
+	indigo_property_type type = get_u8(context);
+	indigo_property_perm perm = get_u8(context);
+	indigo_property_state state = get_u8(context);
+	indigo_rule rule = get_u8(context);
+	char device[INDIGO_NAME_SIZE], name[INDIGO_NAME_SIZE], group[INDIGO_NAME_SIZE], label[INDIGO_VALUE_SIZE], hints[INDIGO_VALUE_SIZE], message[INDIGO_VALUE_SIZE];
+	get_device_name(context, device);
+	get_string(context, name, INDIGO_NAME_SIZE);
+	get_string(context, group, INDIGO_NAME_SIZE);
+	get_string(context, label, INDIGO_VALUE_SIZE);
+	get_string(context, hints, INDIGO_VALUE_SIZE);
+	get_string(context, message, INDIGO_VALUE_SIZE);
+	int count = get_u16(context);
+	if (context->failed || id == 0)
+		return;
+	indigo_property *property = NULL;
+	switch (type) {
+		case INDIGO_TEXT_VECTOR:
+			property = indigo_init_text_property(NULL, device, name, group, label, state, perm, count);
+			break;
+		case INDIGO_NUMBER_VECTOR:
+			property = indigo_init_number_property(NULL, device, name, group, label, state, perm, count);
+			break;
+		case INDIGO_SWITCH_VECTOR:
+			property = indigo_init_switch_property(NULL, device, name, group, label, state, perm, rule, count);
+			break;
+		case INDIGO_LIGHT_VECTOR:
+			property = indigo_init_light_property(NULL, device, name, group, label, state, count);
+			break;
+		case INDIGO_BLOB_VECTOR:
+			property = indigo_init_blob_property_p(NULL, device, name, group, label, state, perm, count);
+			break;
+		default:
+			context->failed = true;
+			return;
+	}
+	indigo_copy_value(property->hints, hints);
+	for (int i = 0; i < count; i++) {
+		indigo_item *item = property->items + i;
+		get_string(context, item->name, INDIGO_NAME_SIZE);
+		get_string(context, item->label, INDIGO_VALUE_SIZE);
+		get_string(context, item->hints, INDIGO_VALUE_SIZE);
+		if (type == INDIGO_BLOB_VECTOR) {
+			indigo_binary_blob_kind kind = get_u8(context);
+			if (kind == INDIGO_BINARY_BLOB_PATH || kind == INDIGO_BINARY_BLOB_URL)
+				get_blob_url(context, item, kind);
+		} else {
+			get_item_value(context, property, item, true);
+		}
+	}
+	if (context->failed) {
+		indigo_release_property(property);
+		return;
+	}
+	/* server assigns ids densely, so id far beyond the table is malformed (and it would make the table grow without limit) */
+	if (id > context->count + MAX_ID_GAP || id >= MAX_ID) {
+		indigo_error("Binary Parser: property id %u out of range", id);
+		indigo_release_property(property);
+		context->failed = true;
+		return;
+	}
+	INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: define '%s' '%s' %u", device, name, id));
+	if (id >= context->count) {
+		uint32_t count = context->count ? context->count : 64;
+		while (count <= id)
+			count *= 2;
+		context->properties = indigo_safe_realloc(context->properties, count * sizeof(indigo_property *));
+		memset(context->properties + context->count, 0, (count - context->count) * sizeof(indigo_property *));
+		context->count = count;
+	}
+	indigo_property *existing = context->properties[id];
+	if (existing && existing->type == property->type && existing->count == property->count && !strcmp(existing->device, property->device) && !strcmp(existing->name, property->name)) {
+		/* property pointer is kept stable for local clients, definition is copied to it */
+		existing->state = property->state;
+		existing->perm = property->perm;
+		existing->rule = property->rule;
+		indigo_copy_name(existing->group, property->group);
+		indigo_copy_value(existing->label, property->label);
+		indigo_copy_value(existing->hints, property->hints);
+		for (int i = 0; i < count; i++) {
+			indigo_item *existing_item = existing->items + i;
+			indigo_item *item = property->items + i;
+			if (type == INDIGO_TEXT_VECTOR) {
+				indigo_safe_free(existing_item->text.long_value);
+				*existing_item = *item;
+				item->text.long_value = NULL;
+			} else if (type == INDIGO_BLOB_VECTOR) {
+				indigo_safe_free(existing_item->blob.value);
+				*existing_item = *item;
+				item->blob.value = NULL;
+			} else {
+				*existing_item = *item;
+			}
+		}
+		indigo_release_property(property);
+		property = existing;
+	} else {
+		if (existing) {
+			indigo_delete_property(context->device, existing, NULL);
+			release_remote_property(existing);
+		}
+		context->properties[id] = property;
+	}
+	indigo_define_property(context->device, property, *message ? message : NULL);
+}
+
+static bool update_response(parser_context *context) {
+	uint32_t id = get_u32(context);
+	indigo_property_type type = get_u8(context);
+	indigo_property_state state = get_u8(context);
+	char message[INDIGO_VALUE_SIZE];
+	get_string(context, message, INDIGO_VALUE_SIZE);
+	int count = get_u16(context);
+	if (context->failed)
+		return true;
+	indigo_property *property = id < context->count ? context->properties[id] : NULL;
+	if (property && property->type != type)
+		property = NULL;
+	/* values of unknown property or item are parsed to scratch item, their BLOB payloads are skipped */
+	indigo_property scratch_property = { .type = type };
+	indigo_item *scratch_item = indigo_safe_malloc(sizeof(indigo_item));
+	blob_payload *payloads = indigo_safe_malloc((count + 1) * sizeof(blob_payload));
+	int payload_count = 0;
+	for (int i = 0; i < count; i++) {
+		int index = get_u16(context);
+		indigo_item *item = property && index < property->count ? property->items + index : scratch_item;
+		if (type == INDIGO_BLOB_VECTOR) {
+			indigo_binary_blob_kind kind = get_u8(context);
+			indigo_safe_free(item->blob.value);
+			item->blob.value = NULL;
+			item->blob.size = 0;
+			if (kind == INDIGO_BINARY_BLOB_DATA) {
+				get_string(context, item->blob.format, INDIGO_NAME_SIZE);
+				item->blob.size = (long)get_u64(context);
+				if (item->blob.size < 0 || item->blob.size > MAX_BLOB_SIZE)
+					context->failed = true;
+				else if (item->blob.size > 0)
+					payloads[payload_count++] = (blob_payload){ item == scratch_item ? NULL : item, item->blob.size };
+			} else if (kind == INDIGO_BINARY_BLOB_PATH || kind == INDIGO_BINARY_BLOB_URL) {
+				get_blob_url(context, item, kind);
+				char *ext = strrchr(item->blob.url, '.');
+				if (ext)
+					indigo_copy_name(item->blob.format, ext);
+			}
+		} else {
+			get_item_value(context, property ? property : &scratch_property, item, false);
+		}
+	}
+	bool result = !context->failed && read_payloads(context, payloads, payload_count);
+	if (type == INDIGO_TEXT_VECTOR)
+		indigo_safe_free(scratch_item->text.long_value);
+	indigo_safe_free(scratch_item);
+	indigo_safe_free(payloads);
+	if (result && property) {
+		INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: update '%s' '%s' %u", property->device, property->name, id));
+		property->state = state;
+		indigo_update_property(context->device, property, *message ? message : NULL);
+	}
+	return result;
+}
+
+static void delete_response(parser_context *context) {
+	uint32_t id = get_u32(context);
+	char device[INDIGO_NAME_SIZE], message[INDIGO_VALUE_SIZE];
+	get_device_name(context, device);
+	get_string(context, message, INDIGO_VALUE_SIZE);
+	if (context->failed)
+		return;
+	INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: delete '%s' %u", device, id));
+	if (id) {
+		indigo_property *property = id < context->count ? context->properties[id] : NULL;
+		if (property) {
+			indigo_delete_property(context->device, property, *message ? message : NULL);
+			release_remote_property(property);
+			context->properties[id] = NULL;
+		}
+	} else {
+		for (uint32_t i = 0; i < context->count; i++) {
+			indigo_property *property = context->properties[i];
+			if (property != NULL && !strncmp(property->device, device, INDIGO_NAME_SIZE)) {
+				indigo_delete_property(context->device, property, *message ? message : NULL);
+				release_remote_property(property);
+				context->properties[i] = NULL;
+			}
+		}
+	}
+}
+
+static void message_response(parser_context *context) {
+	char device[INDIGO_NAME_SIZE], text[INDIGO_VALUE_SIZE], message[INDIGO_VALUE_SIZE];
+	get_device_name(context, device);
+	get_string(context, text, INDIGO_VALUE_SIZE);
+	if (context->failed)
+		return;
+	if (*device)
+		snprintf(message, INDIGO_VALUE_SIZE, "%s: %s", device, text);
+	else
+		indigo_copy_value(message, text);
+	indigo_send_message(context->device, *message ? message : NULL);
+}
+
+void indigo_binary_parse(indigo_device *device, indigo_client *client) {
+	parser_context *context = indigo_safe_malloc(sizeof(parser_context));
+	context->device = device;
+	context->client = client;
+	context->request = indigo_safe_malloc(sizeof(indigo_property));
+	context->request->version = INDIGO_VERSION_CURRENT;
+	int handle = 0;
+	if (device != NULL) {
+		handle = ((indigo_adapter_context *)device->device_context)->input;
+	} else if (client != NULL) {
+		handle = ((indigo_adapter_context *)client->client_context)->input;
+	}
+	context->reader = indigo_safe_malloc(sizeof(indigo_reader));
+	indigo_init_reader(context->reader, handle);
+	INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: parser started"));
+	while (true) {
+		unsigned char header[INDIGO_BINARY_HEADER_SIZE];
+		if (indigo_reader_read(context->reader, (char *)header, INDIGO_BINARY_HEADER_SIZE) != INDIGO_BINARY_HEADER_SIZE)
+			break;
+		long length = (long)header[4] | (long)header[5] << 8 | (long)header[6] << 16 | (long)header[7] << 24;
+		if (header[0] != INDIGO_BINARY_MARKER || length > MAX_FRAME_SIZE) {
+			indigo_error("Binary Parser: invalid frame header");
+			break;
+		}
+		if (length > context->payload_size) {
+			context->payload = indigo_safe_realloc(context->payload, length);
+			context->payload_size = length;
+		}
+		if (length > 0 && indigo_reader_read(context->reader, (char *)context->payload, length) != length)
+			break;
+		context->pointer = context->payload;
+		context->end = context->payload + length;
+		context->failed = false;
+		bool result = true;
+		if (client != NULL) {
+			switch (header[1]) {
+				case INDIGO_BINARY_HELLO:
+					result = hello_request(context);
+					break;
+				case INDIGO_BINARY_GET_PROPERTIES:
+					get_properties_request(context);
+					break;
+				case INDIGO_BINARY_ENABLE_BLOB:
+					enable_blob_request(context);
+					break;
+				case INDIGO_BINARY_NEW:
+					result = new_request(context);
+					break;
+				default:
+					INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: frame type %d ignored", header[1]));
+					break;
+			}
+		} else {
+			switch (header[1]) {
+				case INDIGO_BINARY_HELLO:
+					result = hello_response(context);
+					break;
+				case INDIGO_BINARY_DEFINE:
+					define_response(context);
+					break;
+				case INDIGO_BINARY_UPDATE:
+					result = update_response(context);
+					break;
+				case INDIGO_BINARY_DELETE:
+					delete_response(context);
+					break;
+				case INDIGO_BINARY_MESSAGE:
+					message_response(context);
+					break;
+				default:
+					INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: frame type %d ignored", header[1]));
+					break;
+			}
+		}
+		if (context->failed) {
+			indigo_error("Binary Parser: malformed frame type %d", header[1]);
+			break;
+		}
+		if (!result)
+			break;
+	}
+	while (true) {
+		indigo_property *property = NULL;
+		uint32_t index;
+		for (index = 0; index < context->count; index++) {
+			property = context->properties[index];
+			if (property != NULL)
+				break;
+		}
+		if (property == NULL)
+			break;
+		indigo_device remote_device;
+		indigo_copy_name(remote_device.name, property->device);
+		remote_device.version = property->version;
+		indigo_property *all_properties = indigo_init_text_property(NULL, remote_device.name, "", "", "", INDIGO_OK_STATE, INDIGO_RO_PERM, 0);
+		indigo_delete_property(&remote_device, all_properties, NULL);
+		indigo_release_property(all_properties);
+		for (; index < context->count; index++) {
+			indigo_property *property = context->properties[index];
+			if (property != NULL && !strncmp(remote_device.name, property->device, INDIGO_NAME_SIZE)) {
+				release_remote_property(property);
+				context->properties[index] = NULL;
+			}
+		}
+	}
+	indigo_safe_free(context->properties);
+	indigo_safe_free(context->payload);
+	indigo_safe_free(context->reader);
+	indigo_safe_free(context->request);
+	free(context);
+	close(handle);
+	INDIGO_TRACE_PARSER(indigo_trace("Binary Parser: parser finished"));
+}
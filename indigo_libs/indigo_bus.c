@@ -41,6 +41,7 @@
 #include <syslog.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <zlib.h>
 #endif
 #if defined(INDIGO_WINDOWS)
 #include <io.h>
@@ -55,22 +56,52 @@
 #include <indigo/indigo_token.h>
 
 #define MAX_DEVICES 256
-#define MAX_CLIENTS 256
-#define MAX_BLOBS	32
+#define MAX_CLIENTS 1024
+
+#define DEVICE_HASH_SIZE	512
+#define BLOB_HASH_SIZE		256
+#define BLOB_LOCK_COUNT		16
 
 #define BUFFER_SIZE	1024
 
 static indigo_device *devices[MAX_DEVICES];
 static indigo_client *clients[MAX_CLIENTS];
-static indigo_blob_entry *blobs[MAX_BLOBS];
+/* highest slot ever used, broadcasts don't scan the unused tail of the client table */
+static int max_client_index = -1;
+
+// device registry, local devices are hashed by name, remote proxies ('@' devices) are kept in separate list
+// slot indices are stored as slot + 1, 0 is end of chain
+
+static int device_hash_heads[DEVICE_HASH_SIZE];
+static int device_hash_next[MAX_DEVICES];
+static uint32_t device_hash_codes[MAX_DEVICES];
+static int remote_devices[MAX_DEVICES];
+static int remote_device_count = 0;
 
 static pthread_mutex_t bus_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER;
+
+static void close_http_connections(void);
 #define client_mutex bus_mutex
 #define device_mutex bus_mutex
 
 bool indigo_use_strict_locking = true;
 
-static pthread_mutex_t blob_mutex = PTHREAD_MUTEX_INITIALIZER;
+// BLOB entries are indexed both by item pointer and by (device, property, item) name hash
+// each index bucket is guarded by lock stripe bucket % BLOB_LOCK_COUNT, so BLOBs of different devices don't contend on single mutex
+
+typedef struct blob_index_entry {
+	indigo_blob_entry entry;
+	uint32_t item_hash;
+	uint32_t name_hash;
+	struct blob_index_entry *item_next;
+	struct blob_index_entry *name_next;
+} blob_index_entry;
+
+static blob_index_entry *blob_item_heads[BLOB_HASH_SIZE];
+static blob_index_entry *blob_name_heads[BLOB_HASH_SIZE];
+static pthread_mutex_t blob_mutexes[BLOB_LOCK_COUNT];
+static pthread_once_t blob_mutexes_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t blob_buffer_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static bool is_started = false;
 
@@ -393,6 +424,178 @@ void indigo_trace_property(const char *message, indigo_client *client, indigo_pr
 	}
 }
 
+static uint32_t device_name_hash(const char *name) {
+	uint32_t hash = 2166136261U;
+	for (int i = 0; i < INDIGO_NAME_SIZE && name[i]; i++)
+		hash = (hash ^ (uint8_t)name[i]) * 16777619U;
+	return hash;
+}
+
+static void init_blob_mutexes(void) {
+	for (int i = 0; i < BLOB_LOCK_COUNT; i++)
+		pthread_mutex_init(&blob_mutexes[i], NULL);
+}
+
+static uint32_t blob_item_hash(indigo_item *item) {
+	uint64_t key = (uint64_t)(uintptr_t)item;
+	return (uint32_t)(((key >> 4) * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static uint32_t blob_name_hash(const char *device, const char *property, const char *item) {
+	const char *names[] = { device, property, item };
+	uint32_t hash = 2166136261U;
+	for (int j = 0; j < 3; j++) {
+		for (int i = 0; i < INDIGO_NAME_SIZE && names[j][i]; i++)
+			hash = (hash ^ (uint8_t)names[j][i]) * 16777619U;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static pthread_mutex_t *blob_stripe(uint32_t hash) {
+	pthread_once(&blob_mutexes_once, init_blob_mutexes);
+	return &blob_mutexes[hash & (BLOB_LOCK_COUNT - 1)];
+}
+
+static void lock_blob_stripes(pthread_mutex_t *first, pthread_mutex_t *second) {
+	if (first == second) {
+		pthread_mutex_lock(first);
+	} else if (first < second) {
+		pthread_mutex_lock(first);
+		pthread_mutex_lock(second);
+	} else {
+		pthread_mutex_lock(second);
+		pthread_mutex_lock(first);
+	}
+}
+
+static blob_index_entry *find_blob_by_item(indigo_item *item, uint32_t item_hash) {
+	for (blob_index_entry *index_entry = blob_item_heads[item_hash & (BLOB_HASH_SIZE - 1)]; index_entry; index_entry = index_entry->item_next) {
+		if (index_entry->entry.item == item)
+			return index_entry;
+	}
+	return NULL;
+}
+
+// returns entry for item (created if not yet indexed) with item stripe locked
+
+static blob_index_entry *acquire_blob_entry(indigo_property *property, indigo_item *item) {
+	uint32_t item_hash = blob_item_hash(item);
+	pthread_mutex_t *item_mutex = blob_stripe(item_hash);
+	pthread_mutex_lock(item_mutex);
+	blob_index_entry *index_entry = find_blob_by_item(item, item_hash);
+	if (index_entry != NULL)
+		return index_entry;
+	pthread_mutex_unlock(item_mutex);
+	uint32_t name_hash = blob_name_hash(property->device, property->name, item->name);
+	pthread_mutex_t *name_mutex = blob_stripe(name_hash);
+	lock_blob_stripes(item_mutex, name_mutex);
+	index_entry = find_blob_by_item(item, item_hash);
+	if (index_entry == NULL) {
+		index_entry = indigo_safe_malloc(sizeof(blob_index_entry));
+		index_entry->entry.item = item;
+		index_entry->entry.property = property;
+		pthread_mutex_init(&index_entry->entry.mutext, NULL);
+		index_entry->item_hash = item_hash;
+		index_entry->name_hash = name_hash;
+		blob_index_entry **item_head = &blob_item_heads[item_hash & (BLOB_HASH_SIZE - 1)];
+		index_entry->item_next = *item_head;
+		*item_head = index_entry;
+		blob_index_entry **name_head = &blob_name_heads[name_hash & (BLOB_HASH_SIZE - 1)];
+		index_entry->name_next = *name_head;
+		*name_head = index_entry;
+	}
+	if (name_mutex != item_mutex)
+		pthread_mutex_unlock(name_mutex);
+	return index_entry;
+}
+
+static void remove_blob_entry(indigo_item *item) {
+	uint32_t item_hash = blob_item_hash(item);
+	pthread_mutex_t *item_mutex = blob_stripe(item_hash);
+	pthread_mutex_lock(item_mutex);
+	blob_index_entry *index_entry = find_blob_by_item(item, item_hash);
+	pthread_mutex_unlock(item_mutex);
+	if (index_entry == NULL)
+		return;
+	pthread_mutex_t *name_mutex = blob_stripe(index_entry->name_hash);
+	lock_blob_stripes(item_mutex, name_mutex);
+	if (find_blob_by_item(item, item_hash) == index_entry) {
+		blob_index_entry **link = &blob_item_heads[item_hash & (BLOB_HASH_SIZE - 1)];
+		while (*link != index_entry)
+			link = &(*link)->item_next;
+		*link = index_entry->item_next;
+		link = &blob_name_heads[index_entry->name_hash & (BLOB_HASH_SIZE - 1)];
+		while (*link != index_entry)
+			link = &(*link)->name_next;
+		*link = index_entry->name_next;
+		indigo_blob_entry *entry = &index_entry->entry;
+		pthread_mutex_lock(&entry->mutext);
+		indigo_release_blob_buffer(entry->buffer);
+		pthread_mutex_unlock(&entry->mutext);
+		pthread_mutex_destroy(&entry->mutext);
+		indigo_safe_free(index_entry);
+	}
+	if (name_mutex != item_mutex)
+		pthread_mutex_unlock(name_mutex);
+	pthread_mutex_unlock(item_mutex);
+}
+
+static void register_device(int slot) {
+	indigo_device *device = devices[slot];
+	if (*device->name == '@') {
+		remote_devices[remote_device_count++] = slot;
+	} else {
+		uint32_t hash = device_hash_codes[slot] = device_name_hash(device->name);
+		int *link = &device_hash_heads[hash & (DEVICE_HASH_SIZE - 1)];
+		while (*link)
+			link = &device_hash_next[*link - 1];
+		*link = slot + 1;
+		device_hash_next[slot] = 0;
+	}
+}
+
+static void unregister_device(int slot) {
+	for (int i = 0; i < remote_device_count; i++) {
+		if (remote_devices[i] == slot) {
+			memmove(remote_devices + i, remote_devices + i + 1, (--remote_device_count - i) * sizeof(int));
+			return;
+		}
+	}
+	int *link = &device_hash_heads[device_hash_codes[slot] & (DEVICE_HASH_SIZE - 1)];
+	while (*link) {
+		if (*link == slot + 1) {
+			*link = device_hash_next[slot];
+			device_hash_next[slot] = 0;
+			return;
+		}
+		link = &device_hash_next[*link - 1];
+	}
+}
+
+static int route_devices(indigo_property *property, indigo_device **targets) {
+	int count = 0;
+	if (*property->device == 0) {
+		for (int i = 0; i < MAX_DEVICES; i++) {
+			if (devices[i] != NULL)
+				targets[count++] = devices[i];
+		}
+		return count;
+	}
+	uint32_t hash = device_name_hash(property->device);
+	for (int slot = device_hash_heads[hash & (DEVICE_HASH_SIZE - 1)]; slot; slot = device_hash_next[slot - 1]) {
+		indigo_device *device = devices[slot - 1];
+		if (device != NULL && device_hash_codes[slot - 1] == hash && !strcmp(property->device, device->name))
+			targets[count++] = device;
+	}
+	for (int i = 0; i < remote_device_count; i++) {
+		indigo_device *device = devices[remote_devices[i]];
+		if (device != NULL && (!indigo_use_host_suffix || strstr(property->device, device->name)))
+			targets[count++] = device;
+	}
+	return count;
+}
+
 indigo_result indigo_start() {
 	for (int i = 1; i < indigo_main_argc; i++) {
 		if (!strcmp(indigo_main_argv[i], "-v") || !strcmp(indigo_main_argv[i], "--enable-info")) {
@@ -410,7 +613,8 @@ indigo_result indigo_start() {
 	if (!is_started) {
 		memset(devices, 0, MAX_DEVICES * sizeof(indigo_device *));
 		memset(clients, 0, MAX_CLIENTS * sizeof(indigo_client *));
-		memset(blobs, 0, MAX_BLOBS * sizeof(indigo_property *));
+		memset(device_hash_heads, 0, sizeof(device_hash_heads));
+		remote_device_count = 0;
 		memset(&INDIGO_ALL_PROPERTIES, 0, sizeof(INDIGO_ALL_PROPERTIES));
 		is_started = true;
 	}
@@ -437,6 +641,7 @@ indigo_result indigo_attach_device(indigo_device *device) {
 				INDIGO_TRACE(indigo_trace("%d devices attached", max_index + 1));
 			}
 			devices[i] = device;
+			register_device(i);
 			pthread_mutex_unlock(&device_mutex);
 			device->access_token = 0;
 			if (device->attach != NULL)
@@ -459,15 +664,14 @@ indigo_result indigo_attach_device(indigo_device *device) {
 }
 
 indigo_result indigo_attach_client(indigo_client *client) {
-	static int max_index = -1;
 	if ((!is_started) || (client == NULL))
 		return INDIGO_FAILED;
 	pthread_mutex_lock(&client_mutex);
 	for (int i = 0; i < MAX_CLIENTS; i++) {
 		if (clients[i] == NULL) {
-			if (i > max_index) {
-				max_index = i;
-				INDIGO_TRACE(indigo_trace("%d clients attached", max_index + 1));
+			if (i > max_client_index) {
+				max_client_index = i;
+				INDIGO_TRACE(indigo_trace("%d clients attached", max_client_index + 1));
 			}
 			clients[i] = client;
 			pthread_mutex_unlock(&client_mutex);
@@ -489,6 +693,7 @@ indigo_result indigo_detach_device(indigo_device *device) {
 	INDIGO_DEBUG(indigo_trace_bus("B <- Detach device '%s'", device->name));
 	for (int i = 0; i < MAX_DEVICES; i++) {
 		if (devices[i] == device) {
+			unregister_device(i);
 			devices[i] = NULL;
 			pthread_mutex_unlock(&device_mutex);
 			if (device->detach != NULL) {
@@ -525,19 +730,16 @@ indigo_result indigo_detach_client(indigo_client *client) {
 indigo_result indigo_enumerate_properties(indigo_client *client, indigo_property *property) {
 	if (!is_started)
 		return INDIGO_FAILED;
-	if (indigo_use_strict_locking)
-		pthread_mutex_lock(&device_mutex);
+	indigo_device *targets[MAX_DEVICES];
+	pthread_mutex_lock(&device_mutex);
+	int count = route_devices(property, targets);
+	if (!indigo_use_strict_locking)
+		pthread_mutex_unlock(&device_mutex);
 	INDIGO_TRACE(indigo_trace_property("Enumerate", client, property, false, false));
-	for (int i = 0; i < MAX_DEVICES; i++) {
-		indigo_device *device = devices[i];
-		if (device != NULL && device->enumerate_properties != NULL) {
-			bool route = *property->device == 0;
-			route = route || !strcmp(property->device, device->name);
-			route = route || (indigo_use_host_suffix && *device->name == '@' && strstr(property->device, device->name));
-			route = route || (!indigo_use_host_suffix && *device->name == '@');
-			if (route)
-				device->last_result = device->enumerate_properties(device, client, property);
-		}
+	for (int i = 0; i < count; i++) {
+		indigo_device *device = targets[i];
+		if (device->enumerate_properties != NULL)
+			device->last_result = device->enumerate_properties(device, client, property);
 	}
 	if (indigo_use_strict_locking)
 		pthread_mutex_unlock(&device_mutex);
@@ -547,23 +749,20 @@ indigo_result indigo_enumerate_properties(indigo_client *client, indigo_property
 indigo_result indigo_change_property(indigo_client *client, indigo_property *property) {
 	if ((!is_started) || (property == NULL))
 		return INDIGO_FAILED;
-	if (indigo_use_strict_locking)
-		pthread_mutex_lock(&device_mutex);
+	indigo_device *targets[MAX_DEVICES];
+	pthread_mutex_lock(&device_mutex);
+	int count = route_devices(property, targets);
+	if (!indigo_use_strict_locking)
+		pthread_mutex_unlock(&device_mutex);
 	INDIGO_TRACE(indigo_trace_property("Change", client, property, false, true));
-	for (int i = 0; i < MAX_DEVICES; i++) {
-		indigo_device *device = devices[i];
-		if (device != NULL && device->change_property != NULL) {
-			bool route = *property->device == 0;
-			route = route || !strcmp(property->device, device->name);
-			route = route || (indigo_use_host_suffix && *device->name == '@' && strstr(property->device, device->name));
-			route = route || (!indigo_use_host_suffix && *device->name == '@');
-			if (route) {
-				if (device->access_token != 0 && device->access_token != property->access_token && property->access_token != indigo_get_master_token()) {
-					indigo_send_message(device, "Device '%s' is protected or locked for exclusive access", device->name);
-					continue;
-				}
-				device->last_result = device->change_property(device, client, property);
+	for (int i = 0; i < count; i++) {
+		indigo_device *device = targets[i];
+		if (device->change_property != NULL) {
+			if (device->access_token != 0 && device->access_token != property->access_token && property->access_token != indigo_get_master_token()) {
+				indigo_send_message(device, "Device '%s' is protected or locked for exclusive access", device->name);
+				continue;
 			}
+			device->last_result = device->change_property(device, client, property);
 		}
 	}
 	if (indigo_use_strict_locking)
@@ -574,19 +773,16 @@ indigo_result indigo_change_property(indigo_client *client, indigo_property *pro
 indigo_result indigo_enable_blob(indigo_client *client, indigo_property *property, indigo_enable_blob_mode mode) {
 	if ((!is_started) || (property == NULL))
 		return INDIGO_FAILED;
-	if (indigo_use_strict_locking)
-		pthread_mutex_lock(&device_mutex);
+	indigo_device *targets[MAX_DEVICES];
+	pthread_mutex_lock(&device_mutex);
+	int count = route_devices(property, targets);
+	if (!indigo_use_strict_locking)
+		pthread_mutex_unlock(&device_mutex);
 	INDIGO_TRACE(indigo_trace_property("Enable BLOB mode", client, property, false, true));
-	for (int i = 0; i < MAX_DEVICES; i++) {
-		indigo_device *device = devices[i];
-		if (device != NULL && device->enable_blob != NULL) {
-			bool route = *property->device == 0;
-			route = route || !strcmp(property->device, device->name);
-			route = route || (indigo_use_host_suffix && *device->name == '@' && strstr(property->device, device->name));
-			route = route || (!indigo_use_host_suffix && *device->name == '@');
-			if (route)
-				device->last_result = device->enable_blob(device, client, property, mode);
-		}
+	for (int i = 0; i < count; i++) {
+		indigo_device *device = targets[i];
+		if (device->enable_blob != NULL)
+			device->last_result = device->enable_blob(device, client, property, mode);
 	}
 	if (indigo_use_strict_locking)
 		pthread_mutex_unlock(&device_mutex);
@@ -609,39 +805,12 @@ indigo_result indigo_define_property(indigo_device *device, indigo_property *pro
 			va_end(args);
 		}
 		if (indigo_use_blob_caching && property->type == INDIGO_BLOB_VECTOR && property->perm == INDIGO_WO_PERM) {
-			pthread_mutex_lock(&blob_mutex);
 			for (int i = 0; i < property->count; i++) {
-				indigo_item *item = property->items + i;
-				indigo_blob_entry *entry = NULL;
-				int free_index = -1;
-				for (int j = 0; j < MAX_BLOBS; j++) {
-					entry = blobs[j];
-					if (entry && entry->item == item) {
-						break;
-					}
-					if (entry == NULL && free_index == -1)
-						free_index = j;
-					entry = NULL;
-				}
-				if (entry == NULL && free_index >= 0) {
-					entry = indigo_safe_malloc(sizeof(indigo_blob_entry));
-					blobs[free_index] = entry;
-					memset(entry, 0, sizeof(indigo_blob_entry));
-					entry->item = item;
-					entry->property = property;
-					pthread_mutex_init(&entry->mutext, NULL);
-				}
-				if (entry == NULL) {
-					pthread_mutex_unlock(&blob_mutex);
-					if (indigo_use_strict_locking)
-						pthread_mutex_unlock(&client_mutex);
-					indigo_error("[%s:%d] Max BLOB count reached", __FUNCTION__, __LINE__);
-					return INDIGO_TOO_MANY_ELEMENTS;
-				}
+				blob_index_entry *index_entry = acquire_blob_entry(property, property->items + i);
+				pthread_mutex_unlock(blob_stripe(index_entry->item_hash));
 			}
-			pthread_mutex_unlock(&blob_mutex);
 		}
-		for (int i = 0; i < MAX_CLIENTS; i++) {
+		for (int i = 0; i <= max_client_index; i++) {
 			indigo_client *client = clients[i];
 			if (client != NULL && client->define_property != NULL)
 				client->last_result = client->define_property(client, device, property, format != NULL ? message : NULL);
@@ -670,51 +839,32 @@ indigo_result indigo_update_property(indigo_device *device, indigo_property *pro
 			va_end(args);
 		}
 		if (indigo_use_blob_caching && property->type == INDIGO_BLOB_VECTOR && property->perm == INDIGO_RO_PERM && property->state == INDIGO_OK_STATE) {
-			pthread_mutex_lock(&blob_mutex);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = property->items + i;
-				indigo_blob_entry *entry = NULL;
-				int free_index = -1;
-				for (int j = 0; j < MAX_BLOBS; j++) {
-					entry = blobs[j];
-					if (entry && entry->item == item) {
-						break;
-					}
-					if (entry == NULL && free_index == -1)
-						free_index = j;
-					entry = NULL;
-				}
-				if (entry == NULL && free_index >= 0) {
-					entry = indigo_safe_malloc(sizeof(indigo_blob_entry));
-					blobs[free_index] = entry;
-					memset(entry, 0, sizeof(indigo_blob_entry));
-					entry->item = item;
-					entry->property = property;
-					pthread_mutex_init(&entry->mutext, NULL);
-				}
-				if (entry) {
-					pthread_mutex_lock(&entry->mutext);
-					if (item->blob.size) {
-						entry->content = indigo_safe_realloc(entry->content, entry->size = item->blob.size);
-						memcpy(entry->content, item->blob.value, entry->size);
-						strcpy(entry->format, item->blob.format);
-					} else if (entry->content) {
-						free(entry->content);
-						entry->size = 0;
-						entry->content = NULL;
+				indigo_blob_buffer *buffer = NULL;
+				if (item->blob.size) {
+					if ((buffer = indigo_get_blob_item_buffer(item))) {
+						indigo_retain_blob_buffer(buffer);
+					} else {
+						buffer = indigo_create_blob_buffer(item->blob.size);
+						memcpy(buffer->data, item->blob.value, item->blob.size);
 					}
-					pthread_mutex_unlock(&entry->mutext);
-				} else {
-					pthread_mutex_unlock(&blob_mutex);
-					if (indigo_use_strict_locking)
-						pthread_mutex_unlock(&client_mutex);
-					indigo_error("[%s:%d] Max BLOB count reached", __FUNCTION__, __LINE__);
-					return INDIGO_TOO_MANY_ELEMENTS;
 				}
+				blob_index_entry *index_entry = acquire_blob_entry(property, item);
+				indigo_blob_entry *entry = &index_entry->entry;
+				pthread_mutex_lock(&entry->mutext);
+				indigo_blob_buffer *previous = entry->buffer;
+				entry->buffer = buffer;
+				entry->content = buffer ? buffer->data : NULL;
+				entry->size = buffer ? buffer->size : 0;
+				if (buffer)
+					strcpy(entry->format, item->blob.format);
+				pthread_mutex_unlock(&entry->mutext);
+				pthread_mutex_unlock(blob_stripe(index_entry->item_hash));
+				indigo_release_blob_buffer(previous);
 			}
-			pthread_mutex_unlock(&blob_mutex);
 		}
-		for (int i = 0; i < MAX_CLIENTS; i++) {
+		for (int i = 0; i <= max_client_index; i++) {
 			indigo_client *client = clients[i];
 			if (client != NULL && client->update_property != NULL)
 				client->last_result = client->update_property(client, device, property, format != NULL ? message : NULL);
@@ -741,7 +891,7 @@ indigo_result indigo_delete_property(indigo_device *device, indigo_property *pro
 			vsnprintf(message, INDIGO_VALUE_SIZE, format, args);
 			va_end(args);
 		}
-		for (int i = 0; i < MAX_CLIENTS; i++) {
+		for (int i = 0; i <= max_client_index; i++) {
 			indigo_client *client = clients[i];
 			if (client != NULL && client->delete_property != NULL)
 				client->last_result = client->delete_property(client, device, property, format != NULL ? message : NULL);
@@ -765,7 +915,7 @@ indigo_result indigo_send_message(indigo_device *device, const char *format, ...
 		va_end(args);
 	}
 	INDIGO_DEBUG(indigo_trace_bus("B <- Sent message '%s'", message));
-	for (int i = 0; i < MAX_CLIENTS; i++) {
+	for (int i = 0; i <= max_client_index; i++) {
 		indigo_client *client = clients[i];
 		if (client != NULL && client->send_message != NULL)
 			client->last_result = client->send_message(client, device, format != NULL ? message : NULL);
@@ -779,7 +929,7 @@ indigo_result indigo_stop() {
 	INDIGO_DEBUG(indigo_trace_bus("B <- Stop bus"));
 	if (is_started) {
 		pthread_mutex_lock(&client_mutex);
-		for (int i = 0; i < MAX_CLIENTS; i++) {
+		for (int i = 0; i <= max_client_index; i++) {
 			indigo_client *client = clients[i];
 			if (client != NULL && client->detach != NULL) {
 				clients[i] = NULL;
@@ -797,6 +947,7 @@ indigo_result indigo_stop() {
 			}
 		}
 		pthread_mutex_unlock(&device_mutex);
+		close_http_connections();
 		is_started = false;
 	}
 	return INDIGO_OK;
@@ -954,10 +1105,19 @@ indigo_property *indigo_copy_property(indigo_property *copy, indigo_property *pr
 	if (copy == NULL) {
 		copy = indigo_safe_malloc(sizeof(indigo_property) + property->allocated_count * sizeof(indigo_item));
 	} else {
+		for (int k = 0; k < copy->count; k++) {
+			if (copy->type == INDIGO_BLOB_VECTOR)
+				indigo_set_blob_item_buffer(copy->items + k, NULL);
+			else if (copy->type == INDIGO_TEXT_VECTOR)
+				indigo_safe_free(copy->items[k].text.long_value);
+		}
 		copy = indigo_resize_property(copy, property->count);
 	}
 	memcpy(copy, property, sizeof(indigo_property) + property->count * sizeof(indigo_item));
-	if (copy->type == INDIGO_TEXT_VECTOR) {
+	if (copy->type == INDIGO_BLOB_VECTOR) {
+		for (int k = 0; k < copy->count; k++)
+			indigo_retain_blob_buffer(copy->items[k].blob.buffer);
+	} else if (copy->type == INDIGO_TEXT_VECTOR) {
 		for (int k = 0; k < copy->count; k++) {
 			indigo_item *item = copy->items + k;
 			if (item->text.long_value) {
@@ -981,26 +1141,14 @@ void indigo_release_property(indigo_property *property) {
 	if (property == NULL)
 		return;
 	if (property->type == INDIGO_BLOB_VECTOR) {
-		pthread_mutex_lock(&blob_mutex);
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = property->items + i;
-			for (int j = 0; j < MAX_BLOBS; j++) {
-				indigo_blob_entry *entry = blobs[j];
-				if (entry && entry->item == item) {
-					pthread_mutex_lock(&entry->mutext);
-					blobs[j] = NULL;
-					indigo_safe_free(entry->content);
-					pthread_mutex_unlock(&entry->mutext);
-					pthread_mutex_destroy(&entry->mutext);
-					indigo_safe_free(entry);
-					break;
-				}
-			}
+			remove_blob_entry(item);
+			indigo_release_blob_buffer(item->blob.buffer);
 			if (property->perm == INDIGO_WO_PERM) {
 				indigo_safe_free(item->blob.value);
 			}
 		}
-		pthread_mutex_unlock(&blob_mutex);
 	} else if (property->type == INDIGO_TEXT_VECTOR) {
 		for (int i = 0; i < property->count; i++)
 			indigo_safe_free(property->items[i].text.long_value);
@@ -1009,27 +1157,29 @@ void indigo_release_property(indigo_property *property) {
 }
 
 indigo_blob_entry *indigo_validate_blob(indigo_item *item) {
-	for (int j = 0; j < MAX_BLOBS; j++) {
-		indigo_blob_entry *entry = blobs[j];
-		if (entry && entry->item == item)
-			return entry;
-	}
-	return NULL;
+	uint32_t item_hash = blob_item_hash(item);
+	pthread_mutex_t *item_mutex = blob_stripe(item_hash);
+	pthread_mutex_lock(item_mutex);
+	blob_index_entry *index_entry = find_blob_by_item(item, item_hash);
+	pthread_mutex_unlock(item_mutex);
+	return index_entry ? &index_entry->entry : NULL;
 }
 
 indigo_blob_entry *indigo_find_blob(indigo_property *other_property, indigo_item *other_item) {
 	assert(other_property != NULL);
 	assert(other_item != NULL);
-	for (int j = 0; j < MAX_BLOBS; j++) {
-		indigo_blob_entry *entry = blobs[j];
-		if (entry) {
-			indigo_property *property = entry->property;
-			indigo_item *item = entry->item;
-			if (!strncmp(property->device, other_property->device, INDIGO_NAME_SIZE) && !strncmp(property->name, other_property->name, INDIGO_NAME_SIZE) && !strncmp(item->name, other_item->name, INDIGO_NAME_SIZE))
-				return entry;
-		}
+	uint32_t name_hash = blob_name_hash(other_property->device, other_property->name, other_item->name);
+	pthread_mutex_t *name_mutex = blob_stripe(name_hash);
+	pthread_mutex_lock(name_mutex);
+	blob_index_entry *index_entry = blob_name_heads[name_hash & (BLOB_HASH_SIZE - 1)];
+	for (; index_entry; index_entry = index_entry->name_next) {
+		indigo_property *property = index_entry->entry.property;
+		indigo_item *item = index_entry->entry.item;
+		if (index_entry->name_hash == name_hash && !strncmp(property->device, other_property->device, INDIGO_NAME_SIZE) && !strncmp(property->name, other_property->name, INDIGO_NAME_SIZE) && !strncmp(item->name, other_item->name, INDIGO_NAME_SIZE))
+			break;
 	}
-	return NULL;
+	pthread_mutex_unlock(name_mutex);
+	return index_entry ? &index_entry->entry : NULL;
 }
 
 void indigo_init_text_item(indigo_item *item, const char *name, const char *label, const char *format, ...) {
@@ -1101,224 +1251,367 @@ void *indigo_alloc_blob_buffer(long size) {
 	return indigo_safe_malloc(size);
 }
 
-bool indigo_populate_http_blob_item(indigo_item *blob_item) {
-	char *host = indigo_safe_malloc(BUFFER_SIZE);
-	int port = 80;
-	char *file = indigo_safe_malloc(BUFFER_SIZE);
-	char *request = indigo_safe_malloc(BUFFER_SIZE);
-	char *http_line = indigo_safe_malloc(BUFFER_SIZE);
-	char *http_response = indigo_safe_malloc(BUFFER_SIZE);
-	long content_len = 0;
-	long uncompressed_content_len = 0;
-	int http_result = 0;
-	char *image_type;
-	int socket = -1;
-	int res = false;
+#define BLOB_BUFFER_HEADER_SIZE	((sizeof(indigo_blob_buffer) + 63) & ~63)
 
-	if ((blob_item->blob.url[0] == '\0') || strcmp(blob_item->name, CCD_IMAGE_ITEM_NAME)) {
-		indigo_error("%s: url == \"\" or item != \"%s\"", __FUNCTION__, CCD_IMAGE_ITEM_NAME);
-		goto clean_return;
+indigo_blob_buffer *indigo_create_blob_buffer(long size) {
+	indigo_blob_buffer *buffer = malloc(BLOB_BUFFER_HEADER_SIZE + size);
+	assert(buffer != NULL);
+	buffer->data = (char *)buffer + BLOB_BUFFER_HEADER_SIZE;
+	buffer->size = size;
+	buffer->reference_count = 1;
+	buffer->allocated = NULL;
+	return buffer;
+}
+
+indigo_blob_buffer *indigo_wrap_blob_buffer(void *data, long size) {
+	indigo_blob_buffer *buffer = indigo_safe_malloc(sizeof(indigo_blob_buffer));
+	buffer->data = buffer->allocated = data;
+	buffer->size = size;
+	buffer->reference_count = 1;
+	return buffer;
+}
+
+indigo_blob_buffer *indigo_retain_blob_buffer(indigo_blob_buffer *buffer) {
+	if (buffer) {
+		pthread_mutex_lock(&blob_buffer_mutex);
+		buffer->reference_count++;
+		pthread_mutex_unlock(&blob_buffer_mutex);
 	}
+	return buffer;
+}
 
-	sscanf(blob_item->blob.url, "http://%255[^:]:%5d/%256[^\n]", host, &port, file);
-	socket = indigo_open_tcp(host, port);
-	if (socket < 0)
-		goto clean_return;
+void indigo_release_blob_buffer(indigo_blob_buffer *buffer) {
+	if (buffer) {
+		pthread_mutex_lock(&blob_buffer_mutex);
+		bool last = --buffer->reference_count == 0;
+		pthread_mutex_unlock(&blob_buffer_mutex);
+		if (last) {
+			indigo_safe_free(buffer->allocated);
+			free(buffer);
+		}
+	}
+}
 
-	INDIGO_TRACE(indigo_trace("%d <- // open for '%s:%d'", socket, host, port));
+void indigo_set_blob_item_buffer(indigo_item *item, indigo_blob_buffer *buffer) {
+	indigo_blob_buffer *previous = item->blob.buffer;
+	item->blob.buffer = buffer;
+	if (buffer) {
+		item->blob.value = buffer->data;
+		item->blob.size = buffer->size;
+	}
+	indigo_release_blob_buffer(previous);
+}
+
+indigo_blob_buffer *indigo_get_blob_item_buffer(indigo_item *item) {
+	indigo_blob_buffer *buffer = item->blob.buffer;
+	if (buffer && buffer->data == item->blob.value && buffer->size == item->blob.size)
+		return buffer;
+	return NULL;
+}
+
+// keep-alive HTTP connections used to populate and upload BLOBs, idle connections are kept per host and port
+
+#define HTTP_IDLE_TIMEOUT				30
+#define HTTP_MAX_IDLE_PER_HOST	4
+#define HTTP_CHUNK_SIZE					(64 * 1024)
+
+typedef struct http_connection {
+	char host[BUFFER_SIZE];
+	int port;
+	int socket;
+	time_t last_used;
+	indigo_reader reader;
+	char line[BUFFER_SIZE];
+	char request[2 * BUFFER_SIZE + 128];	// file name, host name and fixed header text
+	struct http_connection *next;
+} http_connection;
+
+static http_connection *http_connections = NULL;
+static pthread_mutex_t http_connections_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+static void close_http_socket(int socket) {
 #if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
-	snprintf(request, BUFFER_SIZE, "GET /%s HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n", file);
-#else
-	snprintf(request, BUFFER_SIZE, "GET /%s HTTP/1.1\r\n\r\n", file);
+	shutdown(socket, SHUT_RDWR);
+	close(socket);
 #endif
-	INDIGO_TRACE(indigo_trace("%d <- %s", socket, request));
-	res = indigo_write(socket, request, strlen(request));
-	if (res == false)
-		goto clean_return;
-
-	res = indigo_read_line(socket, http_line, BUFFER_SIZE);
+#if defined(INDIGO_WINDOWS)
+	shutdown(socket, SD_BOTH);
+	closesocket(socket);
+#endif
+}
 
-	if (res < 0) {
-		res = false;
-		goto clean_return;
+static void release_http_connection(http_connection *connection, bool keep_alive) {
+	if (keep_alive) {
+		connection->last_used = time(NULL);
+		pthread_mutex_lock(&http_connections_mutex);
+		int count = 0;
+		for (http_connection *idle = http_connections; idle; idle = idle->next)
+			if (idle->port == connection->port && !strcmp(idle->host, connection->host))
+				count++;
+		if (count < HTTP_MAX_IDLE_PER_HOST) {
+			connection->next = http_connections;
+			http_connections = connection;
+			connection = NULL;
+		}
+		pthread_mutex_unlock(&http_connections_mutex);
+	}
+	if (connection) {
+		INDIGO_TRACE(indigo_trace("%d <- // closed", connection->socket));
+		close_http_socket(connection->socket);
+		free(connection);
+	}
+}
+
+static http_connection *acquire_http_connection(const char *host, int port, bool *reused) {
+	http_connection *connection = NULL, *expired = NULL;
+	time_t now = time(NULL);
+	pthread_mutex_lock(&http_connections_mutex);
+	http_connection **previous = &http_connections;
+	while (*previous) {
+		http_connection *idle = *previous;
+		if (now - idle->last_used > HTTP_IDLE_TIMEOUT) {
+			*previous = idle->next;
+			idle->next = expired;
+			expired = idle;
+		} else if (connection == NULL && idle->port == port && !strcmp(idle->host, host)) {
+			*previous = idle->next;
+			connection = idle;
+		} else {
+			previous = &idle->next;
+		}
 	}
-	INDIGO_TRACE(indigo_trace("%d -> %s", socket, http_line));
-
-	int count = sscanf(http_line, "HTTP/1.1 %d %255[^\n]", &http_result, http_response);
-	if ((count != 2) || (http_result != 200)) {
-		goto clean_return;
+	pthread_mutex_unlock(&http_connections_mutex);
+	while (expired) {
+		http_connection *next = expired->next;
+		release_http_connection(expired, false);
+		expired = next;
 	}
-	
-	bool use_gzip = false;
-
+	*reused = connection != NULL;
+	if (connection) {
+		INDIGO_TRACE(indigo_trace("%d <- // reused for '%s:%d'", connection->socket, host, port));
+		return connection;
+	}
+	int socket = indigo_open_tcp(host, port);
+	if (socket < 0)
+		return NULL;
+	INDIGO_TRACE(indigo_trace("%d <- // open for '%s:%d'", socket, host, port));
 	/* On Raspberry Pi blob compression may take longer. Make sure we do not timeout prematurely */
 	struct timeval timeout;
 	timeout.tv_sec = 15;
 	timeout.tv_usec = 0;
 	setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout, sizeof(timeout));
+	connection = indigo_safe_malloc(sizeof(http_connection));
+	indigo_copy_value(connection->host, host);
+	connection->port = port;
+	connection->socket = socket;
+	indigo_init_reader(&connection->reader, socket);
+	return connection;
+}
 
+static void close_http_connections(void) {
+	pthread_mutex_lock(&http_connections_mutex);
+	http_connection *connection = http_connections;
+	http_connections = NULL;
+	pthread_mutex_unlock(&http_connections_mutex);
+	while (connection) {
+		http_connection *next = connection->next;
+		release_http_connection(connection, false);
+		connection = next;
+	}
+}
+
+/* read status line and headers, returns HTTP status or -1 if connection failed */
+
+static int read_http_response_header(http_connection *connection, long *content_len, long *uncompressed_content_len, bool *use_gzip, bool *keep_alive) {
+	int http_result = 0;
+	*content_len = *uncompressed_content_len = 0;
+	*use_gzip = false;
+	*keep_alive = true;
+	if (indigo_reader_read_line(&connection->reader, connection->line, BUFFER_SIZE) < 0)
+		return -1;
+	INDIGO_TRACE(indigo_trace("%d -> %s", connection->socket, connection->line));
+	if (sscanf(connection->line, "HTTP/1.%*d %d", &http_result) != 1)
+		return -1;
+	if (!strncmp(connection->line, "HTTP/1.0", 8))
+		*keep_alive = false;
 	do {
-		res = indigo_read_line(socket, http_line, BUFFER_SIZE);
-		if (res < 0) {
+		if (indigo_reader_read_line(&connection->reader, connection->line, BUFFER_SIZE) < 0)
+			return -1;
+		INDIGO_TRACE(indigo_trace("%d -> %s", connection->socket, connection->line));
+		if (!strncasecmp(connection->line, "Content-Encoding: gzip", 22))
+			*use_gzip = true;
+		else if (!strncasecmp(connection->line, "Content-Length:", 15))
+			*content_len = atol(connection->line + 15);
+		else if (!strncasecmp(connection->line, "X-Uncompressed-Content-Length:", 30))
+			*uncompressed_content_len = atol(connection->line + 30);
+		else if (!strncasecmp(connection->line, "Connection: close", 17))
+			*keep_alive = false;
+	} while (connection->line[0] != '\0');
+	/* error responses of INDIGO server are not delimited by content length, connection is closed after them */
+	if (http_result != 200 && *content_len == 0)
+		*keep_alive = false;
+	return http_result;
+}
+
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+
+/* inflate gzip stream directly from the connection into the destination buffer */
+
+static bool read_gzip_content(http_connection *connection, long content_len, void *value, long size) {
+	unsigned char *chunk = indigo_safe_malloc(HTTP_CHUNK_SIZE);
+	z_stream stream = { 0 };
+	int result = inflateInit2(&stream, 15 + 16);
+	stream.next_out = value;
+	stream.avail_out = (unsigned)size;
+	bool res = result == Z_OK;
+	while (res && content_len > 0) {
+		long length = content_len < HTTP_CHUNK_SIZE ? content_len : HTTP_CHUNK_SIZE;
+		if (indigo_reader_read(&connection->reader, (char *)chunk, length) <= 0) {
 			res = false;
-			goto clean_return;
+			break;
 		}
-		INDIGO_TRACE(indigo_trace("%d -> %s", socket, http_line));
-#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
-		if (!strncasecmp(http_line, "Content-Encoding: gzip", 22)) {
-			use_gzip = true;
-			continue;
+		content_len -= length;
+		stream.next_in = chunk;
+		stream.avail_in = (unsigned)length;
+		result = inflate(&stream, Z_NO_FLUSH);
+		if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+			indigo_error("%d -> // inflate failed (%d)", connection->socket, result);
+			res = false;
 		}
+	}
+	if (res && stream.total_out != size) {
+		indigo_error("%d -> // inflated %ld bytes, expected %ld", connection->socket, (long)stream.total_out, size);
+		res = false;
+	}
+	inflateEnd(&stream);
+	free(chunk);
+	return res;
+}
+
 #endif
-		if (sscanf(http_line, "Content-Length: %20ld[^\n]", &content_len) == 1)
-			continue;
-		if (sscanf(http_line, "X-Uncompressed-Content-Length: %20ld[^\n]", &uncompressed_content_len) == 1)
-			continue;
-	} while (http_line[0] != '\0');
 
-	if (content_len) {
-		image_type = strrchr(file, '.');
-		if (image_type)
-			indigo_copy_name(blob_item->blob.format, image_type);
+/* returns 1 on success, 0 on HTTP error and -1 if connection failed */
+
+static int populate_http_blob_item(http_connection *connection, indigo_item *blob_item, const char *file, bool *keep_alive) {
+	long content_len = 0;
+	long uncompressed_content_len = 0;
+	bool use_gzip = false;
+	*keep_alive = false;
 #if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
-		if (use_gzip) {
-			blob_item->blob.size = uncompressed_content_len;
-			blob_item->blob.value = indigo_safe_realloc(blob_item->blob.value, blob_item->blob.size);
-			char *compressed_buffer = indigo_safe_malloc(content_len);
-			res = (indigo_read(socket, compressed_buffer, content_len) >= 0) ? true : false;
-			if (res) {
-				unsigned out_size = (unsigned)uncompressed_content_len;
-				indigo_decompress(compressed_buffer, (unsigned)content_len, blob_item->blob.value, &out_size);
-			}
-			free(compressed_buffer);
-		} else {
-			blob_item->blob.size = content_len;
-			blob_item->blob.value = indigo_safe_realloc(blob_item->blob.value, blob_item->blob.size);
-			INDIGO_TRACE(indigo_trace("%d -> // %d bytes", socket, blob_item->blob.size));
-			res = (indigo_read(socket, blob_item->blob.value, blob_item->blob.size) >= 0) ? true : false;
-		}
+	snprintf(connection->request, sizeof(connection->request), "GET /%s HTTP/1.1\r\nHost: %s:%d\r\nConnection: keep-alive\r\nAccept-Encoding: gzip\r\n\r\n", file, connection->host, connection->port);
 #else
-		blob_item->blob.size = content_len;
-		blob_item->blob.value = indigo_safe_realloc(blob_item->blob.value, blob_item->blob.size);
-		INDIGO_TRACE(indigo_trace("%d -> // %d bytes", socket, blob_item->blob.size));
-		res = (indigo_read(socket, blob_item->blob.value, blob_item->blob.size) >= 0) ? true : false;
+	snprintf(connection->request, sizeof(connection->request), "GET /%s HTTP/1.1\r\nHost: %s:%d\r\nConnection: keep-alive\r\n\r\n", file, connection->host, connection->port);
 #endif
-	} else {
-		res = false;
+	INDIGO_TRACE(indigo_trace("%d <- %s", connection->socket, connection->request));
+	if (!indigo_write(connection->socket, connection->request, strlen(connection->request)))
+		return -1;
+	int http_result = read_http_response_header(connection, &content_len, &uncompressed_content_len, &use_gzip, keep_alive);
+	if (http_result < 0) {
+		*keep_alive = false;
+		return -1;
 	}
-
-clean_return:
-	if (!res || socket < 0)
-		INDIGO_TRACE(indigo_trace("%d -> // %s", socket, strerror(errno)));
-	if (socket >= 0) {
+	if (http_result != 200 || content_len == 0) {
+		if (content_len > 0)
+			*keep_alive = false;
+		return 0;
+	}
+	const char *image_type = strrchr(file, '.');
+	if (image_type)
+		indigo_copy_name(blob_item->blob.format, image_type);
+	bool res;
 #if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
-		shutdown(socket, SHUT_RDWR);
-		close(socket);
-#endif
-#if defined(INDIGO_WINDOWS)
-		shutdown(socket, SD_BOTH);
-		closesocket(socket);
+	if (use_gzip) {
+		blob_item->blob.size = uncompressed_content_len;
+		blob_item->blob.value = indigo_safe_realloc(blob_item->blob.value, blob_item->blob.size);
+		res = read_gzip_content(connection, content_len, blob_item->blob.value, blob_item->blob.size);
+	} else
 #endif
+	{
+		blob_item->blob.size = content_len;
+		blob_item->blob.value = indigo_safe_realloc(blob_item->blob.value, blob_item->blob.size);
+		INDIGO_TRACE(indigo_trace("%d -> // %ld bytes", connection->socket, blob_item->blob.size));
+		res = indigo_reader_read(&connection->reader, blob_item->blob.value, blob_item->blob.size) > 0;
 	}
-	indigo_safe_free(host);
-	indigo_safe_free(file);
-	indigo_safe_free(request);
-	indigo_safe_free(http_line);
-	indigo_safe_free(http_response);
-	return res;
+	if (!res) {
+		*keep_alive = false;
+		return -1;
+	}
+	return 1;
 }
 
-bool indigo_upload_http_blob_item(indigo_item *blob_item) {
-	char *host = indigo_safe_malloc(BUFFER_SIZE);
+bool indigo_populate_http_blob_item(indigo_item *blob_item) {
+	char host[BUFFER_SIZE];
+	char file[BUFFER_SIZE];
 	int port = 80;
-	char *file = indigo_safe_malloc(BUFFER_SIZE);
-	char *request = indigo_safe_malloc(BUFFER_SIZE);
-	char *http_line = indigo_safe_malloc(BUFFER_SIZE);
-	char *http_response = indigo_safe_malloc(BUFFER_SIZE);
-	int http_result = 0;
-	int socket = -1;
-	int res = false;
-
 	if ((blob_item->blob.url[0] == '\0') || strcmp(blob_item->name, CCD_IMAGE_ITEM_NAME)) {
-		indigo_error("%s(): url == \"\" or item != \"%s\"", __FUNCTION__, CCD_IMAGE_ITEM_NAME);
-		goto clean_return;
+		indigo_error("%s: url == \"\" or item != \"%s\"", __FUNCTION__, CCD_IMAGE_ITEM_NAME);
+		return false;
 	}
-
 	sscanf(blob_item->blob.url, "http://%255[^:]:%5d/%256[^\n]", host, &port, file);
-	socket = indigo_open_tcp(host, port);
-	if (socket < 0)
-		goto clean_return;
-	INDIGO_TRACE(indigo_trace("%d <- // open for '%s:%d'", socket, host, port));
-
-//#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
-#if false
-	unsigned char *out_buffer = indigo_safe_malloc(blob_item->blob.size);
-	unsigned int out_size = blob_item->blob.size;
-	if (out_buffer == NULL)
-		goto clean_return;
-	indigo_compress("image", blob_item->blob.value, (unsigned int)blob_item->blob.size, out_buffer, &out_size);
-	snprintf(request, BUFFER_SIZE, "PUT /%s HTTP/1.1\r\nContent-Encoding: gzip\r\nContent-Length: %d\r\nX-Uncompressed-Content-Length: %ld\r\n\r\n", file, out_size, blob_item->blob.size);
-	INDIGO_TRACE(indigo_trace("%d <- %s", request));
-	res = indigo_write(socket, request, strlen(request));
-	if (res == false)
-		goto clean_return;
-	INDIGO_TRACE(indigo_trace("%d <- // %d bytes", socket, blob_item->blob.size));
-	res = indigo_write(socket, (const char *)out_buffer, out_size);
-	indigo_safe_free(out_buffer);
-	if (res == false)
-		goto clean_return;
-#else
-	snprintf(request, BUFFER_SIZE, "PUT /%s HTTP/1.1\r\nContent-Length: %ld\r\n\r\n", file, blob_item->blob.size);
-	INDIGO_TRACE(indigo_trace("%d <- %s", socket, request));
-	res = indigo_write(socket, request, strlen(request));
-	if (res == false)
-		goto clean_return;
-	INDIGO_TRACE(indigo_trace("%d <- // %d bytes", socket, blob_item->blob.size));
-	res = indigo_write(socket, blob_item->blob.value, blob_item->blob.size);
-	if (res == false)
-		goto clean_return;
-#endif
-
-	res = indigo_read_line(socket, http_line, BUFFER_SIZE);
-	INDIGO_TRACE(indigo_trace("%d -> %s", socket, http_line));
-	if (res < 0) {
-		res = false;
-		goto clean_return;
+	/* idle connection may be already closed by server, retry once with the new one */
+	for (int attempt = 0; attempt < 2; attempt++) {
+		bool reused, keep_alive;
+		http_connection *connection = acquire_http_connection(host, port, &reused);
+		if (connection == NULL)
+			break;
+		int res = populate_http_blob_item(connection, blob_item, file, &keep_alive);
+		int socket = connection->socket;
+		release_http_connection(connection, keep_alive);
+		if (res > 0)
+			return true;
+		INDIGO_TRACE(indigo_trace("%d -> // %s", socket, strerror(errno)));
+		if (res == 0 || !reused)
+			break;
 	}
+	return false;
+}
 
-	int count = sscanf(http_line, "HTTP/1.1 %d %255[^\n]", &http_result, http_response);
-	if ((count != 2) || (http_result != 200)) {
-		goto clean_return;
+static int upload_http_blob_item(http_connection *connection, indigo_item *blob_item, const char *file, bool *keep_alive) {
+	long content_len = 0;
+	long uncompressed_content_len = 0;
+	bool use_gzip = false;
+	*keep_alive = false;
+	snprintf(connection->request, sizeof(connection->request), "PUT /%s HTTP/1.1\r\nHost: %s:%d\r\nConnection: keep-alive\r\nContent-Length: %ld\r\n\r\n", file, connection->host, connection->port, blob_item->blob.size);
+	INDIGO_TRACE(indigo_trace("%d <- %s", connection->socket, connection->request));
+	if (!indigo_write(connection->socket, connection->request, strlen(connection->request)))
+		return -1;
+	INDIGO_TRACE(indigo_trace("%d <- // %ld bytes", connection->socket, blob_item->blob.size));
+	if (!indigo_write(connection->socket, blob_item->blob.value, blob_item->blob.size))
+		return -1;
+	int http_result = read_http_response_header(connection, &content_len, &uncompressed_content_len, &use_gzip, keep_alive);
+	if (http_result < 0) {
+		*keep_alive = false;
+		return -1;
 	}
-	do {
-		res = indigo_read_line(socket, http_line, BUFFER_SIZE);
-		INDIGO_TRACE(indigo_trace("%d -> %s", socket, http_line));
-		if (res < 0) {
-			res = false;
-			goto clean_return;
-		}
-	} while (http_line[0] != '\0');
+	if (content_len > 0)
+		*keep_alive = false;
+	return http_result == 200;
+}
 
-clean_return:
-	if (!res || socket < 0)
+bool indigo_upload_http_blob_item(indigo_item *blob_item) {
+	char host[BUFFER_SIZE];
+	char file[BUFFER_SIZE];
+	int port = 80;
+	if ((blob_item->blob.url[0] == '\0') || strcmp(blob_item->name, CCD_IMAGE_ITEM_NAME)) {
+		indigo_error("%s(): url == \"\" or item != \"%s\"", __FUNCTION__, CCD_IMAGE_ITEM_NAME);
+		return false;
+	}
+	sscanf(blob_item->blob.url, "http://%255[^:]:%5d/%256[^\n]", host, &port, file);
+	for (int attempt = 0; attempt < 2; attempt++) {
+		bool reused, keep_alive;
+		http_connection *connection = acquire_http_connection(host, port, &reused);
+		if (connection == NULL)
+			break;
+		int res = upload_http_blob_item(connection, blob_item, file, &keep_alive);
+		int socket = connection->socket;
+		release_http_connection(connection, keep_alive);
+		if (res > 0)
+			return true;
 		INDIGO_TRACE(indigo_trace("%d -> // %s", socket, strerror(errno)));
-	if (socket >= 0) {
-#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
-		shutdown(socket, SHUT_RDWR);
-		close(socket);
-#endif
-#if defined(INDIGO_WINDOWS)
-		shutdown(socket, SD_BOTH);
-		closesocket(socket);
-#endif
+		if (res == 0 || !reused)
+			break;
 	}
-	indigo_safe_free(host);
-	indigo_safe_free(file);
-	indigo_safe_free(request);
-	indigo_safe_free(http_line);
-	indigo_safe_free(http_response);
-	return res;
+	return false;
 }
 
 static bool indigo_get_hint(char *hints, const char *key, char *value) {
@@ -2019,13 +2312,22 @@ double indigo_pixel_scale(double focal_length_cm, double pixel_size_um) {
 
 bool indigo_device_name_exists(const char *name) {
 	pthread_mutex_lock(&device_mutex);
-	for(int slot = 0; slot < MAX_DEVICES; slot++) {
-		indigo_device *device = devices[slot];
-		if (device == NULL)
-			continue;
-		if (!strncmp(device->name, name, INDIGO_NAME_SIZE)) {
-			pthread_mutex_unlock(&device_mutex);
-			return true;
+	if (*name == '@') {
+		for (int i = 0; i < remote_device_count; i++) {
+			indigo_device *device = devices[remote_devices[i]];
+			if (device != NULL && !strncmp(device->name, name, INDIGO_NAME_SIZE)) {
+				pthread_mutex_unlock(&device_mutex);
+				return true;
+			}
+		}
+	} else {
+		uint32_t hash = device_name_hash(name);
+		for (int slot = device_hash_heads[hash & (DEVICE_HASH_SIZE - 1)]; slot; slot = device_hash_next[slot - 1]) {
+			indigo_device *device = devices[slot - 1];
+			if (device != NULL && device_hash_codes[slot - 1] == hash && !strncmp(device->name, name, INDIGO_NAME_SIZE)) {
+				pthread_mutex_unlock(&device_mutex);
+				return true;
+			}
 		}
 	}
 	pthread_mutex_unlock(&device_mutex);
@@ -35,6 +35,7 @@
 #include <math.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <dirent.h>
 #include <jpeglib.h>
 #include <limits.h>
 
@@ -46,6 +47,8 @@
 #include <indigo/indigo_dslr_raw.h>
 #include <indigo/indigo_md5.h>
 #include <indigo/indigo_stretch.h>
+#include <indigo/indigo_parallel.h>
+#include <indigo/indigo_xisf.h>
 
 struct indigo_jpeg_compress_struct {
 	struct jpeg_compress_struct pub;
@@ -137,6 +140,7 @@ indigo_result indigo_ccd_attach(indigo_device *device, const char* driver_name,
 		device->device_context = indigo_safe_malloc(sizeof(indigo_ccd_context));
 	}
 	if (CCD_CONTEXT != NULL) {
+		pthread_mutex_init(&CCD_CONTEXT->file_writer_mutex, NULL);
 		if (indigo_device_attach(device, driver_name, version, INDIGO_INTERFACE_CCD) == INDIGO_OK) {
 			// -------------------------------------------------------------------------------- CCD_INFO
 			CCD_INFO_PROPERTY = indigo_init_number_property(NULL, device->name, CCD_INFO_PROPERTY_NAME, CCD_MAIN_GROUP, "Info", INDIGO_OK_STATE, INDIGO_RO_PERM, 8);
@@ -269,6 +273,21 @@ indigo_result indigo_ccd_attach(indigo_device *device, const char* driver_name,
 			indigo_init_switch_item(CCD_IMAGE_FORMAT_JPEG_AVI_ITEM, CCD_IMAGE_FORMAT_JPEG_AVI_ITEM_NAME, "JPEG + AVI format", false);
 			indigo_init_switch_item(CCD_IMAGE_FORMAT_RAW_SER_ITEM, CCD_IMAGE_FORMAT_RAW_SER_ITEM_NAME, "RAW + SER format", false);
 			CCD_IMAGE_FORMAT_PROPERTY->count = 5;
+			// -------------------------------------------------------------------------------- CCD_FITS_COMPRESSION
+			CCD_FITS_COMPRESSION_PROPERTY = indigo_init_switch_property(NULL, device->name, CCD_FITS_COMPRESSION_PROPERTY_NAME, CCD_IMAGE_GROUP, "FITS compression", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 3);
+			if (CCD_FITS_COMPRESSION_PROPERTY == NULL)
+				return INDIGO_FAILED;
+			indigo_init_switch_item(CCD_FITS_COMPRESSION_NONE_ITEM, CCD_FITS_COMPRESSION_NONE_ITEM_NAME, "Uncompressed", true);
+			indigo_init_switch_item(CCD_FITS_COMPRESSION_RICE_ITEM, CCD_FITS_COMPRESSION_RICE_ITEM_NAME, "Rice tile compression", false);
+			indigo_init_switch_item(CCD_FITS_COMPRESSION_GZIP_ITEM, CCD_FITS_COMPRESSION_GZIP_ITEM_NAME, "GZIP tile compression", false);
+			// -------------------------------------------------------------------------------- CCD_XISF_COMPRESSION
+			CCD_XISF_COMPRESSION_PROPERTY = indigo_init_switch_property(NULL, device->name, CCD_XISF_COMPRESSION_PROPERTY_NAME, CCD_IMAGE_GROUP, "XISF compression", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 4);
+			if (CCD_XISF_COMPRESSION_PROPERTY == NULL)
+				return INDIGO_FAILED;
+			indigo_init_switch_item(CCD_XISF_COMPRESSION_NONE_ITEM, CCD_XISF_COMPRESSION_NONE_ITEM_NAME, "Uncompressed", true);
+			indigo_init_switch_item(CCD_XISF_COMPRESSION_ZLIB_ITEM, CCD_XISF_COMPRESSION_ZLIB_ITEM_NAME, "zlib with byte shuffling", false);
+			indigo_init_switch_item(CCD_XISF_COMPRESSION_LZ4_ITEM, CCD_XISF_COMPRESSION_LZ4_ITEM_NAME, "LZ4 with byte shuffling", false);
+			indigo_init_switch_item(CCD_XISF_COMPRESSION_LZ4HC_ITEM, CCD_XISF_COMPRESSION_LZ4HC_ITEM_NAME, "LZ4HC with byte shuffling", false);
 			// -------------------------------------------------------------------------------- CCD_IMAGE
 			CCD_IMAGE_PROPERTY = indigo_init_blob_property(NULL, device->name, CCD_IMAGE_PROPERTY_NAME, CCD_IMAGE_GROUP, "Image data", INDIGO_OK_STATE, 1);
 			if (CCD_IMAGE_PROPERTY == NULL)
@@ -326,12 +345,13 @@ indigo_result indigo_ccd_attach(indigo_device *device, const char* driver_name,
 				return INDIGO_FAILED;
 			indigo_init_text_item(CCD_REMOVE_FITS_HEADER_NAME_ITEM, CCD_REMOVE_FITS_HEADER_KEYWORD_ITEM_NAME, "Keyword", "");
 			// -------------------------------------------------------------------------------- CCD_JPEG_SETTINGS
-			CCD_JPEG_SETTINGS_PROPERTY = indigo_init_number_property(NULL, device->name, CCD_JPEG_SETTINGS_PROPERTY_NAME, CCD_IMAGE_GROUP, "JPEG Settings", INDIGO_OK_STATE, INDIGO_RW_PERM, 3);
+			CCD_JPEG_SETTINGS_PROPERTY = indigo_init_number_property(NULL, device->name, CCD_JPEG_SETTINGS_PROPERTY_NAME, CCD_IMAGE_GROUP, "JPEG Settings", INDIGO_OK_STATE, INDIGO_RW_PERM, 4);
 			if (CCD_JPEG_SETTINGS_PROPERTY == NULL)
 				return INDIGO_FAILED;
 			indigo_init_number_item(CCD_JPEG_SETTINGS_QUALITY_ITEM, CCD_JPEG_SETTINGS_QUALITY_ITEM_NAME, "Conversion quality", 10, 100, 11, 90);
 			indigo_init_number_item(CCD_JPEG_SETTINGS_TARGET_BACKGROUND_ITEM, CCD_JPEG_SETTINGS_TARGET_BACKGROUND_ITEM_NAME, "Target mean background", 0, 1, 0.05, ccd_jpeg_stretch_params_lut[CCD_JPEG_STRETCH_NORMAL].target_background);
 			indigo_init_number_item(CCD_JPEG_SETTINGS_CLIPPING_POINT_ITEM, CCD_JPEG_SETTINGS_CLIPPING_POINT_ITEM_NAME, "Clipping point", -3, 0, 0.1, ccd_jpeg_stretch_params_lut[CCD_JPEG_STRETCH_NORMAL].clipping_point);
+			indigo_init_number_item(CCD_JPEG_SETTINGS_MAX_PREVIEW_SIZE_ITEM, CCD_JPEG_SETTINGS_MAX_PREVIEW_SIZE_ITEM_NAME, "Max preview size (0 = full)", 0, 16384, 64, 0);
 			// -------------------------------------------------------------------------------- CCD_RBI_FLUSH_ENABLE
 			CCD_JPEG_STRETCH_PRESETS_PROPERTY = indigo_init_switch_property(NULL, device->name, CCD_JPEG_STRETCH_PRESETS_PROPERTY_NAME, CCD_IMAGE_GROUP, "JPEG Strecthing Presets", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_AT_MOST_ONE_RULE, 4);
 			if (CCD_JPEG_STRETCH_PRESETS_PROPERTY == NULL)
@@ -354,6 +374,33 @@ indigo_result indigo_ccd_attach(indigo_device *device, const char* driver_name,
 			CCD_RBI_FLUSH_PROPERTY->hidden = true;
 			indigo_init_number_item(CCD_RBI_FLUSH_EXPOSURE_ITEM, CCD_RBI_FLUSH_EXPOSURE_ITEM_NAME, "NIR flood time (s)", 0, 16, 0, 1);
 			indigo_init_number_item(CCD_RBI_FLUSH_COUNT_ITEM, CCD_RBI_FLUSH_COUNT_ITEM_NAME, "Number of flushes", 1, 10, 1, 3);
+			// -------------------------------------------------------------------------------- CCD_PIPELINE
+			CCD_PIPELINE_PROPERTY = indigo_init_number_property(NULL, device->name, CCD_PIPELINE_PROPERTY_NAME, CCD_ADVANCED_GROUP, "Image pipeline", INDIGO_OK_STATE, INDIGO_RO_PERM, 3);
+			if (CCD_PIPELINE_PROPERTY == NULL)
+				return INDIGO_FAILED;
+			CCD_PIPELINE_PROPERTY->hidden = true;
+			indigo_init_number_item(CCD_PIPELINE_BUFFERS_ITEM, CCD_PIPELINE_BUFFERS_ITEM_NAME, "Frame buffers", 0, CCD_PIPELINE_MAX_BUFFERS, 1, 0);
+			indigo_init_number_item(CCD_PIPELINE_QUEUED_ITEM, CCD_PIPELINE_QUEUED_ITEM_NAME, "Frames queued", 0, CCD_PIPELINE_MAX_BUFFERS, 1, 0);
+			indigo_init_number_item(CCD_PIPELINE_DROPPED_ITEM, CCD_PIPELINE_DROPPED_ITEM_NAME, "Frames dropped", 0, 1e9, 1, 0);
+			// -------------------------------------------------------------------------------- CCD_LOCAL_WRITER
+			CCD_LOCAL_WRITER_PROPERTY = indigo_init_switch_property(NULL, device->name, CCD_LOCAL_WRITER_PROPERTY_NAME, CCD_ADVANCED_GROUP, "Save on server options", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ANY_OF_MANY_RULE, 4);
+			if (CCD_LOCAL_WRITER_PROPERTY == NULL)
+				return INDIGO_FAILED;
+			indigo_init_switch_item(CCD_LOCAL_WRITER_BACKGROUND_ITEM, CCD_LOCAL_WRITER_BACKGROUND_ITEM_NAME, "Write in background", false);
+			indigo_init_switch_item(CCD_LOCAL_WRITER_SYNC_ITEM, CCD_LOCAL_WRITER_SYNC_ITEM_NAME, "Flush to disk after write", false);
+			indigo_init_switch_item(CCD_LOCAL_WRITER_PREALLOCATE_ITEM, CCD_LOCAL_WRITER_PREALLOCATE_ITEM_NAME, "Preallocate files", false);
+			indigo_init_switch_item(CCD_LOCAL_WRITER_WAIT_ITEM, CCD_LOCAL_WRITER_WAIT_ITEM_NAME, "Wait if queue is full", true);
+			// -------------------------------------------------------------------------------- CCD_LOCAL_WRITER_QUEUE
+			CCD_LOCAL_WRITER_QUEUE_PROPERTY = indigo_init_number_property(NULL, device->name, CCD_LOCAL_WRITER_QUEUE_PROPERTY_NAME, CCD_ADVANCED_GROUP, "Save on server queue", INDIGO_OK_STATE, INDIGO_RW_PERM, 1);
+			if (CCD_LOCAL_WRITER_QUEUE_PROPERTY == NULL)
+				return INDIGO_FAILED;
+			indigo_init_number_item(CCD_LOCAL_WRITER_QUEUE_SIZE_ITEM, CCD_LOCAL_WRITER_QUEUE_SIZE_ITEM_NAME, "Queue size (MB)", 16, 65536, 16, 1024);
+			// -------------------------------------------------------------------------------- CCD_LOCAL_WRITER_PENDING
+			CCD_LOCAL_WRITER_PENDING_PROPERTY = indigo_init_number_property(NULL, device->name, CCD_LOCAL_WRITER_PENDING_PROPERTY_NAME, CCD_ADVANCED_GROUP, "Save on server pending", INDIGO_OK_STATE, INDIGO_RO_PERM, 2);
+			if (CCD_LOCAL_WRITER_PENDING_PROPERTY == NULL)
+				return INDIGO_FAILED;
+			indigo_init_number_item(CCD_LOCAL_WRITER_PENDING_FILES_ITEM, CCD_LOCAL_WRITER_PENDING_FILES_ITEM_NAME, "Pending files", 0, 1e9, 1, 0);
+			indigo_init_number_item(CCD_LOCAL_WRITER_PENDING_BYTES_ITEM, CCD_LOCAL_WRITER_PENDING_BYTES_ITEM_NAME, "Pending bytes", 0, 1e15, 1, 0);
 			// --------------------------------------------------------------------------------
 			CCD_CONTEXT->countdown_canceled = false;
 			CCD_CONTEXT->countdown_enabled = false;
@@ -403,6 +450,10 @@ indigo_result indigo_ccd_enumerate_properties(indigo_device *device, indigo_clie
 			indigo_define_property(device, CCD_FRAME_TYPE_PROPERTY, NULL);
 		if (indigo_property_match(CCD_IMAGE_FORMAT_PROPERTY, property))
 			indigo_define_property(device, CCD_IMAGE_FORMAT_PROPERTY, NULL);
+		if (indigo_property_match(CCD_FITS_COMPRESSION_PROPERTY, property))
+			indigo_define_property(device, CCD_FITS_COMPRESSION_PROPERTY, NULL);
+		if (indigo_property_match(CCD_XISF_COMPRESSION_PROPERTY, property))
+			indigo_define_property(device, CCD_XISF_COMPRESSION_PROPERTY, NULL);
 		if (indigo_property_match(CCD_UPLOAD_MODE_PROPERTY, property))
 			indigo_define_property(device, CCD_UPLOAD_MODE_PROPERTY, NULL);
 		if (indigo_property_match(CCD_PREVIEW_PROPERTY, property))
@@ -433,6 +484,14 @@ indigo_result indigo_ccd_enumerate_properties(indigo_device *device, indigo_clie
 			indigo_define_property(device, CCD_RBI_FLUSH_ENABLE_PROPERTY, NULL);
 		if (indigo_property_match(CCD_RBI_FLUSH_PROPERTY, property))
 			indigo_define_property(device, CCD_RBI_FLUSH_PROPERTY, NULL);
+		if (indigo_property_match(CCD_PIPELINE_PROPERTY, property))
+			indigo_define_property(device, CCD_PIPELINE_PROPERTY, NULL);
+		if (indigo_property_match(CCD_LOCAL_WRITER_PROPERTY, property))
+			indigo_define_property(device, CCD_LOCAL_WRITER_PROPERTY, NULL);
+		if (indigo_property_match(CCD_LOCAL_WRITER_QUEUE_PROPERTY, property))
+			indigo_define_property(device, CCD_LOCAL_WRITER_QUEUE_PROPERTY, NULL);
+		if (indigo_property_match(CCD_LOCAL_WRITER_PENDING_PROPERTY, property))
+			indigo_define_property(device, CCD_LOCAL_WRITER_PENDING_PROPERTY, NULL);
 	}
 	return indigo_device_enumerate_properties(device, client, property);
 }
@@ -450,13 +509,68 @@ indigo_result indigo_ccd_failure_cleanup(indigo_device *device) {
 		CCD_PREVIEW_HISTOGRAM_PROPERTY->state = INDIGO_ALERT_STATE;
 		indigo_update_property(device, CCD_PREVIEW_HISTOGRAM_PROPERTY, NULL);
 	}
-	if (CCD_IMAGE_FILE_PROPERTY->state == INDIGO_BUSY_STATE) {
+	pthread_mutex_lock(&CCD_CONTEXT->file_writer_mutex);
+	bool changed = CCD_IMAGE_FILE_PROPERTY->state == INDIGO_BUSY_STATE;
+	if (changed)
 		CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+	pthread_mutex_unlock(&CCD_CONTEXT->file_writer_mutex);
+	if (changed)
 		indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, NULL);
-	}
 	return INDIGO_OK;
 }
 
+// background writer for local save
+
+/* CCD_IMAGE_FILE is shared by the thread processing frames, the writer callback and CCD_EXPOSURE handler, file_writer_mutex guards
+ its value, state and file_writer_busy only, file IO and property updates are done outside of it, so it never nests with bus locks */
+
+static void update_local_writer_pending(indigo_device *device) {
+	indigo_file_writer_stats stats;
+	indigo_file_writer_get_stats(CCD_CONTEXT->file_writer, &stats);
+	pthread_mutex_lock(&CCD_CONTEXT->file_writer_mutex);
+	CCD_LOCAL_WRITER_PENDING_FILES_ITEM->number.value = stats.files;
+	CCD_LOCAL_WRITER_PENDING_BYTES_ITEM->number.value = stats.bytes;
+	pthread_mutex_unlock(&CCD_CONTEXT->file_writer_mutex);
+	indigo_update_property(device, CCD_LOCAL_WRITER_PENDING_PROPERTY, NULL);
+}
+
+/* set CCD_IMAGE_FILE to the new file (if any) or to alert state and publish it */
+static void update_image_file(indigo_device *device, const char *file_name, bool failed, const char *message) {
+	pthread_mutex_lock(&CCD_CONTEXT->file_writer_mutex);
+	if (file_name && *file_name) {
+		indigo_copy_value(CCD_IMAGE_FILE_ITEM->text.value, file_name);
+		CCD_IMAGE_FILE_PROPERTY->state = INDIGO_OK_STATE;
+	}
+	if (failed)
+		CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+	pthread_mutex_unlock(&CCD_CONTEXT->file_writer_mutex);
+	indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, message);
+}
+
+/* called by writer thread */
+static void local_writer_callback(indigo_device *device, const char *file_name, int error) {
+	bool completed = false;
+	pthread_mutex_lock(&CCD_CONTEXT->file_writer_mutex);
+	if (error) {
+		CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+	} else if (CCD_CONTEXT->file_writer_busy && !strcmp(CCD_IMAGE_FILE_ITEM->text.value, file_name)) {
+		CCD_CONTEXT->file_writer_busy = false;
+		CCD_IMAGE_FILE_PROPERTY->state = INDIGO_OK_STATE;
+		completed = true;
+	}
+	pthread_mutex_unlock(&CCD_CONTEXT->file_writer_mutex);
+	if (error)
+		indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, "Failed to write %s (%s)", file_name, strerror(error));
+	else if (completed)
+		indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, NULL);
+	update_local_writer_pending(device);
+}
+
+static void configure_file_writer(indigo_device *device) {
+	if (CCD_CONTEXT->file_writer)
+		indigo_file_writer_configure(CCD_CONTEXT->file_writer, (long)CCD_LOCAL_WRITER_QUEUE_SIZE_ITEM->number.value * 1024 * 1024, CCD_LOCAL_WRITER_SYNC_ITEM->sw.value, CCD_LOCAL_WRITER_PREALLOCATE_ITEM->sw.value);
+}
+
 indigo_result indigo_ccd_abort_exposure_cleanup(indigo_device *device) {
 	indigo_ccd_failure_cleanup(device);
 	if (CCD_EXPOSURE_PROPERTY->state == INDIGO_BUSY_STATE) {
@@ -510,6 +624,8 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 			indigo_define_property(device, CCD_GAMMA_PROPERTY, NULL);
 			indigo_define_property(device, CCD_FRAME_TYPE_PROPERTY, NULL);
 			indigo_define_property(device, CCD_IMAGE_FORMAT_PROPERTY, NULL);
+			indigo_define_property(device, CCD_FITS_COMPRESSION_PROPERTY, NULL);
+			indigo_define_property(device, CCD_XISF_COMPRESSION_PROPERTY, NULL);
 			indigo_define_property(device, CCD_IMAGE_FILE_PROPERTY, NULL);
 			indigo_define_property(device, CCD_IMAGE_PROPERTY, NULL);
 			indigo_define_property(device, CCD_PREVIEW_IMAGE_PROPERTY, NULL);
@@ -524,6 +640,10 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 			indigo_define_property(device, CCD_JPEG_STRETCH_PRESETS_PROPERTY, NULL);
 			indigo_define_property(device, CCD_RBI_FLUSH_ENABLE_PROPERTY, NULL);
 			indigo_define_property(device, CCD_RBI_FLUSH_PROPERTY, NULL);
+			indigo_define_property(device, CCD_PIPELINE_PROPERTY, NULL);
+			indigo_define_property(device, CCD_LOCAL_WRITER_PROPERTY, NULL);
+			indigo_define_property(device, CCD_LOCAL_WRITER_QUEUE_PROPERTY, NULL);
+			indigo_define_property(device, CCD_LOCAL_WRITER_PENDING_PROPERTY, NULL);
 			CCD_CONTEXT->countdown_enabled = true;
 			CCD_CONTEXT->countdown_endtime = 0;
 		} else {
@@ -554,6 +674,8 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 			indigo_delete_property(device, CCD_GAMMA_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_FRAME_TYPE_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_IMAGE_FORMAT_PROPERTY, NULL);
+			indigo_delete_property(device, CCD_FITS_COMPRESSION_PROPERTY, NULL);
+			indigo_delete_property(device, CCD_XISF_COMPRESSION_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_IMAGE_FILE_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_IMAGE_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_PREVIEW_IMAGE_PROPERTY, NULL);
@@ -568,6 +690,10 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 			indigo_delete_property(device, CCD_JPEG_STRETCH_PRESETS_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_RBI_FLUSH_ENABLE_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_RBI_FLUSH_PROPERTY, NULL);
+			indigo_delete_property(device, CCD_PIPELINE_PROPERTY, NULL);
+			indigo_delete_property(device, CCD_LOCAL_WRITER_PROPERTY, NULL);
+			indigo_delete_property(device, CCD_LOCAL_WRITER_QUEUE_PROPERTY, NULL);
+			indigo_delete_property(device, CCD_LOCAL_WRITER_PENDING_PROPERTY, NULL);
 		}
 	} else if (indigo_property_match_changeable(CONFIG_PROPERTY, property)) {
 		// -------------------------------------------------------------------------------- CONFIG
@@ -577,6 +703,8 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 			indigo_save_property(device, NULL, CCD_READ_MODE_PROPERTY);
 			indigo_save_property(device, NULL, CCD_UPLOAD_MODE_PROPERTY);
 			indigo_save_property(device, NULL, CCD_LOCAL_MODE_PROPERTY);
+			indigo_save_property(device, NULL, CCD_LOCAL_WRITER_PROPERTY);
+			indigo_save_property(device, NULL, CCD_LOCAL_WRITER_QUEUE_PROPERTY);
 			indigo_save_property(device, NULL, CCD_FRAME_PROPERTY);
 			indigo_save_property(device, NULL, CCD_BIN_PROPERTY);
 			indigo_save_property(device, NULL, CCD_OFFSET_PROPERTY);
@@ -611,10 +739,15 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 		// -------------------------------------------------------------------------------- CCD_EXPOSURE
 		if (CCD_EXPOSURE_PROPERTY->state == INDIGO_BUSY_STATE) {
 			if (CCD_UPLOAD_MODE_LOCAL_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value) {
-				if (CCD_IMAGE_FILE_PROPERTY->state != INDIGO_BUSY_STATE) {
+				/* file written in background from now on doesn't complete CCD_IMAGE_FILE, next frame will */
+				pthread_mutex_lock(&CCD_CONTEXT->file_writer_mutex);
+				CCD_CONTEXT->file_writer_busy = false;
+				bool changed = CCD_IMAGE_FILE_PROPERTY->state != INDIGO_BUSY_STATE;
+				if (changed)
 					CCD_IMAGE_FILE_PROPERTY->state = INDIGO_BUSY_STATE;
+				pthread_mutex_unlock(&CCD_CONTEXT->file_writer_mutex);
+				if (changed)
 					indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, NULL);
-				}
 			}
 			if (CCD_UPLOAD_MODE_CLIENT_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value) {
 				if (CCD_IMAGE_PROPERTY->state != INDIGO_BUSY_STATE) {
@@ -721,6 +854,18 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 		CCD_IMAGE_FORMAT_PROPERTY->state = INDIGO_OK_STATE;
 		indigo_update_property(device, CCD_IMAGE_FORMAT_PROPERTY, NULL);
 		return INDIGO_OK;
+	} else if (indigo_property_match_changeable(CCD_FITS_COMPRESSION_PROPERTY, property)) {
+		// -------------------------------------------------------------------------------- CCD_FITS_COMPRESSION
+		indigo_property_copy_values(CCD_FITS_COMPRESSION_PROPERTY, property, false);
+		CCD_FITS_COMPRESSION_PROPERTY->state = INDIGO_OK_STATE;
+		indigo_update_property(device, CCD_FITS_COMPRESSION_PROPERTY, NULL);
+		return INDIGO_OK;
+	} else if (indigo_property_match_changeable(CCD_XISF_COMPRESSION_PROPERTY, property)) {
+		// -------------------------------------------------------------------------------- CCD_XISF_COMPRESSION
+		indigo_property_copy_values(CCD_XISF_COMPRESSION_PROPERTY, property, false);
+		CCD_XISF_COMPRESSION_PROPERTY->state = INDIGO_OK_STATE;
+		indigo_update_property(device, CCD_XISF_COMPRESSION_PROPERTY, NULL);
+		return INDIGO_OK;
 	} else if (indigo_property_match_changeable(CCD_UPLOAD_MODE_PROPERTY, property)) {
 		// -------------------------------------------------------------------------------- CCD_IMAGE_UPLOAD_MODE
 		indigo_property_copy_values(CCD_UPLOAD_MODE_PROPERTY, property, false);
@@ -772,6 +917,20 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 		CCD_LOCAL_MODE_PROPERTY->state = INDIGO_OK_STATE;
 		indigo_update_property(device, CCD_LOCAL_MODE_PROPERTY, NULL);
 		return INDIGO_OK;
+	} else if (indigo_property_match_changeable(CCD_LOCAL_WRITER_PROPERTY, property)) {
+		// -------------------------------------------------------------------------------- CCD_LOCAL_WRITER
+		indigo_property_copy_values(CCD_LOCAL_WRITER_PROPERTY, property, false);
+		configure_file_writer(device);
+		CCD_LOCAL_WRITER_PROPERTY->state = INDIGO_OK_STATE;
+		indigo_update_property(device, CCD_LOCAL_WRITER_PROPERTY, NULL);
+		return INDIGO_OK;
+	} else if (indigo_property_match_changeable(CCD_LOCAL_WRITER_QUEUE_PROPERTY, property)) {
+		// -------------------------------------------------------------------------------- CCD_LOCAL_WRITER_QUEUE
+		indigo_property_copy_values(CCD_LOCAL_WRITER_QUEUE_PROPERTY, property, false);
+		configure_file_writer(device);
+		CCD_LOCAL_WRITER_QUEUE_PROPERTY->state = INDIGO_OK_STATE;
+		indigo_update_property(device, CCD_LOCAL_WRITER_QUEUE_PROPERTY, NULL);
+		return INDIGO_OK;
 	} else if (indigo_property_match_changeable(CCD_SET_FITS_HEADER_PROPERTY, property)) {
 		// -------------------------------------------------------------------------------- CCD_SET_FITS_HEADER
 		indigo_property_copy_values(CCD_SET_FITS_HEADER_PROPERTY, property, false);
@@ -913,10 +1072,17 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 	return indigo_device_change_property(device, client, property);
 }
 
+static void release_pipeline(indigo_device *device);
+
 indigo_result indigo_ccd_detach(indigo_device *device) {
 	assert(device != NULL);
 	CCD_CONTEXT->countdown_canceled = true;
 	indigo_cancel_timer_sync(device, &CCD_CONTEXT->countdown_timer);
+	release_pipeline(device);
+	indigo_file_writer_release(CCD_CONTEXT->file_writer);
+	CCD_CONTEXT->file_writer = NULL;
+	pthread_mutex_destroy(&CCD_CONTEXT->file_writer_mutex);
+	indigo_set_blob_item_buffer(CCD_IMAGE_ITEM, NULL);
 	indigo_release_property(CCD_INFO_PROPERTY);
 	indigo_release_property(CCD_LENS_PROPERTY);
 	indigo_release_property(CCD_UPLOAD_MODE_PROPERTY);
@@ -935,6 +1101,8 @@ indigo_result indigo_ccd_detach(indigo_device *device) {
 	indigo_release_property(CCD_OFFSET_PROPERTY);
 	indigo_release_property(CCD_FRAME_TYPE_PROPERTY);
 	indigo_release_property(CCD_IMAGE_FORMAT_PROPERTY);
+	indigo_release_property(CCD_FITS_COMPRESSION_PROPERTY);
+	indigo_release_property(CCD_XISF_COMPRESSION_PROPERTY);
 	indigo_release_property(CCD_IMAGE_FILE_PROPERTY);
 	indigo_release_property(CCD_IMAGE_PROPERTY);
 	indigo_release_property(CCD_PREVIEW_IMAGE_PROPERTY);
@@ -949,15 +1117,75 @@ indigo_result indigo_ccd_detach(indigo_device *device) {
 	indigo_release_property(CCD_JPEG_STRETCH_PRESETS_PROPERTY);
 	indigo_release_property(CCD_RBI_FLUSH_ENABLE_PROPERTY);
 	indigo_release_property(CCD_RBI_FLUSH_PROPERTY);
+	indigo_release_property(CCD_PIPELINE_PROPERTY);
+	indigo_release_property(CCD_LOCAL_WRITER_PROPERTY);
+	indigo_release_property(CCD_LOCAL_WRITER_QUEUE_PROPERTY);
+	indigo_release_property(CCD_LOCAL_WRITER_PENDING_PROPERTY);
 	if (CCD_CONTEXT->preview_image)
 		free(CCD_CONTEXT->preview_image);
+	indigo_safe_free(CCD_CONTEXT->sequence_template);
 	return indigo_device_detach(device);
 }
 
 #define STRECH_SAMPLE_SIZE	0x1FF
 
 void indigo_raw_to_jpeg(indigo_device *device, void *data_in, int frame_width, int frame_height, int bpp, const char *bayerpat, void **data_out, unsigned long *size_out, void **histogram_data, unsigned long *histogram_size, double B, double C) {
+	indigo_raw_to_scaled_jpeg(device, data_in, frame_width, frame_height, bpp, bayerpat, 0, data_out, size_out, histogram_data, histogram_size, B, C);
+}
+
+static void *bin_raw(void *data_in, int *frame_width, int *frame_height, int *bpp, const char *bayerpat, int max_size) {
+	int size = *frame_width > *frame_height ? *frame_width : *frame_height;
+	if (max_size <= 0 || size <= max_size) {
+		return NULL;
+	}
+	int factor = (size + max_size - 1) / max_size;
+	if (bayerpat && (factor & 1)) {
+		factor++;
+	}
+	int width = *frame_width / factor;
+	int height = *frame_height / factor;
+	if (width == 0 || height == 0) {
+		return NULL;
+	}
+	void *binned = NULL;
+	if (bayerpat) {
+		/* bayered data are debayered while binned, result is handled as RGB */
+		binned = indigo_safe_malloc(3 * width * height * *bpp / 8);
+		if (!strcmp(bayerpat, "RGGB")) {
+			*bpp == 8 ? indigo_debayer_bin_8_rggb(data_in, *frame_width, *frame_height, factor, binned) : indigo_debayer_bin_16_rggb(data_in, *frame_width, *frame_height, factor, binned);
+		} else if (!strcmp(bayerpat, "GBRG")) {
+			*bpp == 8 ? indigo_debayer_bin_8_gbrg(data_in, *frame_width, *frame_height, factor, binned) : indigo_debayer_bin_16_gbrg(data_in, *frame_width, *frame_height, factor, binned);
+		} else if (!strcmp(bayerpat, "GRBG")) {
+			*bpp == 8 ? indigo_debayer_bin_8_grbg(data_in, *frame_width, *frame_height, factor, binned) : indigo_debayer_bin_16_grbg(data_in, *frame_width, *frame_height, factor, binned);
+		} else if (!strcmp(bayerpat, "BGGR")) {
+			*bpp == 8 ? indigo_debayer_bin_8_bggr(data_in, *frame_width, *frame_height, factor, binned) : indigo_debayer_bin_16_bggr(data_in, *frame_width, *frame_height, factor, binned);
+		} else {
+			assert(false);
+		}
+		*bpp *= 3;
+	} else {
+		binned = indigo_safe_malloc(width * height * *bpp / 8);
+		int components = (*bpp == 8 || *bpp == 16) ? 1 : 3;
+		if (*bpp == 8 || *bpp == 24) {
+			indigo_bin_8(data_in, *frame_width, *frame_height, components, factor, binned);
+		} else {
+			indigo_bin_16(data_in, *frame_width, *frame_height, components, factor, binned);
+		}
+	}
+	*frame_width = width;
+	*frame_height = height;
+	return binned;
+}
+
+void indigo_raw_to_scaled_jpeg(indigo_device *device, void *data_in, int frame_width, int frame_height, int bpp, const char *bayerpat, int max_size, void **data_out, unsigned long *size_out, void **histogram_data, unsigned long *histogram_size, double B, double C) {
 	INDIGO_DEBUG(clock_t start = clock());
+	bool debayered = false;
+	void *binned = bin_raw(data_in, &frame_width, &frame_height, &bpp, bayerpat, max_size);
+	if (binned) {
+		data_in = binned;
+		debayered = bayerpat != NULL;
+		bayerpat = NULL;
+	}
 	size_t size_in = frame_width * frame_height;
 	int sample_by = frame_width < STRECH_SAMPLE_SIZE ? 1 : frame_width / STRECH_SAMPLE_SIZE;
 	void *copy = indigo_safe_malloc(3 * size_in * bpp / 8);
@@ -974,6 +1202,7 @@ void indigo_raw_to_jpeg(indigo_device *device, void *data_in, int frame_width, i
 	if (setjmp(cinfo.jpeg_error)) {
 		jpeg_destroy_compress(&cinfo.pub);
 		indigo_safe_free(copy);
+		indigo_safe_free(binned);
 		indigo_safe_free(histo[0]);
 		indigo_safe_free(histo[1]);
 		indigo_safe_free(histo[2]);
@@ -1052,13 +1281,21 @@ void indigo_raw_to_jpeg(indigo_device *device, void *data_in, int frame_width, i
 	} else if (bpp == 24) {
 		if (B != 0 && C != 0) {
 			indigo_compute_stretch_params_24((uint8_t *)(data_in), frame_width, frame_height, sample_by, shadows, midtones, highlights, histo, totals, B, C);
-			indigo_stretch_24((uint8_t *)(data_in), frame_width, frame_height, copy, shadows, midtones, highlights, totals);
+			if (debayered) {
+				indigo_stretch_24_debayered((uint8_t *)(data_in), frame_width, frame_height, copy, shadows, midtones, highlights, totals);
+			} else {
+				indigo_stretch_24((uint8_t *)(data_in), frame_width, frame_height, copy, shadows, midtones, highlights, totals);
+			}
 		} else {
 			memcpy(copy, data_in, 3 * frame_width * frame_height);
 		}
 	} else if (bpp == 48) {
 		indigo_compute_stretch_params_48((uint16_t *)(data_in), frame_width, frame_height, sample_by, shadows, midtones, highlights, histo, totals, B, C);
-		indigo_stretch_48((uint16_t *)(data_in), frame_width, frame_height, copy, shadows, midtones, highlights, totals);
+		if (debayered) {
+			indigo_stretch_48_debayered((uint16_t *)(data_in), frame_width, frame_height, copy, shadows, midtones, highlights, totals);
+		} else {
+			indigo_stretch_48((uint16_t *)(data_in), frame_width, frame_height, copy, shadows, midtones, highlights, totals);
+		}
 	} else {
 		assert(false);
 	}
@@ -1080,6 +1317,7 @@ void indigo_raw_to_jpeg(indigo_device *device, void *data_in, int frame_width, i
 	*data_out = mem;
 	*size_out = mem_size;
 	indigo_safe_free(copy);
+	indigo_safe_free(binned);
 	if (histogram_data != NULL) {
 		uint8_t raw[128 * 256 * 3];
 		memset(raw, 0, sizeof(raw));
@@ -1148,7 +1386,7 @@ void indigo_raw_to_jpeg(indigo_device *device, void *data_in, int frame_width, i
 	indigo_safe_free(histo[0]);
 	indigo_safe_free(histo[1]);
 	indigo_safe_free(histo[2]);
-	INDIGO_DEBUG(indigo_debug("RAW to preview conversion in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
+	INDIGO_DEBUG(indigo_debug("RAW to preview conversion (%dx%d) in %gs", frame_width, frame_height, (clock() - start) / (double)CLOCKS_PER_SEC));
 }
 
 static void add_key(char **header, bool fits, char *format, ...) {
@@ -1233,7 +1471,7 @@ static void raw_to_tiff(indigo_device *device, void *data_in, int frame_width, i
 	add_key(&next_key, false, "DATE-OBS= '%s' / UTC date that FITS file was created", date_time_end);
 	add_key(&next_key, false, "INSTRUME= '%s'%*c / instrument name", device->name, (int)(19 - strlen(device->name)), ' ');
 	add_key(&next_key, false, "ROWORDER= 'TOP-DOWN'           / Image row order");
-	add_key(&next_key, false, "SWCREATE= 'INDIGO 2.0-%s'     / Capture software", INDIGO_VERSION_MAJOR(INDIGO_VERSION_CURRENT), INDIGO_VERSION_MINOR(INDIGO_VERSION_CURRENT), INDIGO_BUILD);
+	add_key(&next_key, false, "SWCREATE= 'INDIGO 2.0-%s'     / Capture software", INDIGO_BUILD);
 	if (keywords) {
 		while (keywords->type && (next_key - fits_header) < (FITS_HEADER_SIZE - 80)) {
 			switch (keywords->type) {
@@ -1316,6 +1554,43 @@ static void sanitise(char *buffer) {
 	}
 }
 
+// highest index of existing files matching template with %0nd at position
+
+static int last_sequence_index(const char *template, int position) {
+	char dir[PATH_MAX];
+	int dir_length = position;
+	while (dir_length > 0 && template[dir_length - 1] != '/')
+		dir_length--;
+	if (dir_length == 0) {
+		strcpy(dir, ".");
+	} else {
+		strncpy(dir, template, dir_length);
+		dir[dir_length] = 0;
+	}
+	const char *head = template + dir_length;
+	int head_length = position - dir_length;
+	const char *tail = template + position + 4;
+	int tail_length = (int)strlen(tail);
+	int last = 0;
+	DIR *folder = opendir(dir);
+	if (folder) {
+		struct dirent *entry;
+		while ((entry = readdir(folder)) != NULL) {
+			const char *name = entry->d_name;
+			int digits = (int)strlen(name) - head_length - tail_length;
+			if (digits < 1 || digits > 5 || strncmp(name, head, head_length) || strcmp(name + head_length + digits, tail))
+				continue;
+			int index = 0;
+			for (int i = 0; i < digits && index >= 0; i++)
+				index = isdigit(name[head_length + i]) ? index * 10 + name[head_length + i] - '0' : -1;
+			if (index > last)
+				last = index;
+		}
+		closedir(folder);
+	}
+	return last;
+}
+
 static bool create_file_name(indigo_device *device, void *blob_value, long blob_size, char *dir, char *prefix, char *suffix, char *file_name) {
 	char format[PATH_MAX], tmp[PATH_MAX];
 	strcpy(format, dir);
@@ -1441,7 +1716,6 @@ static bool create_file_name(indigo_device *device, void *blob_value, long blob_
 				fs = next;
 				continue;
 			}
-			struct stat sb;
 			strncpy(tmp, format, fs - format + 1);
 			switch (fs[1]) {
 				case '1':
@@ -1461,10 +1735,21 @@ static bool create_file_name(indigo_device *device, void *blob_value, long blob_
 					break;
 			}
 			strcat(tmp, fs + 3);
-			for (int i = 1; i < 100000; i++) {
+			/* directory is scanned only if template changed, otherwise sequence continues from the last index */
+			if (CCD_CONTEXT->sequence_template == NULL || strcmp(CCD_CONTEXT->sequence_template, tmp)) {
+				indigo_safe_free(CCD_CONTEXT->sequence_template);
+				CCD_CONTEXT->sequence_template = strdup(tmp);
+				CCD_CONTEXT->sequence_index = last_sequence_index(tmp, (int)(fs - format));
+			}
+			for (int i = CCD_CONTEXT->sequence_index + 1; i < 100000; i++) {
 				snprintf(format, PATH_MAX, tmp, i);
-				if (stat(format, &sb) == 0 && S_ISREG(sb.st_mode))
-					continue;;
+				/* name is reserved by exclusive create, so file created by someone else since the scan is skipped */
+				int handle = open(format, O_WRONLY | O_CREAT | O_EXCL, 0644);
+				if (handle < 0 && errno == EEXIST)
+					continue;
+				if (handle >= 0)
+					close(handle);
+				CCD_CONTEXT->sequence_index = i;
 				strcpy(file_name, format);
 				return true;
 			}
@@ -1508,7 +1793,62 @@ int mkpath(const char *path) {
 	return 0;
 }
 
-void indigo_process_image(indigo_device *device, void *data, int frame_width, int frame_height, int bpp, bool little_endian, bool byte_order_rgb, indigo_fits_keyword *keywords, bool streaming) {
+static void set_image_item_value(indigo_device *device, void *value, long size) {
+	*CCD_IMAGE_ITEM->blob.url = 0;
+	if (indigo_use_blob_caching) {
+		/* driver reuses its buffer for the next frame, so copy it once to the buffer shared by BLOB cache, HTTP and XML clients */
+		indigo_blob_buffer *buffer = indigo_create_blob_buffer(size);
+		memcpy(buffer->data, value, size);
+		indigo_set_blob_item_buffer(CCD_IMAGE_ITEM, buffer);
+	} else {
+		indigo_set_blob_item_buffer(CCD_IMAGE_ITEM, NULL);
+		CCD_IMAGE_ITEM->blob.value = value;
+		CCD_IMAGE_ITEM->blob.size = size;
+	}
+}
+
+static void set_image_item_buffer(indigo_device *device, indigo_blob_buffer *buffer) {
+	*CCD_IMAGE_ITEM->blob.url = 0;
+	indigo_set_blob_item_buffer(CCD_IMAGE_ITEM, indigo_retain_blob_buffer(buffer));
+}
+
+typedef struct {
+	void *input;
+	void *output;
+	unsigned long size;
+} pixel_conversion;
+
+static void swap_bytes_16(pixel_conversion *conversion, int start, int end) {
+	uint16_t *raw = (uint16_t *)conversion->input + start;
+	for (int i = start; i < end; i++) {
+		uint16_t value = *raw;
+		*raw++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
+	}
+}
+
+static void swap_red_blue_8(pixel_conversion *conversion, int start, int end) {
+	unsigned char *b8 = (unsigned char *)conversion->input + 3 * start;
+	for (int i = start; i < end; i++) {
+		unsigned char b = *b8;
+		unsigned char r = *(b8 + 2);
+		*b8 = r;
+		*(b8 + 2) = b;
+		b8 += 3;
+	}
+}
+
+static void swap_red_blue_16(pixel_conversion *conversion, int start, int end) {
+	uint16_t *b16 = (uint16_t *)conversion->input + 3 * start;
+	for (int i = start; i < end; i++) {
+		uint16_t b = *b16;
+		uint16_t r = *(b16 + 2);
+		*b16 = r;
+		*(b16 + 2) = b;
+		b16 += 3;
+	}
+}
+
+static void process_image(indigo_device *device, void *data, int frame_width, int frame_height, int bpp, bool little_endian, bool byte_order_rgb, indigo_fits_keyword *keywords, bool streaming) {
 	assert(device != NULL);
 	assert(data != NULL);
 
@@ -1526,35 +1866,22 @@ void indigo_process_image(indigo_device *device, void *data, int frame_width, in
 		byte_per_pixel = 2;
 		naxis = 3;
 	}
-	if (byte_per_pixel == 2 && !little_endian) {
-		uint16_t *raw = (uint16_t *)(data + FITS_HEADER_SIZE);
-		for (int i = 0; i < size; i++) {
-			uint16_t value = *raw;
-			*raw++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-		}
-	}
-	if (naxis == 3 && !byte_order_rgb) {
-		if (byte_per_pixel == 1) {
-			unsigned char *b8 = data + FITS_HEADER_SIZE;
-			for (int i = 0; i < size; i++) {
-				unsigned char b = *b8;
-				unsigned char r = *(b8 + 2);
-				*b8 = r;
-				*(b8 + 2) = b;
-				b8 += 3;
-			}
-		} else if (byte_per_pixel == 2) {
-			unsigned char *b16 = data + FITS_HEADER_SIZE;
-			for (int i = 0; i < size; i++) {
-				unsigned char b = *b16;
-				unsigned char r = *(b16 + 2);
-				*b16 = r;
-				*(b16 + 2) = b;
-				b16 += 3;
-			}
+	bool preview = CCD_IMAGE_FORMAT_JPEG_ITEM->sw.value || CCD_IMAGE_FORMAT_JPEG_AVI_ITEM->sw.value || CCD_PREVIEW_ENABLED_ITEM->sw.value || CCD_PREVIEW_ENABLED_WITH_HISTOGRAM_ITEM->sw.value;
+	/* FITS conversion handles byte and channel order in the same pass, raw data are normalized only if they are used as they are */
+	if (preview || !CCD_IMAGE_FORMAT_FITS_ITEM->sw.value) {
+		if (byte_per_pixel == 2 && !little_endian) {
+			pixel_conversion conversion = { data + FITS_HEADER_SIZE, NULL, size };
+			indigo_parallel_for((int)(naxis == 3 ? 3 * size : size), (void (*)(void *, int, int))swap_bytes_16, &conversion);
+			little_endian = true;
+		}
+		if (naxis == 3 && !byte_order_rgb) {
+			pixel_conversion conversion = { data + FITS_HEADER_SIZE, NULL, size };
+			indigo_parallel_for((int)size, (void (*)(void *, int, int))(byte_per_pixel == 1 ? swap_red_blue_8 : swap_red_blue_16), &conversion);
+			byte_order_rgb = true;
 		}
 	}
 	unsigned header_size = 0;
+	indigo_blob_buffer *blob_buffer = NULL;
 	void *jpeg_data = NULL;
 	unsigned long jpeg_size = 0;
 	void *histogram_data = NULL;
@@ -1571,10 +1898,12 @@ void indigo_process_image(indigo_device *device, void *data, int frame_width, in
 			}
 		}
 	}
-	if (CCD_IMAGE_FORMAT_JPEG_ITEM->sw.value || CCD_IMAGE_FORMAT_JPEG_AVI_ITEM->sw.value || CCD_PREVIEW_ENABLED_ITEM->sw.value || CCD_PREVIEW_ENABLED_WITH_HISTOGRAM_ITEM->sw.value) {
+	if (preview) {
 		double B = CCD_JPEG_SETTINGS_TARGET_BACKGROUND_ITEM->number.target;
 		double C = CCD_JPEG_SETTINGS_CLIPPING_POINT_ITEM->number.target;
-		indigo_raw_to_jpeg(device, data + FITS_HEADER_SIZE, frame_width, frame_height, bpp, bayerpat, &jpeg_data, &jpeg_size,  CCD_PREVIEW_ENABLED_WITH_HISTOGRAM_ITEM->sw.value ? &histogram_data : NULL, CCD_PREVIEW_ENABLED_WITH_HISTOGRAM_ITEM->sw.value ? &histogram_size : NULL, B, C);
+		/* JPEG image format shares the conversion with preview, so it must be kept in full resolution */
+		int max_size = (CCD_IMAGE_FORMAT_JPEG_ITEM->sw.value || CCD_IMAGE_FORMAT_JPEG_AVI_ITEM->sw.value) ? 0 : (int)CCD_JPEG_SETTINGS_MAX_PREVIEW_SIZE_ITEM->number.target;
+		indigo_raw_to_scaled_jpeg(device, data + FITS_HEADER_SIZE, frame_width, frame_height, bpp, bayerpat, max_size, &jpeg_data, &jpeg_size,  CCD_PREVIEW_ENABLED_WITH_HISTOGRAM_ITEM->sw.value ? &histogram_data : NULL, CCD_PREVIEW_ENABLED_WITH_HISTOGRAM_ITEM->sw.value ? &histogram_size : NULL, B, C);
 		if (CCD_PREVIEW_ENABLED_ITEM->sw.value || CCD_PREVIEW_ENABLED_WITH_HISTOGRAM_ITEM->sw.value) {
 			CCD_PREVIEW_IMAGE_PROPERTY->state = INDIGO_BUSY_STATE;
 			indigo_update_property(device, CCD_PREVIEW_IMAGE_PROPERTY, NULL);
@@ -1762,54 +2091,34 @@ void indigo_process_image(indigo_device *device, void *data, int frame_width, in
 		if (header_size % FITS_LOGICAL_RECORD_LENGTH != 0) {
 			header_size = (header_size / FITS_LOGICAL_RECORD_LENGTH + 1) * FITS_LOGICAL_RECORD_LENGTH;
 		}
-		if (header_size < FITS_HEADER_SIZE) {
-			memmove(data + FITS_HEADER_SIZE - header_size, data, header_size);
-		}
-		if (byte_per_pixel == 2 && naxis == 2) {
-			uint16_t *raw = (uint16_t *)(data + FITS_HEADER_SIZE);
-			for (int i = 0; i < size; i++) {
-				int value = *raw - 32768;
-				*raw++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-			}
-		} else if (byte_per_pixel == 1 && naxis == 3) {
-			unsigned char *raw = indigo_safe_malloc(3 * size);
-			unsigned char *red = raw;
-			unsigned char *green = raw + size;
-			unsigned char *blue = raw + 2 * size;
-			unsigned char *tmp = data + FITS_HEADER_SIZE;
-			for (int i = 0; i < size; i++) {
-				*red++ = *tmp++;
-				*green++ = *tmp++;
-				*blue++ = *tmp++;
-			}
-			memcpy(data + FITS_HEADER_SIZE, raw, 3 * size);
-			free(raw);
-		} else if (byte_per_pixel == 2 && naxis == 3) {
-			uint16_t *raw = indigo_safe_malloc(6 * size);
-			uint16_t *red = raw;
-			uint16_t *green = raw + size;
-			uint16_t *blue = raw + 2 * size;
-			uint16_t *tmp = (uint16_t *)(data + FITS_HEADER_SIZE);
-			for (int i = 0; i < size; i++) {
-				int value = *tmp++ - 32768;
-				*red++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-				value = *tmp++ - 32768;
-				*green++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-				value = *tmp++ - 32768;
-				*blue++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-			}
-			memcpy(data + FITS_HEADER_SIZE, raw, 6 * size);
-			free(raw);
-		}
-		int mod2880 = blobsize % 2880;
-		if (mod2880) {
-			int padding = 2880 - mod2880;
-			if (padding) {
-				memset(data + FITS_HEADER_SIZE + blobsize, 0, padding);
-				blobsize += padding;
+		int padding = blobsize % 2880 ? 2880 - blobsize % 2880 : 0;
+		if (naxis == 3) {
+			/* planes can't be created in place, so they are written directly behind the header to the buffer shared with clients */
+			blob_buffer = indigo_create_blob_buffer(header_size + blobsize + padding);
+			memcpy(blob_buffer->data, data, header_size);
+			indigo_raw_to_fits_payload(data + FITS_HEADER_SIZE, blob_buffer->data + header_size, frame_width, frame_height, byte_per_pixel, 3, little_endian, byte_order_rgb);
+			memset(blob_buffer->data + header_size + blobsize, 0, padding);
+		} else {
+			if (header_size < FITS_HEADER_SIZE) {
+				memmove(data + FITS_HEADER_SIZE - header_size, data, header_size);
 			}
+			indigo_raw_to_fits_payload(data + FITS_HEADER_SIZE, data + FITS_HEADER_SIZE, frame_width, frame_height, byte_per_pixel, 1, little_endian, byte_order_rgb);
+			memset(data + FITS_HEADER_SIZE + blobsize, 0, padding);
 		}
+		blobsize += padding;
 		INDIGO_DEBUG(indigo_debug("RAW to FITS conversion in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
+		if (!CCD_FITS_COMPRESSION_NONE_ITEM->sw.value) {
+			INDIGO_DEBUG(clock_t start = clock());
+			void *fits = blob_buffer ? blob_buffer->data : data + FITS_HEADER_SIZE - header_size;
+			indigo_blob_buffer *compressed = indigo_fits_compress(fits, header_size + blobsize, CCD_FITS_COMPRESSION_RICE_ITEM->sw.value ? INDIGO_FITS_RICE : INDIGO_FITS_GZIP);
+			if (compressed) {
+				indigo_release_blob_buffer(blob_buffer);
+				blob_buffer = compressed;
+				INDIGO_DEBUG(indigo_debug("FITS tile compression to %ld bytes in %gs", compressed->size, (clock() - start) / (double)CLOCKS_PER_SEC));
+			} else {
+				indigo_error("FITS tile compression failed, image is not compressed");
+			}
+		}
 	} else if (CCD_IMAGE_FORMAT_XISF_ITEM->sw.value) {
 		INDIGO_DEBUG(clock_t start = clock());
 		time_t timer;
@@ -1919,6 +2228,18 @@ void indigo_process_image(indigo_device *device, void *data, int frame_width, in
 		header += sprintf(header, "<Property id='XISF:BlockAlignmentSize' type='UInt16' value='2880'/></Metadata></xisf>");
 		*(uint32_t *)(data + 8) = (uint32_t)(header - (char *)data) - 16;
 		INDIGO_DEBUG(indigo_debug("RAW to XISF conversion in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
+		if (!CCD_XISF_COMPRESSION_NONE_ITEM->sw.value) {
+			INDIGO_DEBUG(clock_t start = clock());
+			indigo_xisf_codec codec = CCD_XISF_COMPRESSION_ZLIB_ITEM->sw.value ? INDIGO_XISF_ZLIB : CCD_XISF_COMPRESSION_LZ4_ITEM->sw.value ? INDIGO_XISF_LZ4 : INDIGO_XISF_LZ4HC;
+			indigo_blob_buffer *compressed = indigo_xisf_compress(data, FITS_HEADER_SIZE + blobsize, codec, true);
+			if (compressed) {
+				indigo_release_blob_buffer(blob_buffer);
+				blob_buffer = compressed;
+				INDIGO_DEBUG(indigo_debug("XISF block compression to %ld bytes in %gs", compressed->size, (clock() - start) / (double)CLOCKS_PER_SEC));
+			} else {
+				indigo_error("XISF block compression failed, image is not compressed");
+			}
+		}
 	} else if (CCD_IMAGE_FORMAT_RAW_ITEM->sw.value || CCD_IMAGE_FORMAT_RAW_SER_ITEM->sw.value) {
 		indigo_raw_header *header = (indigo_raw_header *)(data + FITS_HEADER_SIZE - sizeof(indigo_raw_header));
 		if (naxis == 2 && byte_per_pixel == 1)
@@ -1960,7 +2281,10 @@ void indigo_process_image(indigo_device *device, void *data, int frame_width, in
 	}
 	void *blob_value = NULL;
 	long blob_size = 0;
-	if (CCD_IMAGE_FORMAT_FITS_ITEM->sw.value) {
+	if (blob_buffer) {
+		blob_value = blob_buffer->data;
+		blob_size = blob_buffer->size;
+	} else if (CCD_IMAGE_FORMAT_FITS_ITEM->sw.value) {
 		blob_value = data + FITS_HEADER_SIZE - header_size;
 		blob_size = header_size + blobsize;
 	} else if (CCD_IMAGE_FORMAT_XISF_ITEM->sw.value) {
@@ -2006,13 +2330,13 @@ void indigo_process_image(indigo_device *device, void *data, int frame_width, in
 			}
 		}
 		char *message = NULL;
+		bool failed = false;
+		bool queued = false;
 		int handle = 0;
 		char file_name[INDIGO_VALUE_SIZE] = {0};
 		if (!(use_avi || use_ser) || CCD_CONTEXT->video_stream == NULL) {
 			if (indigo_is_sandboxed || !mkpath(CCD_LOCAL_MODE_DIR_ITEM->text.value)) {
 				if (create_file_name(device, blob_value, blob_size, CCD_LOCAL_MODE_DIR_ITEM->text.value, CCD_LOCAL_MODE_PREFIX_ITEM->text.value, suffix, file_name)) {
-					indigo_copy_value(CCD_IMAGE_FILE_ITEM->text.value, file_name);
-					CCD_IMAGE_FILE_PROPERTY->state = INDIGO_OK_STATE;
 					if (use_avi) {
 						CCD_CONTEXT->video_stream = gwavi_open(file_name, frame_width, frame_height, "MJPG", 5);
 					} else if (use_ser) {
@@ -2021,46 +2345,83 @@ void indigo_process_image(indigo_device *device, void *data, int frame_width, in
 						handle = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
 					}
 				} else {
-					CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+					failed = true;
 					message = "Failed to create file name";
 				}
 			} else {
-				CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+				failed = true;
 				message = "Failed to create storage directory, image can not be saved on server";
 			}
 		}
 		if (CCD_CONTEXT->video_stream != NULL) {
 			if (use_avi) {
 				if (!gwavi_add_frame((struct gwavi_t *)(CCD_CONTEXT->video_stream), data, blobsize)) {
-					CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+					failed = true;
 					message = strerror(errno);
 				}
 			} else if (use_ser) {
 				if (!indigo_ser_add_frame((indigo_ser *)(CCD_CONTEXT->video_stream), data + FITS_HEADER_SIZE - sizeof(indigo_raw_header), blobsize + sizeof(indigo_raw_header))) {
-					CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+					failed = true;
 					message = strerror(errno);
 				}
 			}
+		} else if (handle > 0 && CCD_LOCAL_WRITER_BACKGROUND_ITEM->sw.value) {
+			if (CCD_CONTEXT->file_writer == NULL) {
+				CCD_CONTEXT->file_writer = indigo_file_writer_create((indigo_file_writer_callback)local_writer_callback, device);
+				configure_file_writer(device);
+			}
+			if (blob_buffer == NULL) {
+				/* driver reuses its buffer for the next frame, so the writer gets a copy (shared with clients) */
+				blob_buffer = indigo_create_blob_buffer(blob_size);
+				memcpy(blob_buffer->data, blob_value, blob_size);
+				blob_value = blob_buffer->data;
+			}
+			/* CCD_IMAGE_FILE is switched to OK state by writer callback, it may happen before the push returns */
+			pthread_mutex_lock(&CCD_CONTEXT->file_writer_mutex);
+			indigo_copy_value(CCD_IMAGE_FILE_ITEM->text.value, file_name);
+			CCD_IMAGE_FILE_PROPERTY->state = INDIGO_BUSY_STATE;
+			CCD_CONTEXT->file_writer_busy = true;
+			pthread_mutex_unlock(&CCD_CONTEXT->file_writer_mutex);
+			queued = CCD_CONTEXT->file_writer && indigo_file_writer_push(CCD_CONTEXT->file_writer, handle, file_name, blob_buffer, false);
+			if (!queued && CCD_CONTEXT->file_writer && CCD_LOCAL_WRITER_WAIT_ITEM->sw.value) {
+				CCD_LOCAL_WRITER_PENDING_PROPERTY->state = INDIGO_BUSY_STATE;
+				indigo_update_property(device, CCD_LOCAL_WRITER_PENDING_PROPERTY, "Local save queue is full, waiting");
+				queued = indigo_file_writer_push(CCD_CONTEXT->file_writer, handle, file_name, blob_buffer, true);
+				CCD_LOCAL_WRITER_PENDING_PROPERTY->state = INDIGO_OK_STATE;
+			}
+			if (queued) {
+				update_local_writer_pending(device);
+			} else {
+				pthread_mutex_lock(&CCD_CONTEXT->file_writer_mutex);
+				CCD_CONTEXT->file_writer_busy = false;
+				pthread_mutex_unlock(&CCD_CONTEXT->file_writer_mutex);
+				close(handle);
+				file_remove(file_name);
+				failed = true;
+				message = "Local save queue is full, image is not saved";
+			}
 		} else if (handle > 0) {
-			if (!indigo_write(handle, blob_value, blob_size)) {
-				CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+			if (!indigo_write_file(handle, blob_value, blob_size, CCD_LOCAL_WRITER_SYNC_ITEM->sw.value, CCD_LOCAL_WRITER_PREALLOCATE_ITEM->sw.value)) {
+				failed = true;
 				message = strerror(errno);
 			}
 			close(handle);
-			if (CCD_IMAGE_FILE_PROPERTY->state == INDIGO_ALERT_STATE) {
+			if (failed) {
 				file_remove(file_name);
 			}
 		} else if (message == NULL) {
-			CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+			failed = true;
 			message = strerror(errno);
 		}
-		indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, message);
+		/* queued file already is in CCD_IMAGE_FILE and its state may be changed by writer callback meanwhile */
+		update_image_file(device, queued ? NULL : file_name, failed, message);
 		INDIGO_DEBUG(indigo_debug("Local save in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
 	}
 	if (CCD_UPLOAD_MODE_CLIENT_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value) {
-		*CCD_IMAGE_ITEM->blob.url = 0;
-		CCD_IMAGE_ITEM->blob.value = blob_value;
-		CCD_IMAGE_ITEM->blob.size = blob_size;
+		if (blob_buffer)
+			set_image_item_buffer(device, blob_buffer);
+		else
+			set_image_item_value(device, blob_value, blob_size);
 		if (CCD_IMAGE_FORMAT_FITS_ITEM->sw.value)
 			strcpy(CCD_IMAGE_ITEM->blob.format, ".fits");
 		else if (CCD_IMAGE_FORMAT_XISF_ITEM->sw.value)
@@ -2079,6 +2440,259 @@ void indigo_process_image(indigo_device *device, void *data, int frame_width, in
 		free(jpeg_data);
 	if (histogram_data)
 		free(histogram_data);
+	indigo_release_blob_buffer(blob_buffer);
+}
+
+void indigo_process_image(indigo_device *device, void *data, int frame_width, int frame_height, int bpp, bool little_endian, bool byte_order_rgb, indigo_fits_keyword *keywords, bool streaming) {
+	/* frames handed over to the pipeline use the same properties and buffers, so they must be finished first */
+	if (CCD_CONTEXT->pipeline)
+		indigo_ccd_flush_pipeline(device);
+	process_image(device, data, frame_width, frame_height, bpp, little_endian, byte_order_rgb, keywords, streaming);
+}
+
+// asynchronous image pipeline, submitted frames are processed in order by one thread per device
+
+typedef struct {
+	void *data;
+	long size;
+	bool in_use;
+	int frame_width;
+	int frame_height;
+	int bpp;
+	bool little_endian;
+	bool byte_order_rgb;
+	bool streaming;
+	indigo_fits_keyword *keywords;
+} pipeline_frame;
+
+struct indigo_ccd_pipeline {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	pthread_t thread;
+	bool stop;
+	bool processing;
+	bool changed;
+	bool publishing;
+	int count;
+	int head;
+	int queued;
+	int queue[CCD_PIPELINE_MAX_BUFFERS];
+	long dropped;
+	pipeline_frame frames[CCD_PIPELINE_MAX_BUFFERS];
+};
+
+static indigo_fits_keyword *copy_keywords(indigo_fits_keyword *keywords) {
+	/* keywords and strings they refer to are usually on the stack of the driver thread */
+	if (keywords == NULL)
+		return NULL;
+	int count = 0;
+	long length = 0;
+	for (; keywords[count].type; count++) {
+		length += strlen(keywords[count].name) + 1;
+		length += keywords[count].comment ? strlen(keywords[count].comment) + 1 : 0;
+		if (keywords[count].type == INDIGO_FITS_STRING)
+			length += strlen(keywords[count].string) + 1;
+	}
+	indigo_fits_keyword *copy = indigo_safe_malloc((count + 1) * sizeof(indigo_fits_keyword) + length);
+	char *strings = (char *)(copy + count + 1);
+	memcpy(copy, keywords, count * sizeof(indigo_fits_keyword));
+	for (int i = 0; i < count; i++) {
+		copy[i].name = strcpy(strings, keywords[i].name);
+		strings += strlen(strings) + 1;
+		if (keywords[i].comment) {
+			copy[i].comment = strcpy(strings, keywords[i].comment);
+			strings += strlen(strings) + 1;
+		}
+		if (keywords[i].type == INDIGO_FITS_STRING) {
+			copy[i].string = strcpy(strings, keywords[i].string);
+			strings += strlen(strings) + 1;
+		}
+	}
+	return copy;
+}
+
+static pipeline_frame *find_frame(indigo_ccd_pipeline *pipeline, void *data) {
+	for (int i = 0; i < pipeline->count; i++) {
+		if (pipeline->frames[i].in_use && pipeline->frames[i].data == data)
+			return pipeline->frames + i;
+	}
+	return NULL;
+}
+
+static void update_pipeline_property(indigo_device *device, indigo_ccd_pipeline *pipeline) {
+	/* called with mutex locked, property is updated with mutex unlocked by one thread at a time until it shows the latest state */
+	pipeline->changed = true;
+	if (pipeline->publishing)
+		return;
+	pipeline->publishing = true;
+	while (pipeline->changed) {
+		pipeline->changed = false;
+		int in_use = 0;
+		for (int i = 0; i < pipeline->count; i++) {
+			if (pipeline->frames[i].in_use)
+				in_use++;
+		}
+		int queued = pipeline->queued + (pipeline->processing ? 1 : 0);
+		long dropped = pipeline->dropped;
+		/* busy state signals back-pressure, driver has no free buffer */
+		indigo_property_state state = in_use == pipeline->count ? INDIGO_BUSY_STATE : INDIGO_OK_STATE;
+		pthread_mutex_unlock(&pipeline->mutex);
+		CCD_PIPELINE_QUEUED_ITEM->number.value = queued;
+		CCD_PIPELINE_DROPPED_ITEM->number.value = dropped;
+		CCD_PIPELINE_PROPERTY->state = state;
+		indigo_update_property(device, CCD_PIPELINE_PROPERTY, NULL);
+		pthread_mutex_lock(&pipeline->mutex);
+	}
+	pipeline->publishing = false;
+}
+
+static void *pipeline_thread(indigo_device *device) {
+	indigo_ccd_pipeline *pipeline = CCD_CONTEXT->pipeline;
+	pthread_mutex_lock(&pipeline->mutex);
+	while (true) {
+		while (pipeline->queued == 0 && !pipeline->stop)
+			pthread_cond_wait(&pipeline->cond, &pipeline->mutex);
+		/* frames submitted before stop are still processed */
+		if (pipeline->queued == 0)
+			break;
+		pipeline_frame *frame = pipeline->frames + pipeline->queue[pipeline->head];
+		pipeline->head = (pipeline->head + 1) % CCD_PIPELINE_MAX_BUFFERS;
+		pipeline->queued--;
+		pipeline->processing = true;
+		pthread_mutex_unlock(&pipeline->mutex);
+		process_image(device, frame->data, frame->frame_width, frame->frame_height, frame->bpp, frame->little_endian, frame->byte_order_rgb, frame->keywords, frame->streaming);
+		indigo_safe_free(frame->keywords);
+		frame->keywords = NULL;
+		pthread_mutex_lock(&pipeline->mutex);
+		pipeline->processing = false;
+		frame->in_use = false;
+		pthread_cond_broadcast(&pipeline->cond);
+		update_pipeline_property(device, pipeline);
+	}
+	pthread_mutex_unlock(&pipeline->mutex);
+	return NULL;
+}
+
+void indigo_ccd_enable_pipeline(indigo_device *device, int buffers) {
+	assert(device != NULL);
+	if (CCD_CONTEXT->pipeline)
+		return;
+	indigo_ccd_pipeline *pipeline = indigo_safe_malloc(sizeof(indigo_ccd_pipeline));
+	pipeline->count = buffers < 2 ? 2 : buffers > CCD_PIPELINE_MAX_BUFFERS ? CCD_PIPELINE_MAX_BUFFERS : buffers;
+	pthread_mutex_init(&pipeline->mutex, NULL);
+	pthread_cond_init(&pipeline->cond, NULL);
+	CCD_CONTEXT->pipeline = pipeline;
+	if (pthread_create(&pipeline->thread, NULL, (void *(*)(void *))pipeline_thread, device)) {
+		indigo_error("Can't create image pipeline thread (%s)", strerror(errno));
+		CCD_CONTEXT->pipeline = NULL;
+		pthread_cond_destroy(&pipeline->cond);
+		pthread_mutex_destroy(&pipeline->mutex);
+		indigo_safe_free(pipeline);
+		return;
+	}
+	CCD_PIPELINE_BUFFERS_ITEM->number.value = pipeline->count;
+	CCD_PIPELINE_PROPERTY->hidden = false;
+}
+
+void *indigo_ccd_acquire_frame_buffer(indigo_device *device, long size, bool wait) {
+	assert(device != NULL);
+	indigo_ccd_pipeline *pipeline = CCD_CONTEXT->pipeline;
+	assert(pipeline != NULL);
+	pipeline_frame *frame = NULL;
+	pthread_mutex_lock(&pipeline->mutex);
+	while (true) {
+		for (int i = 0; i < pipeline->count; i++) {
+			if (!pipeline->frames[i].in_use) {
+				frame = pipeline->frames + i;
+				break;
+			}
+		}
+		if (frame || !wait)
+			break;
+		pthread_cond_wait(&pipeline->cond, &pipeline->mutex);
+	}
+	if (frame == NULL) {
+		pipeline->dropped++;
+		update_pipeline_property(device, pipeline);
+		pthread_mutex_unlock(&pipeline->mutex);
+		return NULL;
+	}
+	frame->in_use = true;
+	pthread_mutex_unlock(&pipeline->mutex);
+	if (frame->size < size) {
+		indigo_safe_free(frame->data);
+		frame->data = indigo_alloc_blob_buffer(size);
+		frame->size = size;
+	}
+	return frame->data;
+}
+
+void indigo_ccd_release_frame_buffer(indigo_device *device, void *data) {
+	assert(device != NULL);
+	indigo_ccd_pipeline *pipeline = CCD_CONTEXT->pipeline;
+	assert(pipeline != NULL);
+	pthread_mutex_lock(&pipeline->mutex);
+	pipeline_frame *frame = find_frame(pipeline, data);
+	if (frame) {
+		frame->in_use = false;
+		pthread_cond_broadcast(&pipeline->cond);
+	}
+	pthread_mutex_unlock(&pipeline->mutex);
+}
+
+void indigo_ccd_submit_frame(indigo_device *device, void *data, int frame_width, int frame_height, int bpp, bool little_endian, bool byte_order_rgb, indigo_fits_keyword *keywords, bool streaming) {
+	assert(device != NULL);
+	indigo_ccd_pipeline *pipeline = CCD_CONTEXT->pipeline;
+	assert(pipeline != NULL);
+	indigo_fits_keyword *copy = copy_keywords(keywords);
+	pthread_mutex_lock(&pipeline->mutex);
+	pipeline_frame *frame = find_frame(pipeline, data);
+	if (frame == NULL) {
+		pthread_mutex_unlock(&pipeline->mutex);
+		indigo_safe_free(copy);
+		indigo_error("Frame buffer %p was not acquired from pipeline", data);
+		return;
+	}
+	frame->frame_width = frame_width;
+	frame->frame_height = frame_height;
+	frame->bpp = bpp;
+	frame->little_endian = little_endian;
+	frame->byte_order_rgb = byte_order_rgb;
+	frame->streaming = streaming;
+	frame->keywords = copy;
+	pipeline->queue[(pipeline->head + pipeline->queued) % CCD_PIPELINE_MAX_BUFFERS] = (int)(frame - pipeline->frames);
+	pipeline->queued++;
+	pthread_cond_broadcast(&pipeline->cond);
+	update_pipeline_property(device, pipeline);
+	pthread_mutex_unlock(&pipeline->mutex);
+}
+
+void indigo_ccd_flush_pipeline(indigo_device *device) {
+	assert(device != NULL);
+	indigo_ccd_pipeline *pipeline = CCD_CONTEXT->pipeline;
+	if (pipeline == NULL)
+		return;
+	pthread_mutex_lock(&pipeline->mutex);
+	while (pipeline->queued > 0 || pipeline->processing)
+		pthread_cond_wait(&pipeline->cond, &pipeline->mutex);
+	pthread_mutex_unlock(&pipeline->mutex);
+}
+
+static void release_pipeline(indigo_device *device) {
+	indigo_ccd_pipeline *pipeline = CCD_CONTEXT->pipeline;
+	if (pipeline == NULL)
+		return;
+	pthread_mutex_lock(&pipeline->mutex);
+	pipeline->stop = true;
+	pthread_cond_broadcast(&pipeline->cond);
+	pthread_mutex_unlock(&pipeline->mutex);
+	pthread_join(pipeline->thread, NULL);
+	for (int i = 0; i < pipeline->count; i++)
+		indigo_safe_free(pipeline->frames[i].data);
+	pthread_cond_destroy(&pipeline->cond);
+	pthread_mutex_destroy(&pipeline->mutex);
+	indigo_safe_free(pipeline);
+	CCD_CONTEXT->pipeline = NULL;
 }
 
 void indigo_process_dslr_image(indigo_device *device, void *data, int data_size, const char *suffix, bool streaming) {
@@ -2135,39 +2749,36 @@ void indigo_process_dslr_image(indigo_device *device, void *data, int data_size,
 			if (CCD_UPLOAD_MODE_LOCAL_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value) {
 				char file_name[INDIGO_VALUE_SIZE] = {0};
 				char *message = NULL;
+				bool failed = false;
 				if (indigo_is_sandboxed || !mkpath(CCD_LOCAL_MODE_DIR_ITEM->text.value)) {
 					if (create_file_name(device, data, data_size, CCD_LOCAL_MODE_DIR_ITEM->text.value, CCD_LOCAL_MODE_PREFIX_ITEM->text.value, ".raw", file_name)) {
-						indigo_copy_value(CCD_IMAGE_FILE_ITEM->text.value, file_name);
-						CCD_IMAGE_FILE_PROPERTY->state = INDIGO_OK_STATE;
 						int handle = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
 						if (handle > 0) {
 							if (!indigo_write(handle, image + FITS_HEADER_SIZE - sizeof(indigo_raw_header), image_size + sizeof(indigo_raw_header))) {
-								CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+								failed = true;
 								message = strerror(errno);
 							}
 							close(handle);
-							if (CCD_IMAGE_FILE_PROPERTY->state == INDIGO_ALERT_STATE) {
+							if (failed) {
 								file_remove(file_name);
 							}
 						} else {
-							CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+							failed = true;
 							message = strerror(errno);
 						}
 					} else {
-						CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+						failed = true;
 						message = "Failed to create file name";
 					}
 				} else {
-					CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+					failed = true;
 					message = "Failed to create storage directory, image can not be saved on server";
 				}
-				indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, message);
+				update_image_file(device, file_name, failed, message);
 				INDIGO_DEBUG(indigo_debug("Local save in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
 			}
 			if (CCD_UPLOAD_MODE_CLIENT_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value) {
-				*CCD_IMAGE_ITEM->blob.url = 0;
-				CCD_IMAGE_ITEM->blob.value = image + FITS_HEADER_SIZE - sizeof(indigo_raw_header);
-				CCD_IMAGE_ITEM->blob.size = image_size + sizeof(indigo_raw_header);
+				set_image_item_value(device, image + FITS_HEADER_SIZE - sizeof(indigo_raw_header), image_size + sizeof(indigo_raw_header));
 				indigo_copy_name(CCD_IMAGE_ITEM->blob.format, ".raw");
 				CCD_IMAGE_PROPERTY->state = INDIGO_OK_STATE;
 				indigo_update_property(device, CCD_IMAGE_PROPERTY, NULL);
@@ -2214,6 +2825,7 @@ void indigo_process_dslr_image(indigo_device *device, void *data, int data_size,
 		int handle = 0;
 		char *message = NULL;
 		char file_name[INDIGO_VALUE_SIZE] = {0};
+		bool failed = false;
 		if (CCD_IMAGE_FORMAT_NATIVE_AVI_ITEM->sw.value && !strcmp(standard_suffix, ".jpeg") && streaming) {
 			strcpy(standard_suffix, ".avi");
 			use_avi = true;
@@ -2221,8 +2833,6 @@ void indigo_process_dslr_image(indigo_device *device, void *data, int data_size,
 		if (!use_avi || CCD_CONTEXT->video_stream == NULL) {
 			if (indigo_is_sandboxed || !mkpath(CCD_LOCAL_MODE_DIR_ITEM->text.value)) {
 				if (create_file_name(device, data, data_size, CCD_LOCAL_MODE_DIR_ITEM->text.value, CCD_LOCAL_MODE_PREFIX_ITEM->text.value, standard_suffix, file_name)) {
-					indigo_copy_value(CCD_IMAGE_FILE_ITEM->text.value, file_name);
-					CCD_IMAGE_FILE_PROPERTY->state = INDIGO_OK_STATE;
 					if (use_avi) {
 						struct indigo_jpeg_decompress_struct cinfo;
 						struct jpeg_error_mgr jerr;
@@ -2233,8 +2843,7 @@ void indigo_process_dslr_image(indigo_device *device, void *data, int data_size,
 						if (setjmp(cinfo.jpeg_error)) {
 							jpeg_destroy_decompress(&cinfo.pub);
 							INDIGO_ERROR(indigo_error("JPEG decompression failed"));
-							CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
-							indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, "JPEG decompression failed");
+							update_image_file(device, file_name, true, "JPEG decompression failed");
 							return;
 						}
 						jpeg_create_decompress(&cinfo.pub);
@@ -2246,41 +2855,39 @@ void indigo_process_dslr_image(indigo_device *device, void *data, int data_size,
 						handle = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
 					}
 				} else {
-					CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+					failed = true;
 					message = "Failed to create file name";
 				}
 			} else {
-				CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+				failed = true;
 				message = "Failed to create storage directory, image can not be saved on server";
 			}
 		}
 		if (CCD_CONTEXT->video_stream != NULL) {
 			if (use_avi) {
 				if (!gwavi_add_frame((struct gwavi_t *)(CCD_CONTEXT->video_stream), data, data_size)) {
-					CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+					failed = true;
 					message = strerror(errno);
 				}
 			}
 		} else if (handle > 0) {
 			if (!indigo_write(handle, data, data_size)) {
-				CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+				failed = true;
 				message = strerror(errno);
 			}
 			close(handle);
-			if (CCD_IMAGE_FILE_PROPERTY->state == INDIGO_ALERT_STATE) {
+			if (failed) {
 				file_remove(file_name);
 			}
 		} else {
-			CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
+			failed = true;
 			message = strerror(errno);
 		}
-		indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, message);
+		update_image_file(device, file_name, failed, message);
 		INDIGO_DEBUG(indigo_debug("Local save in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
 	}
 	if (CCD_UPLOAD_MODE_CLIENT_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value) {
-		*CCD_IMAGE_ITEM->blob.url = 0;
-		CCD_IMAGE_ITEM->blob.value = data;
-		CCD_IMAGE_ITEM->blob.size = data_size;
+		set_image_item_value(device, data, data_size);
 		indigo_copy_name(CCD_IMAGE_ITEM->blob.format, standard_suffix);
 		CCD_IMAGE_PROPERTY->state = INDIGO_OK_STATE;
 		indigo_update_property(device, CCD_IMAGE_PROPERTY, NULL);
@@ -2305,16 +2912,21 @@ void indigo_process_dslr_preview_image(indigo_device *device, void *data, int bl
 }
 
 void indigo_finalize_video_stream(indigo_device *device) {
+	indigo_ccd_flush_pipeline(device);
 	if (CCD_CONTEXT->video_stream) {
 		if (CCD_IMAGE_FORMAT_JPEG_AVI_ITEM->sw.value) {
 			gwavi_close((struct gwavi_t *)(CCD_CONTEXT->video_stream));
 			CCD_CONTEXT->video_stream = NULL;
+			pthread_mutex_lock(&CCD_CONTEXT->file_writer_mutex);
 			CCD_IMAGE_FILE_PROPERTY->state = INDIGO_OK_STATE;
+			pthread_mutex_unlock(&CCD_CONTEXT->file_writer_mutex);
 			indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, NULL);
 		} else if (CCD_IMAGE_FORMAT_RAW_SER_ITEM->sw.value) {
 			indigo_ser_close((indigo_ser *)(CCD_CONTEXT->video_stream));
 			CCD_CONTEXT->video_stream = NULL;
+			pthread_mutex_lock(&CCD_CONTEXT->file_writer_mutex);
 			CCD_IMAGE_FILE_PROPERTY->state = INDIGO_OK_STATE;
+			pthread_mutex_unlock(&CCD_CONTEXT->file_writer_mutex);
 			indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, NULL);
 		}
 	}
@@ -2325,7 +2937,9 @@ void indigo_finalize_dslr_video_stream(indigo_device *device) {
 		if (CCD_IMAGE_FORMAT_NATIVE_AVI_ITEM->sw.value) {
 			gwavi_close((struct gwavi_t *)(CCD_CONTEXT->video_stream));
 			CCD_CONTEXT->video_stream = NULL;
+			pthread_mutex_lock(&CCD_CONTEXT->file_writer_mutex);
 			CCD_IMAGE_FILE_PROPERTY->state = INDIGO_OK_STATE;
+			pthread_mutex_unlock(&CCD_CONTEXT->file_writer_mutex);
 			indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, NULL);
 		}
 	}
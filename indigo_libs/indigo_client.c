@@ -54,10 +54,17 @@
 #endif
 
 #include <indigo/indigo_client_xml.h>
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+#include <indigo/indigo_client_binary.h>
+#endif
 #include <indigo/indigo_client.h>
 
 char *indigo_client_name = NULL;
 
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+bool indigo_use_binary_protocol = false;
+#endif
+
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 
 #if defined(INDIGO_WINDOWS)
@@ -407,9 +414,18 @@ static void *server_thread(indigo_server_entry *server) {
 #if defined(INDIGO_WINDOWS)
 			indigo_send_message(server->protocol_adapter, "connected");
 #endif
-			server->protocol_adapter = indigo_xml_client_adapter(server->name, url, server->socket, server->socket);
-			indigo_attach_device(server->protocol_adapter);
-			indigo_xml_parse(server->protocol_adapter, NULL);
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+			if (indigo_use_binary_protocol) {
+				server->protocol_adapter = indigo_binary_client_adapter(server->name, url, server->socket, server->socket);
+				indigo_attach_device(server->protocol_adapter);
+				indigo_binary_parse(server->protocol_adapter, NULL);
+			} else
+#endif
+			{
+				server->protocol_adapter = indigo_xml_client_adapter(server->name, url, server->socket, server->socket);
+				indigo_attach_device(server->protocol_adapter);
+				indigo_xml_parse(server->protocol_adapter, NULL);
+			}
 			indigo_detach_device(server->protocol_adapter);
 			if (server->protocol_adapter) {
 				if (server->protocol_adapter->device_context) {
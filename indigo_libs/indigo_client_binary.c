@@ -0,0 +1,212 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO binary wire protocol driver side adapter
+ \file indigo_client_binary.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <assert.h>
+#include <unistd.h>
+#include <libgen.h>
+
+#include <indigo/indigo_io.h>
+#include <indigo/indigo_version.h>
+#include <indigo/indigo_client_binary.h>
+
+extern char *indigo_client_name;
+
+/* protects frame builder, frames and BLOB payloads must not interleave */
+static pthread_mutex_t binary_mutex = PTHREAD_MUTEX_INITIALIZER;
+static indigo_binary_frame frame = { 0 };
+
+static void remote_device_name(const char *device, char *buffer) {
+	indigo_copy_name(buffer, device);
+	if (indigo_use_host_suffix) {
+		char *at = strrchr(buffer, '@');
+		if (at != NULL) {
+			while (at > buffer && at[-1] == ' ')
+				at--;
+			*at = 0;
+		}
+	}
+}
+
+static void close_connection(indigo_adapter_context *device_context) {
+	if (device_context->output == device_context->input) {
+		close(device_context->input);
+	} else {
+		close(device_context->input);
+		close(device_context->output);
+	}
+	device_context->output = device_context->input = -1;
+}
+
+static indigo_result binary_client_parser_enumerate_properties(indigo_device *device, indigo_client *client, indigo_property *property) {
+	assert(device != NULL);
+	if (!indigo_reshare_remote_devices && client && client->is_remote)
+		return INDIGO_OK;
+	indigo_adapter_context *device_context = (indigo_adapter_context *)device->device_context;
+	assert(device_context != NULL);
+	if (device_context->output <= 0)
+		return INDIGO_OK;
+	char device_name[INDIGO_NAME_SIZE] = "";
+	if (property != NULL)
+		remote_device_name(property->device, device_name);
+	pthread_mutex_lock(&binary_mutex);
+	indigo_binary_frame_begin(&frame, INDIGO_BINARY_GET_PROPERTIES);
+	indigo_binary_put_string(&frame, device_name);
+	indigo_binary_put_string(&frame, property != NULL ? property->name : "");
+	indigo_binary_frame_end(&frame);
+	if (!indigo_write(device_context->output, (const char *)frame.data, frame.length))
+		close_connection(device_context);
+	pthread_mutex_unlock(&binary_mutex);
+	return INDIGO_OK;
+}
+
+static indigo_result binary_client_parser_change_property(indigo_device *device, indigo_client *client, indigo_property *property) {
+	assert(device != NULL);
+	assert(property != NULL);
+	if (!indigo_reshare_remote_devices && client && client->is_remote)
+		return INDIGO_OK;
+	indigo_adapter_context *device_context = (indigo_adapter_context *)device->device_context;
+	assert(device_context != NULL);
+	if (device_context->output <= 0)
+		return INDIGO_OK;
+	if (property->type != INDIGO_TEXT_VECTOR && property->type != INDIGO_NUMBER_VECTOR && property->type != INDIGO_SWITCH_VECTOR && property->type != INDIGO_BLOB_VECTOR)
+		return INDIGO_OK;
+	char device_name[INDIGO_NAME_SIZE];
+	remote_device_name(property->device, device_name);
+	pthread_mutex_lock(&binary_mutex);
+	indigo_binary_frame_begin(&frame, INDIGO_BINARY_NEW);
+	indigo_binary_put_string(&frame, device_name);
+	indigo_binary_put_string(&frame, property->name);
+	indigo_binary_put_u8(&frame, property->type);
+	indigo_binary_put_u64(&frame, property->access_token);
+	indigo_binary_put_u16(&frame, property->count);
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = property->items + i;
+		indigo_binary_put_string(&frame, item->name);
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				indigo_binary_put_text(&frame, indigo_get_text_item_value(item));
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				indigo_binary_put_double(&frame, item->number.value);
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				indigo_binary_put_u8(&frame, item->sw.value);
+				break;
+			case INDIGO_BLOB_VECTOR:
+				if (item->blob.value && item->blob.size > 0) {
+					indigo_binary_put_u8(&frame, INDIGO_BINARY_BLOB_DATA);
+					indigo_binary_put_string(&frame, item->blob.format);
+					indigo_binary_put_u64(&frame, item->blob.size);
+				} else {
+					indigo_binary_put_u8(&frame, INDIGO_BINARY_BLOB_NONE);
+					indigo_binary_put_string(&frame, item->blob.format);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	indigo_binary_frame_end(&frame);
+	bool result = indigo_write(device_context->output, (const char *)frame.data, frame.length);
+	if (property->type == INDIGO_BLOB_VECTOR) {
+		/* raw payloads follow the frame */
+		for (int i = 0; result && i < property->count; i++) {
+			indigo_item *item = property->items + i;
+			if (item->blob.value && item->blob.size > 0)
+				result = indigo_write(device_context->output, item->blob.value, item->blob.size);
+		}
+	}
+	if (!result)
+		close_connection(device_context);
+	pthread_mutex_unlock(&binary_mutex);
+	return INDIGO_OK;
+}
+
+static indigo_result binary_client_parser_enable_blob(indigo_device *device, indigo_client *client, indigo_property *property, indigo_enable_blob_mode mode) {
+	assert(device != NULL);
+	assert(property != NULL);
+	if (!indigo_reshare_remote_devices && client && client->is_remote)
+		return INDIGO_OK;
+	indigo_adapter_context *device_context = (indigo_adapter_context *)device->device_context;
+	assert(device_context != NULL);
+	if (device_context->output <= 0)
+		return INDIGO_OK;
+	char device_name[INDIGO_NAME_SIZE];
+	remote_device_name(property->device, device_name);
+	pthread_mutex_lock(&binary_mutex);
+	indigo_binary_frame_begin(&frame, INDIGO_BINARY_ENABLE_BLOB);
+	indigo_binary_put_string(&frame, device_name);
+	indigo_binary_put_string(&frame, property->name);
+	indigo_binary_put_u8(&frame, mode);
+	indigo_binary_frame_end(&frame);
+	if (!indigo_write(device_context->output, (const char *)frame.data, frame.length))
+		close_connection(device_context);
+	pthread_mutex_unlock(&binary_mutex);
+	return INDIGO_OK;
+}
+
+static indigo_result binary_client_parser_detach(indigo_device *device) {
+	assert(device != NULL);
+	indigo_adapter_context *device_context = (indigo_adapter_context *)device->device_context;
+	if (device_context->output <= 0)
+		return INDIGO_OK;
+	close(device_context->input);
+	close(device_context->output);
+	return INDIGO_OK;
+}
+
+indigo_device *indigo_binary_client_adapter(char *name, char *url_prefix, int input, int output) {
+	static indigo_device device_template = INDIGO_DEVICE_INITIALIZER(
+		"Binary Client Adapter", NULL,
+		binary_client_parser_enumerate_properties,
+		binary_client_parser_change_property,
+		binary_client_parser_enable_blob,
+		binary_client_parser_detach
+	);
+	indigo_device *device = indigo_safe_malloc_copy(sizeof(indigo_device), &device_template);
+	sprintf(device->name, "@ %s", name);
+	device->is_remote = input == output; // is socket, otherwise is pipe
+	device->version = INDIGO_VERSION_CURRENT;
+	indigo_adapter_context *device_context = indigo_safe_malloc(sizeof(indigo_adapter_context));
+	device_context->input = input;
+	device_context->output = output;
+	indigo_copy_name(device_context->url_prefix, url_prefix);
+	device->device_context = device_context;
+	const char *client_name = indigo_client_name ? indigo_client_name : indigo_main_argv ? basename((char *)indigo_main_argv[0]) : "";
+	pthread_mutex_lock(&binary_mutex);
+	indigo_binary_frame_begin(&frame, INDIGO_BINARY_HELLO);
+	indigo_binary_put_u16(&frame, INDIGO_VERSION_CURRENT);
+	indigo_binary_put_string(&frame, client_name);
+	indigo_binary_frame_end(&frame);
+	if (!indigo_write(output, (const char *)frame.data, frame.length))
+		close_connection(device_context);
+	pthread_mutex_unlock(&binary_mutex);
+	return device;
+}
@@ -0,0 +1,440 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO binary wire protocol client side adapter
+ \file indigo_driver_binary.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include <indigo/indigo_io.h>
+#include <indigo/indigo_queue.h>
+#include <indigo/indigo_driver_binary.h>
+
+#define INTERN_HASH_SIZE	256
+
+// properties are interned on definition, updates and deletions refer to them by id and to items by index
+
+typedef struct interned_property {
+	uint32_t id;
+	uint32_t hash;
+	char device[INDIGO_NAME_SIZE];
+	char name[INDIGO_NAME_SIZE];
+	int count;
+	char (*items)[INDIGO_NAME_SIZE];
+	struct interned_property *next;
+} interned_property;
+
+typedef struct {
+	indigo_adapter_context context;			///< must be the first, parser and queue see adapter context only
+	pthread_mutex_t mutex;
+	indigo_binary_frame frame;
+	interned_property *hash_heads[INTERN_HASH_SIZE];
+	interned_property **by_id;
+	uint32_t id_count;
+	uint32_t *free_ids;
+	uint32_t free_count;
+} binary_adapter_context;
+
+static uint32_t name_hash(const char *device, const char *name) {
+	uint32_t hash = 2166136261U;
+	for (int i = 0; i < INDIGO_NAME_SIZE && device[i]; i++)
+		hash = (hash ^ (uint8_t)device[i]) * 16777619U;
+	hash *= 16777619U;
+	for (int i = 0; i < INDIGO_NAME_SIZE && name[i]; i++)
+		hash = (hash ^ (uint8_t)name[i]) * 16777619U;
+	return hash;
+}
+
+static interned_property *find_interned(binary_adapter_context *context, const char *device, const char *name) {
+	uint32_t hash = name_hash(device, name);
+	for (interned_property *interned = context->hash_heads[hash & (INTERN_HASH_SIZE - 1)]; interned; interned = interned->next) {
+		if (interned->hash == hash && !strncmp(interned->device, device, INDIGO_NAME_SIZE) && !strncmp(interned->name, name, INDIGO_NAME_SIZE))
+			return interned;
+	}
+	return NULL;
+}
+
+static interned_property *intern_property(binary_adapter_context *context, indigo_property *property) {
+	interned_property *interned = find_interned(context, property->device, property->name);
+	if (interned == NULL) {
+		interned = indigo_safe_malloc(sizeof(interned_property));
+		interned->hash = name_hash(property->device, property->name);
+		indigo_copy_name(interned->device, property->device);
+		indigo_copy_name(interned->name, property->name);
+		if (context->free_count) {
+			interned->id = context->free_ids[--context->free_count];
+		} else {
+			interned->id = context->id_count + 1;
+			context->by_id = indigo_safe_realloc(context->by_id, (context->id_count + 1) * sizeof(interned_property *));
+			context->free_ids = indigo_safe_realloc(context->free_ids, (context->id_count + 1) * sizeof(uint32_t));
+			context->id_count++;
+		}
+		context->by_id[interned->id - 1] = interned;
+		interned_property **head = &context->hash_heads[interned->hash & (INTERN_HASH_SIZE - 1)];
+		interned->next = *head;
+		*head = interned;
+	}
+	if (interned->count != property->count) {
+		interned->items = indigo_safe_realloc(interned->items, (property->count + 1) * INDIGO_NAME_SIZE);
+		interned->count = property->count;
+	}
+	for (int i = 0; i < property->count; i++)
+		indigo_copy_name(interned->items[i], property->items[i].name);
+	return interned;
+}
+
+static void release_interned(binary_adapter_context *context, interned_property *interned) {
+	interned_property **link = &context->hash_heads[interned->hash & (INTERN_HASH_SIZE - 1)];
+	while (*link != interned)
+		link = &(*link)->next;
+	*link = interned->next;
+	context->by_id[interned->id - 1] = NULL;
+	context->free_ids[context->free_count++] = interned->id;
+	indigo_safe_free(interned->items);
+	free(interned);
+}
+
+static int item_index(interned_property *interned, int i, indigo_item *item) {
+	if (i < interned->count && !strncmp(interned->items[i], item->name, INDIGO_NAME_SIZE))
+		return i;
+	for (int j = 0; j < interned->count; j++) {
+		if (!strncmp(interned->items[j], item->name, INDIGO_NAME_SIZE))
+			return j;
+	}
+	return -1;
+}
+
+static void patch_u16(indigo_binary_frame *frame, long offset, uint16_t value) {
+	frame->data[offset] = value;
+	frame->data[offset + 1] = value >> 8;
+}
+
+static indigo_result binary_device_adapter_define_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(property != NULL);
+	if (!indigo_reshare_remote_devices && device->is_remote)
+		return INDIGO_OK;
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	binary_adapter_context *client_context = (binary_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	if (client_context->context.output <= 0)
+		return INDIGO_OK;
+	indigo_queue_entry *entry = indigo_queue_entry_create(property, false);
+	pthread_mutex_lock(&client_context->mutex);
+	interned_property *interned = intern_property(client_context, property);
+	indigo_binary_frame *frame = &client_context->frame;
+	indigo_binary_frame_begin(frame, INDIGO_BINARY_DEFINE);
+	indigo_binary_put_u32(frame, interned->id);
+	indigo_binary_put_u8(frame, property->type);
+	indigo_binary_put_u8(frame, property->perm);
+	indigo_binary_put_u8(frame, property->state);
+	indigo_binary_put_u8(frame, property->rule);
+	indigo_binary_put_string(frame, property->device);
+	indigo_binary_put_string(frame, property->name);
+	indigo_binary_put_string(frame, property->group);
+	indigo_binary_put_string(frame, property->label);
+	indigo_binary_put_string(frame, property->hints);
+	indigo_binary_put_string(frame, message);
+	indigo_binary_put_u16(frame, property->count);
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = property->items + i;
+		indigo_binary_put_string(frame, item->name);
+		indigo_binary_put_string(frame, item->label);
+		indigo_binary_put_string(frame, item->hints);
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				indigo_binary_put_text(frame, indigo_get_text_item_value(item));
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				indigo_binary_put_string(frame, item->number.format);
+				indigo_binary_put_double(frame, item->number.min);
+				indigo_binary_put_double(frame, item->number.max);
+				indigo_binary_put_double(frame, item->number.step);
+				indigo_binary_put_double(frame, item->number.value);
+				indigo_binary_put_double(frame, item->number.target);
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				indigo_binary_put_u8(frame, item->sw.value);
+				break;
+			case INDIGO_LIGHT_VECTOR:
+				indigo_binary_put_u8(frame, item->light.value);
+				break;
+			case INDIGO_BLOB_VECTOR:
+				if (property->perm == INDIGO_WO_PERM) {
+					if (item->blob.url[0] == 0 || indigo_proxy_blob) {
+						char path[INDIGO_NAME_SIZE];
+						snprintf(path, sizeof(path), "/blob/%p", item);
+						indigo_binary_put_u8(frame, INDIGO_BINARY_BLOB_PATH);
+						indigo_binary_put_string(frame, path);
+					} else {
+						indigo_binary_put_u8(frame, INDIGO_BINARY_BLOB_URL);
+						indigo_binary_put_string(frame, item->blob.url);
+					}
+				} else {
+					indigo_binary_put_u8(frame, INDIGO_BINARY_BLOB_NONE);
+				}
+				break;
+		}
+	}
+	indigo_binary_frame_end(frame);
+	indigo_queue_entry_append(entry, frame->data, frame->length, INDIGO_QUEUE_RAW);
+	pthread_mutex_unlock(&client_context->mutex);
+	indigo_queue_push(client_context->context.queue, entry);
+	return INDIGO_OK;
+}
+
+static indigo_result binary_device_adapter_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(property != NULL);
+	if (!indigo_reshare_remote_devices && device->is_remote)
+		return INDIGO_OK;
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	binary_adapter_context *client_context = (binary_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	if (client_context->context.output <= 0)
+		return INDIGO_OK;
+	indigo_enable_blob_mode mode = INDIGO_ENABLE_BLOB_NEVER;
+	if (property->type == INDIGO_BLOB_VECTOR) {
+		indigo_enable_blob_mode_record *record = client->enable_blob_mode_records;
+		while (record) {
+			if ((*record->device == 0 || !strcmp(property->device, record->device)) && (*record->name == 0 || !strcmp(property->name, record->name))) {
+				mode = record->mode;
+				break;
+			}
+			record = record->next;
+		}
+		if (mode == INDIGO_ENABLE_BLOB_NEVER)
+			return INDIGO_OK;
+	}
+	pthread_mutex_lock(&client_context->mutex);
+	interned_property *interned = find_interned(client_context, property->device, property->name);
+	if (interned == NULL) {
+		/* client doesn't know the property */
+		pthread_mutex_unlock(&client_context->mutex);
+		return INDIGO_OK;
+	}
+	indigo_item **payload_items = NULL;
+	int payload_count = 0;
+	indigo_binary_frame *frame = &client_context->frame;
+	indigo_binary_frame_begin(frame, INDIGO_BINARY_UPDATE);
+	indigo_binary_put_u32(frame, interned->id);
+	indigo_binary_put_u8(frame, property->type);
+	indigo_binary_put_u8(frame, property->state);
+	indigo_binary_put_string(frame, message);
+	long count_offset = frame->length;
+	int count = 0;
+	indigo_binary_put_u16(frame, 0);
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = property->items + i;
+		int index = item_index(interned, i, item);
+		if (index < 0)
+			continue;
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				indigo_binary_put_u16(frame, index);
+				indigo_binary_put_text(frame, indigo_get_text_item_value(item));
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				indigo_binary_put_u16(frame, index);
+				indigo_binary_put_double(frame, item->number.value);
+				indigo_binary_put_double(frame, item->number.target);
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				indigo_binary_put_u16(frame, index);
+				indigo_binary_put_u8(frame, item->sw.value);
+				break;
+			case INDIGO_LIGHT_VECTOR:
+				indigo_binary_put_u16(frame, index);
+				indigo_binary_put_u8(frame, item->light.value);
+				break;
+			case INDIGO_BLOB_VECTOR:
+				if (property->state != INDIGO_OK_STATE)
+					continue;
+				indigo_binary_put_u16(frame, index);
+				if (mode == INDIGO_ENABLE_BLOB_URL) {
+					if (item->blob.value || indigo_proxy_blob) {
+						char path[INDIGO_VALUE_SIZE];
+						snprintf(path, sizeof(path), "/blob/%p%s", item, item->blob.format);
+						indigo_binary_put_u8(frame, INDIGO_BINARY_BLOB_PATH);
+						indigo_binary_put_string(frame, path);
+					} else {
+						indigo_binary_put_u8(frame, INDIGO_BINARY_BLOB_URL);
+						indigo_binary_put_string(frame, item->blob.url);
+					}
+				} else {
+					indigo_binary_put_u8(frame, INDIGO_BINARY_BLOB_DATA);
+					indigo_binary_put_string(frame, item->blob.format);
+					indigo_binary_put_u64(frame, item->blob.value ? item->blob.size : 0);
+					if (item->blob.value && item->blob.size > 0) {
+						if (payload_items == NULL)
+							payload_items = indigo_safe_malloc(property->count * sizeof(indigo_item *));
+						payload_items[payload_count++] = item;
+					}
+				}
+				break;
+		}
+		count++;
+	}
+	patch_u16(frame, count_offset, count);
+	indigo_binary_frame_end(frame);
+	indigo_queue_entry *entry = indigo_queue_entry_create_update(property, message);
+	indigo_queue_entry_append(entry, frame->data, frame->length, INDIGO_QUEUE_RAW);
+	pthread_mutex_unlock(&client_context->mutex);
+	/* raw BLOB payloads follow the frame, shared buffers are not copied */
+	for (int i = 0; i < payload_count; i++) {
+		indigo_item *item = payload_items[i];
+		indigo_blob_buffer *buffer = indigo_get_blob_item_buffer(item);
+		if (buffer)
+			indigo_queue_entry_append_buffer(entry, buffer, INDIGO_QUEUE_RAW);
+		else
+			indigo_queue_entry_append(entry, item->blob.value, item->blob.size, INDIGO_QUEUE_RAW);
+	}
+	indigo_safe_free(payload_items);
+	indigo_queue_push(client_context->context.queue, entry);
+	return INDIGO_OK;
+}
+
+static indigo_result binary_device_adapter_delete_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(property != NULL);
+	if (!indigo_reshare_remote_devices && device->is_remote)
+		return INDIGO_OK;
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	binary_adapter_context *client_context = (binary_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	if (client_context->context.output <= 0)
+		return INDIGO_OK;
+	const char *device_name = *property->device ? property->device : device->name;
+	pthread_mutex_lock(&client_context->mutex);
+	uint32_t id = 0;
+	if (*property->name) {
+		interned_property *interned = find_interned(client_context, device_name, property->name);
+		if (interned == NULL) {
+			pthread_mutex_unlock(&client_context->mutex);
+			return INDIGO_OK;
+		}
+		id = interned->id;
+		release_interned(client_context, interned);
+	} else {
+		for (uint32_t i = 0; i < client_context->id_count; i++) {
+			interned_property *interned = client_context->by_id[i];
+			if (interned && !strncmp(interned->device, device_name, INDIGO_NAME_SIZE))
+				release_interned(client_context, interned);
+		}
+	}
+	indigo_binary_frame *frame = &client_context->frame;
+	indigo_binary_frame_begin(frame, INDIGO_BINARY_DELETE);
+	indigo_binary_put_u32(frame, id);
+	indigo_binary_put_string(frame, device_name);
+	indigo_binary_put_string(frame, message);
+	indigo_binary_frame_end(frame);
+	indigo_queue_entry *entry = indigo_queue_entry_create_delete(property, device_name);
+	indigo_queue_entry_append(entry, frame->data, frame->length, INDIGO_QUEUE_RAW);
+	pthread_mutex_unlock(&client_context->mutex);
+	indigo_queue_push(client_context->context.queue, entry);
+	return INDIGO_OK;
+}
+
+static indigo_result binary_device_adapter_send_message(indigo_client *client, indigo_device *device, const char *message) {
+	assert(client != NULL);
+	if (device && !indigo_reshare_remote_devices && device->is_remote)
+		return INDIGO_OK;
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	binary_adapter_context *client_context = (binary_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	if (client_context->context.output <= 0)
+		return INDIGO_OK;
+	if (message == NULL)
+		return INDIGO_OK;
+	pthread_mutex_lock(&client_context->mutex);
+	indigo_binary_frame *frame = &client_context->frame;
+	indigo_binary_frame_begin(frame, INDIGO_BINARY_MESSAGE);
+	indigo_binary_put_string(frame, device ? device->name : "");
+	indigo_binary_put_string(frame, message);
+	indigo_binary_frame_end(frame);
+	indigo_queue_entry *entry = indigo_queue_entry_create(NULL, false);
+	indigo_queue_entry_append(entry, frame->data, frame->length, INDIGO_QUEUE_RAW);
+	pthread_mutex_unlock(&client_context->mutex);
+	indigo_queue_push(client_context->context.queue, entry);
+	return INDIGO_OK;
+}
+
+indigo_client *indigo_binary_device_adapter(int input, int ouput) {
+	static indigo_client client_template = {
+		"Binary Driver Adapter", false, NULL, INDIGO_OK, INDIGO_VERSION_NONE, NULL,
+		NULL,
+		binary_device_adapter_define_property,
+		binary_device_adapter_update_property,
+		binary_device_adapter_delete_property,
+		binary_device_adapter_send_message,
+		NULL
+	};
+	indigo_client *client = indigo_safe_malloc_copy(sizeof(indigo_client), &client_template);
+	binary_adapter_context *client_context = indigo_safe_malloc(sizeof(binary_adapter_context));
+	snprintf(client->name, sizeof(client->name), "Binary Driver Adapter #%d", input);
+	client_context->context.input = input;
+	client_context->context.output = ouput;
+	pthread_mutex_init(&client_context->mutex, NULL);
+	client_context->context.queue = indigo_queue_create(&client_context->context, indigo_write, input == ouput);
+	client->client_context = client_context;
+	client->is_remote = input == ouput;
+	return client;
+}
+
+void indigo_release_binary_device_adapter(indigo_client *client) {
+	assert(client != NULL);
+	assert(client->client_context != NULL);
+	binary_adapter_context *client_context = (binary_adapter_context *)client->client_context;
+	indigo_enable_blob_mode_record *blob_record = client->enable_blob_mode_records;
+	while (blob_record) {
+		client->enable_blob_mode_records = blob_record->next;
+		free(blob_record);
+		blob_record = client->enable_blob_mode_records;
+	}
+	indigo_queue_release(client_context->context.queue);
+	for (uint32_t i = 0; i < client_context->id_count; i++) {
+		interned_property *interned = client_context->by_id[i];
+		if (interned) {
+			indigo_safe_free(interned->items);
+			free(interned);
+		}
+	}
+	indigo_safe_free(client_context->by_id);
+	indigo_safe_free(client_context->free_ids);
+	indigo_binary_frame_release(&client_context->frame);
+	pthread_mutex_destroy(&client_context->mutex);
+	free(client_context);
+	free(client);
+}
@@ -32,15 +32,18 @@
 #include <pthread.h>
 #include <assert.h>
 #include <stdint.h>
+#include <sys/socket.h>
 #include <arpa/inet.h>
 
 
 #include <indigo/indigo_json.h>
 #include <indigo/indigo_io.h>
+#include <indigo/indigo_queue.h>
 
 //#undef INDIGO_TRACE_PROTOCOL
 //#define INDIGO_TRACE_PROTOCOL(c) c
 
+/* protects static buffers used by indigo_json_escape(), messages are written by per-client queues */
 static pthread_mutex_t json_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static bool ws_write(int handle, const char *buffer, long length) {
@@ -64,18 +67,6 @@ static bool ws_write(int handle, const char *buffer, long length) {
 	return result;
 }
 
-#define SPRINTF(...) { \
-	size = sprintf(__VA_ARGS__); \
-	pnt += size; \
-	size = pnt - output_buffer; \
-	if (size + 1024 > buffer_size) { \
-		buffer_size *= 2; \
-printf("realloc to %ld\n", buffer_size); \
-		output_buffer = indigo_safe_realloc(output_buffer, buffer_size); \
-		pnt = output_buffer + size; \
-	} \
-}
-
 static indigo_result json_define_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
 	assert(device != NULL);
 	assert(client != NULL);
@@ -84,126 +75,107 @@ static indigo_result json_define_property(indigo_client *client, indigo_device *
 		return INDIGO_OK;
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
-	pthread_mutex_lock(&json_mutex);
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
 	assert(client_context != NULL);
-	int handle = client_context->output;
-	long buffer_size = JSON_BUFFER_SIZE;
-	char *output_buffer = indigo_safe_malloc(buffer_size);
-	char *pnt = output_buffer;
-	long size;
+	if (client_context->output <= 0)
+		return INDIGO_OK;
+	indigo_queue_entry *entry = indigo_queue_entry_create(property, false);
+	pthread_mutex_lock(&json_mutex);
 	char b1[32], b2[32], b3[32], b4[32], b5[32];
 	switch (property->type) {
 		case INDIGO_TEXT_VECTOR:
-			SPRINTF(pnt, "{ \"defTextVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"perm\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, indigo_json_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state]);
+			indigo_queue_entry_printf(entry, "{ \"defTextVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"perm\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, indigo_json_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state]);
 			if (*property->hints) {
-				SPRINTF(pnt, ", \"hints\": \"%s\"", indigo_json_escape(property->hints));
+				indigo_queue_entry_printf(entry, ", \"hints\": \"%s\"", indigo_json_escape(property->hints));
 			}
 			if (message) {
-				SPRINTF(pnt, ", \"message\": \"%s\", \"items\": [ ", indigo_json_escape(message));
+				indigo_queue_entry_printf(entry, ", \"message\": \"%s\", \"items\": [ ", indigo_json_escape(message));
 			} else {
-				SPRINTF(pnt, ", \"items\": [ ");
+				indigo_queue_entry_printf(entry, ", \"items\": [ ");
 			}
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				SPRINTF(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, indigo_json_escape(item->label), indigo_json_escape(indigo_get_text_item_value(item)));
+				indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, indigo_json_escape(item->label), indigo_json_escape(indigo_get_text_item_value(item)));
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
+			indigo_queue_entry_printf(entry, " ] } }");
 			break;
 		case INDIGO_NUMBER_VECTOR:
-			SPRINTF(pnt, "{ \"defNumberVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"perm\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, indigo_json_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state]);
+			indigo_queue_entry_printf(entry, "{ \"defNumberVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"perm\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, indigo_json_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state]);
 			if (*property->hints) {
-				SPRINTF(pnt, ", \"hints\": \"%s\"", indigo_json_escape(property->hints));
+				indigo_queue_entry_printf(entry, ", \"hints\": \"%s\"", indigo_json_escape(property->hints));
 			}
 			if (message) {
-				SPRINTF(pnt, ", \"message\": \"%s\", \"items\": [ ", indigo_json_escape(message));
+				indigo_queue_entry_printf(entry, ", \"message\": \"%s\", \"items\": [ ", indigo_json_escape(message));
 			} else {
-				SPRINTF(pnt, ", \"items\": [ ");
+				indigo_queue_entry_printf(entry, ", \"items\": [ ");
 			}
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
 				if (property->perm != INDIGO_RO_PERM) {
-					SPRINTF(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"min\": %s, \"max\": %s, \"step\": %s, \"format\": \"%s\", \"target\": %s, \"value\": %s }",  i > 0 ? "," : "", item->name, indigo_json_escape(item->label), indigo_dtoa(item->number.min, b1), indigo_dtoa(item->number.max, b2), indigo_dtoa(item->number.step, b3), item->number.format, indigo_dtoa(item->number.target, b4), indigo_dtoa(item->number.value, b5));
+					indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"label\": \"%s\", \"min\": %s, \"max\": %s, \"step\": %s, \"format\": \"%s\", \"target\": %s, \"value\": %s }",  i > 0 ? "," : "", item->name, indigo_json_escape(item->label), indigo_dtoa(item->number.min, b1), indigo_dtoa(item->number.max, b2), indigo_dtoa(item->number.step, b3), item->number.format, indigo_dtoa(item->number.target, b4), indigo_dtoa(item->number.value, b5));
 				} else {
-					SPRINTF(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"min\": %s, \"max\": %s, \"step\": %s, \"format\": \"%s\", \"value\": %s }",  i > 0 ? "," : "", item->name, indigo_json_escape(item->label), indigo_dtoa(item->number.min, b1), indigo_dtoa(item->number.max, b2), indigo_dtoa(item->number.step, b3), item->number.format, indigo_dtoa(item->number.value, b4));
+					indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"label\": \"%s\", \"min\": %s, \"max\": %s, \"step\": %s, \"format\": \"%s\", \"value\": %s }",  i > 0 ? "," : "", item->name, indigo_json_escape(item->label), indigo_dtoa(item->number.min, b1), indigo_dtoa(item->number.max, b2), indigo_dtoa(item->number.step, b3), item->number.format, indigo_dtoa(item->number.value, b4));
 				}
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
+			indigo_queue_entry_printf(entry, " ] } }");
 			break;
 		case INDIGO_SWITCH_VECTOR:
-			SPRINTF(pnt, "{ \"defSwitchVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"perm\": \"%s\", \"state\": \"%s\", \"rule\": \"%s\"", property->version, property->device, property->name, property->group, indigo_json_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], indigo_switch_rule_text[property->rule]);
+			indigo_queue_entry_printf(entry, "{ \"defSwitchVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"perm\": \"%s\", \"state\": \"%s\", \"rule\": \"%s\"", property->version, property->device, property->name, property->group, indigo_json_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], indigo_switch_rule_text[property->rule]);
 			if (*property->hints) {
-				SPRINTF(pnt, ", \"hints\": \"%s\"", indigo_json_escape(property->hints));
+				indigo_queue_entry_printf(entry, ", \"hints\": \"%s\"", indigo_json_escape(property->hints));
 			}
 			if (message) {
-				SPRINTF(pnt, ", \"message\": \"%s\", \"items\": [ ", indigo_json_escape(message));
+				indigo_queue_entry_printf(entry, ", \"message\": \"%s\", \"items\": [ ", indigo_json_escape(message));
 			} else {
-				SPRINTF(pnt, ", \"items\": [ ");
+				indigo_queue_entry_printf(entry, ", \"items\": [ ");
 			}
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				SPRINTF(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": %s }",  i > 0 ? "," : "", item->name, indigo_json_escape(item->label), item->sw.value ? "true" : "false");
+				indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": %s }",  i > 0 ? "," : "", item->name, indigo_json_escape(item->label), item->sw.value ? "true" : "false");
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
+			indigo_queue_entry_printf(entry, " ] } }");
 			break;
 		case INDIGO_LIGHT_VECTOR:
-			SPRINTF(pnt, "{ \"defLightVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, indigo_json_escape(property->label), indigo_property_state_text[property->state]);
+			indigo_queue_entry_printf(entry, "{ \"defLightVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, indigo_json_escape(property->label), indigo_property_state_text[property->state]);
 			if (*property->hints) {
-				SPRINTF(pnt, ", \"hints\": \"%s\"", indigo_json_escape(property->hints));
+				indigo_queue_entry_printf(entry, ", \"hints\": \"%s\"", indigo_json_escape(property->hints));
 			}
 			if (message) {
-				SPRINTF(pnt, ", \"message\": \"%s\", \"items\": [ ", indigo_json_escape(message));
+				indigo_queue_entry_printf(entry, ", \"message\": \"%s\", \"items\": [ ", indigo_json_escape(message));
 			} else {
-				SPRINTF(pnt, ", \"items\": [ ");
+				indigo_queue_entry_printf(entry, ", \"items\": [ ");
 			}
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				SPRINTF(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, indigo_json_escape(item->label), indigo_property_state_text[item->light.value]);
+				indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, indigo_json_escape(item->label), indigo_property_state_text[item->light.value]);
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
+			indigo_queue_entry_printf(entry, " ] } }");
 			break;
 		case INDIGO_BLOB_VECTOR:
-			SPRINTF(pnt, "{ \"defBLOBVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, indigo_json_escape(property->label), indigo_property_state_text[property->state]);
+			indigo_queue_entry_printf(entry, "{ \"defBLOBVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, indigo_json_escape(property->label), indigo_property_state_text[property->state]);
 			if (*property->hints) {
-				SPRINTF(pnt, ", \"hints\": \"%s\"", indigo_json_escape(property->hints));
+				indigo_queue_entry_printf(entry, ", \"hints\": \"%s\"", indigo_json_escape(property->hints));
 			}
 			if (message) {
-				SPRINTF(pnt, ", \"message\": \"%s\", \"items\": [ ", indigo_json_escape(message));
+				indigo_queue_entry_printf(entry, ", \"message\": \"%s\", \"items\": [ ", indigo_json_escape(message));
 			} else {
-				SPRINTF(pnt, ", \"items\": [ ");
+				indigo_queue_entry_printf(entry, ", \"items\": [ ");
 			}
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
 				if ((property->state == INDIGO_OK_STATE && item->blob.value) || indigo_proxy_blob) {
-					SPRINTF(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": \"/blob/%p%s\" }", i > 0 ? "," : "", item->name, indigo_json_escape(item->label), item, item->blob.format);
+					indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": \"/blob/%p%s\" }", i > 0 ? "," : "", item->name, indigo_json_escape(item->label), item, item->blob.format);
 				} else if (property->state == INDIGO_OK_STATE && *item->blob.url) {
-					SPRINTF(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": \"%s\" }", i > 0 ? "," : "", item->name, indigo_json_escape(item->label), item->blob.url);
+					indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": \"%s\" }", i > 0 ? "," : "", item->name, indigo_json_escape(item->label), item->blob.url);
 				} else {
-					SPRINTF(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\"  }", i > 0 ? "," : "", item->name, indigo_json_escape(item->label));
+					indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"label\": \"%s\"  }", i > 0 ? "," : "", item->name, indigo_json_escape(item->label));
 				}
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
+			indigo_queue_entry_printf(entry, " ] } }");
 			break;
 	}
-	if (client_context->web_socket ? ws_write(handle, output_buffer, size) : indigo_write(handle, output_buffer, size)) {
-		INDIGO_TRACE_PROTOCOL(indigo_trace("%d <- %s\n", handle, output_buffer));
-	} else {
-		INDIGO_TRACE_PROTOCOL(indigo_trace("%d <- FAILED\n", handle));
-		if (client_context->output == client_context->input) {
-			close(client_context->input);
-		} else {
-			close(client_context->input);
-			close(client_context->output);
-		}
-		client_context->output = client_context->input = -1;
-	}
-	free(output_buffer);
 	pthread_mutex_unlock(&json_mutex);
+	indigo_queue_push(client_context->queue, entry);
 	return INDIGO_OK;
 }
 
@@ -216,112 +188,91 @@ static indigo_result json_update_property(indigo_client *client, indigo_device *
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
-	int handle = client_context->output;
-	if (handle <= 0)
+	assert(client_context != NULL);
+	if (client_context->output <= 0)
 		return INDIGO_OK;
+	indigo_queue_entry *entry = indigo_queue_entry_create_update(property, message);
 	pthread_mutex_lock(&json_mutex);
-	assert(client_context != NULL);
-	long buffer_size = JSON_BUFFER_SIZE;
-	char *output_buffer = indigo_safe_malloc(buffer_size);
-	char *pnt = output_buffer;
-	long size;
 	char b1[32], b2[32];
 	switch (property->type) {
 		case INDIGO_TEXT_VECTOR:
-			SPRINTF(pnt, "{ \"setTextVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
+			indigo_queue_entry_printf(entry, "{ \"setTextVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
 			if (message) {
-				SPRINTF(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
+				indigo_queue_entry_printf(entry, ", \"message\": \"%s\", \"items\": [ ", message);
 			} else {
-				SPRINTF(pnt, ", \"items\": [ ");
+				indigo_queue_entry_printf(entry, ", \"items\": [ ");
 			}
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				SPRINTF(pnt, "%s { \"name\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, indigo_json_escape(indigo_get_text_item_value(item)));
+				indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, indigo_json_escape(indigo_get_text_item_value(item)));
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
+			indigo_queue_entry_printf(entry, " ] } }");
 			break;
 		case INDIGO_NUMBER_VECTOR:
-			SPRINTF(pnt, "{ \"setNumberVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
+			indigo_queue_entry_printf(entry, "{ \"setNumberVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
 			if (message) {
-				SPRINTF(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
+				indigo_queue_entry_printf(entry, ", \"message\": \"%s\", \"items\": [ ", message);
 			} else {
-				SPRINTF(pnt, ", \"items\": [ ");
+				indigo_queue_entry_printf(entry, ", \"items\": [ ");
 			}
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
 				if (property->perm != INDIGO_RO_PERM) {
-					SPRINTF(pnt, "%s { \"name\": \"%s\", \"target\": %s, \"value\": %s }",  i > 0 ? "," : "", item->name, indigo_dtoa(item->number.target, b1), indigo_dtoa(item->number.value, b2));
+					indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"target\": %s, \"value\": %s }",  i > 0 ? "," : "", item->name, indigo_dtoa(item->number.target, b1), indigo_dtoa(item->number.value, b2));
 				} else {
-					SPRINTF(pnt, "%s { \"name\": \"%s\", \"value\": %s }",  i > 0 ? "," : "", item->name, indigo_dtoa(item->number.value, b1));
+					indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"value\": %s }",  i > 0 ? "," : "", item->name, indigo_dtoa(item->number.value, b1));
 				}
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
+			indigo_queue_entry_printf(entry, " ] } }");
 			break;
 		case INDIGO_SWITCH_VECTOR:
-			SPRINTF(pnt, "{ \"setSwitchVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
+			indigo_queue_entry_printf(entry, "{ \"setSwitchVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
 			if (message) {
-				SPRINTF(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
+				indigo_queue_entry_printf(entry, ", \"message\": \"%s\", \"items\": [ ", message);
 			} else {
-				SPRINTF(pnt, ", \"items\": [ ");
+				indigo_queue_entry_printf(entry, ", \"items\": [ ");
 			}
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				SPRINTF(pnt, "%s { \"name\": \"%s\", \"value\": %s }",  i > 0 ? "," : "", item->name, item->sw.value ? "true" : "false");
+				indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"value\": %s }",  i > 0 ? "," : "", item->name, item->sw.value ? "true" : "false");
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
+			indigo_queue_entry_printf(entry, " ] } }");
 			break;
 		case INDIGO_LIGHT_VECTOR:
-			SPRINTF(pnt, "{ \"setLightVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
+			indigo_queue_entry_printf(entry, "{ \"setLightVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
 			if (message) {
-				SPRINTF(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
+				indigo_queue_entry_printf(entry, ", \"message\": \"%s\", \"items\": [ ", message);
 			} else {
-				SPRINTF(pnt, ", \"items\": [ ");
+				indigo_queue_entry_printf(entry, ", \"items\": [ ");
 			}
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				SPRINTF(pnt, "%s { \"name\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, indigo_property_state_text[item->light.value]);
+				indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, indigo_property_state_text[item->light.value]);
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
+			indigo_queue_entry_printf(entry, " ] } }");
 			break;
 		case INDIGO_BLOB_VECTOR:
-			SPRINTF(pnt, "{ \"setBLOBVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
+			indigo_queue_entry_printf(entry, "{ \"setBLOBVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
 			if (message) {
-				SPRINTF(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
+				indigo_queue_entry_printf(entry, ", \"message\": \"%s\", \"items\": [ ", message);
 			} else {
-				SPRINTF(pnt, ", \"items\": [ ");
+				indigo_queue_entry_printf(entry, ", \"items\": [ ");
 			}
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
 				if ((property->state == INDIGO_OK_STATE && item->blob.value) || indigo_proxy_blob) {
-					SPRINTF(pnt, "%s { \"name\": \"%s\", \"value\": \"/blob/%p%s\" }", i > 0 ? "," : "", item->name, item, item->blob.format);
+					indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"value\": \"/blob/%p%s\" }", i > 0 ? "," : "", item->name, item, item->blob.format);
 				} else if (property->state == INDIGO_OK_STATE && *item->blob.url) {
-					SPRINTF(pnt, "%s { \"name\": \"%s\", \"value\": \"%s\" }", i > 0 ? "," : "", item->name, item->blob.url);
+					indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\", \"value\": \"%s\" }", i > 0 ? "," : "", item->name, item->blob.url);
 				} else {
-					SPRINTF(pnt, "%s { \"name\": \"%s\" }", i > 0 ? "," : "", item->name);
+					indigo_queue_entry_printf(entry, "%s { \"name\": \"%s\" }", i > 0 ? "," : "", item->name);
 				}
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
+			indigo_queue_entry_printf(entry, " ] } }");
 			break;
 	}
-	if (client_context->web_socket ? ws_write(handle, output_buffer, size) : indigo_write(handle, output_buffer, size)) {
-		INDIGO_TRACE_PROTOCOL(indigo_trace("%d <- %s\n", handle, output_buffer));
-	} else {
-		INDIGO_TRACE_PROTOCOL(indigo_trace("%d <- FAILED\n", handle));
-		if (client_context->output == client_context->input) {
-			close(client_context->input);
-		} else {
-			close(client_context->input);
-			close(client_context->output);
-		}
-		client_context->output = client_context->input = -1;
-	}
-	free(output_buffer);
 	pthread_mutex_unlock(&json_mutex);
+	indigo_queue_push(client_context->queue, entry);
 	return INDIGO_OK;
 }
 
@@ -333,42 +284,23 @@ static indigo_result json_delete_property(indigo_client *client, indigo_device *
 		return INDIGO_OK;
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
-	pthread_mutex_lock(&json_mutex);
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
 	assert(client_context != NULL);
-	int handle = client_context->output;
-	char *output_buffer = indigo_safe_malloc(JSON_BUFFER_SIZE);
-	char *pnt = output_buffer;
-	long size;
+	if (client_context->output <= 0)
+		return INDIGO_OK;
+	indigo_queue_entry *entry = indigo_queue_entry_create_delete(property, device->name);
+	pthread_mutex_lock(&json_mutex);
 	if (*property->name == 0)
-		size = sprintf(pnt, "{ \"deleteProperty\": { \"device\": \"%s\"", device->name);
+		indigo_queue_entry_printf(entry, "{ \"deleteProperty\": { \"device\": \"%s\"", device->name);
 	else
-		size = sprintf(pnt, "{ \"deleteProperty\": { \"device\": \"%s\", \"name\": \"%s\"", property->device, property->name);
-	pnt += size;
+		indigo_queue_entry_printf(entry, "{ \"deleteProperty\": { \"device\": \"%s\", \"name\": \"%s\"", property->device, property->name);
 	if (message) {
-		size = sprintf(pnt, ", \"message\": \"%s\" } }", message);
-	} else {
-		size = sprintf(pnt, " } }");
-	}
-	size += pnt - output_buffer;
-	if (client_context->web_socket)
-		ws_write(handle, output_buffer, size);
-	else
-		indigo_write(handle, output_buffer, size);
-	if (client_context->web_socket ? ws_write(handle, output_buffer, size) : indigo_write(handle, output_buffer, size)) {
-		INDIGO_TRACE_PROTOCOL(indigo_trace("%d <- %s\n", handle, output_buffer));
+		indigo_queue_entry_printf(entry, ", \"message\": \"%s\" } }", message);
 	} else {
-		INDIGO_TRACE_PROTOCOL(indigo_trace("%d <- FAILED\n", handle));
-		if (client_context->output == client_context->input) {
-			close(client_context->input);
-		} else {
-			close(client_context->input);
-			close(client_context->output);
-		}
-		client_context->output = client_context->input = -1;
+		indigo_queue_entry_printf(entry, " } }");
 	}
-	free(output_buffer);
 	pthread_mutex_unlock(&json_mutex);
+	indigo_queue_push(client_context->queue, entry);
 	return INDIGO_OK;
 }
 
@@ -377,35 +309,26 @@ static indigo_result json_message_property(indigo_client *client, indigo_device
 	assert(client != NULL);
 	if (!indigo_reshare_remote_devices && device->is_remote)
 		return INDIGO_OK;
-	pthread_mutex_lock(&json_mutex);
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
 	assert(client_context != NULL);
-	int handle = client_context->output;
-	char *output_buffer = indigo_safe_malloc(JSON_BUFFER_SIZE);
-	char *pnt = output_buffer;
-	long size = sprintf(pnt, "{ \"message\": \"%s\" }", message);
-	if (client_context->web_socket ? ws_write(handle, output_buffer, size) : indigo_write(handle, output_buffer, size)) {
-		INDIGO_TRACE_PROTOCOL(indigo_trace("%d <- %s\n", handle, output_buffer));
-	} else {
-		INDIGO_TRACE_PROTOCOL(indigo_trace("%d <- FAILED\n", handle));
-		if (client_context->output == client_context->input) {
-			close(client_context->input);
-		} else {
-			close(client_context->input);
-			close(client_context->output);
-		}
-		client_context->output = client_context->input = -1;
-	}
-	free(output_buffer);
-	pthread_mutex_unlock(&json_mutex);
+	if (client_context->output <= 0 || message == NULL)
+		return INDIGO_OK;
+	indigo_queue_entry *entry = indigo_queue_entry_create(NULL, false);
+	indigo_queue_entry_printf(entry, "{ \"message\": \"%s\" }", message);
+	indigo_queue_push(client_context->queue, entry);
 	return INDIGO_OK;
 }
 
 static indigo_result json_detach(indigo_client *client) {
 	assert(client != NULL);
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
-	close(client_context->input);
-	close(client_context->output);
+	if (client_context->input == client_context->output) {
+		/* wake up reader, socket is closed by the server worker thread after writer is stopped */
+		shutdown(client_context->input, SHUT_RDWR);
+	} else {
+		close(client_context->input);
+		close(client_context->output);
+	}
 	return INDIGO_OK;
 }
 
@@ -426,6 +349,7 @@ indigo_client *indigo_json_device_adapter(int input, int ouput, bool web_socket)
 	client_context->input = input;
 	client_context->output = ouput;
 	client_context->web_socket = web_socket;
+	client_context->queue = indigo_queue_create_shared(client_context, web_socket ? ws_write : indigo_write);
 	client->client_context = client_context;
 	client->is_remote = input == ouput;
 	return client;
@@ -434,6 +358,7 @@ indigo_client *indigo_json_device_adapter(int input, int ouput, bool web_socket)
 void indigo_release_json_device_adapter(indigo_client *client) {
 	assert(client != NULL);
 	assert(client->client_context != NULL);
+	indigo_queue_release(((indigo_adapter_context *)client->client_context)->queue);
 	free(client->client_context);
 	free(client);
 }
@@ -47,15 +47,12 @@
 
 #include <indigo/indigo_xml.h>
 #include <indigo/indigo_io.h>
-#include <indigo/indigo_base64.h>
+#include <indigo/indigo_queue.h>
 #include <indigo/indigo_version.h>
 #include <indigo/indigo_driver_xml.h>
 
-#define RAW_BUF_SIZE 98304
-#define BASE64_BUF_SIZE 131072  /* BASE64_BUF_SIZE >= (RAW_BUF_SIZE + 2) / 3 * 4 */
-#define INDIGO_PRINTF(...) if (!indigo_printf(__VA_ARGS__)) goto failure
-
-static pthread_mutex_t write_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* protects static buffers used by indigo_xml_escape() and attribute formatters, messages are written by per-client queues */
+static pthread_mutex_t format_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static const char *message_attribute(const char *message) {
 	if (message) {
@@ -84,83 +81,72 @@ static indigo_result xml_device_adapter_define_property(indigo_client *client, i
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	assert(client_context != NULL);
 	if (client_context->output <= 0)
 		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
-	assert(client_context != NULL);
-	int handle = client_context->output;
+	indigo_queue_entry *entry = indigo_queue_entry_create(property, false);
+	pthread_mutex_lock(&format_mutex);
 	char b1[32], b2[32], b3[32], b4[32], b5[32];
 	switch (property->type) {
 	case INDIGO_TEXT_VECTOR:
-		INDIGO_PRINTF(handle, "<defTextVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
+		indigo_queue_entry_printf(entry, "<defTextVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
-			INDIGO_PRINTF(handle, "<defText name='%s' label='%s'%s>%s</defText>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), indigo_xml_escape(indigo_get_text_item_value(item)));
+			indigo_queue_entry_printf(entry, "<defText name='%s' label='%s'%s>%s</defText>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), indigo_xml_escape(indigo_get_text_item_value(item)));
 		}
-		INDIGO_PRINTF(handle, "</defTextVector>\n");
+		indigo_queue_entry_printf(entry, "</defTextVector>\n");
 		break;
 	case INDIGO_NUMBER_VECTOR:
-		INDIGO_PRINTF(handle, "<defNumberVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
+		indigo_queue_entry_printf(entry, "<defNumberVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
 			if (client->version >= INDIGO_VERSION_2_0 && property->perm != INDIGO_RO_PERM) {
-				INDIGO_PRINTF(handle, "<defNumber name='%s' label='%s' format='%s' min='%s' max='%s' step='%s' target='%s'>%s</defNumber>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), item->number.format, indigo_dtoa(item->number.min, b1), indigo_dtoa(item->number.max, b2), indigo_dtoa(item->number.step, b3), indigo_dtoa(item->number.target, b4), indigo_dtoa(item->number.value, b5));
+				indigo_queue_entry_printf(entry, "<defNumber name='%s' label='%s' format='%s' min='%s' max='%s' step='%s' target='%s'>%s</defNumber>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), item->number.format, indigo_dtoa(item->number.min, b1), indigo_dtoa(item->number.max, b2), indigo_dtoa(item->number.step, b3), indigo_dtoa(item->number.target, b4), indigo_dtoa(item->number.value, b5));
 			} else {
-				INDIGO_PRINTF(handle, "<defNumber name='%s' label='%s'%s format='%s' min='%s' max='%s' step='%s'>%s</defNumber>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), item->number.format, indigo_dtoa(item->number.min, b1), indigo_dtoa(item->number.max, b2), indigo_dtoa(item->number.step, b3), indigo_dtoa(item->number.value, b4));
+				indigo_queue_entry_printf(entry, "<defNumber name='%s' label='%s'%s format='%s' min='%s' max='%s' step='%s'>%s</defNumber>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), item->number.format, indigo_dtoa(item->number.min, b1), indigo_dtoa(item->number.max, b2), indigo_dtoa(item->number.step, b3), indigo_dtoa(item->number.value, b4));
 			}
 		}
-		INDIGO_PRINTF(handle, "</defNumberVector>\n");
+		indigo_queue_entry_printf(entry, "</defNumberVector>\n");
 		break;
 	case INDIGO_SWITCH_VECTOR:
-		INDIGO_PRINTF(handle, "<defSwitchVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s' rule='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], indigo_switch_rule_text[property->rule], hints_attribute(property->hints), message_attribute(message));
+		indigo_queue_entry_printf(entry, "<defSwitchVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s' rule='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], indigo_switch_rule_text[property->rule], hints_attribute(property->hints), message_attribute(message));
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
-			INDIGO_PRINTF(handle, "<defSwitch name='%s' label='%s'%s>%s</defSwitch>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), item->sw.value ? "On" : "Off");
+			indigo_queue_entry_printf(entry, "<defSwitch name='%s' label='%s'%s>%s</defSwitch>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), item->sw.value ? "On" : "Off");
 		}
-		INDIGO_PRINTF(handle, "</defSwitchVector>\n");
+		indigo_queue_entry_printf(entry, "</defSwitchVector>\n");
 		break;
 	case INDIGO_LIGHT_VECTOR:
-		INDIGO_PRINTF(handle, "<defLightVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
+		indigo_queue_entry_printf(entry, "<defLightVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
-			INDIGO_PRINTF(handle, " <defLight name='%s' label='%s'%s>%s</defLight>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), indigo_property_state_text[item->light.value]);
+			indigo_queue_entry_printf(entry, " <defLight name='%s' label='%s'%s>%s</defLight>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), indigo_property_state_text[item->light.value]);
 		}
-		INDIGO_PRINTF(handle, "</defLightVector>\n");
+		indigo_queue_entry_printf(entry, "</defLightVector>\n");
 		break;
 	case INDIGO_BLOB_VECTOR:
-		INDIGO_PRINTF(handle, "<defBLOBVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
+		indigo_queue_entry_printf(entry, "<defBLOBVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
 			if (property->perm == INDIGO_WO_PERM && client->version >= INDIGO_VERSION_2_0) {
 				if (item->blob.url[0] == 0 || indigo_proxy_blob) {
-					INDIGO_PRINTF(handle, "<defBLOB name='%s' path='/blob/%p' label='%s'%s/>\n", indigo_item_name(client->version, property, item), item, indigo_xml_escape(item->label), hints_attribute(item->hints));
+					indigo_queue_entry_printf(entry, "<defBLOB name='%s' path='/blob/%p' label='%s'%s/>\n", indigo_item_name(client->version, property, item), item, indigo_xml_escape(item->label), hints_attribute(item->hints));
 				} else {
-					INDIGO_PRINTF(handle, "<defBLOB name='%s' url='%s' label='%s'%s/>\n", indigo_item_name(client->version, property, item), item->blob.url, indigo_xml_escape(item->label), hints_attribute(item->hints));
+					indigo_queue_entry_printf(entry, "<defBLOB name='%s' url='%s' label='%s'%s/>\n", indigo_item_name(client->version, property, item), item->blob.url, indigo_xml_escape(item->label), hints_attribute(item->hints));
 				}
 			} else {
-				INDIGO_PRINTF(handle, "<defBLOB name='%s' label='%s'%s/>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints));
+				indigo_queue_entry_printf(entry, "<defBLOB name='%s' label='%s'%s/>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints));
 			}
 		}
-		INDIGO_PRINTF(handle, "</defBLOBVector>\n");
+		indigo_queue_entry_printf(entry, "</defBLOBVector>\n");
 		break;
 	}
-	pthread_mutex_unlock(&write_mutex);
-	return INDIGO_OK;
-failure:
-	if (client_context->output == client_context->input) {
-		close(client_context->input);
-	} else {
-		close(client_context->input);
-		close(client_context->output);
-	}
-	client_context->output = client_context->input = -1;
-	pthread_mutex_unlock(&write_mutex);
+	pthread_mutex_unlock(&format_mutex);
+	indigo_queue_push(client_context->queue, entry);
 	return INDIGO_OK;
 }
 
 static indigo_result xml_device_adapter_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
-	FILE* fh;
-	int handle2;
 	assert(device != NULL);
 	assert(client != NULL);
 	assert(property != NULL);
@@ -169,48 +155,48 @@ static indigo_result xml_device_adapter_update_property(indigo_client *client, i
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	assert(client_context != NULL);
 	if (client_context->output <= 0)
 		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
-	assert(client_context != NULL);
-	int handle = client_context->output;
+	indigo_queue_entry *entry = indigo_queue_entry_create_update(property, message);
+	pthread_mutex_lock(&format_mutex);
 	char b1[32], b2[32];
 	switch (property->type) {
 		case INDIGO_TEXT_VECTOR:
-			INDIGO_PRINTF(handle, "<setTextVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
+			indigo_queue_entry_printf(entry, "<setTextVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				INDIGO_PRINTF(handle, "<oneText name='%s'>%s</oneText>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(indigo_get_text_item_value(item)));
+				indigo_queue_entry_printf(entry, "<oneText name='%s'>%s</oneText>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(indigo_get_text_item_value(item)));
 			}
-			INDIGO_PRINTF(handle, "</setTextVector>\n");
+			indigo_queue_entry_printf(entry, "</setTextVector>\n");
 			break;
 		case INDIGO_NUMBER_VECTOR:
-			INDIGO_PRINTF(handle, "<setNumberVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
+			indigo_queue_entry_printf(entry, "<setNumberVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
 				if (client->version >= INDIGO_VERSION_2_0 && property->perm != INDIGO_RO_PERM) {
-					INDIGO_PRINTF(handle, "<oneNumber name='%s' target='%s'>%s</oneNumber>\n", indigo_item_name(client->version, property, item), indigo_dtoa(item->number.target, b1), indigo_dtoa(item->number.value, b2));
+					indigo_queue_entry_printf(entry, "<oneNumber name='%s' target='%s'>%s</oneNumber>\n", indigo_item_name(client->version, property, item), indigo_dtoa(item->number.target, b1), indigo_dtoa(item->number.value, b2));
 				} else {
-					INDIGO_PRINTF(handle, "<oneNumber name='%s'>%s</oneNumber>\n", indigo_item_name(client->version, property, item), indigo_dtoa(item->number.value, b1));
+					indigo_queue_entry_printf(entry, "<oneNumber name='%s'>%s</oneNumber>\n", indigo_item_name(client->version, property, item), indigo_dtoa(item->number.value, b1));
 				}
 			}
-			INDIGO_PRINTF(handle, "</setNumberVector>\n");
+			indigo_queue_entry_printf(entry, "</setNumberVector>\n");
 			break;
 		case INDIGO_SWITCH_VECTOR:
-			INDIGO_PRINTF(handle, "<setSwitchVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
+			indigo_queue_entry_printf(entry, "<setSwitchVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				INDIGO_PRINTF(handle, "<oneSwitch name='%s'>%s</oneSwitch>\n", indigo_item_name(client->version, property, item), item->sw.value ? "On" : "Off");
+				indigo_queue_entry_printf(entry, "<oneSwitch name='%s'>%s</oneSwitch>\n", indigo_item_name(client->version, property, item), item->sw.value ? "On" : "Off");
 			}
-			INDIGO_PRINTF(handle, "</setSwitchVector>\n");
+			indigo_queue_entry_printf(entry, "</setSwitchVector>\n");
 			break;
 		case INDIGO_LIGHT_VECTOR:
-			INDIGO_PRINTF(handle, "<setLightVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
+			indigo_queue_entry_printf(entry, "<setLightVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				INDIGO_PRINTF(handle, "<oneLight name='%s'>%s</oneLight>\n", indigo_item_name(client->version, property, item), indigo_property_state_text[item->light.value]);
+				indigo_queue_entry_printf(entry, "<oneLight name='%s'>%s</oneLight>\n", indigo_item_name(client->version, property, item), indigo_property_state_text[item->light.value]);
 			}
-			INDIGO_PRINTF(handle, "</setLightVector>\n");
+			indigo_queue_entry_printf(entry, "</setLightVector>\n");
 			break;
 		case INDIGO_BLOB_VECTOR: {
 			indigo_enable_blob_mode mode = INDIGO_ENABLE_BLOB_NEVER;
@@ -222,66 +208,42 @@ static indigo_result xml_device_adapter_update_property(indigo_client *client, i
 				}
 				record = record->next;
 			}
-			if (mode != INDIGO_ENABLE_BLOB_NEVER) {
-				INDIGO_PRINTF(handle, "<setBLOBVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
-				if (property->state == INDIGO_OK_STATE) {
-					for (int i = 0; i < property->count; i++) {
-						indigo_item *item = &property->items[i];
-						if (mode == INDIGO_ENABLE_BLOB_URL && client->version >= INDIGO_VERSION_2_0) {
-							if (item->blob.value || indigo_proxy_blob) {
-								INDIGO_PRINTF(handle, "<oneBLOB name='%s' path='/blob/%p%s'/>\n", indigo_item_name(client->version, property, item), item, item->blob.format);
-							} else {
-								INDIGO_PRINTF(handle, "<oneBLOB name='%s' url='%s'/>\n", indigo_item_name(client->version, property, item), item->blob.url);
-							}
+			if (mode == INDIGO_ENABLE_BLOB_NEVER) {
+				pthread_mutex_unlock(&format_mutex);
+				indigo_queue_entry_release(entry);
+				return INDIGO_OK;
+			}
+			indigo_queue_entry_printf(entry, "<setBLOBVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
+			if (property->state == INDIGO_OK_STATE) {
+				for (int i = 0; i < property->count; i++) {
+					indigo_item *item = &property->items[i];
+					if (mode == INDIGO_ENABLE_BLOB_URL && client->version >= INDIGO_VERSION_2_0) {
+						if (item->blob.value || indigo_proxy_blob) {
+							indigo_queue_entry_printf(entry, "<oneBLOB name='%s' path='/blob/%p%s'/>\n", indigo_item_name(client->version, property, item), item, item->blob.format);
+						} else {
+							indigo_queue_entry_printf(entry, "<oneBLOB name='%s' url='%s'/>\n", indigo_item_name(client->version, property, item), item->blob.url);
+						}
+					} else {
+						indigo_queue_entry_printf(entry, "<oneBLOB name='%s' format='%s' size='%ld'>\n", indigo_item_name(client->version, property, item), item->blob.format, item->blob.size);
+						indigo_blob_buffer *buffer = indigo_get_blob_item_buffer(item);
+						if (buffer) {
+							indigo_queue_entry_append_buffer(entry, buffer, INDIGO_QUEUE_BASE64);
 						} else {
-							long input_length = item->blob.size;
-							unsigned char *data = item->blob.value;
-							INDIGO_PRINTF(handle, "<oneBLOB name='%s' format='%s' size='%ld'>\n", indigo_item_name(client->version, property, item), item->blob.format, item->blob.size);
-							handle2 = dup(handle);
-							fh = fdopen(handle2, "w");
-							if (client->version >= INDIGO_VERSION_2_0) {
-								while (input_length) {
-									char encoded_data[BASE64_BUF_SIZE + 1];
-									long len = (RAW_BUF_SIZE < input_length) ?  RAW_BUF_SIZE : input_length;
-									long enclen = base64_encode((unsigned char*)encoded_data, (unsigned char*)data, len);
-									fwrite(encoded_data, 1, enclen, fh);
-									input_length -= len;
-									data += len;
-								}
-							} else {
-								static char encoded_data[74];
-								while (input_length) {
-									/* 54 raw = 72 encoded */
-									long len = (54 < input_length) ?  54 : input_length;
-									long enclen = base64_encode((unsigned char*)encoded_data, (unsigned char*)data, len);
-									encoded_data[enclen] = '\n';
-									fwrite(encoded_data, 1, enclen, fh);
-									input_length -= len;
-									data += len;
-								}
-							}
-							fflush(fh);
-							fclose(fh);
-							INDIGO_PRINTF(handle, "</oneBLOB>\n");
+							/* BLOB is copied outside of format_mutex and base64 encoded by the writer */
+							pthread_mutex_unlock(&format_mutex);
+							indigo_queue_entry_append(entry, item->blob.value, item->blob.size, INDIGO_QUEUE_BASE64);
+							pthread_mutex_lock(&format_mutex);
 						}
+						indigo_queue_entry_printf(entry, "</oneBLOB>\n");
 					}
 				}
-				INDIGO_PRINTF(handle, "</setBLOBVector>\n");
 			}
+			indigo_queue_entry_printf(entry, "</setBLOBVector>\n");
 			break;
 		}
 	}
-	pthread_mutex_unlock(&write_mutex);
-	return INDIGO_OK;
-failure:
-	if (client_context->output == client_context->input) {
-		close(client_context->input);
-	} else {
-		close(client_context->input);
-		close(client_context->output);
-	}
-	client_context->output = client_context->input = -1;
-	pthread_mutex_unlock(&write_mutex);
+	pthread_mutex_unlock(&format_mutex);
+	indigo_queue_push(client_context->queue, entry);
 	return INDIGO_OK;
 }
 
@@ -294,27 +256,18 @@ static indigo_result xml_device_adapter_delete_property(indigo_client *client, i
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	assert(client_context != NULL);
 	if (client_context->output <= 0)
 		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
-	assert(client_context != NULL);
-	int handle = client_context->output;
+	indigo_queue_entry *entry = indigo_queue_entry_create_delete(property, device->name);
+	pthread_mutex_lock(&format_mutex);
 	if (*property->name) {
-		INDIGO_PRINTF(handle, "<delProperty device='%s' name='%s'%s/>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), message_attribute(message));
+		indigo_queue_entry_printf(entry, "<delProperty device='%s' name='%s'%s/>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), message_attribute(message));
 	} else {
-		INDIGO_PRINTF(handle, "<delProperty device='%s'%s/>\n", device->name, message_attribute(message));
+		indigo_queue_entry_printf(entry, "<delProperty device='%s'%s/>\n", device->name, message_attribute(message));
 	}
-	pthread_mutex_unlock(&write_mutex);
-	return INDIGO_OK;
-failure:
-	if (client_context->output == client_context->input) {
-		close(client_context->input);
-	} else {
-		close(client_context->input);
-		close(client_context->output);
-	}
-	client_context->output = client_context->input = -1;
-	pthread_mutex_unlock(&write_mutex);
+	pthread_mutex_unlock(&format_mutex);
+	indigo_queue_push(client_context->queue, entry);
 	return INDIGO_OK;
 }
 
@@ -326,29 +279,20 @@ static indigo_result xml_device_adapter_send_message(indigo_client *client, indi
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	assert(client_context != NULL);
 	if (client_context->output <= 0)
 		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
-	assert(client_context != NULL);
-	int handle = client_context->output;
-	if (message) {
-		if (device) {
-			INDIGO_PRINTF(handle, "<message device='%s'%s/>\n", device->name, message_attribute(message));
-		} else {
-			INDIGO_PRINTF(handle, "<message%s/>\n", message_attribute(message));
-		}
-	}
-	pthread_mutex_unlock(&write_mutex);
-	return INDIGO_OK;
-failure:
-	if (client_context->output == client_context->input) {
-		close(client_context->input);
+	if (message == NULL)
+		return INDIGO_OK;
+	indigo_queue_entry *entry = indigo_queue_entry_create(NULL, false);
+	pthread_mutex_lock(&format_mutex);
+	if (device) {
+		indigo_queue_entry_printf(entry, "<message device='%s'%s/>\n", device->name, message_attribute(message));
 	} else {
-		close(client_context->input);
-		close(client_context->output);
+		indigo_queue_entry_printf(entry, "<message%s/>\n", message_attribute(message));
 	}
-	client_context->output = client_context->input = -1;
-	pthread_mutex_unlock(&write_mutex);
+	pthread_mutex_unlock(&format_mutex);
+	indigo_queue_push(client_context->queue, entry);
 	return INDIGO_OK;
 }
 
@@ -367,6 +311,8 @@ indigo_client *indigo_xml_device_adapter(int input, int ouput) {
 	snprintf(client->name, sizeof(client->name), "XML Driver Adapter #%d", input);
 	client_context->input = input;
 	client_context->output = ouput;
+	/* network clients get own writer thread, pipe to the server is written directly */
+	client_context->queue = indigo_queue_create(client_context, indigo_write, input == ouput);
 	client->client_context = client_context;
 	client->is_remote = input == ouput;
 	return client;
@@ -381,6 +327,7 @@ void indigo_release_xml_device_adapter(indigo_client *client) {
 		free(blob_record);
 		blob_record = client->enable_blob_mode_records;
 	}
+	indigo_queue_release(((indigo_adapter_context *)client->client_context)->queue);
 	free(client->client_context);
 	free(client);
 }
@@ -0,0 +1,214 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO background file writer
+ \file indigo_file_writer.c
+ */
+
+#if defined(INDIGO_LINUX)
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_io.h>
+#include <indigo/indigo_file_writer.h>
+
+typedef struct writer_entry {
+	struct writer_entry *next;
+	int handle;
+	bool sync;
+	bool preallocate;
+	indigo_blob_buffer *buffer;
+	char file_name[PATH_MAX];
+} writer_entry;
+
+struct indigo_file_writer {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	pthread_t thread;
+	writer_entry *head;
+	writer_entry *tail;
+	long max_bytes;
+	bool sync;
+	bool preallocate;
+	bool stop;
+	indigo_file_writer_stats stats;
+	indigo_file_writer_callback callback;
+	void *context;
+};
+
+bool indigo_write_file(int handle, const void *data, long size, bool sync, bool preallocate) {
+	if (preallocate && size > 0) {
+#if defined(INDIGO_LINUX)
+		/* posix_fallocate() would emulate it by writing the file twice on NFS or FAT, so preallocation is skipped where it is not supported natively */
+		if (fallocate(handle, 0, 0, size) < 0 && errno != EOPNOTSUPP && errno != ENOSYS && errno != EINVAL)
+			return false;
+#elif defined(INDIGO_MACOS)
+		fstore_t store = { F_ALLOCATEALL, F_PEOFPOSMODE, 0, size, 0 };
+		fcntl(handle, F_PREALLOCATE, &store);
+#endif
+	}
+	if (!indigo_write(handle, data, size))
+		return false;
+	if (sync) {
+#if defined(INDIGO_LINUX)
+		if (fdatasync(handle) < 0)
+			return false;
+#elif defined(INDIGO_MACOS)
+		if (fcntl(handle, F_FULLFSYNC) < 0 && fsync(handle) < 0)
+			return false;
+#elif !defined(INDIGO_WINDOWS)
+		if (fsync(handle) < 0)
+			return false;
+#endif
+	}
+	return true;
+}
+
+static void *writer_thread(indigo_file_writer *writer) {
+	pthread_mutex_lock(&writer->mutex);
+	while (true) {
+		while (writer->head == NULL && !writer->stop)
+			pthread_cond_wait(&writer->cond, &writer->mutex);
+		writer_entry *entry = writer->head;
+		if (entry == NULL)
+			break;
+		pthread_mutex_unlock(&writer->mutex);
+		int error = 0;
+		if (!indigo_write_file(entry->handle, entry->buffer->data, entry->buffer->size, entry->sync, entry->preallocate))
+			error = errno;
+		if (close(entry->handle) < 0 && error == 0)
+			error = errno;
+		if (error) {
+			unlink(entry->file_name);
+			indigo_error("Failed to write %s (%s)", entry->file_name, strerror(error));
+		}
+		pthread_mutex_lock(&writer->mutex);
+		/* entry is dequeued only now, so it is counted as pending while it is written */
+		writer->head = entry->next;
+		if (writer->head == NULL)
+			writer->tail = NULL;
+		writer->stats.files--;
+		writer->stats.bytes -= entry->buffer->size;
+		if (error)
+			writer->stats.failed++;
+		else
+			writer->stats.written++;
+		pthread_cond_broadcast(&writer->cond);
+		pthread_mutex_unlock(&writer->mutex);
+		if (writer->callback)
+			writer->callback(writer->context, entry->file_name, error);
+		indigo_release_blob_buffer(entry->buffer);
+		indigo_safe_free(entry);
+		pthread_mutex_lock(&writer->mutex);
+	}
+	pthread_mutex_unlock(&writer->mutex);
+	return NULL;
+}
+
+indigo_file_writer *indigo_file_writer_create(indigo_file_writer_callback callback, void *context) {
+	indigo_file_writer *writer = indigo_safe_malloc(sizeof(indigo_file_writer));
+	pthread_mutex_init(&writer->mutex, NULL);
+	pthread_cond_init(&writer->cond, NULL);
+	writer->max_bytes = LONG_MAX;
+	writer->callback = callback;
+	writer->context = context;
+	if (pthread_create(&writer->thread, NULL, (void *(*)(void *))writer_thread, writer)) {
+		indigo_error("Can't create file writer thread (%s)", strerror(errno));
+		pthread_mutex_destroy(&writer->mutex);
+		pthread_cond_destroy(&writer->cond);
+		indigo_safe_free(writer);
+		return NULL;
+	}
+	return writer;
+}
+
+void indigo_file_writer_configure(indigo_file_writer *writer, long max_bytes, bool sync, bool preallocate) {
+	pthread_mutex_lock(&writer->mutex);
+	writer->max_bytes = max_bytes;
+	writer->sync = sync;
+	writer->preallocate = preallocate;
+	pthread_cond_broadcast(&writer->cond);
+	pthread_mutex_unlock(&writer->mutex);
+}
+
+bool indigo_file_writer_push(indigo_file_writer *writer, int handle, const char *file_name, indigo_blob_buffer *buffer, bool wait) {
+	pthread_mutex_lock(&writer->mutex);
+	while (writer->stats.files > 0 && writer->stats.bytes + buffer->size > writer->max_bytes) {
+		if (!wait) {
+			pthread_mutex_unlock(&writer->mutex);
+			return false;
+		}
+		pthread_cond_wait(&writer->cond, &writer->mutex);
+	}
+	writer_entry *entry = indigo_safe_malloc(sizeof(writer_entry));
+	entry->handle = handle;
+	entry->sync = writer->sync;
+	entry->preallocate = writer->preallocate;
+	entry->buffer = indigo_retain_blob_buffer(buffer);
+	strncpy(entry->file_name, file_name, PATH_MAX - 1);
+	if (writer->tail)
+		writer->tail->next = entry;
+	else
+		writer->head = entry;
+	writer->tail = entry;
+	writer->stats.files++;
+	writer->stats.bytes += buffer->size;
+	pthread_cond_broadcast(&writer->cond);
+	pthread_mutex_unlock(&writer->mutex);
+	return true;
+}
+
+void indigo_file_writer_flush(indigo_file_writer *writer) {
+	pthread_mutex_lock(&writer->mutex);
+	while (writer->stats.files > 0)
+		pthread_cond_wait(&writer->cond, &writer->mutex);
+	pthread_mutex_unlock(&writer->mutex);
+}
+
+void indigo_file_writer_get_stats(indigo_file_writer *writer, indigo_file_writer_stats *stats) {
+	pthread_mutex_lock(&writer->mutex);
+	*stats = writer->stats;
+	pthread_mutex_unlock(&writer->mutex);
+}
+
+void indigo_file_writer_release(indigo_file_writer *writer) {
+	if (writer == NULL)
+		return;
+	pthread_mutex_lock(&writer->mutex);
+	writer->stop = true;
+	pthread_cond_broadcast(&writer->cond);
+	pthread_mutex_unlock(&writer->mutex);
+	/* thread exits when queue is empty, so nothing queued is lost */
+	pthread_join(writer->thread, NULL);
+	pthread_mutex_destroy(&writer->mutex);
+	pthread_cond_destroy(&writer->cond);
+	indigo_safe_free(writer);
+}
@@ -337,6 +337,17 @@ static void update_additional_instances(indigo_device *device) {
 	indigo_update_property(device, ADDITIONAL_INSTANCES_PROPERTY, NULL);
 }
 
+static void release_device_cache_property(indigo_property *property) {
+	// device cache copies share item values with agent cache copies, so only references and copies made by indigo_copy_property() are released
+	for (int i = 0; i < property->count; i++) {
+		if (property->type == INDIGO_BLOB_VECTOR)
+			indigo_release_blob_buffer(property->items[i].blob.buffer);
+		else if (property->type == INDIGO_TEXT_VECTOR)
+			indigo_safe_free(property->items[i].text.long_value);
+	}
+	free(property);
+}
+
 static void add_cached_connection_property(indigo_device *device, indigo_property *property) {
 	int free_index = -1;
 	for (int i = 0; i < INDIGO_FILTER_MAX_DEVICES; i++) {
@@ -419,7 +430,7 @@ static indigo_result update_device_list(indigo_device *device, indigo_client *cl
 			for (int i = 0; i < INDIGO_FILTER_MAX_CACHED_PROPERTIES; i++) {
 				indigo_property *device_property = device_cache[i];
 				if (device_property && !strcmp(connection_property->device, device_property->device)) {
-					indigo_safe_free(device_property);
+					release_device_cache_property(device_property);
 					device_cache[i] = NULL;
 					if (agent_cache[i]) {
 						indigo_delete_property(device, agent_cache[i], NULL);
@@ -805,8 +816,7 @@ indigo_result indigo_filter_define_property(indigo_client *client, indigo_device
 				int free_index;
 				for (free_index = 0; free_index < INDIGO_FILTER_MAX_CACHED_PROPERTIES; free_index++) {
 					if (device_cache[free_index] == NULL) {
-						int size = sizeof(indigo_property) + property->count * sizeof(indigo_item);
-						device_cache[free_index] = indigo_safe_malloc_copy(size, property);
+						device_cache[free_index] = indigo_copy_property(NULL, property);
 						indigo_property *agent_property = indigo_copy_property(NULL, property);
 						strcpy(agent_property->device, device->name);
 						bool translate = strncmp(name_prefix, agent_property->name, name_prefix_length);
@@ -905,6 +915,14 @@ indigo_result indigo_filter_update_property(indigo_client *client, indigo_device
 							for (int k = 0; k < agent_property->count; k++) {
 								indigo_set_text_item_value(agent_property->items + k, indigo_get_text_item_value(property->items + k));
 							}
+						} else if (agent_property->type == INDIGO_BLOB_VECTOR) {
+							for (int k = 0; k < property->count; k++) {
+								indigo_item *item = agent_property->items + k;
+								indigo_blob_buffer *previous = item->blob.buffer;
+								*item = property->items[k];
+								indigo_retain_blob_buffer(item->blob.buffer);
+								indigo_release_blob_buffer(previous);
+							}
 						} else {
 							memcpy(agent_property->items, property->items, property->count * sizeof(indigo_item));
 						}
@@ -952,7 +970,7 @@ indigo_result indigo_filter_delete_property(indigo_client *client, indigo_device
 					!strcmp(property->name, FOCUSER_DIRECTION_PROPERTY_NAME) ||
 					!strcmp(property->name, FOCUSER_STEPS_PROPERTY_NAME) ||
 					!strcmp(property->name, WHEEL_SLOT_NAME_PROPERTY_NAME);
-				indigo_safe_free(device_cache[i]);
+				release_device_cache_property(device_cache[i]);
 				device_cache[i] = NULL;
 				if (agent_cache[i]) {
 					indigo_delete_property(device, agent_cache[i], NULL);
@@ -968,7 +986,7 @@ indigo_result indigo_filter_delete_property(indigo_client *client, indigo_device
 		for (int i = 0; i < INDIGO_FILTER_MAX_CACHED_PROPERTIES; i++) {
 			if (device_cache[i] && !strcmp(device_cache[i]->device, property->device)) {
 				FILTER_CLIENT_CONTEXT->property_removed = true;
-				indigo_safe_free(device_cache[i]);
+				release_device_cache_property(device_cache[i]);
 				device_cache[i] = NULL;
 				if (agent_cache[i]) {
 					indigo_delete_property(device, agent_cache[i], message);
@@ -1004,7 +1022,7 @@ indigo_result indigo_filter_client_detach(indigo_client *client) {
 	indigo_property **agent_cache = FILTER_CLIENT_CONTEXT->agent_property_cache;
 	for (int i = 0; i < INDIGO_FILTER_MAX_CACHED_PROPERTIES; i++) {
 		if (device_cache[i])
-			indigo_safe_free(device_cache[i]);
+			release_device_cache_property(device_cache[i]);
 		if (agent_cache[i])
 			indigo_release_property(agent_cache[i]);
 	}
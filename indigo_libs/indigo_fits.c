@@ -20,13 +20,340 @@
 // 2.0 by Rumen Bogdanovski <rumenastro@gmail.com>
 
 #include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
 #include <math.h>
 #include <stdio.h>
 #include <errno.h>
+#include <zlib.h>
 
 #include <indigo/indigo_bus.h>
+#include <indigo/indigo_parallel.h>
 #include <indigo/indigo_fits.h>
 
+typedef struct {
+	const void *input;
+	void *output;
+	int width;
+	long plane;
+	int components;
+	bool little_endian;
+	bool byte_order_rgb;
+} payload_conversion;
+
+static void payload_rows_8(payload_conversion *conversion, int start, int end) {
+	const int width = conversion->width;
+	const int first = conversion->byte_order_rgb ? 0 : 2, last = 2 - first;
+	for (int row = start; row < end; row++) {
+		const uint8_t *in = (const uint8_t *)conversion->input + 3L * row * width;
+		uint8_t *red = (uint8_t *)conversion->output + (long)row * width;
+		uint8_t *green = red + conversion->plane;
+		uint8_t *blue = green + conversion->plane;
+		for (int i = 0; i < width; i++, in += 3) {
+			red[i] = in[first];
+			green[i] = in[1];
+			blue[i] = in[last];
+		}
+	}
+}
+
+/* value - BZERO is equal to flipping the sign bit, FITS is big endian, so for little endian input it is byte swapped value ^ 0x0080 */
+
+static inline uint16_t payload_value_16(uint16_t value, bool little_endian) {
+	return (little_endian ? (uint16_t)(value << 8 | value >> 8) : value) ^ 0x0080;
+}
+
+static void payload_rows_16(payload_conversion *conversion, int start, int end) {
+	const int width = conversion->width;
+	const bool little_endian = conversion->little_endian;
+	if (conversion->components == 1) {
+		for (int row = start; row < end; row++) {
+			const uint16_t *in = (const uint16_t *)conversion->input + (long)row * width;
+			uint16_t *out = (uint16_t *)conversion->output + (long)row * width;
+			for (int i = 0; i < width; i++) {
+				out[i] = payload_value_16(in[i], little_endian);
+			}
+		}
+	} else {
+		const int first = conversion->byte_order_rgb ? 0 : 2, last = 2 - first;
+		for (int row = start; row < end; row++) {
+			const uint16_t *in = (const uint16_t *)conversion->input + 3L * row * width;
+			uint16_t *red = (uint16_t *)conversion->output + (long)row * width;
+			uint16_t *green = red + conversion->plane;
+			uint16_t *blue = green + conversion->plane;
+			for (int i = 0; i < width; i++, in += 3) {
+				red[i] = payload_value_16(in[first], little_endian);
+				green[i] = payload_value_16(in[1], little_endian);
+				blue[i] = payload_value_16(in[last], little_endian);
+			}
+		}
+	}
+}
+
+void indigo_raw_to_fits_payload(const void *input, void *output, int width, int height, int bytes_per_sample, int components, bool little_endian, bool byte_order_rgb) {
+	if (bytes_per_sample == 1 && components == 1) {
+		if (input != output)
+			memcpy(output, input, (long)width * height);
+		return;
+	}
+	payload_conversion conversion = { input, output, width, (long)width * height, components, little_endian, byte_order_rgb };
+	indigo_parallel_for(height, (void (*)(void *, int, int))(bytes_per_sample == 1 ? payload_rows_8 : payload_rows_16), &conversion);
+}
+
+// tile compression
+
+#define RICE_BLOCK_SIZE		32
+
+typedef struct {
+	uint8_t *current;
+	uint8_t *end;
+	uint64_t bits;
+	int count;
+} rice_writer;
+
+static inline bool rice_put(rice_writer *writer, uint32_t value, int count) {
+	writer->bits = (writer->bits << count) | (value & ((1ULL << count) - 1));
+	writer->count += count;
+	while (writer->count >= 8) {
+		if (writer->current == writer->end)
+			return false;
+		writer->count -= 8;
+		*writer->current++ = (uint8_t)(writer->bits >> writer->count);
+	}
+	return true;
+}
+
+/* same bit stream as fits_rcomp_short() and fits_rcomp_byte() in CFITSIO */
+
+static long rice_compress(const uint8_t *data, int count, int bytepix, uint8_t *output, long capacity) {
+	const int fsbits = bytepix == 1 ? 3 : 4, fsmax = bytepix == 1 ? 6 : 14, bbits = 8 * bytepix;
+	rice_writer writer = { output, output + capacity, 0, 0 };
+	uint32_t diff[RICE_BLOCK_SIZE];
+	int lastpix = bytepix == 1 ? data[0] : (int16_t)(data[0] << 8 | data[1]);
+	if (!rice_put(&writer, lastpix, bbits))
+		return -1;
+	for (int i = 0; i < count; i += RICE_BLOCK_SIZE) {
+		int block = count - i < RICE_BLOCK_SIZE ? count - i : RICE_BLOCK_SIZE;
+		double pixelsum = 0;
+		for (int j = 0; j < block; j++) {
+			int nextpix, pdiff;
+			if (bytepix == 1) {
+				nextpix = data[i + j];
+				pdiff = (int8_t)(nextpix - lastpix);
+			} else {
+				nextpix = (int16_t)(data[2 * (i + j)] << 8 | data[2 * (i + j) + 1]);
+				pdiff = (int16_t)(nextpix - lastpix);
+			}
+			diff[j] = pdiff < 0 ? -2 * pdiff - 1 : 2 * pdiff;
+			pixelsum += diff[j];
+			lastpix = nextpix;
+		}
+		double dpsum = (pixelsum - (block / 2) - 1) / block;
+		if (dpsum < 0)
+			dpsum = 0;
+		unsigned psum = (unsigned)dpsum >> 1;
+		int fs = 0;
+		for (; psum > 0; fs++)
+			psum >>= 1;
+		if (fs >= fsmax) {
+			/* high entropy, differences are stored as they are */
+			if (!rice_put(&writer, fsmax + 1, fsbits))
+				return -1;
+			for (int j = 0; j < block; j++)
+				if (!rice_put(&writer, diff[j], bbits))
+					return -1;
+		} else if (fs == 0 && pixelsum == 0) {
+			/* low entropy, all differences are zero */
+			if (!rice_put(&writer, 0, fsbits))
+				return -1;
+		} else {
+			if (!rice_put(&writer, fs + 1, fsbits))
+				return -1;
+			for (int j = 0; j < block; j++) {
+				/* top bits as number of zeros followed by one, bottom fs bits as they are */
+				uint32_t top = diff[j] >> fs;
+				for (; top >= 24; top -= 24)
+					if (!rice_put(&writer, 0, 24))
+						return -1;
+				if (!rice_put(&writer, 1, top + 1) || (fs > 0 && !rice_put(&writer, diff[j], fs)))
+					return -1;
+			}
+		}
+	}
+	if (writer.count > 0) {
+		if (writer.current == writer.end)
+			return -1;
+		*writer.current++ = (uint8_t)(writer.bits << (8 - writer.count));
+	}
+	return writer.current - output;
+}
+
+static long gzip_compress(const uint8_t *data, long size, uint8_t *output, long capacity) {
+	z_stream stream = { 0 };
+	if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return -1;
+	stream.next_in = (Bytef *)data;
+	stream.avail_in = (uInt)size;
+	stream.next_out = output;
+	stream.avail_out = (uInt)capacity;
+	int result = deflate(&stream, Z_FINISH);
+	deflateEnd(&stream);
+	return result == Z_STREAM_END ? (long)stream.total_out : -1;
+}
+
+typedef struct {
+	const uint8_t *data;
+	int width;
+	int bytepix;
+	indigo_fits_compression compression;
+	uint8_t *output;
+	long capacity;
+	long *sizes;
+} tile_compression;
+
+static void compress_tiles(tile_compression *job, int start, int end) {
+	long tile_size = (long)job->width * job->bytepix;
+	for (int tile = start; tile < end; tile++) {
+		const uint8_t *data = job->data + tile * tile_size;
+		uint8_t *output = job->output + tile * job->capacity;
+		if (job->compression == INDIGO_FITS_RICE)
+			job->sizes[tile] = rice_compress(data, job->width, job->bytepix, output, job->capacity);
+		else
+			job->sizes[tile] = gzip_compress(data, tile_size, output, job->capacity);
+	}
+}
+
+static char *fits_card(char *header, const char *format, ...) {
+	char card[81];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(card, sizeof(card), format, args);
+	va_end(args);
+	memset(header, ' ', 80);
+	memcpy(header, card, length < 80 ? length : 80);
+	return header + 80;
+}
+
+static bool fits_structural_keyword(const char *card) {
+	if (!strncmp(card, "SIMPLE  ", 8) || !strncmp(card, "BITPIX  ", 8) || !strncmp(card, "EXTEND  ", 8) || !strncmp(card, "END     ", 8))
+		return true;
+	return !strncmp(card, "NAXIS", 5) && (card[5] == ' ' || isdigit(card[5]));
+}
+
+indigo_blob_buffer *indigo_fits_compress(const void *fits, long size, indigo_fits_compression compression) {
+	const char *card = fits;
+	int bitpix = 0, naxis = 0, naxes[3] = { 1, 1, 1 };
+	long header_size = 0;
+	for (; header_size + 80 <= size; header_size += 80, card += 80) {
+		if (!strncmp(card, "END     ", 8))
+			break;
+		if (!strncmp(card, "BITPIX  =", 9))
+			bitpix = atoi(card + 10);
+		else if (!strncmp(card, "NAXIS   =", 9))
+			naxis = atoi(card + 10);
+		else if (!strncmp(card, "NAXIS", 5) && card[5] >= '1' && card[5] <= '3' && card[8] == '=')
+			naxes[card[5] - '1'] = atoi(card + 10);
+	}
+	long data_offset = (header_size / FITS_RECORD_SIZE + 1) * FITS_RECORD_SIZE;
+	int bytepix = bitpix / 8, tiles = naxes[1] * naxes[2];
+	if ((bitpix != 8 && bitpix != 16) || naxis < 2 || naxis > 3 || naxes[0] <= 0 || tiles <= 0 || data_offset + (long)naxes[0] * tiles * bytepix > size)
+		return NULL;
+	tile_compression job = { (const uint8_t *)fits + data_offset, naxes[0], bytepix, compression };
+	long tile_size = (long)naxes[0] * bytepix;
+	/* rice output never exceeds twice the input */
+	job.capacity = compression == INDIGO_FITS_RICE ? 2 * tile_size + 16 : (long)compressBound((uLong)tile_size) + 32;
+	job.output = malloc(job.capacity * tiles);
+	if (job.output == NULL)
+		return NULL;
+	job.sizes = indigo_safe_malloc(tiles * sizeof(long));
+	indigo_parallel_for(tiles, (void (*)(void *, int, int))compress_tiles, &job);
+	long heap_size = 0, max_size = 0;
+	for (int tile = 0; tile < tiles; tile++) {
+		if (job.sizes[tile] < 0) {
+			heap_size = -1;
+			break;
+		}
+		heap_size += job.sizes[tile];
+		if (job.sizes[tile] > max_size)
+			max_size = job.sizes[tile];
+	}
+	indigo_blob_buffer *buffer = NULL;
+	if (heap_size >= 0) {
+		/* table keywords, image keywords, ZNAXISn and ZTILEn, compression keywords, END */
+		int cards = 10 + 4 + 2 * naxis + (compression == INDIGO_FITS_RICE ? 5 : 1) + 1;
+		card = fits;
+		for (long i = 0; i < header_size; i += 80, card += 80)
+			if (!fits_structural_keyword(card))
+				cards++;
+		long table_header_size = ((cards * 80L + FITS_RECORD_SIZE - 1) / FITS_RECORD_SIZE) * FITS_RECORD_SIZE;
+		long data_size = 8L * tiles + heap_size;
+		long padding = data_size % FITS_RECORD_SIZE ? FITS_RECORD_SIZE - data_size % FITS_RECORD_SIZE : 0;
+		buffer = indigo_create_blob_buffer(FITS_RECORD_SIZE + table_header_size + data_size + padding);
+		char *header = buffer->data;
+		memset(header, ' ', FITS_RECORD_SIZE + table_header_size);
+		header = fits_card(header, "SIMPLE  =                    T / file does conform to FITS standard");
+		header = fits_card(header, "BITPIX  =                    8 / number of bits per data pixel");
+		header = fits_card(header, "NAXIS   =                    0 / number of data axes");
+		header = fits_card(header, "EXTEND  =                    T / FITS dataset may contain extensions");
+		header = fits_card(header, "END");
+		header = (char *)buffer->data + FITS_RECORD_SIZE;
+		header = fits_card(header, "XTENSION= 'BINTABLE'           / binary table extension");
+		header = fits_card(header, "BITPIX  =                    8 / 8-bit bytes");
+		header = fits_card(header, "NAXIS   =                    2 / 2-dimensional binary table");
+		header = fits_card(header, "NAXIS1  =                    8 / width of table in bytes");
+		header = fits_card(header, "NAXIS2  = %20d / number of rows in table", tiles);
+		header = fits_card(header, "PCOUNT  = %20ld / size of special data area", heap_size);
+		header = fits_card(header, "GCOUNT  =                    1 / one data group (required keyword)");
+		header = fits_card(header, "TFIELDS =                    1 / number of fields in each row");
+		header = fits_card(header, "TTYPE1  = 'COMPRESSED_DATA'    / label for field 1");
+		header = fits_card(header, "TFORM1  = '1PB(%ld)'%*c / data format of field: variable length array", max_size, (int)(13 - snprintf(NULL, 0, "%ld", max_size)), ' ');
+		header = fits_card(header, "ZIMAGE  =                    T / extension contains compressed image");
+		header = fits_card(header, "ZSIMPLE =                    T / file does conform to FITS standard");
+		header = fits_card(header, "ZBITPIX = %20d / data type of original image", bitpix);
+		header = fits_card(header, "ZNAXIS  = %20d / dimension of original image", naxis);
+		for (int i = 0; i < naxis; i++)
+			header = fits_card(header, "ZNAXIS%d = %20d / length of original image axis", i + 1, naxes[i]);
+		header = fits_card(header, "ZTILE1  = %20d / size of tiles to be compressed", naxes[0]);
+		for (int i = 1; i < naxis; i++)
+			header = fits_card(header, "ZTILE%d  =                    1 / size of tiles to be compressed", i + 1);
+		if (compression == INDIGO_FITS_RICE) {
+			header = fits_card(header, "ZCMPTYPE= 'RICE_1'             / compression algorithm");
+			header = fits_card(header, "ZNAME1  = 'BLOCKSIZE'          / compression block size");
+			header = fits_card(header, "ZVAL1   = %20d / pixels per block", RICE_BLOCK_SIZE);
+			header = fits_card(header, "ZNAME2  = 'BYTEPIX'            / bytes per pixel (1, 2, 4, or 8)");
+			header = fits_card(header, "ZVAL2   = %20d / bytes per pixel (1, 2, 4, or 8)", bytepix);
+		} else {
+			header = fits_card(header, "ZCMPTYPE= 'GZIP_1'             / compression algorithm");
+		}
+		card = fits;
+		for (long i = 0; i < header_size; i += 80, card += 80) {
+			if (!fits_structural_keyword(card)) {
+				memcpy(header, card, 80);
+				header += 80;
+			}
+		}
+		header = fits_card(header, "END");
+		uint8_t *table = (uint8_t *)buffer->data + FITS_RECORD_SIZE + table_header_size;
+		uint8_t *heap = table + 8L * tiles;
+		long offset = 0;
+		for (int tile = 0; tile < tiles; tile++) {
+			/* descriptor is big endian pair of 32 bit length and heap offset */
+			uint8_t *descriptor = table + 8L * tile;
+			for (int i = 0; i < 4; i++) {
+				descriptor[i] = (uint8_t)(job.sizes[tile] >> (24 - 8 * i));
+				descriptor[4 + i] = (uint8_t)(offset >> (24 - 8 * i));
+			}
+			memcpy(heap + offset, job.output + tile * job.capacity, job.sizes[tile]);
+			offset += job.sizes[tile];
+		}
+		memset(heap + heap_size, 0, padding);
+	}
+	free(job.output);
+	indigo_safe_free(job.sizes);
+	return buffer;
+}
+
 static int raw_read_keyword_value(const uint8_t *ptr8, char *keyword, char *value) {
 	int i;
 	int length = strlen(ptr8);
@@ -182,49 +509,7 @@ indigo_result indigo_raw_to_fits(char *image, int in_size, char **fits, int *fit
 	t = sprintf(p += 80, "COMMENT   and Astrophysics', volume 376, page 359; bibcode: 2001A&A...376..359H"); p[t] = ' ';
 	t = sprintf(p += 80, "COMMENT   Converted from INDIGO RAW format. See www.indigo-astronomy.org"); p[t] = ' ';
 	t = sprintf(p += 80, "END"); p[t] = ' ';
-	p = buffer + FITS_RECORD_SIZE;
-	if (components == 1) {
-		// mono
-		if (byte_per_pixel == 2) {
-			// 16 bit RAW - swap endianness
-			uint16_t *in = (uint16_t *)image;
-			uint16_t *out = (uint16_t *)p;
-			for (int i = 0; i < pixel_count; i++) {
-				int value = *in++ - 32768;
-				*out++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-			}
-		} else {
-			// 8 bit RAW
-			memcpy(p, image, pixel_count);
-		}
-	} else {
-		// RGB
-		if (byte_per_pixel == 2) {
-			uint16_t *out_ch0 = (uint16_t *)p;
-			uint16_t *out_ch1 = (uint16_t *)p + pixel_count;
-			uint16_t *out_ch2 = (uint16_t *)p + 2 * pixel_count;
-			// 16 bit RGB - average and swap endianness
-			uint16_t *in = (uint16_t *)image;
-			for (int i = 0; i < pixel_count * 3; i++) {
-				int value =  *in++ - 32768;
-				*out_ch0++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-				value =  *in++ - 32768;
-				*out_ch1++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-				value =  *in++ - 32768;
-				*out_ch2++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-			}
-		} else {
-			uint8_t *out_ch0 = (uint8_t *)p;
-			uint8_t *out_ch1 = (uint8_t *)p + pixel_count;
-			uint8_t *out_ch2 = (uint8_t *)p + 2 * pixel_count;
-			uint8_t *in = (uint8_t *)image;
-			for (int i = 0; i < pixel_count; i++) {
-				*out_ch0++ = *in++;
-				*out_ch1++ = *in++;
-				*out_ch2++ = *in++;
-			}
-		}
-	}
+	indigo_raw_to_fits_payload(image, buffer + FITS_RECORD_SIZE, frame_width, frame_height, byte_per_pixel, components, true, true);
 	*fits = buffer;
 	*fits_size = image_size;
 	return INDIGO_OK;
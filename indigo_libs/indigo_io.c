@@ -409,9 +409,56 @@ int indigo_close(int handle) {
 }
 #endif
 
+#if !defined(INDIGO_WINDOWS)
+
+/* peek available data and consume just the line itself, so nothing beyond it is taken from the socket; returns -2 if handle is not a socket */
+
+static int read_socket_line(int handle, char *buffer, int length) {
+	char data[1024];
+	long total_bytes = 0;
+	bool complete = false;
+	while (!complete && total_bytes < length) {
+		long bytes_read = recv(handle, data, sizeof(data), MSG_PEEK);
+		if (bytes_read < 0 && errno == ENOTSOCK && total_bytes == 0)
+			return -2;
+		if (bytes_read <= 0) {
+			errno = ECONNRESET;
+			INDIGO_TRACE_PROTOCOL(indigo_trace("%d -> // Connection reset", handle));
+			return -1;
+		}
+		long consumed = 0;
+		while (consumed < bytes_read && total_bytes < length) {
+			char c = data[consumed++];
+			if (c == '\r')
+				;
+			else if (c != '\n')
+				buffer[total_bytes++] = c;
+			else {
+				complete = true;
+				break;
+			}
+		}
+		if (recv(handle, data, consumed, MSG_WAITALL) != consumed) {
+			errno = ECONNRESET;
+			INDIGO_TRACE_PROTOCOL(indigo_trace("%d -> // Connection reset", handle));
+			return -1;
+		}
+	}
+	buffer[total_bytes] = '\0';
+	INDIGO_TRACE_PROTOCOL(indigo_trace("%d -> %s", handle, buffer));
+	return (int)total_bytes;
+}
+
+#endif
+
 int indigo_read_line(int handle, char *buffer, int length) {
 	char c = '\0';
 	long total_bytes = 0;
+#if !defined(INDIGO_WINDOWS)
+	int result = read_socket_line(handle, buffer, length);
+	if (result != -2)
+		return result;
+#endif
 	while (total_bytes < length) {
 #if defined(INDIGO_WINDOWS)
 		long bytes_read = recv(handle, &c, 1, 0);
@@ -440,6 +487,96 @@ int indigo_read_line(int handle, char *buffer, int length) {
 	return (int)total_bytes;
 }
 
+void indigo_init_reader(indigo_reader *reader, int handle) {
+	reader->handle = handle;
+	reader->start = reader->end = 0;
+	reader->reads = 0;
+}
+
+static long reader_read(indigo_reader *reader, char *buffer, long length) {
+	while (true) {
+		reader->reads++;
+#if defined(INDIGO_WINDOWS)
+		long bytes_read = recv(reader->handle, buffer, length, 0);
+		if (bytes_read == -1 && WSAGetLastError() == WSAETIMEDOUT) {
+			Sleep(500);
+			continue;
+		}
+#else
+		long bytes_read = read(reader->handle, buffer, length);
+		if (bytes_read == -1 && errno == EINTR)
+			continue;
+#endif
+		return bytes_read;
+	}
+}
+
+static bool reader_fill(indigo_reader *reader) {
+	if (reader->start == reader->end)
+		reader->start = reader->end = 0;
+	long bytes_read = reader_read(reader, reader->buffer + reader->end, INDIGO_READER_BUFFER_SIZE - reader->end);
+	if (bytes_read <= 0)
+		return false;
+	reader->end += bytes_read;
+	return true;
+}
+
+int indigo_reader_read_line(indigo_reader *reader, char *buffer, int length) {
+	long total_bytes = 0;
+	while (total_bytes < length) {
+		if (reader->start == reader->end && !reader_fill(reader)) {
+			errno = ECONNRESET;
+			INDIGO_TRACE_PROTOCOL(indigo_trace("%d -> // Connection reset", reader->handle));
+			return -1;
+		}
+		char c = reader->buffer[reader->start++];
+		if (c == '\r')
+			;
+		else if (c != '\n')
+			buffer[total_bytes++] = c;
+		else
+			break;
+	}
+	buffer[total_bytes] = '\0';
+	INDIGO_TRACE_PROTOCOL(indigo_trace("%d -> %s", reader->handle, buffer));
+	return (int)total_bytes;
+}
+
+int indigo_reader_read(indigo_reader *reader, char *buffer, long length) {
+	long total_bytes = reader->end - reader->start;
+	if (total_bytes > length)
+		total_bytes = length;
+	memcpy(buffer, reader->buffer + reader->start, total_bytes);
+	reader->start += total_bytes;
+	/* remainder is read directly to the destination */
+	while (total_bytes < length) {
+		long bytes_read = reader_read(reader, buffer + total_bytes, length - total_bytes);
+		if (bytes_read <= 0) {
+			if (bytes_read < 0)
+				INDIGO_ERROR(indigo_error("%d -> // %s", reader->handle, strerror(errno)));
+			return (int)bytes_read;
+		}
+		total_bytes += bytes_read;
+	}
+	return (int)total_bytes;
+}
+
+int indigo_reader_peek(indigo_reader *reader) {
+	if (reader->start == reader->end && !reader_fill(reader))
+		return -1;
+	return (unsigned char)reader->buffer[reader->start];
+}
+
+int indigo_reader_select(indigo_reader *reader, long usec) {
+	if (reader->start < reader->end)
+		return 1;
+	return indigo_select(reader->handle, usec);
+}
+
+void indigo_reader_discard(indigo_reader *reader) {
+	reader->start = reader->end = 0;
+}
+
 bool indigo_write(int handle, const char *buffer, long length) {
 	long remains = length;
 	while (true) {
@@ -291,43 +291,59 @@ static void *top_level_handler(parser_state state, char *name, char *value, indi
 	return top_level_handler;
 }
 
-void indigo_json_parse(indigo_device *device, indigo_client *client) {
-	indigo_adapter_context *context = (indigo_adapter_context*)client->client_context;
-	int handle = context->input;
-	char *buffer = indigo_safe_malloc(JSON_BUFFER_SIZE);
-	char *value_buffer = indigo_safe_malloc(JSON_BUFFER_SIZE);
-	char *name_buffer = indigo_safe_malloc(INDIGO_NAME_SIZE);
-	indigo_property *property = indigo_safe_malloc(sizeof(indigo_property) + INDIGO_PREALLOCATED_COUNT * sizeof(indigo_item));
-	property->allocated_count = INDIGO_PREALLOCATED_COUNT;
-	char *pointer = buffer;
-	char *value_pointer = value_buffer;
-	char *name_pointer = name_buffer;
-	*pointer = 0;
-	char c = 0;
-	char q = '"';
-	int depth = 0;
-	bool is_escaped = false;
-	parser_handler handler = top_level_handler;
-	parser_state state = IDLE;
-	while (true) {
-		assert(pointer - buffer <= JSON_BUFFER_SIZE);
+/* item handlers resize the property as needed, so the parser doesn't hold INDIGO_PREALLOCATED_COUNT items for each session */
+#define JSON_PREALLOCATED_COUNT	16
+
+struct indigo_json_parser {
+	indigo_device *device;
+	indigo_client *client;
+	char *value_buffer;
+	char *name_buffer;
+	char *value_pointer;
+	char *name_pointer;
+	indigo_property *property;
+	parser_handler handler;
+	parser_state state;
+	char q;
+	int depth;
+	bool is_escaped;
+};
+
+indigo_json_parser *indigo_json_parser_create(indigo_device *device, indigo_client *client) {
+	indigo_json_parser *parser = indigo_safe_malloc(sizeof(indigo_json_parser));
+	parser->device = device;
+	parser->client = client;
+	parser->value_pointer = parser->value_buffer = indigo_safe_malloc(JSON_BUFFER_SIZE);
+	parser->name_pointer = parser->name_buffer = indigo_safe_malloc(INDIGO_NAME_SIZE);
+	parser->property = indigo_safe_malloc(sizeof(indigo_property) + JSON_PREALLOCATED_COUNT * sizeof(indigo_item));
+	parser->property->allocated_count = JSON_PREALLOCATED_COUNT;
+	parser->handler = top_level_handler;
+	parser->state = IDLE;
+	parser->q = '"';
+	return parser;
+}
+
+bool indigo_json_parser_parse(indigo_json_parser *parser, const char *data, long length) {
+	indigo_device *device = parser->device;
+	indigo_client *client = parser->client;
+	char *value_buffer = parser->value_buffer;
+	char *name_buffer = parser->name_buffer;
+	char *value_pointer = parser->value_pointer;
+	char *name_pointer = parser->name_pointer;
+	parser_handler handler = parser->handler;
+	parser_state state = parser->state;
+	char q = parser->q;
+	int depth = parser->depth;
+	bool is_escaped = parser->is_escaped;
+	long i = 0;
+	while (i < length && state != ERROR) {
 		assert(name_pointer - name_buffer <= INDIGO_NAME_SIZE);
-		if (state == ERROR) {
-			indigo_error("JSON Parser: syntax error");
-			goto exit_loop;
-		}
-		while ((c = *pointer++) == 0) {
-			ssize_t count = (int)context->web_socket ? ws_read(handle, buffer, JSON_BUFFER_SIZE) : indigo_read_line(handle, buffer, JSON_BUFFER_SIZE);
-			if (count <= 0) {
-				goto exit_loop;
-			}
-			pointer = buffer;
-			buffer[count] = 0;
-			INDIGO_TRACE_PROTOCOL(indigo_trace("%d -> %s", handle, buffer));
-		}
+		char c = data[i++];
+		if (c == 0)
+			continue;
 		switch (state) {
 			case ERROR:
-				goto exit_loop;
+				break;
 			case IDLE:
 				if (isspace(c)) {
 				} else if (c == '{') {
@@ -338,7 +354,7 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 					state = BEGIN_STRUCT;
 					INDIGO_TRACE_PARSER(indigo_trace("JSON Parser: '%c' IDLE -> BEGIN_STRUCT", c));
 					depth++;
-					handler = handler(BEGIN_STRUCT, NULL, NULL, &property, device, client, NULL);
+					handler = handler(BEGIN_STRUCT, NULL, NULL, &parser->property, device, client, NULL);
 				}
 				break;
 			case BEGIN_STRUCT:
@@ -359,7 +375,7 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 					state = BEGIN_STRUCT;
 					INDIGO_TRACE_PARSER(indigo_trace("JSON Parser: '%c' BEGIN_ARRAY -> BEGIN_STRUCT", c));
 					depth++;
-					handler = handler(BEGIN_STRUCT, NULL, NULL, &property, device, client, NULL);
+					handler = handler(BEGIN_STRUCT, NULL, NULL, &parser->property, device, client, NULL);
 				}
 				break;
 			case NAME:
@@ -385,12 +401,12 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 				} else if (c == '{') {
 					state = BEGIN_STRUCT;
 					INDIGO_TRACE_PARSER(indigo_trace("JSON Parser: '%c' NAME2 -> BEGIN_STRUCT", c));
-					handler = handler(BEGIN_STRUCT, name_buffer, NULL, &property, device, client, NULL);
+					handler = handler(BEGIN_STRUCT, name_buffer, NULL, &parser->property, device, client, NULL);
 					depth++;
 				} else if (c == '[') {
 					state = BEGIN_ARRAY;
 					INDIGO_TRACE_PARSER(indigo_trace("JSON Parser: '%c' NAME2 -> BEGIN_ARRAY", c));
-					handler = handler(BEGIN_ARRAY, name_buffer, NULL, &property, device, client, NULL);
+					handler = handler(BEGIN_ARRAY, name_buffer, NULL, &parser->property, device, client, NULL);
 				} else if (c == '"' || c == '\'') {
 					q = c;
 					state = TEXT_VALUE;
@@ -411,9 +427,9 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 			case TEXT_VALUE:
 				if (c == q && !is_escaped) {
 					state = VALUE1;
-					pointer--;
+					i--;
 					*value_pointer = 0;
-					handler = handler(TEXT_VALUE, name_buffer, value_buffer, &property, device, client, NULL);
+					handler = handler(TEXT_VALUE, name_buffer, value_buffer, &parser->property, device, client, NULL);
 					INDIGO_TRACE_PARSER(indigo_trace("JSON Parser: '%c' TEXT_VALUE -> VALUE1", c));
 				} else if (c == '\\') {
 					is_escaped = true;
@@ -438,9 +454,9 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 					*value_pointer++ = c;
 				} else {
 					state = VALUE1;
-					pointer--;
+					i--;
 					*value_pointer = 0;
-					handler = handler(NUMBER_VALUE, name_buffer, value_buffer, &property, device, client, NULL);
+					handler = handler(NUMBER_VALUE, name_buffer, value_buffer, &parser->property, device, client, NULL);
 					INDIGO_TRACE_PARSER(indigo_trace("JSON Parser: '%c' NUMBER_VALUE -> VALUE1", c));
 				}
 				break;
@@ -450,9 +466,9 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 				} else {
 					*value_pointer = 0;
 					if (!strcmp(value_buffer, "true") || !strcmp(value_buffer, "false")) {
-						handler = handler(LOGICAL_VALUE, name_buffer, value_buffer, &property, device, client, NULL);
+						handler = handler(LOGICAL_VALUE, name_buffer, value_buffer, &parser->property, device, client, NULL);
 						state = VALUE1;
-						pointer--;
+						i--;
 						INDIGO_TRACE_PARSER(indigo_trace("JSON Parser: '%c' LOGICAL_VALUE -> VALUE1", c));
 					} else {
 						state = ERROR;
@@ -466,14 +482,14 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 					state = VALUE2;
 					INDIGO_TRACE_PARSER(indigo_trace("JSON Parser: '%c' VALUE1 -> VALUE2", c));
 				} else if (c == '}') {
-					handler = handler(END_STRUCT, NULL, NULL, &property, device, client, NULL);
+					handler = handler(END_STRUCT, NULL, NULL, &parser->property, device, client, NULL);
 					depth--;
 					if (depth == 0) {
 						state = IDLE;
 						INDIGO_TRACE_PARSER(indigo_trace("JSON Parser: '%c' VALUE2 -> IDLE", c));
 					}
 				} else if (c == ']') {
-					handler = handler(END_ARRAY, NULL, NULL, &property, device, client, NULL);
+					handler = handler(END_ARRAY, NULL, NULL, &parser->property, device, client, NULL);
 					depth--;
 					if (depth == 0) {
 						state = IDLE;
@@ -491,7 +507,7 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 				} else if (c == '{') {
 					state = BEGIN_STRUCT;
 					INDIGO_TRACE_PARSER(indigo_trace("JSON Parser: '%c' NAME2 -> BEGIN_STRUCT", c));
-					handler = handler(BEGIN_STRUCT, NULL, NULL, &property, device, client, NULL);
+					handler = handler(BEGIN_STRUCT, NULL, NULL, &parser->property, device, client, NULL);
 					depth++;
 				} else {
 					state = ERROR;
@@ -503,11 +519,47 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 				break;
 		}
 	}
-exit_loop:
+	parser->value_pointer = value_pointer;
+	parser->name_pointer = name_pointer;
+	parser->handler = handler;
+	parser->state = state;
+	parser->q = q;
+	parser->depth = depth;
+	parser->is_escaped = is_escaped;
+	if (state == ERROR) {
+		indigo_error("JSON Parser: syntax error");
+		return false;
+	}
+	return true;
+}
+
+void indigo_json_parser_release(indigo_json_parser *parser) {
+	indigo_safe_free(parser->value_buffer);
+	indigo_safe_free(parser->name_buffer);
+	indigo_safe_free(parser->property);
+	free(parser);
+}
+
+void indigo_json_parse(indigo_device *device, indigo_client *client) {
+	indigo_adapter_context *context = (indigo_adapter_context*)client->client_context;
+	int handle = context->input;
+	char *buffer = indigo_safe_malloc(JSON_BUFFER_SIZE + 1);
+	indigo_reader *reader = context->web_socket ? NULL : indigo_safe_malloc(sizeof(indigo_reader));
+	if (reader)
+		indigo_init_reader(reader, handle);
+	indigo_json_parser *parser = indigo_json_parser_create(device, client);
+	while (true) {
+		ssize_t count = (int)context->web_socket ? ws_read(handle, buffer, JSON_BUFFER_SIZE) : indigo_reader_read_line(reader, buffer, JSON_BUFFER_SIZE);
+		if (count <= 0)
+			break;
+		buffer[count] = 0;
+		INDIGO_TRACE_PROTOCOL(indigo_trace("%d -> %s", handle, buffer));
+		if (!indigo_json_parser_parse(parser, buffer, count))
+			break;
+	}
+	indigo_json_parser_release(parser);
 	indigo_safe_free(buffer);
-	indigo_safe_free(value_buffer);
-	indigo_safe_free(name_buffer);
-	indigo_safe_free(property);
+	indigo_safe_free(reader);
 	close(handle);
 	indigo_log("JSON Parser: parser finished");
 }
@@ -287,14 +287,16 @@ void indigo_mount_load_alignment_points(indigo_device *device) {
 	if (handle > 0) {
 		int count;
 		char buffer[1024], name[INDIGO_NAME_SIZE], label[INDIGO_VALUE_SIZE];
-		indigo_read_line(handle, buffer, sizeof(buffer));
+		indigo_reader reader;
+		indigo_init_reader(&reader, handle);
+		indigo_reader_read_line(&reader, buffer, sizeof(buffer));
 		sscanf(buffer, "%d", &count);
 		MOUNT_CONTEXT->alignment_point_count = count;
 		MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY->count = count;
 		MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY->count = count > 0 ? count + 1 : 0;
 		for (int i = 0; i < count; i++) {
 			indigo_alignment_point *point =  MOUNT_CONTEXT->alignment_points + i;
-			indigo_read_line(handle, buffer, sizeof(buffer));
+			indigo_reader_read_line(&reader, buffer, sizeof(buffer));
 			point->used = false;
 			sscanf(buffer, "%d %lg %lg %lg %lg %lg %d", (int *)&point->used, &point->ra, &point->dec, &point->raw_ra, &point->raw_dec, &point->lst, &point->side_of_pier);
 			snprintf(name, INDIGO_NAME_SIZE, "%d", i);
@@ -0,0 +1,170 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO shared worker pool for data parallel image processing
+ \file indigo_parallel.c
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_parallel.h>
+
+#define DEFAULT_THREADS 4
+
+int indigo_parallel_threads = 0;
+
+typedef struct indigo_parallel_job {
+	void (*body)(void *data, int start, int end);
+	void *data;
+	int count;
+	int chunks;
+	int claimed;
+	int done;
+	pthread_cond_t finished;
+	struct indigo_parallel_job *next;
+} indigo_parallel_job;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+static indigo_parallel_job *first_job = NULL;
+static indigo_parallel_job *last_job = NULL;
+static int pool_size = 0;
+
+// called with pool_mutex locked, job with all chunks claimed is removed from the queue
+
+static bool claim_chunk(indigo_parallel_job *job, int *start, int *end) {
+	if (job->claimed == job->chunks)
+		return false;
+	int chunk = job->claimed++;
+	*start = (int)((long long)job->count * chunk / job->chunks);
+	*end = (int)((long long)job->count * (chunk + 1) / job->chunks);
+	if (job->claimed == job->chunks) {
+		indigo_parallel_job *previous = NULL;
+		for (indigo_parallel_job *current = first_job; current; previous = current, current = current->next) {
+			if (current == job) {
+				if (previous)
+					previous->next = job->next;
+				else
+					first_job = job->next;
+				if (last_job == job)
+					last_job = previous;
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+// called with pool_mutex locked
+
+static void finish_chunk(indigo_parallel_job *job) {
+	if (++job->done == job->chunks)
+		pthread_cond_signal(&job->finished);
+}
+
+static void *worker_thread(void *arg) {
+	pthread_mutex_lock(&pool_mutex);
+	while (true) {
+		while (first_job == NULL)
+			pthread_cond_wait(&pool_cond, &pool_mutex);
+		indigo_parallel_job *job = first_job;
+		int start, end;
+		if (claim_chunk(job, &start, &end)) {
+			pthread_mutex_unlock(&pool_mutex);
+			job->body(job->data, start, end);
+			pthread_mutex_lock(&pool_mutex);
+			finish_chunk(job);
+		}
+	}
+	return NULL;
+}
+
+// called with pool_mutex locked
+
+static void start_pool(void) {
+	int size = indigo_parallel_threads;
+	if (size <= 0) {
+		size = (int)sysconf(_SC_NPROCESSORS_ONLN);
+		if (size <= 0)
+			size = DEFAULT_THREADS;
+	}
+	pool_size = 1;
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	for (int i = 1; i < size; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, &attr, worker_thread, NULL)) {
+			indigo_error("Failed to create parallel worker thread");
+			break;
+		}
+		pool_size++;
+	}
+	pthread_attr_destroy(&attr);
+	INDIGO_DEBUG(indigo_debug("Parallel worker pool started with %d threads", pool_size));
+}
+
+int indigo_parallel_size(void) {
+	pthread_mutex_lock(&pool_mutex);
+	if (pool_size == 0)
+		start_pool();
+	int size = pool_size;
+	pthread_mutex_unlock(&pool_mutex);
+	return size;
+}
+
+void indigo_parallel_for(int count, void (*body)(void *data, int start, int end), void *data) {
+	if (count <= 0)
+		return;
+	int chunks = indigo_parallel_size();
+	if (chunks > count)
+		chunks = count;
+	if (chunks == 1) {
+		body(data, 0, count);
+		return;
+	}
+	indigo_parallel_job job = { body, data, count, chunks, 0, 0 };
+	pthread_cond_init(&job.finished, NULL);
+	pthread_mutex_lock(&pool_mutex);
+	if (last_job)
+		last_job->next = &job;
+	else
+		first_job = &job;
+	last_job = &job;
+	pthread_cond_broadcast(&pool_cond);
+	// calling thread works on its own job, so the job completes even if all workers are busy
+	int start, end;
+	while (claim_chunk(&job, &start, &end)) {
+		pthread_mutex_unlock(&pool_mutex);
+		body(data, start, end);
+		pthread_mutex_lock(&pool_mutex);
+		finish_chunk(&job);
+	}
+	while (job.done < job.chunks)
+		pthread_cond_wait(&job.finished, &pool_mutex);
+	pthread_mutex_unlock(&pool_mutex);
+	pthread_cond_destroy(&job.finished);
+}
@@ -0,0 +1,821 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO protocol adapter outbound queue
+ \file indigo_queue.c
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+#include <sys/socket.h>
+
+#include <indigo/indigo_queue.h>
+#include <indigo/indigo_base64.h>
+
+#define RAW_BUF_SIZE 98304
+#define BASE64_BUF_SIZE 131072  /* BASE64_BUF_SIZE >= (RAW_BUF_SIZE + 2) / 3 * 4 */
+#define TEXT_BUF_SIZE 1024
+#define RECORD_HASH_SIZE 64
+#define MAX_RECORDS 1024
+#define NANO 1000000000ULL
+#define SHARED_BATCH 16
+
+int indigo_queue_size = 1024;
+long indigo_queue_max_bytes = 256 * 1024 * 1024;
+indigo_queue_overflow_policy indigo_queue_policy = INDIGO_QUEUE_DROP_STALE;
+bool indigo_queue_coalesce = true;
+double indigo_queue_update_rate = 0;
+int indigo_queue_shared_writers = 8;
+
+typedef struct {
+	char *data;
+	long length;
+	long allocated;
+	indigo_queue_encoding encoding;
+	indigo_blob_buffer *buffer;
+} indigo_queue_segment;
+
+// update policy for properties matching device and property name pattern
+
+typedef struct rate_policy {
+	struct rate_policy *next;
+	char device[INDIGO_NAME_SIZE];
+	char property[INDIGO_NAME_SIZE];
+	uint64_t interval;
+} rate_policy;
+
+// per key state, lives until the queue is released
+
+typedef struct key_record {
+	struct key_record *next;
+	const void *key;
+	struct indigo_queue_entry *last;	// last queued entry with this key
+	int queued;	// number of queued entries referring to this record
+	uint64_t last_sent;
+	bool has_state;
+	indigo_property_state state;
+} key_record;
+
+struct indigo_queue_entry {
+	struct indigo_queue_entry *next;
+	const void *key;
+	bool droppable;
+	bool coalescable;
+	indigo_property_state state;
+	indigo_property *property;	// property update, valid only while pushed
+	key_record *record;
+	uint64_t not_before;
+	char device[INDIGO_NAME_SIZE];	// device of delayed update or device wide deletion
+	long size;
+	int count;
+	int allocated;
+	indigo_queue_segment *segments;
+};
+
+struct indigo_queue {
+	struct indigo_queue *next;
+	indigo_adapter_context *context;
+	bool (*write)(int handle, const char *buffer, long length);
+	bool asynchronous;
+	bool closing;
+	bool writing;
+	bool failed;
+	bool shared;
+	bool scheduled;	// shared queue is waiting in writer pool or served by a writer, guarded by pool_mutex
+	bool serving;
+	uint64_t wake_up;
+	struct indigo_queue *next_scheduled;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	indigo_queue_entry *head;
+	indigo_queue_entry *tail;
+	char *encoded_data;
+	rate_policy *policies;
+	key_record *records[RECORD_HASH_SIZE];
+	int record_count;
+	indigo_queue_stats stats;
+};
+
+static rate_policy *default_policies = NULL;
+static pthread_mutex_t policy_mutex = PTHREAD_MUTEX_INITIALIZER;
+static indigo_queue *live_queues = NULL;
+static pthread_mutex_t live_queues_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// writer pool shared by queues without dedicated thread
+
+static indigo_queue *pool_head = NULL;
+static indigo_queue *pool_tail = NULL;
+static int pool_threads = 0;
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cond;
+static pthread_cond_t pool_idle_cond;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+static uint64_t monotonic_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * NANO + ts.tv_nsec;
+}
+
+indigo_queue_entry *indigo_queue_entry_create(const void *key, bool droppable) {
+	indigo_queue_entry *entry = indigo_safe_malloc(sizeof(indigo_queue_entry));
+	entry->key = key;
+	entry->droppable = droppable;
+	return entry;
+}
+
+indigo_queue_entry *indigo_queue_entry_create_update(indigo_property *property, const char *message) {
+	indigo_queue_entry *entry = indigo_queue_entry_create(property, true);
+	/* BLOBs are never coalesced or delayed, updates with message are never coalesced or delayed */
+	if (property->type != INDIGO_BLOB_VECTOR) {
+		entry->coalescable = message == NULL || *message == 0;
+		entry->state = property->state;
+		entry->property = property;
+	}
+	return entry;
+}
+
+indigo_queue_entry *indigo_queue_entry_create_delete(indigo_property *property, const char *device) {
+	indigo_queue_entry *entry = indigo_queue_entry_create(property, false);
+	if (*property->name == 0)
+		indigo_copy_name(entry->device, device);
+	return entry;
+}
+
+static indigo_queue_segment *add_segment(indigo_queue_entry *entry, long size, indigo_queue_encoding encoding) {
+	if (entry->count == entry->allocated) {
+		entry->allocated = entry->allocated ? 2 * entry->allocated : 4;
+		entry->segments = indigo_safe_realloc(entry->segments, entry->allocated * sizeof(indigo_queue_segment));
+	}
+	indigo_queue_segment *segment = &entry->segments[entry->count++];
+	if (size > 0) {
+		segment->data = malloc(size);
+		assert(segment->data != NULL);
+	} else {
+		segment->data = NULL;
+	}
+	segment->length = 0;
+	segment->allocated = size;
+	segment->encoding = encoding;
+	segment->buffer = NULL;
+	return segment;
+}
+
+void indigo_queue_entry_printf(indigo_queue_entry *entry, const char *format, ...) {
+	indigo_queue_segment *segment = NULL;
+	if (entry->count > 0 && entry->segments[entry->count - 1].encoding == INDIGO_QUEUE_RAW)
+		segment = &entry->segments[entry->count - 1];
+	else
+		segment = add_segment(entry, TEXT_BUF_SIZE, INDIGO_QUEUE_RAW);
+	va_list args;
+	va_start(args, format);
+	long length = vsnprintf(segment->data + segment->length, segment->allocated - segment->length, format, args);
+	va_end(args);
+	if (segment->length + length >= segment->allocated) {
+		while (segment->length + length >= segment->allocated)
+			segment->allocated *= 2;
+		segment->data = indigo_safe_realloc(segment->data, segment->allocated);
+		va_start(args, format);
+		vsnprintf(segment->data + segment->length, segment->allocated - segment->length, format, args);
+		va_end(args);
+	}
+	segment->length += length;
+	entry->size += length;
+}
+
+void indigo_queue_entry_append(indigo_queue_entry *entry, const void *data, long length, indigo_queue_encoding encoding) {
+	if (length <= 0)
+		return;
+	indigo_queue_segment *segment = add_segment(entry, length, encoding);
+	memcpy(segment->data, data, length);
+	segment->length = length;
+	entry->size += length;
+}
+
+void indigo_queue_entry_append_buffer(indigo_queue_entry *entry, indigo_blob_buffer *buffer, indigo_queue_encoding encoding) {
+	if (buffer == NULL || buffer->size <= 0)
+		return;
+	indigo_queue_segment *segment = add_segment(entry, 0, encoding);
+	segment->buffer = indigo_retain_blob_buffer(buffer);
+	segment->data = buffer->data;
+	segment->length = buffer->size;
+	entry->size += buffer->size;
+}
+
+void indigo_queue_entry_release(indigo_queue_entry *entry) {
+	for (int i = 0; i < entry->count; i++) {
+		if (entry->segments[i].buffer)
+			indigo_release_blob_buffer(entry->segments[i].buffer);
+		else
+			indigo_safe_free(entry->segments[i].data);
+	}
+	indigo_safe_free(entry->segments);
+	indigo_safe_free(entry);
+}
+
+static bool write_entry(indigo_queue *queue, int handle, indigo_queue_entry *entry) {
+	for (int i = 0; i < entry->count; i++) {
+		indigo_queue_segment *segment = &entry->segments[i];
+		if (segment->encoding == INDIGO_QUEUE_RAW) {
+			INDIGO_TRACE_PROTOCOL(indigo_trace("%d <- %.*s", handle, (int)segment->length, segment->data));
+			if (!queue->write(handle, segment->data, segment->length))
+				return false;
+		} else {
+			if (queue->encoded_data == NULL)
+				queue->encoded_data = indigo_safe_malloc(BASE64_BUF_SIZE + 1);
+			unsigned char *data = (unsigned char *)segment->data;
+			long input_length = segment->length;
+			while (input_length) {
+				long len = (RAW_BUF_SIZE < input_length) ? RAW_BUF_SIZE : input_length;
+				long enclen = base64_encode((unsigned char *)queue->encoded_data, data, len);
+				if (!queue->write(handle, queue->encoded_data, enclen))
+					return false;
+				input_length -= len;
+				data += len;
+			}
+		}
+	}
+	return true;
+}
+
+static void discard_entries(indigo_queue *queue) {
+	indigo_queue_entry *entry = queue->head;
+	while (entry) {
+		indigo_queue_entry *next = entry->next;
+		if (entry->record) {
+			entry->record->last = NULL;
+			entry->record->queued--;
+		}
+		indigo_queue_entry_release(entry);
+		entry = next;
+	}
+	queue->head = queue->tail = NULL;
+	queue->stats.depth = 0;
+	queue->stats.bytes = 0;
+}
+
+static void disconnect(indigo_queue *queue) {
+	indigo_adapter_context *context = queue->context;
+	queue->failed = true;
+	discard_entries(queue);
+	if (context->output == context->input) {
+		if (queue->asynchronous) {
+			/* socket is closed by the thread reading from it */
+			shutdown(context->output, SHUT_RDWR);
+		} else {
+			close(context->input);
+		}
+	} else {
+		close(context->input);
+		close(context->output);
+	}
+	context->output = context->input = -1;
+}
+
+static void unlink_entry(indigo_queue *queue, indigo_queue_entry *previous, indigo_queue_entry *entry) {
+	if (previous)
+		previous->next = entry->next;
+	else
+		queue->head = entry->next;
+	if (queue->tail == entry)
+		queue->tail = previous;
+	if (entry->record) {
+		if (entry->record->last == entry)
+			entry->record->last = NULL;
+		entry->record->queued--;
+	}
+	queue->stats.depth--;
+	queue->stats.bytes -= entry->size;
+}
+
+static indigo_queue_entry *next_entry(indigo_queue *queue, uint64_t *wake_up) {
+	indigo_queue_entry *previous = NULL, *entry = queue->head;
+	if (entry->not_before) {
+		/* skip rate limited updates which are not due yet */
+		uint64_t now = monotonic_ns();
+		while (entry && entry->not_before > now) {
+			if (entry->not_before < *wake_up)
+				*wake_up = entry->not_before;
+			previous = entry;
+			entry = entry->next;
+		}
+		if (entry == NULL)
+			return NULL;
+	}
+	unlink_entry(queue, previous, entry);
+	return entry;
+}
+
+static void wait_until(pthread_cond_t *cond, pthread_mutex_t *mutex, uint64_t time) {
+#if defined(INDIGO_MACOS)
+	uint64_t now = monotonic_ns();
+	if (time > now) {
+		struct timespec delay = { (time - now) / NANO, (time - now) % NANO };
+		pthread_cond_timedwait_relative_np(cond, mutex, &delay);
+	}
+#else
+	struct timespec end = { time / NANO, time % NANO };
+	pthread_cond_timedwait(cond, mutex, &end);
+#endif
+}
+
+static void init_cond(pthread_cond_t *cond) {
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+#if !defined(INDIGO_MACOS)
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+#endif
+	pthread_cond_init(cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+static void send_entry(indigo_queue *queue, indigo_queue_entry *entry) {
+	/* called and returns with queue mutex locked, the mutex is released while writing */
+	if (entry->record) {
+		/* record may be pruned as soon as the mutex is released */
+		entry->record->last_sent = monotonic_ns();
+		entry->record = NULL;
+	}
+	int handle = queue->context->output;
+	queue->writing = true;
+	pthread_mutex_unlock(&queue->mutex);
+	bool result = handle > 0 && write_entry(queue, handle, entry);
+	indigo_queue_entry_release(entry);
+	pthread_mutex_lock(&queue->mutex);
+	queue->writing = false;
+	if (result)
+		queue->stats.sent++;
+	else if (!queue->failed && !queue->closing)
+		disconnect(queue);
+}
+
+static void *queue_writer(indigo_queue *queue) {
+	pthread_mutex_lock(&queue->mutex);
+	while (true) {
+		indigo_queue_entry *entry = NULL;
+		while (!queue->closing) {
+			uint64_t wake_up = UINT64_MAX;
+			if (queue->head && (entry = next_entry(queue, &wake_up)))
+				break;
+			if (wake_up == UINT64_MAX)
+				pthread_cond_wait(&queue->cond, &queue->mutex);
+			else
+				wait_until(&queue->cond, &queue->mutex, wake_up);
+		}
+		if (entry == NULL)
+			break;
+		send_entry(queue, entry);
+	}
+	pthread_mutex_unlock(&queue->mutex);
+	return NULL;
+}
+
+static void append_scheduled(indigo_queue *queue) {
+	queue->next_scheduled = NULL;
+	if (pool_tail)
+		pool_tail->next_scheduled = queue;
+	else
+		pool_head = queue;
+	pool_tail = queue;
+}
+
+static void unlink_scheduled(indigo_queue *previous, indigo_queue *queue) {
+	if (previous)
+		previous->next_scheduled = queue->next_scheduled;
+	else
+		pool_head = queue->next_scheduled;
+	if (pool_tail == queue)
+		pool_tail = previous;
+}
+
+static void schedule(indigo_queue *queue, uint64_t time) {
+	/* called with queue mutex locked, queue being served is rescheduled by its writer */
+	pthread_mutex_lock(&pool_mutex);
+	if (!queue->scheduled) {
+		queue->scheduled = true;
+		queue->wake_up = time;
+		append_scheduled(queue);
+		pthread_cond_signal(&pool_cond);
+	} else if (!queue->serving && time < queue->wake_up) {
+		queue->wake_up = time;
+		pthread_cond_signal(&pool_cond);
+	}
+	pthread_mutex_unlock(&pool_mutex);
+}
+
+static void serve(indigo_queue *queue) {
+	/* send a batch of due messages, then give way to other queues */
+	pthread_mutex_lock(&queue->mutex);
+	indigo_queue_entry *entry;
+	uint64_t wake_up = UINT64_MAX;
+	for (int i = 0; i < SHARED_BATCH && !queue->closing && queue->head && (entry = next_entry(queue, &wake_up)); i++)
+		send_entry(queue, entry);
+	if (queue->head && !queue->closing) {
+		/* either batch is exhausted or remaining messages are delayed */
+		wake_up = UINT64_MAX;
+		uint64_t now = monotonic_ns();
+		for (indigo_queue_entry *pending = queue->head; pending && wake_up > now; pending = pending->next) {
+			if (pending->not_before < wake_up)
+				wake_up = pending->not_before;
+		}
+	}
+	pthread_mutex_lock(&pool_mutex);
+	queue->serving = false;
+	if (queue->head && !queue->closing) {
+		queue->wake_up = wake_up;
+		append_scheduled(queue);
+	} else {
+		queue->scheduled = false;
+	}
+	pthread_cond_broadcast(&pool_idle_cond);
+	pthread_mutex_unlock(&pool_mutex);
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+static void *shared_writer(void *data) {
+	pthread_mutex_lock(&pool_mutex);
+	while (true) {
+		uint64_t now = monotonic_ns(), wake_up = UINT64_MAX;
+		indigo_queue *previous = NULL, *queue = pool_head;
+		while (queue && queue->wake_up > now) {
+			if (queue->wake_up < wake_up)
+				wake_up = queue->wake_up;
+			previous = queue;
+			queue = queue->next_scheduled;
+		}
+		if (queue == NULL) {
+			if (wake_up == UINT64_MAX)
+				pthread_cond_wait(&pool_cond, &pool_mutex);
+			else
+				wait_until(&pool_cond, &pool_mutex, wake_up);
+			continue;
+		}
+		unlink_scheduled(previous, queue);
+		queue->serving = true;
+		pthread_mutex_unlock(&pool_mutex);
+		serve(queue);
+		pthread_mutex_lock(&pool_mutex);
+	}
+	return NULL;
+}
+
+static void init_pool(void) {
+	init_cond(&pool_cond);
+	pthread_cond_init(&pool_idle_cond, NULL);
+}
+
+indigo_queue *indigo_queue_create(indigo_adapter_context *context, bool (*write)(int handle, const char *buffer, long length), bool asynchronous) {
+	indigo_queue *queue = indigo_safe_malloc(sizeof(indigo_queue));
+	queue->context = context;
+	queue->write = write;
+	queue->asynchronous = asynchronous;
+	pthread_mutex_init(&queue->mutex, NULL);
+	init_cond(&queue->cond);
+	if (asynchronous && pthread_create(&queue->thread, NULL, (void *(*)(void *))queue_writer, queue)) {
+		indigo_error("[%s:%d] Can't create writer thread, falling back to synchronous writes", __FUNCTION__, __LINE__);
+		queue->asynchronous = false;
+	}
+	pthread_mutex_lock(&live_queues_mutex);
+	queue->next = live_queues;
+	live_queues = queue;
+	pthread_mutex_unlock(&live_queues_mutex);
+	return queue;
+}
+
+indigo_queue *indigo_queue_create_shared(indigo_adapter_context *context, bool (*write)(int handle, const char *buffer, long length)) {
+	pthread_once(&pool_once, init_pool);
+	pthread_mutex_lock(&pool_mutex);
+	/* writers are started on demand and live until the process exits */
+	while (pool_threads < indigo_queue_shared_writers) {
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, shared_writer, NULL)) {
+			indigo_error("[%s:%d] Can't create shared writer thread", __FUNCTION__, __LINE__);
+			break;
+		}
+		pthread_detach(thread);
+		pool_threads++;
+	}
+	bool available = pool_threads > 0;
+	pthread_mutex_unlock(&pool_mutex);
+	if (!available)
+		return indigo_queue_create(context, write, true);
+	indigo_queue *queue = indigo_queue_create(context, write, false);
+	queue->asynchronous = queue->shared = true;
+	return queue;
+}
+
+void indigo_queue_release(indigo_queue *queue) {
+	assert(queue != NULL);
+	pthread_mutex_lock(&live_queues_mutex);
+	for (indigo_queue **previous = &live_queues; *previous; previous = &(*previous)->next) {
+		if (*previous == queue) {
+			*previous = queue->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&live_queues_mutex);
+	pthread_mutex_lock(&queue->mutex);
+	queue->closing = true;
+	discard_entries(queue);
+	if (queue->writing && queue->context->output > 0 && queue->context->output == queue->context->input) {
+		/* unblock write to stalled client */
+		shutdown(queue->context->output, SHUT_RDWR);
+	}
+	pthread_cond_signal(&queue->cond);
+	pthread_mutex_unlock(&queue->mutex);
+	if (queue->shared) {
+		pthread_mutex_lock(&pool_mutex);
+		while (queue->serving)
+			pthread_cond_wait(&pool_idle_cond, &pool_mutex);
+		if (queue->scheduled) {
+			indigo_queue *previous = NULL;
+			for (indigo_queue *scheduled = pool_head; scheduled != queue; scheduled = scheduled->next_scheduled)
+				previous = scheduled;
+			unlink_scheduled(previous, queue);
+			queue->scheduled = false;
+		}
+		pthread_mutex_unlock(&pool_mutex);
+	} else if (queue->asynchronous) {
+		pthread_join(queue->thread, NULL);
+	}
+	INDIGO_DEBUG(indigo_debug("%d <- // Queue released (sent %ld, coalesced %ld, dropped %ld, high-water mark %d)", queue->context->output, queue->stats.sent, queue->stats.coalesced, queue->stats.dropped, queue->stats.max_depth));
+	pthread_cond_destroy(&queue->cond);
+	pthread_mutex_destroy(&queue->mutex);
+	for (int i = 0; i < RECORD_HASH_SIZE; i++) {
+		key_record *record = queue->records[i];
+		while (record) {
+			key_record *next = record->next;
+			indigo_safe_free(record);
+			record = next;
+		}
+	}
+	pthread_mutex_lock(&policy_mutex);
+	rate_policy *policy = queue->policies;
+	while (policy) {
+		rate_policy *next = policy->next;
+		indigo_safe_free(policy);
+		policy = next;
+	}
+	pthread_mutex_unlock(&policy_mutex);
+	indigo_safe_free(queue->encoded_data);
+	indigo_safe_free(queue);
+}
+
+void indigo_queue_get_stats(indigo_queue *queue, indigo_queue_stats *stats) {
+	pthread_mutex_lock(&queue->mutex);
+	*stats = queue->stats;
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+int indigo_queue_get_total_stats(indigo_queue_stats *total) {
+	int count = 0;
+	memset(total, 0, sizeof(indigo_queue_stats));
+	pthread_mutex_lock(&live_queues_mutex);
+	for (indigo_queue *queue = live_queues; queue; queue = queue->next) {
+		indigo_queue_stats stats;
+		indigo_queue_get_stats(queue, &stats);
+		INDIGO_TRACE(indigo_trace("%d <- // Queue depth %d (%ld bytes, high-water mark %d), sent %ld, coalesced %ld, dropped %ld", queue->context->output, stats.depth, stats.bytes, stats.max_depth, stats.sent, stats.coalesced, stats.dropped));
+		total->depth += stats.depth;
+		total->bytes += stats.bytes;
+		if (stats.max_depth > total->max_depth)
+			total->max_depth = stats.max_depth;
+		total->sent += stats.sent;
+		total->dropped += stats.dropped;
+		total->coalesced += stats.coalesced;
+		count++;
+	}
+	pthread_mutex_unlock(&live_queues_mutex);
+	return count;
+}
+
+static bool is_full(indigo_queue *queue, indigo_queue_entry *entry) {
+	return queue->stats.depth >= indigo_queue_size || (queue->stats.depth > 0 && queue->stats.bytes + entry->size > indigo_queue_max_bytes);
+}
+
+static bool matches(const char *pattern, const char *name) {
+	if (*pattern == 0 || !strcmp(pattern, "*"))
+		return true;
+	long length = strlen(pattern);
+	if (pattern[length - 1] == '*')
+		return !strncmp(pattern, name, length - 1);
+	return !strcmp(pattern, name);
+}
+
+static uint64_t update_interval(indigo_queue *queue, indigo_property *property) {
+	uint64_t interval = indigo_queue_update_rate > 0 ? (uint64_t)(NANO / indigo_queue_update_rate) : 0;
+	pthread_mutex_lock(&policy_mutex);
+	rate_policy *policy = queue->policies;
+	while (policy && !(matches(policy->device, property->device) && matches(policy->property, property->name)))
+		policy = policy->next;
+	if (policy == NULL) {
+		policy = default_policies;
+		while (policy && !(matches(policy->device, property->device) && matches(policy->property, property->name)))
+			policy = policy->next;
+	}
+	if (policy)
+		interval = policy->interval;
+	pthread_mutex_unlock(&policy_mutex);
+	return interval;
+}
+
+void indigo_queue_set_update_rate(indigo_queue *queue, const char *device, const char *property, double rate) {
+	device = device ? device : "";
+	property = property ? property : "";
+	pthread_mutex_lock(&policy_mutex);
+	rate_policy **list = queue ? &queue->policies : &default_policies;
+	rate_policy *policy = *list;
+	while (policy && !(!strcmp(policy->device, device) && !strcmp(policy->property, property)))
+		policy = policy->next;
+	if (policy == NULL) {
+		policy = indigo_safe_malloc(sizeof(rate_policy));
+		indigo_copy_name(policy->device, device);
+		indigo_copy_name(policy->property, property);
+		policy->next = *list;
+		*list = policy;
+	}
+	policy->interval = rate > 0 ? (uint64_t)(NANO / rate) : 0;
+	pthread_mutex_unlock(&policy_mutex);
+}
+
+static void prune_records(indigo_queue *queue, uint64_t now) {
+	/* forget idle keys, worst case the next update is treated as state transition */
+	for (int i = 0; i < RECORD_HASH_SIZE; i++) {
+		key_record **link = &queue->records[i];
+		while (*link) {
+			key_record *record = *link;
+			if (record->queued == 0 && now - record->last_sent > NANO) {
+				*link = record->next;
+				indigo_safe_free(record);
+				queue->record_count--;
+			} else {
+				link = &record->next;
+			}
+		}
+	}
+}
+
+static key_record *get_record(indigo_queue *queue, const void *key) {
+	int hash = (int)(((uintptr_t)key >> 4) % RECORD_HASH_SIZE);
+	key_record *record = queue->records[hash];
+	while (record && record->key != key)
+		record = record->next;
+	if (record == NULL) {
+		if (queue->record_count >= MAX_RECORDS)
+			prune_records(queue, monotonic_ns());
+		record = indigo_safe_malloc(sizeof(key_record));
+		record->key = key;
+		record->next = queue->records[hash];
+		queue->records[hash] = record;
+		queue->record_count++;
+	}
+	return record;
+}
+
+static void coalesce(indigo_queue *queue, indigo_queue_entry *pending, indigo_queue_entry *entry) {
+	/* pending message takes content of the new one and keeps its position */
+	indigo_queue_segment *segments = pending->segments;
+	int count = pending->count, allocated = pending->allocated;
+	long size = pending->size;
+	pending->segments = entry->segments;
+	pending->count = entry->count;
+	pending->allocated = entry->allocated;
+	pending->size = entry->size;
+	entry->segments = segments;
+	entry->count = count;
+	entry->allocated = allocated;
+	entry->size = size;
+	queue->stats.bytes += pending->size - size;
+	queue->stats.coalesced++;
+	indigo_queue_entry_release(entry);
+}
+
+static bool drop_stale(indigo_queue *queue, indigo_queue_entry *entry) {
+	if (entry->key == NULL)
+		return false;
+	indigo_queue_entry *previous = NULL, *stale = queue->head;
+	while (stale && !(stale->droppable && stale->key == entry->key)) {
+		previous = stale;
+		stale = stale->next;
+	}
+	if (stale == NULL)
+		return false;
+	unlink_entry(queue, previous, stale);
+	queue->stats.dropped++;
+	indigo_queue_entry_release(stale);
+	return true;
+}
+
+bool indigo_queue_push(indigo_queue *queue, indigo_queue_entry *entry) {
+	assert(queue != NULL);
+	assert(entry != NULL);
+	pthread_mutex_lock(&queue->mutex);
+	if (queue->failed || queue->closing) {
+		pthread_mutex_unlock(&queue->mutex);
+		indigo_queue_entry_release(entry);
+		return false;
+	}
+	if (!queue->asynchronous) {
+		int handle = queue->context->output;
+		bool result = handle > 0 && write_entry(queue, handle, entry);
+		if (result)
+			queue->stats.sent++;
+		else
+			disconnect(queue);
+		pthread_mutex_unlock(&queue->mutex);
+		indigo_queue_entry_release(entry);
+		return result;
+	}
+	key_record *record = NULL;
+	if (entry->key) {
+		record = get_record(queue, entry->key);
+		indigo_queue_entry *last = record->last;
+		if (entry->property) {
+			bool transition = !record->has_state || record->state != entry->state;
+			record->has_state = true;
+			record->state = entry->state;
+			if (entry->coalescable && !transition && last && last->coalescable && last->state == entry->state && (indigo_queue_coalesce || last->not_before)) {
+				coalesce(queue, last, entry);
+				pthread_mutex_unlock(&queue->mutex);
+				return true;
+			}
+			uint64_t interval = transition || !entry->coalescable ? 0 : update_interval(queue, entry->property);
+			if (interval) {
+				uint64_t now = monotonic_ns();
+				if (record->last_sent + interval > now) {
+					entry->not_before = record->last_sent + interval;
+					memcpy(entry->device, entry->property->device, INDIGO_NAME_SIZE);
+				}
+			}
+		}
+		if (last && last->not_before && !entry->not_before) {
+			/* state transition, definition or deletion flushes delayed update first */
+			last->not_before = 0;
+		}
+	}
+	if (*entry->device && !entry->not_before) {
+		/* device wide deletion flushes delayed updates of all device properties first */
+		for (indigo_queue_entry *delayed = queue->head; delayed; delayed = delayed->next) {
+			if (delayed->not_before && !strcmp(delayed->device, entry->device))
+				delayed->not_before = 0;
+		}
+	}
+	entry->property = NULL;
+	if (is_full(queue, entry)) {
+		if (indigo_queue_policy == INDIGO_QUEUE_DROP_STALE) {
+			while (is_full(queue, entry) && drop_stale(queue, entry))
+				;
+		}
+		if (is_full(queue, entry)) {
+			indigo_error("%d <- // Queue overflow (%d messages, %ld bytes), client disconnected", queue->context->output, queue->stats.depth, queue->stats.bytes);
+			disconnect(queue);
+			pthread_mutex_unlock(&queue->mutex);
+			indigo_queue_entry_release(entry);
+			return false;
+		}
+	}
+	if (queue->tail)
+		queue->tail->next = entry;
+	else
+		queue->head = entry;
+	queue->tail = entry;
+	if (record) {
+		entry->record = record;
+		record->last = entry;
+		record->queued++;
+	}
+	queue->stats.depth++;
+	queue->stats.bytes += entry->size;
+	if (queue->stats.depth > queue->stats.max_depth)
+		queue->stats.max_depth = queue->stats.depth;
+	if (queue->shared)
+		schedule(queue, entry->not_before);
+	pthread_cond_signal(&queue->cond);
+	pthread_mutex_unlock(&queue->mutex);
+	return true;
+}
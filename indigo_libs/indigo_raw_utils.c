@@ -16,6 +16,7 @@
 #include <sys/param.h>
 
 #include <indigo/indigo_bus.h>
+#include <indigo/indigo_parallel.h>
 #include <indigo/indigo_raw_utils.h>
 
 // Above this value the pixel is considered saturated
@@ -56,6 +57,54 @@ bool indigo_is_bayered_image(indigo_raw_header *header, size_t data_length) {
 	return false;
 }
 
+typedef struct {
+	indigo_raw_type raw_type;
+	void *data;
+	int width;
+	double scale_factor[4];
+} equalize_bayer_data;
+
+static void equalize_bayer_rows(equalize_bayer_data *equalize_data, int start, int end) {
+	const int width = equalize_data->width;
+	const double ch1_scale_factor = equalize_data->scale_factor[0];
+	const double ch2_scale_factor = equalize_data->scale_factor[1];
+	const double ch3_scale_factor = equalize_data->scale_factor[2];
+	const double ch4_scale_factor = equalize_data->scale_factor[3];
+	if (equalize_data->raw_type == INDIGO_RAW_MONO16) {
+		uint16_t* data16 = (uint16_t*)equalize_data->data;
+		for (int y = 2 * start; y < 2 * end; y += 2) {
+			for (int x = 0; x < width - 1; x += 2) {
+				// Scale pixels at (x, y), (x+1, y), (x, y+1), and (x+1, y+1)
+				int index = y * width + x;
+				int index_right = index + 1;
+				int index_down = (y + 1) * width + x;
+				int index_diag = index_down + 1;
+
+				data16[index] = (uint16_t)(data16[index] * ch1_scale_factor);
+				data16[index_right] = (uint16_t)(data16[index_right] * ch3_scale_factor);
+				data16[index_down] = (uint16_t)(data16[index_down] * ch2_scale_factor);
+				data16[index_diag] = (uint16_t)(data16[index_diag] * ch4_scale_factor);
+			}
+		}
+	} else if (equalize_data->raw_type == INDIGO_RAW_MONO8) {
+		uint8_t* data8 = (uint8_t*)equalize_data->data;
+		for (int y = 2 * start; y < 2 * end; y += 2) {
+			for (int x = 0; x < width - 1; x += 2) {
+				// Scale pixels at (x, y), (x+1, y), (x, y+1), and (x+1, y+1)
+				int index = y * width + x;
+				int index_right = index + 1;
+				int index_down = (y + 1) * width + x;
+				int index_diag = index_down + 1;
+
+				data8[index] = (data8[index] * ch1_scale_factor);
+				data8[index_right] = (data8[index_right] * ch3_scale_factor);
+				data8[index_down] = (data8[index_down] * ch2_scale_factor);
+				data8[index_diag] = (data8[index_diag] * ch4_scale_factor);
+			}
+		}
+	}
+}
+
 indigo_result indigo_equalize_bayer_channels(indigo_raw_type raw_type, void *data, const int width, const int height) {
 	long long ch1_sum = 0, ch2_sum = 0, ch3_sum = 0, ch4_sum = 0;
 	int ch1_count = 0, ch2_count = 0, ch3_count = 0, ch4_count = 0;
@@ -121,39 +170,8 @@ indigo_result indigo_equalize_bayer_channels(indigo_raw_type raw_type, void *dat
 	double ch3_scale_factor = overall_average /(ch3_sum / (double)ch3_count);
 	double ch4_scale_factor = overall_average / (ch4_sum / (double)ch4_count);
 
-	if (raw_type == INDIGO_RAW_MONO16) {
-		uint16_t* data16 = (uint16_t*)data;
-		for (int y = 0; y < height - 1; y += 2) {
-			for (int x = 0; x < width - 1; x += 2) {
-				// Scale pixels at (x, y), (x+1, y), (x, y+1), and (x+1, y+1)
-				int index = y * width + x;
-				int index_right = index + 1;
-				int index_down = (y + 1) * width + x;
-				int index_diag = index_down + 1;
-
-				data16[index] = (uint16_t)(data16[index] * ch1_scale_factor);
-				data16[index_right] = (uint16_t)(data16[index_right] * ch3_scale_factor);
-				data16[index_down] = (uint16_t)(data16[index_down] * ch2_scale_factor);
-				data16[index_diag] = (uint16_t)(data16[index_diag] * ch4_scale_factor);
-			}
-		}
-	} else if (raw_type == INDIGO_RAW_MONO8) {
-		uint8_t* data8 = (uint8_t*)data;
-		for (int y = 0; y < height - 1; y += 2) {
-			for (int x = 0; x < width - 1; x += 2) {
-				// Scale pixels at (x, y), (x+1, y), (x, y+1), and (x+1, y+1)
-				int index = y * width + x;
-				int index_right = index + 1;
-				int index_down = (y + 1) * width + x;
-				int index_diag = index_down + 1;
-
-				data8[index] = (data8[index] * ch1_scale_factor);
-				data8[index_right] = (data8[index_right] * ch3_scale_factor);
-				data8[index_down] = (data8[index_down] * ch2_scale_factor);
-				data8[index_diag] = (data8[index_diag] * ch4_scale_factor);
-			}
-		}
-	}
+	equalize_bayer_data equalize_data = { raw_type, data, width, { ch1_scale_factor, ch2_scale_factor, ch3_scale_factor, ch4_scale_factor } };
+	indigo_parallel_for(height / 2, (void (*)(void *, int, int))equalize_bayer_rows, &equalize_data);
 	return INDIGO_OK;
 }
 
@@ -272,85 +290,195 @@ static void tuckey_window(double (*data)[2], int len, double alpha) {
 }
 */
 
-static void _fft(const int n, const int offset, const int delta, const double (*x)[2], double (*X)[2], double (*_X)[2]);
+/* FFT plans with precomputed twiddle factors, bit reversal permutation and work buffer, cached per transform size for the lifetime of the process */
+
+typedef struct {
+	int n;
+	double (*twiddle)[2];
+	int *reverse;
+	double *work;
+	bool work_used;
+} fft_plan;
+
+static fft_plan *fft_plans[32];
+static pthread_mutex_t fft_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static fft_plan *fft_get_plan(const int n) {
+	int bits = 0;
+	while ((1 << bits) < n)
+		bits++;
+	pthread_mutex_lock(&fft_mutex);
+	fft_plan *plan = fft_plans[bits];
+	if (plan == NULL) {
+		plan = indigo_safe_malloc(sizeof(fft_plan));
+		plan->n = n;
+		/* twiddle[k] = (cos, sin) of 2 * PI * k / n for k = 0 ... n / 2 */
+		plan->twiddle = indigo_safe_malloc((n / 2 + 1) * sizeof(double[2]));
+		for (int k = 0; k <= n / 2; k++) {
+			plan->twiddle[k][RE] = cos(PI_2 * k / (double)n);
+			plan->twiddle[k][IM] = sin(PI_2 * k / (double)n);
+		}
+		plan->reverse = indigo_safe_malloc(n * sizeof(int));
+		for (int i = 0; i < n; i++) {
+			int r = 0;
+			for (int b = 0; b < bits; b++)
+				r |= ((i >> b) & 1) << (bits - 1 - b);
+			plan->reverse[i] = r;
+		}
+		plan->work = indigo_safe_malloc(n * sizeof(double));
+		fft_plans[bits] = plan;
+	}
+	pthread_mutex_unlock(&fft_mutex);
+	return plan;
+}
 
-static void fft(const int n, const double (*x)[2], double (*X)[2]) {
-	double (*_X)[2] = indigo_safe_malloc(2 * n * sizeof(double));
-	_fft(n, 0, 1, x, X, _X);
-	free(_X);
-}
-
-static void _fft(const int n, const int offset, const int delta, const double (*x)[2], double (*X)[2], double (*_X)[2]) {
-	int n2 = n / 2;
-	int k;
-	double ccos, csin;
-	int k00, k01, k10, k11;
-	double tmp0, tmp1;
-	if (n != 2) {
-		_fft(n2, offset, 2 * delta, x, _X, X);
-		_fft(n2, offset + delta, 2 * delta, x, _X, X);
-		for (k = 0; k < n2; k++) {
-			k00 = offset + k * delta;
-			k01 = k00 + n2 * delta;
-			k10 = offset + 2 * k * delta;
-			k11 = k10 + delta;
-			ccos = cos(PI_2 * k / (double)n);
-			csin = sin(PI_2 * k / (double)n);
-			tmp0 = ccos * _X[k11][RE] + csin * _X[k11][IM];
-			tmp1 = ccos * _X[k11][IM] - csin * _X[k11][RE];
-			X[k01][RE] = _X[k10][RE] - tmp0;
-			X[k01][IM] = _X[k10][IM] - tmp1;
-			X[k00][RE] = _X[k10][RE] + tmp0;
-			X[k00][IM] = _X[k10][IM] + tmp1;
-		}
+/* Work buffer of n doubles, cached one is used if not in use by another thread */
+
+static double *fft_acquire_work(fft_plan *plan) {
+	double *work = NULL;
+	pthread_mutex_lock(&fft_mutex);
+	if (!plan->work_used) {
+		plan->work_used = true;
+		work = plan->work;
+	}
+	pthread_mutex_unlock(&fft_mutex);
+	return work ? work : indigo_safe_malloc(plan->n * sizeof(double));
+}
+
+static void fft_release_work(fft_plan *plan, double *work) {
+	if (work == plan->work) {
+		pthread_mutex_lock(&fft_mutex);
+		plan->work_used = false;
+		pthread_mutex_unlock(&fft_mutex);
 	} else {
-		k00 = offset;
-		k01 = k00 + delta;
-		X[k01][RE] = x[k00][RE] - x[k01][RE];
-		X[k01][IM] = x[k00][IM] - x[k01][IM];
-		X[k00][RE] = x[k00][RE] + x[k01][RE];
-		X[k00][IM] = x[k00][IM] + x[k01][IM];
+		free(work);
 	}
 }
 
-static void ifft(const int n, const double (*X)[2], double (*x)[2]) {
-	int n2 = n / 2;
-	int i;
-	double tmp0, tmp1;
-	fft(n, X, x);
-	x[0][RE] = x[0][RE] / n;
-	x[0][IM] = x[0][IM] / n;
-	x[n2][RE] = x[n2][RE] / n;
-	x[n2][IM] = x[n2][IM] / n;
-	for (i = 1; i < n2; i++) {
-		tmp0 = x[i][RE] / n;
-		tmp1 = x[i][IM] / n;
-		x[i][RE] = x[n-i][RE] / n;
-		x[i][IM] = x[n-i][IM] / n;
-		x[n-i][RE] = tmp0;
-		x[n-i][IM] = tmp1;
-	}
-}
-
-static void corellate_fft(const int n, const double (*X1)[2], const double (*X2)[2], double (*c)[2]) {
-	int i;
-	double (*C)[2] = indigo_safe_malloc(2 * n * sizeof(double));
-	/* pointwise multiply X1 conjugate with X2 here, store in X1 */
-	for (i = 0; i < n; i++) {
-		C[i][RE] = X1[i][RE] * X2[i][RE] + X1[i][IM] * X2[i][IM];
-		C[i][IM] = X1[i][IM] * X2[i][RE] - X1[i][RE] * X2[i][IM];
+/* Iterative in-place radix-2 complex forward transform */
+
+static void fft_complex(const fft_plan *plan, double (*X)[2]) {
+	const int n = plan->n;
+	for (int i = 0; i < n; i++) {
+		int j = plan->reverse[i];
+		if (i < j) {
+			double tmp0 = X[i][RE], tmp1 = X[i][IM];
+			X[i][RE] = X[j][RE];
+			X[i][IM] = X[j][IM];
+			X[j][RE] = tmp0;
+			X[j][IM] = tmp1;
+		}
+	}
+	for (int size = 2; size <= n; size <<= 1) {
+		const int half = size / 2, step = n / size;
+		for (int start = 0; start < n; start += size) {
+			for (int k = 0; k < half; k++) {
+				const double *w = plan->twiddle[k * step];
+				double *a = X[start + k], *b = X[start + k + half];
+				double tmp0 = w[RE] * b[RE] + w[IM] * b[IM];
+				double tmp1 = w[RE] * b[IM] - w[IM] * b[RE];
+				b[RE] = a[RE] - tmp0;
+				b[IM] = a[IM] - tmp1;
+				a[RE] += tmp0;
+				a[IM] += tmp1;
+			}
+		}
+	}
+}
+
+/* X[k] of real input from Z[k] and Z[n / 2 - k] of the half size transform of even (real) and odd (imaginary) samples */
+
+static inline void fft_split(const double zr, const double zi, const double mr, const double mi, const double *w, double *X) {
+	double er = (zr + mr) / 2, ei = (zi - mi) / 2;
+	double or = (zi + mi) / 2, oi = (mr - zr) / 2;
+	X[RE] = er + w[RE] * or + w[IM] * oi;
+	X[IM] = ei + w[RE] * oi - w[IM] * or;
+}
+
+/* Forward transform of real input (imaginary parts are ignored) computed as complex transform of half size, full spectrum is stored to X */
+
+static void fft(const int n, const double (*x)[2], double (*X)[2]) {
+	if (n < 4) {
+		for (int i = 0; i < n; i++) {
+			X[i][RE] = x[i][RE];
+			X[i][IM] = 0;
+		}
+		fft_complex(fft_get_plan(n), X);
+		return;
+	}
+	const int m = n / 2;
+	const fft_plan *plan = fft_get_plan(n);
+	for (int k = 0; k < m; k++) {
+		X[k][RE] = x[2 * k][RE];
+		X[k][IM] = x[2 * k + 1][RE];
+	}
+	fft_complex(fft_get_plan(m), X);
+	double z0 = X[0][RE], z1 = X[0][IM];
+	for (int k = 1; k <= m / 2; k++) {
+		int j = m - k;
+		double zr = X[k][RE], zi = X[k][IM], mr = X[j][RE], mi = X[j][IM];
+		fft_split(zr, zi, mr, mi, plan->twiddle[k], X[k]);
+		if (j != k)
+			fft_split(mr, mi, zr, zi, plan->twiddle[j], X[j]);
+	}
+	X[0][RE] = z0 + z1;
+	X[0][IM] = 0;
+	X[m][RE] = z0 - z1;
+	X[m][IM] = 0;
+	for (int k = 1; k < m; k++) {
+		X[n - k][RE] = X[k][RE];
+		X[n - k][IM] = -X[k][IM];
 	}
-	ifft(n, C, c);
-	free(C);
 }
 
-static double find_distance(const int n, const double (*c)[2]) {
+/* Circular cross-correlation of real signals given by their spectra. Result is real, it is computed by inverse complex transform
+   of half size, where even samples are real and odd samples imaginary parts */
+
+static void corellate_fft(const int n, const double (*X1)[2], const double (*X2)[2], double *c) {
+	if (n < 4) {
+		double C[4][2];
+		for (int i = 0; i < n; i++) {
+			/* store conjugate of X1[i] * conj(X2[i]) to get inverse transform */
+			C[i][RE] = X1[i][RE] * X2[i][RE] + X1[i][IM] * X2[i][IM];
+			C[i][IM] = X1[i][RE] * X2[i][IM] - X1[i][IM] * X2[i][RE];
+		}
+		fft_complex(fft_get_plan(n), C);
+		for (int i = 0; i < n; i++)
+			c[i] = C[i][RE] / n;
+		return;
+	}
+	const int m = n / 2;
+	const fft_plan *plan = fft_get_plan(n);
+	double (*Z)[2] = (double (*)[2])c;
+	for (int k = 0; k < m; k++) {
+		/* C[k] = X1[k] * conj(X2[k]) and C[k + n / 2] = conj(C[n / 2 - k]) */
+		int j = m - k;
+		double cr = X1[k][RE] * X2[k][RE] + X1[k][IM] * X2[k][IM];
+		double ci = X1[k][IM] * X2[k][RE] - X1[k][RE] * X2[k][IM];
+		double mr = X1[j][RE] * X2[j][RE] + X1[j][IM] * X2[j][IM];
+		double mi = X1[j][RE] * X2[j][IM] - X1[j][IM] * X2[j][RE];
+		double er = (cr + mr) / 2, ei = (ci + mi) / 2;
+		double dr = (cr - mr) / 2, di = (ci - mi) / 2;
+		const double *w = plan->twiddle[k];
+		double or = dr * w[RE] - di * w[IM], oi = dr * w[IM] + di * w[RE];
+		/* store conjugate of E + i * O to get inverse transform */
+		Z[k][RE] = er - oi;
+		Z[k][IM] = -(ei + or);
+	}
+	fft_complex(fft_get_plan(m), Z);
+	for (int k = 0; k < m; k++) {
+		Z[k][RE] = Z[k][RE] / m;
+		Z[k][IM] = -Z[k][IM] / m;
+	}
+}
+
+static double find_distance(const int n, const double *c) {
 	int i;
 	const int n2 = n / 2;
 	int max=0;
 	int prev, next;
 	for (i = 0; i < n; i++) {
-		max = (c[i][0] > c[max][0]) ? i : max;
+		max = (c[i] > c[max]) ? i : max;
 	}
 	/* find previous and next positions to calculate quadratic interpolation */
 	if ((max == 0) || (max == n2)) {
@@ -364,8 +492,8 @@ static double find_distance(const int n, const double (*c)[2]) {
 		next = max + 1;
 	}
 	/* find subpixel offset of the maximum position using quadratic interpolation */
-	double max_subp = (c[next][RE] - c[prev][RE]) / (2 * (2 * c[max][RE] - c[next][RE] - c[prev][RE]));
-	//INDIGO_DEBUG(indigo_debug("max_subp = %5.2f max: %d -> %5.2f %5.2f %5.2f\n", max_subp, max, c[prev][0], c[max][0], c[next][0]));
+	double max_subp = (c[next] - c[prev]) / (2 * (2 * c[max] - c[next] - c[prev]));
+	//INDIGO_DEBUG(indigo_debug("max_subp = %5.2f max: %d -> %5.2f %5.2f %5.2f\n", max_subp, max, c[prev], c[max], c[next]));
 	if (max == n2) {
 		return max_subp;
 	} else if (max > n2) {
@@ -1505,420 +1633,264 @@ double indigo_stddev(double set[], const int count) {
 	return sqrt(sum / count);
 }
 
-static double indigo_stddev_8(uint8_t set[], const int width, const int height, bool *saturated) {
-	double d, m, sum = 0;
-	int real_count = 0;
-
-	if (saturated) *saturated = false;
-
-	const int end_x = width - 1;
-	const int end_y = height - 1;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			sum += set[y * width + x];
-			real_count++;
-		}
-	}
-	m = sum / real_count;
-
-	const double threshold = (SATURATION_8 - m) * 0.3 + m;
-	real_count = 0;
-	sum = 0;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			int i = y * width + x;
-			/* Check if saturated feature or hotpixel, hotpixels do not break the estimation */
-			if (set[i] > SATURATION_8 && median3(set[i - 1], set[i], set[i + 1]) > threshold) {
-				if (saturated) {
-					if (!(*saturated)) INDIGO_DEBUG(indigo_debug("Saturation detected: threshold = %.2f, median = %d, mean = %.2f", threshold, median3(set[i - 1], set[i], set[i + 1]), m));
-					*saturated = true;
-				}
-			}
-			d = set[i] - m;
-			sum += d * d;
-			real_count++;
-		}
+/* RMS contrast is computed over fixed bands of CONTRAST_TILE_ROWS rows processed in parallel,
+   partial sums are reduced in band order so the result does not depend on the number of threads */
+
+#define CONTRAST_TILE_ROWS 32
+
+typedef struct {
+	uint64_t sum;
+	int count;
+	double deviation;
+	bool saturated;
+	int median;
+} contrast_tile;
+
+typedef struct {
+	const void *data;
+	const uint8_t *mask;
+	int width;
+	int height;
+	int components;
+	double mean;
+	double threshold;
+	contrast_tile *tiles;
+} contrast_data;
+
+static inline void contrast_sum_row_8(const uint8_t *row, const uint8_t *mask, const int end_x, const int components, uint64_t *sum, int *count) {
+	uint64_t row_sum = 0;
+	int row_count = 0;
+	for (int x = 1; x < end_x; x++) {
+		if (mask && !mask[x])
+			continue;
+		for (int c = 0; c < components; c++)
+			row_sum += row[x * components + c];
+		row_count++;
 	}
-
-	return sqrt(sum / real_count);
+	*sum += row_sum;
+	*count += row_count;
 }
 
-static double indigo_stddev_masked_8(uint8_t set[], const uint8_t mask[], const int width, const int height, bool *saturated) {
-	double d, m, sum = 0;
-	int real_count = 0;
-
-	if (saturated) *saturated = false;
-
-	const int end_x = width - 1;
-	const int end_y = height - 1;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			int i = y * width + x;
-			if (mask[i]) {
-				sum += set[i];
-				real_count++;
-			}
-		}
+static void contrast_sum_tiles_8(contrast_data *contrast_data, int start, int end) {
+	const uint8_t *set = contrast_data->data;
+	const int width = contrast_data->width;
+	const int components = contrast_data->components;
+	const int end_y = contrast_data->height - 1;
+	for (int t = start; t < end; t++) {
+		uint64_t sum = 0;
+		int count = 0;
+		const int tile_end_y = MIN(end_y, 1 + (t + 1) * CONTRAST_TILE_ROWS);
+		for (int y = 1 + t * CONTRAST_TILE_ROWS; y < tile_end_y; y++) {
+			const uint8_t *row = set + y * width * components;
+			const uint8_t *mask = contrast_data->mask ? contrast_data->mask + y * width : NULL;
+			if (components == 1)
+				contrast_sum_row_8(row, mask, width - 1, 1, &sum, &count);
+			else
+				contrast_sum_row_8(row, mask, width - 1, 3, &sum, &count);
+		}
+		contrast_data->tiles[t].sum = sum;
+		contrast_data->tiles[t].count = count;
 	}
-	m = sum / real_count;
-
-	const double threshold = (SATURATION_8 - m) * 0.3 + m;
-	real_count = 0;
-	sum = 0;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			int i = y * width + x;
-			if (mask[i]) {
-				/* Check if saturated feature or hotpixel, hotpixels do not break the estimation */
-				if (set[i] > SATURATION_8 && median3(set[i - 1], set[i], set[i + 1]) > threshold) {
-					if (saturated) {
-						if (!(*saturated)) INDIGO_DEBUG(indigo_debug("Saturation detected: threshold = %.2f, median = %d, mean = %.2f", threshold, median3(set[i - 1], set[i], set[i + 1]), m));
-						*saturated = true;
-					}
-				}
-				d = set[i] - m;
-				sum += d * d;
-				real_count++;
-			}
-		}
-	}
-
-	return sqrt(sum / real_count);
 }
 
-static double indigo_stddev_masked_rgb24(uint8_t set[], const uint8_t mask[], const int width, const int height, bool *saturated) {
-	double d, m, sum = 0;
-	int real_count = 0;
-	int index = 0, i = 0;
+/* Check if saturated feature or hotpixel, hotpixels do not break the estimation */
 
-	if (saturated) *saturated = false;
-
-	const int end_x = width - 1;
-	const int end_y = height - 1;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			index = y * width + x;
-			i = index * 3;
-			if (mask[index]) {
-				sum += set[i];
-				sum += set[i + 1];
-				sum += set[i + 2];
-				real_count++;
-			}
-		}
-	}
-	m = sum / (real_count * 3);
-
-	const double threshold = (SATURATION_8 - m) * 0.3 + m;
-	real_count = 0;
-	sum = 0;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			index = y * width + x;
-			i = index * 3;
-			if (mask[index]) {
-				/* Check if saturated feature or hotpixel, hotpixels do not break the estimation */
-				if (
-					(
-						set[i] > SATURATION_8 ||
-						set[i + 1] > SATURATION_8 ||
-						set[i + 2] > SATURATION_8
-					) && (
-						median3(set[i - 3], set[i], set[i + 3]) > threshold ||
-						median3(set[i - 2], set[i + 1], set[i + 4]) > threshold ||
-						median3(set[i - 1], set[i + 2], set[i + 5]) > threshold
-					)
-				) {
-					if (saturated) {
-						if (!(*saturated)) INDIGO_DEBUG(indigo_debug("Saturation detected: threshold = %.2f, mean = %.2f", threshold, m));
-						*saturated = true;
-					}
+static inline double contrast_deviation_row_8(const uint8_t *row, const uint8_t *mask, const int end_x, const int components, const double m, const double threshold, double sum, contrast_tile *tile) {
+	double d;
+	for (int x = 1; x < end_x; x++) {
+		if (mask && !mask[x])
+			continue;
+		const uint8_t *pixel = row + x * components;
+		if (components == 1) {
+			if (pixel[0] > SATURATION_8 && !tile->saturated) {
+				int median = median3(pixel[-1], pixel[0], pixel[1]);
+				if (median > threshold) {
+					tile->saturated = true;
+					tile->median = median;
 				}
-				d = set[i] - m;
-				sum += d * d;
-				d = set[i + 1] - m;
-				sum += d * d;
-				d = set[i + 2] - m;
-				sum += d * d;
-
-				real_count++;
 			}
-		}
-	}
-
-	return sqrt(sum / real_count);
-}
-
-static double indigo_stddev_rgb24(uint8_t set[], const int width, const int height, bool *saturated) {
-	double d, m, sum = 0;
-	int real_count = 0;
-	int i = 0;
-
-	if (saturated) *saturated = false;
-
-	const int end_x = width - 1;
-	const int end_y = height - 1;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			i = (y * width + x) * 3;
-			sum += set[i];
-			sum += set[i + 1];
-			sum += set[i + 2];
-			real_count++;
-		}
-	}
-	m = sum / (real_count * 3);
-
-	const double threshold = (SATURATION_8 - m) * 0.3 + m;
-	real_count = 0;
-	sum = 0;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			i = (y * width + x) * 3;
-			/* Check if saturated feature or hotpixel, hotpixels do not break the estimation */
+			d = pixel[0] - m;
+			sum += d * d;
+		} else {
 			if (
 				(
-					set[i] > SATURATION_8 ||
-					set[i + 1] > SATURATION_8 ||
-					set[i + 2] > SATURATION_8
-				) && (
-					median3(set[i - 3], set[i], set[i + 3]) > threshold ||
-					median3(set[i - 2], set[i + 1], set[i + 4]) > threshold ||
-					median3(set[i - 1], set[i + 2], set[i + 5]) > threshold
+					pixel[0] > SATURATION_8 ||
+					pixel[1] > SATURATION_8 ||
+					pixel[2] > SATURATION_8
+				) && !tile->saturated && (
+					median3(pixel[-3], pixel[0], pixel[3]) > threshold ||
+					median3(pixel[-2], pixel[1], pixel[4]) > threshold ||
+					median3(pixel[-1], pixel[2], pixel[5]) > threshold
 				)
 			) {
-				if (saturated) {
-					if (!(*saturated)) INDIGO_DEBUG(indigo_debug("Saturation detected: threshold = %.2f, mean = %.2f", threshold, m));
-					*saturated = true;
-				}
+				tile->saturated = true;
 			}
-			d = set[i] - m;
+			d = pixel[0] - m;
 			sum += d * d;
-			d = set[i + 1] - m;
+			d = pixel[1] - m;
 			sum += d * d;
-			d = set[i + 2] - m;
+			d = pixel[2] - m;
 			sum += d * d;
-
-			real_count++;
 		}
 	}
-
-	return sqrt(sum / real_count);
+	return sum;
 }
 
-static double indigo_stddev_16(uint16_t set[], const int width, const int height, bool *saturated) {
-	double d, m, sum = 0;
-	int real_count = 0;
-
-	if (saturated) *saturated = false;
-
-	const int end_x = width - 1;
-	const int end_y = height - 1;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			sum += set[y * width + x];
-			real_count++;
-		}
+static void contrast_deviation_tiles_8(contrast_data *contrast_data, int start, int end) {
+	const uint8_t *set = contrast_data->data;
+	const int width = contrast_data->width;
+	const int components = contrast_data->components;
+	const int end_y = contrast_data->height - 1;
+	for (int t = start; t < end; t++) {
+		contrast_tile *tile = contrast_data->tiles + t;
+		double sum = 0;
+		const int tile_end_y = MIN(end_y, 1 + (t + 1) * CONTRAST_TILE_ROWS);
+		for (int y = 1 + t * CONTRAST_TILE_ROWS; y < tile_end_y; y++) {
+			const uint8_t *row = set + y * width * components;
+			const uint8_t *mask = contrast_data->mask ? contrast_data->mask + y * width : NULL;
+			if (components == 1)
+				sum = contrast_deviation_row_8(row, mask, width - 1, 1, contrast_data->mean, contrast_data->threshold, sum, tile);
+			else
+				sum = contrast_deviation_row_8(row, mask, width - 1, 3, contrast_data->mean, contrast_data->threshold, sum, tile);
+		}
+		tile->deviation = sum;
 	}
-	m = sum / real_count;
-
-	const double threshold = (SATURATION_16 - m) * 0.3 + m;
-	real_count = 0;
-	sum = 0;
+}
 
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			int i = y * width + x;
-			/* Check if saturated feature or hotpixel, hotpixels do not break the estimation */
-			if (set[i] > SATURATION_16 && median3(set[i - 1], set[i], set[i + 1]) > threshold) {
-				if (saturated) {
-					if (!(*saturated)) INDIGO_DEBUG(indigo_debug("Saturation detected: threshold = %.2f, median = %d, mean = %.2f", threshold, median3(set[i - 1], set[i], set[i + 1]), m));
-					*saturated = true;
-				}
-			}
-			d = set[i] - m;
-			sum += d * d;
-			real_count++;
-		}
+static inline void contrast_sum_row_16(const uint16_t *row, const uint8_t *mask, const int end_x, const int components, uint64_t *sum, int *count) {
+	uint64_t row_sum = 0;
+	int row_count = 0;
+	for (int x = 1; x < end_x; x++) {
+		if (mask && !mask[x])
+			continue;
+		for (int c = 0; c < components; c++)
+			row_sum += row[x * components + c];
+		row_count++;
 	}
-
-	return sqrt(sum / real_count);
+	*sum += row_sum;
+	*count += row_count;
 }
 
-static double indigo_stddev_masked_16(uint16_t set[], const uint8_t mask[], const int width, const int height, bool *saturated) {
-	double d, m, sum = 0;
-	int real_count = 0;
-
-	if (saturated) *saturated = false;
-
-	const int end_x = width - 1;
-	const int end_y = height - 1;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			int i = y * width + x;
-			if (mask[i]) {
-				sum += set[i];
-				real_count++;
-			}
-		}
+static void contrast_sum_tiles_16(contrast_data *contrast_data, int start, int end) {
+	const uint16_t *set = contrast_data->data;
+	const int width = contrast_data->width;
+	const int components = contrast_data->components;
+	const int end_y = contrast_data->height - 1;
+	for (int t = start; t < end; t++) {
+		uint64_t sum = 0;
+		int count = 0;
+		const int tile_end_y = MIN(end_y, 1 + (t + 1) * CONTRAST_TILE_ROWS);
+		for (int y = 1 + t * CONTRAST_TILE_ROWS; y < tile_end_y; y++) {
+			const uint16_t *row = set + y * width * components;
+			const uint8_t *mask = contrast_data->mask ? contrast_data->mask + y * width : NULL;
+			if (components == 1)
+				contrast_sum_row_16(row, mask, width - 1, 1, &sum, &count);
+			else
+				contrast_sum_row_16(row, mask, width - 1, 3, &sum, &count);
+		}
+		contrast_data->tiles[t].sum = sum;
+		contrast_data->tiles[t].count = count;
 	}
-	m = sum / real_count;
+}
 
-	const double threshold = (SATURATION_16 - m) * 0.3 + m;
-	real_count = 0;
-	sum = 0;
+/* Check if saturated feature or hotpixel, hotpixels do not break the estimation */
 
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			int i = y * width + x;
-			if (mask[i]) {
-				/* Check if saturated feature or hotpixel, hotpixels do not break the estimation */
-				if (set[i] > SATURATION_16 && median3(set[i - 1], set[i], set[i + 1]) > threshold) {
-					if (saturated) {
-						if (!(*saturated)) INDIGO_DEBUG(indigo_debug("Saturation detected: threshold = %.2f, median = %d, mean = %.2f", threshold, median3(set[i - 1], set[i], set[i + 1]), m));
-						*saturated = true;
-					}
+static inline double contrast_deviation_row_16(const uint16_t *row, const uint8_t *mask, const int end_x, const int components, const double m, const double threshold, double sum, contrast_tile *tile) {
+	double d;
+	for (int x = 1; x < end_x; x++) {
+		if (mask && !mask[x])
+			continue;
+		const uint16_t *pixel = row + x * components;
+		if (components == 1) {
+			if (pixel[0] > SATURATION_16 && !tile->saturated) {
+				int median = median3(pixel[-1], pixel[0], pixel[1]);
+				if (median > threshold) {
+					tile->saturated = true;
+					tile->median = median;
 				}
-				d = set[i] - m;
-				sum += d * d;
-				real_count++;
 			}
+			d = pixel[0] - m;
+			sum += d * d;
+		} else {
+			if (
+				(
+					pixel[0] > SATURATION_16 ||
+					pixel[1] > SATURATION_16 ||
+					pixel[2] > SATURATION_16
+				) && !tile->saturated && (
+					median3(pixel[-3], pixel[0], pixel[3]) > threshold ||
+					median3(pixel[-2], pixel[1], pixel[4]) > threshold ||
+					median3(pixel[-1], pixel[2], pixel[5]) > threshold
+				)
+			) {
+				tile->saturated = true;
+			}
+			d = pixel[0] - m;
+			sum += d * d;
+			d = pixel[1] - m;
+			sum += d * d;
+			d = pixel[2] - m;
+			sum += d * d;
 		}
 	}
-
-	return sqrt(sum / real_count);
+	return sum;
 }
 
-static double indigo_stddev_masked_rgb48(uint16_t set[], const uint8_t mask[], const int width, const int height, bool *saturated) {
-	double d, m, sum = 0;
-	int real_count = 0;
-	int index = 0, i = 0;
-
-	if (saturated) *saturated = false;
-
-	const int end_x = width - 1;
-	const int end_y = height - 1;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			index = y * width + x;
-			i = index * 3;
-			if (mask[index]) {
-				sum += set[i];
-				sum += set[i + 1];
-				sum += set[i + 2];
-				real_count++;
-			}
-		}
-	}
-	m = sum / (real_count * 3);
-
-	const double threshold = (SATURATION_16 - m) * 0.3 + m;
-	real_count = 0;
-	sum = 0;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			index = y * width + x;
-			i = index * 3;
-			if (mask[index]) {
-				/* Check if saturated feature or hotpixel, hotpixels do not break the estimation */
-				if (
-					(
-						set[i] > SATURATION_16 ||
-						set[i + 1] > SATURATION_16 ||
-						set[i + 2] > SATURATION_16
-					) && (
-						median3(set[i - 3], set[i], set[i + 3]) > threshold ||
-						median3(set[i - 2], set[i + 1], set[i + 4]) > threshold ||
-						median3(set[i - 1], set[i + 2], set[i + 5]) > threshold
-					)
-				) {
-					if (saturated) {
-						if (!(*saturated)) INDIGO_DEBUG(indigo_debug("Saturation detected: threshold = %.2f, mean = %.2f", threshold, m));
-						*saturated = true;
-					}
-				}
-				d = set[i] - m;
-				sum += d * d;
-				d = set[i + 1] - m;
-				sum += d * d;
-				d = set[i + 2] - m;
-				sum += d * d;
-
-				real_count++;
-			}
-		}
+static void contrast_deviation_tiles_16(contrast_data *contrast_data, int start, int end) {
+	const uint16_t *set = contrast_data->data;
+	const int width = contrast_data->width;
+	const int components = contrast_data->components;
+	const int end_y = contrast_data->height - 1;
+	for (int t = start; t < end; t++) {
+		contrast_tile *tile = contrast_data->tiles + t;
+		double sum = 0;
+		const int tile_end_y = MIN(end_y, 1 + (t + 1) * CONTRAST_TILE_ROWS);
+		for (int y = 1 + t * CONTRAST_TILE_ROWS; y < tile_end_y; y++) {
+			const uint16_t *row = set + y * width * components;
+			const uint8_t *mask = contrast_data->mask ? contrast_data->mask + y * width : NULL;
+			if (components == 1)
+				sum = contrast_deviation_row_16(row, mask, width - 1, 1, contrast_data->mean, contrast_data->threshold, sum, tile);
+			else
+				sum = contrast_deviation_row_16(row, mask, width - 1, 3, contrast_data->mean, contrast_data->threshold, sum, tile);
+		}
+		tile->deviation = sum;
 	}
-
-	return sqrt(sum / real_count);
 }
 
-static double indigo_stddev_rgb48(uint16_t set[], const int width, const int height, bool *saturated) {
-	double d, m, sum = 0;
-	int real_count = 0;
-	int i = 0;
+/* standard deviation of the frame without the border pixels, RGB deviations of all three channels are summed per pixel */
 
+static double indigo_stddev_tiled(const void *set, const uint8_t mask[], const int width, const int height, const int components, const bool wide, bool *saturated) {
 	if (saturated) *saturated = false;
 
-	const int end_x = width - 1;
-	const int end_y = height - 1;
+	const int tile_count = MAX(1, (height - 2 + CONTRAST_TILE_ROWS - 1) / CONTRAST_TILE_ROWS);
+	contrast_data contrast_data = { set, mask, width, height, components };
+	contrast_data.tiles = indigo_safe_malloc(tile_count * sizeof(contrast_tile));
 
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			i = y * width + x;
-			sum += set[i];
-			sum += set[i + 1];
-			sum += set[i + 2];
-			real_count++;
-		}
+	indigo_parallel_for(tile_count, (void (*)(void *, int, int))(wide ? contrast_sum_tiles_16 : contrast_sum_tiles_8), &contrast_data);
+	uint64_t total = 0;
+	int real_count = 0;
+	for (int t = 0; t < tile_count; t++) {
+		total += contrast_data.tiles[t].sum;
+		real_count += contrast_data.tiles[t].count;
 	}
-	m = sum / (real_count * 3);
-
-	const double threshold = (SATURATION_16 - m) * 0.3 + m;
-	real_count = 0;
-	sum = 0;
-
-	for (int y = 1; y < end_y; y++) {
-		for (int x = 1; x < end_x; x++) {
-			i = (y * width + x) * 3;
-			/* Check if saturated feature or hotpixel, hotpixels do not break the estimation */
-			if (
-				(
-					set[i] > SATURATION_16 ||
-					set[i + 1] > SATURATION_16 ||
-					set[i + 2] > SATURATION_16
-				) && (
-					median3(set[i - 3], set[i], set[i + 3]) > threshold ||
-					median3(set[i - 2], set[i + 1], set[i + 4]) > threshold ||
-					median3(set[i - 1], set[i + 2], set[i + 5]) > threshold
-				)
-			) {
-				if (saturated) {
-					if (!(*saturated)) INDIGO_DEBUG(indigo_debug("Saturation detected: threshold = %.2f, mean = %.2f", threshold, m));
-					*saturated = true;
-				}
-			}
-			d = set[i] - m;
-			sum += d * d;
-			d = set[i + 1] - m;
-			sum += d * d;
-			d = set[i + 2] - m;
-			sum += d * d;
+	const double m = (double)total / (real_count * components);
+	contrast_data.mean = m;
+	contrast_data.threshold = ((wide ? SATURATION_16 : SATURATION_8) - m) * 0.3 + m;
 
-			real_count++;
+	indigo_parallel_for(tile_count, (void (*)(void *, int, int))(wide ? contrast_deviation_tiles_16 : contrast_deviation_tiles_8), &contrast_data);
+	double sum = 0;
+	for (int t = 0; t < tile_count; t++) {
+		contrast_tile *tile = contrast_data.tiles + t;
+		sum += tile->deviation;
+		if (saturated && tile->saturated && !(*saturated)) {
+			if (components == 1)
+				INDIGO_DEBUG(indigo_debug("Saturation detected: threshold = %.2f, median = %d, mean = %.2f", contrast_data.threshold, tile->median, m));
+			else
+				INDIGO_DEBUG(indigo_debug("Saturation detected: threshold = %.2f, mean = %.2f", contrast_data.threshold, m));
+			*saturated = true;
 		}
 	}
+	indigo_safe_free(contrast_data.tiles);
 
 	return sqrt(sum / real_count);
 }
@@ -1928,32 +1900,16 @@ double indigo_contrast(indigo_raw_type raw_type, const void *data, const uint8_t
 
 	switch (raw_type) {
 		case INDIGO_RAW_MONO8: {
-			if (saturation_mask == NULL) {
-				return indigo_stddev_8((uint8_t*)data, width, height, saturated) / 255.0;
-			} else {
-				return indigo_stddev_masked_8((uint8_t*)data, saturation_mask, width, height, saturated) / 255.0;
-			}
+			return indigo_stddev_tiled(data, saturation_mask, width, height, 1, false, saturated) / 255.0;
 		}
 		case INDIGO_RAW_MONO16: {
-			if (saturation_mask == NULL) {
-				return indigo_stddev_16((uint16_t*)data, width, height, saturated) / 65535.0;
-			} else {
-				return indigo_stddev_masked_16((uint16_t*)data, saturation_mask, width, height, saturated) / 65535.0;
-			}
+			return indigo_stddev_tiled(data, saturation_mask, width, height, 1, true, saturated) / 65535.0;
 		}
 		case INDIGO_RAW_RGB24: {
-			if (saturation_mask == NULL) {
-				return indigo_stddev_rgb24((uint8_t*)data, width, height, saturated) / 255.0;
-			} else {
-				return indigo_stddev_masked_rgb24((uint8_t*)data, saturation_mask, width, height, saturated) / 255.0;
-			}
+			return indigo_stddev_tiled(data, saturation_mask, width, height, 3, false, saturated) / 255.0;
 		}
 		case INDIGO_RAW_RGB48: {
-			if (saturation_mask == NULL) {
-				return indigo_stddev_rgb48((uint16_t*)data, width, height, saturated) / 65535.0;
-			} else {
-				return indigo_stddev_masked_rgb48((uint16_t*)data, saturation_mask, width, height, saturated) / 65535.0;
-			}
+			return indigo_stddev_tiled(data, saturation_mask, width, height, 3, true, saturated) / 65535.0;
 		}
 		case INDIGO_RAW_RGBA32: {
 			return 0;
@@ -2112,16 +2068,18 @@ indigo_result indigo_calculate_drift(const indigo_frame_digest *ref, const indig
 		return INDIGO_OK;
 	}
 	if (ref->algorithm == donuts) {
-		double (*c_buf)[2];
-		int max_dim = (ref->width > ref->height) ? ref->width : ref->height;
-		c_buf = indigo_safe_malloc(2 * max_dim * sizeof(double));
 		/* find X correction */
+		fft_plan *plan = fft_get_plan(ref->width);
+		double *c_buf = fft_acquire_work(plan);
 		corellate_fft(ref->width, new_digest->fft_x, ref->fft_x, c_buf);
 		*drift_x = find_distance(ref->width, c_buf);
+		fft_release_work(plan, c_buf);
 		/* find Y correction */
+		plan = fft_get_plan(ref->height);
+		c_buf = fft_acquire_work(plan);
 		corellate_fft(ref->height, new_digest->fft_y, ref->fft_y, c_buf);
 		*drift_y = find_distance(ref->height, c_buf);
-		free(c_buf);
+		fft_release_work(plan, c_buf);
 		return INDIGO_OK;
 	}
 	return INDIGO_FAILED;
@@ -2143,254 +2101,596 @@ indigo_result indigo_delete_frame_digest(indigo_frame_digest *fdigest) {
 	return INDIGO_FAILED;
 }
 
-static const double FIND_STAR_EDGE_CLIPPING = 20;
+/* Local background mesh, frame is split to cells of approximately cell_size pixels, background and noise of each cell are estimated
+   by iterative sigma clipping of sampled cell pixels, cells dominated by bright objects are suppressed by 3x3 median filter of the mesh */
+
+#define BACKGROUND_CLIP_SIGMA 3.0
+#define BACKGROUND_CLIP_ITERATIONS 10
+/* odd step, so all sites of raw bayer frames are sampled */
+#define BACKGROUND_SAMPLING 3
+
+typedef struct {
+	const uint16_t *buf;
+	indigo_background_mesh *mesh;
+} background_mesh_data;
+
+static void background_mesh_rows(background_mesh_data *mesh_data, int start, int end) {
+	indigo_background_mesh *mesh = mesh_data->mesh;
+	const int width = mesh->width;
+	/* samples are collected once, so clipping iterations do not walk the frame again */
+	const int max_samples = ((mesh->width / mesh->columns + 1) / BACKGROUND_SAMPLING + 1) * ((mesh->height / mesh->rows + 1) / BACKGROUND_SAMPLING + 1);
+	uint16_t *samples = indigo_safe_malloc(max_samples * sizeof(uint16_t));
+	for (int row = start; row < end; row++) {
+		const int y0 = row * mesh->height / mesh->rows;
+		const int y1 = (row + 1) * mesh->height / mesh->rows;
+		for (int column = 0; column < mesh->columns; column++) {
+			const int x0 = column * width / mesh->columns;
+			const int x1 = (column + 1) * width / mesh->columns;
+			int sample_count = 0;
+			for (int y = y0 + BACKGROUND_SAMPLING / 2; y < y1; y += BACKGROUND_SAMPLING) {
+				const uint16_t *pixel = mesh_data->buf + y * width;
+				for (int x = x0 + BACKGROUND_SAMPLING / 2; x < x1; x += BACKGROUND_SAMPLING)
+					samples[sample_count++] = pixel[x];
+			}
+			if (sample_count == 0)
+				samples[sample_count++] = mesh_data->buf[y0 * width + x0];
+			int low = 0, high = 0xFFFF, previous_count = -1;
+			int reference = samples[0];
+			double mean = reference, sigma = 0;
+			for (int iteration = 0; iteration < BACKGROUND_CLIP_ITERATIONS; iteration++) {
+				/* sums are shifted by the previous mean to avoid cancellation in variance */
+				int64_t sum = 0, sum_sq = 0;
+				int count = 0;
+				for (int i = 0; i < sample_count; i++) {
+					const int value = samples[i];
+					if (value >= low && value <= high) {
+						const int64_t delta = value - reference;
+						sum += delta;
+						sum_sq += delta * delta;
+						count++;
+					}
+				}
+				if (count == 0 || count == previous_count)
+					break;
+				previous_count = count;
+				const double shift = (double)sum / count;
+				mean = reference + shift;
+				sigma = sqrt(MAX(0, (double)sum_sq / count - shift * shift));
+				low = (int)ceil(mean - BACKGROUND_CLIP_SIGMA * sigma);
+				high = (int)floor(mean + BACKGROUND_CLIP_SIGMA * sigma);
+				reference = (int)round(mean);
+			}
+			mesh->background[row * mesh->columns + column] = mean;
+			mesh->noise[row * mesh->columns + column] = sigma;
+		}
+	}
+	indigo_safe_free(samples);
+}
 
-static int luminance_comparator(const void *item_1, const void *item_2) {
-	if (((indigo_star_detection *)item_1)->luminance < ((indigo_star_detection *)item_2)->luminance)
-		return 1;
-	if (((indigo_star_detection *)item_1)->luminance > ((indigo_star_detection *)item_2)->luminance)
-		return -1;
-	return 0;
+static int float_comparator(const void *item_1, const void *item_2) {
+	const float value_1 = *(const float *)item_1, value_2 = *(const float *)item_2;
+	return value_1 < value_2 ? -1 : value_1 > value_2;
 }
 
-/* With radius < 3, no precise star positins will be determined */
-indigo_result indigo_find_stars_precise(indigo_raw_type raw_type, const void *data, const uint16_t radius, const int width, const int height, const int stars_max, indigo_star_detection star_list[], int *stars_found) {
-	if (data == NULL || star_list == NULL || stars_found == NULL) return INDIGO_FAILED;
+static void median_filter_mesh(const indigo_background_mesh *mesh, float *cells) {
+	const int size = mesh->columns * mesh->rows;
+	float *filtered = indigo_safe_malloc(size * sizeof(float));
+	for (int row = 0; row < mesh->rows; row++) {
+		for (int column = 0; column < mesh->columns; column++) {
+			float neighbours[9];
+			int count = 0;
+			for (int j = MAX(0, row - 1); j <= MIN(mesh->rows - 1, row + 1); j++)
+				for (int i = MAX(0, column - 1); i <= MIN(mesh->columns - 1, column + 1); i++)
+					neighbours[count++] = cells[j * mesh->columns + i];
+			qsort(neighbours, count, sizeof(float), float_comparator);
+			filtered[row * mesh->columns + column] = count % 2 ? neighbours[count / 2] : (neighbours[count / 2 - 1] + neighbours[count / 2]) / 2;
+		}
+	}
+	memcpy(cells, filtered, size * sizeof(float));
+	indigo_safe_free(filtered);
+}
 
-	int  size = width * height;
-	uint16_t *buf = indigo_safe_malloc(size * sizeof(uint16_t));
-	int star_size = 100;
-	const int clip_edge = height >= FIND_STAR_EDGE_CLIPPING * 4 ? FIND_STAR_EDGE_CLIPPING : (height / 4);
-	int clip_width  = width - clip_edge;
-	int clip_height = height - clip_edge;
-	uint16_t max_luminance = 0;
+static void make_background_mesh(const uint16_t *buf, const int width, const int height, const int cell_size, indigo_background_mesh *mesh) {
+	mesh->width = width;
+	mesh->height = height;
+	mesh->columns = MAX(1, width / cell_size);
+	mesh->rows = MAX(1, height / cell_size);
+	mesh->background = indigo_safe_malloc(mesh->columns * mesh->rows * sizeof(float));
+	mesh->noise = indigo_safe_malloc(mesh->columns * mesh->rows * sizeof(float));
+	background_mesh_data mesh_data = { buf, mesh };
+	indigo_parallel_for(mesh->rows, (void (*)(void *, int, int))background_mesh_rows, &mesh_data);
+	if (mesh->columns * mesh->rows > 1) {
+		median_filter_mesh(mesh, mesh->background);
+		median_filter_mesh(mesh, mesh->noise);
+	}
+}
 
-	uint8_t *data8 = (uint8_t *)data;
-	uint16_t *data16 = (uint16_t *)data;
-	double sum = 0;
-	double sum_sq = 0;
+/* Row is split to segments between cell centres (plus the edges before the first and after the last one), level is linear within each
+   of them, so the integer floor of its lower end is enough to skip most of the pixels without interpolation */
+
+static inline double mesh_row_position(const indigo_background_mesh *mesh, const int x) {
+	return (x + 0.5) * mesh->columns / mesh->width - 0.5;
+}
+
+static inline int mesh_row_segment(const indigo_background_mesh *mesh, const double u) {
+	return u <= 0 ? 0 : u >= mesh->columns - 1 ? mesh->columns : (int)u + 1;
+}
+
+static void mesh_row_segments(const indigo_background_mesh *mesh, int *segment_ends) {
+	int segment = 0;
+	for (int x = 0; x < mesh->width; x++) {
+		const int current = mesh_row_segment(mesh, mesh_row_position(mesh, x));
+		while (segment < current)
+			segment_ends[segment++] = x;
+	}
+	while (segment <= mesh->columns)
+		segment_ends[segment++] = mesh->width;
+}
+
+static inline float mesh_row_level(const indigo_background_mesh *mesh, const float *column_levels, const int x) {
+	const double u = mesh_row_position(mesh, x);
+	const int segment = mesh_row_segment(mesh, u);
+	if (segment == 0)
+		return column_levels[0];
+	if (segment == mesh->columns)
+		return column_levels[mesh->columns - 1];
+	return column_levels[segment - 1] + (column_levels[segment] - column_levels[segment - 1]) * (u - (segment - 1));
+}
+
+/* Interpolate per cell levels (background + sigma * noise) to the frame row at cell centres and the skip level of each segment */
 
+static void interpolate_mesh_row(const indigo_background_mesh *mesh, const double sigma, const int y, float *column_levels, int *skip_levels) {
+	double v = (y + 0.5) * mesh->rows / mesh->height - 0.5;
+	v = MAX(0, MIN(mesh->rows - 1, v));
+	const int row_0 = (int)v, row_1 = MIN(mesh->rows - 1, row_0 + 1);
+	const double fraction = v - row_0;
+	for (int column = 0; column < mesh->columns; column++) {
+		double level_0 = mesh->background[row_0 * mesh->columns + column] + sigma * mesh->noise[row_0 * mesh->columns + column];
+		double level_1 = mesh->background[row_1 * mesh->columns + column] + sigma * mesh->noise[row_1 * mesh->columns + column];
+		column_levels[column] = level_0 + (level_1 - level_0) * fraction;
+	}
+	for (int s = 0; s <= mesh->columns; s++) {
+		const float level = MIN(column_levels[MAX(0, s - 1)], column_levels[MIN(mesh->columns - 1, s)]);
+		skip_levels[s] = level < 0 ? -1 : level >= 0xFFFF ? 0xFFFF : (int)level;
+	}
+}
+
+/* Convert frame to 16 bit luminance buffer, RGB pixels are averaged */
+
+static uint16_t *luminance_buffer(indigo_raw_type raw_type, const void *data, const int width, const int height, uint16_t *max_luminance) {
+	const int size = width * height;
+	uint16_t *buf = indigo_safe_malloc(size * sizeof(uint16_t));
+	const uint8_t *data8 = (const uint8_t *)data;
+	const uint16_t *data16 = (const uint16_t *)data;
 	switch (raw_type) {
 		case INDIGO_RAW_MONO8: {
-			max_luminance = 0xFF;
-			for (int i = 0; i < size; i++) {
+			*max_luminance = 0xFF;
+			for (int i = 0; i < size; i++)
 				buf[i] = data8[i];
-				sum += buf[i];
-				sum_sq += buf[i] * buf[i];
-			}
 			break;
 		}
 		case INDIGO_RAW_MONO16: {
-			max_luminance = 0xFFFF;
-			for (int i = 0; i < size; i++) {
-				buf[i] = data16[i];
-				sum += buf[i];
-				sum_sq += buf[i] * buf[i];
-			}
+			*max_luminance = 0xFFFF;
+			memcpy(buf, data16, size * sizeof(uint16_t));
 			break;
 		}
 		case INDIGO_RAW_RGB24: {
-			max_luminance = 0xFF;
-			for (int i = 0, j = 0; i < 3 * size; i++, j++) {
-				buf[j] = (data8[i] + data8[i + 1] + data8[i + 2]) / 3;
-				sum += buf[j];
-				sum_sq += buf[j] * buf[j];
-				i += 2;
-			}
+			*max_luminance = 0xFF;
+			for (int i = 0; i < size; i++)
+				buf[i] = (data8[3 * i] + data8[3 * i + 1] + data8[3 * i + 2]) / 3;
 			break;
 		}
 		case INDIGO_RAW_RGBA32: {
-			max_luminance = 0xFF;
-			for (int i = 0, j = 0; i < 4 * size; i++, j++) {
-				buf[j] = (data8[i] + data8[i + 1] + data8[i + 2]) / 3;
-				sum += buf[j];
-				sum_sq += buf[j] * buf[j];
-				i += 3;
-			}
+			*max_luminance = 0xFF;
+			for (int i = 0; i < size; i++)
+				buf[i] = (data8[4 * i] + data8[4 * i + 1] + data8[4 * i + 2]) / 3;
 			break;
 		}
 		case INDIGO_RAW_ABGR32: {
-			max_luminance = 0xFF;
-			for (int i = 0, j = 0; i < 4 * size; i++, j++) {
-				buf[j] = (data8[i + 1] + data8[i + 2] + data8[i + 3]) / 3;
-				sum += buf[j];
-				sum_sq += buf[j] * buf[j];
-				i += 3;
-			}
+			*max_luminance = 0xFF;
+			for (int i = 0; i < size; i++)
+				buf[i] = (data8[4 * i + 1] + data8[4 * i + 2] + data8[4 * i + 3]) / 3;
 			break;
 		}
 		case INDIGO_RAW_RGB48: {
-			max_luminance = 0xFFFF;
-			for (int i = 0, j = 0; i < 3 * size; i++, j++) {
-				buf[j] = (data16[i] + data16[i + 1] + data16[i + 2]) / 3;
-				sum += buf[j];
-				sum_sq += buf[j] * buf[j];
-				i += 2;
-			}
+			*max_luminance = 0xFFFF;
+			for (int i = 0; i < size; i++)
+				buf[i] = (data16[3 * i] + data16[3 * i + 1] + data16[3 * i + 2]) / 3;
 			break;
 		}
+		default:
+			*max_luminance = 0;
+			break;
 	}
+	return buf;
+}
 
-	// Calculate mean
-	double mean = sum / size;
+indigo_result indigo_make_background_mesh(indigo_raw_type raw_type, const void *data, const int width, const int height, const int cell_size, indigo_background_mesh *mesh) {
+	if (data == NULL || mesh == NULL || width <= 0 || height <= 0 || cell_size <= 0)
+		return INDIGO_FAILED;
+	uint16_t max_luminance;
+	uint16_t *buf = luminance_buffer(raw_type, data, width, height, &max_luminance);
+	make_background_mesh(buf, width, height, cell_size, mesh);
+	indigo_safe_free(buf);
+	return max_luminance ? INDIGO_OK : INDIGO_FAILED;
+}
 
-	/* Calculate standard deviation - simplified, approximate estimate,
-	   with a nice property that it is less affected by outliers. This proeprty
-	   fixes the issue with finding guide stars in the presence of saturated stars,
-	   as it effectively filters out the outliers.
-	*/
-	double stddev = sqrt(fabs(sum_sq / size - mean * mean));
+indigo_result indigo_background_at(const indigo_background_mesh *mesh, const double x, const double y, double *background, double *noise) {
+	if (mesh == NULL || mesh->background == NULL)
+		return INDIGO_FAILED;
+	double u = (x + 0.5) * mesh->columns / mesh->width - 0.5;
+	double v = (y + 0.5) * mesh->rows / mesh->height - 0.5;
+	u = MAX(0, MIN(mesh->columns - 1, u));
+	v = MAX(0, MIN(mesh->rows - 1, v));
+	const int column_0 = (int)u, column_1 = MIN(mesh->columns - 1, column_0 + 1);
+	const int row_0 = (int)v, row_1 = MIN(mesh->rows - 1, row_0 + 1);
+	const double fu = u - column_0, fv = v - row_0;
+	const float *cells[2] = { mesh->background, mesh->noise };
+	double values[2];
+	for (int i = 0; i < 2; i++) {
+		const float *c = cells[i];
+		double top = c[row_0 * mesh->columns + column_0] + (c[row_0 * mesh->columns + column_1] - c[row_0 * mesh->columns + column_0]) * fu;
+		double bottom = c[row_1 * mesh->columns + column_0] + (c[row_1 * mesh->columns + column_1] - c[row_1 * mesh->columns + column_0]) * fu;
+		values[i] = top + (bottom - top) * fv;
+	}
+	if (background)
+		*background = values[0];
+	if (noise)
+		*noise = values[1];
+	return INDIGO_OK;
+}
 
-	/* Calculate threshold - add 4.5 stddev threshold for stars */
-	uint32_t threshold = 4.5 * stddev + mean;
-	indigo_debug("%s(): image mean = %.2f, simplified stddev = %.2f, star detection threshold = %d", __FUNCTION__, mean, stddev, threshold);
+indigo_result indigo_delete_background_mesh(indigo_background_mesh *mesh) {
+	if (mesh) {
+		indigo_safe_free(mesh->background);
+		indigo_safe_free(mesh->noise);
+		mesh->background = mesh->noise = NULL;
+		mesh->columns = mesh->rows = 0;
+	}
+	return INDIGO_OK;
+}
 
-	int threshold_hist = threshold * 0.9;
+static const double FIND_STAR_EDGE_CLIPPING = 20;
 
-	int found = 0;
-	int width2 = width / 2;
-	int height2 = height / 2;
-	uint32_t lmax = threshold + 1;
+static int luminance_comparator(const void *item_1, const void *item_2) {
+	if (((indigo_star_detection *)item_1)->luminance < ((indigo_star_detection *)item_2)->luminance)
+		return 1;
+	if (((indigo_star_detection *)item_1)->luminance > ((indigo_star_detection *)item_2)->luminance)
+		return -1;
+	return 0;
+}
 
-	indigo_star_detection star = { 0 };
-	int divider = (width > height) ? height2 : width2;
-	while (lmax > threshold) {
-		lmax = threshold;
-		star.x = 0;
-		star.y = 0;
-		star.nc_distance = 0;
-		star.luminance = 0;
-		star.oversaturated = 0;
-
-		for (int j = clip_edge; j < clip_height; j++) {
-			for (int i = clip_edge; i < clip_width; i++) {
-				int off = j * width + i;
-				if (
-				    buf[off] > lmax &&
-				    /* also check median of the neighbouring pixels to avoid hot pixels and lines */
-				    median3(buf[off - 1], buf[off], buf[off + 1]) > threshold &&
-				    median3(buf[off - width], buf[off], buf[off + width]) > threshold &&
-				    median3(buf[off - width - 1], buf[off], buf[off + width + 1]) > threshold &&
-				    median3(buf[off - width + 1], buf[off], buf[off + width - 1]) > threshold
-				) {
-					lmax = buf[off];
-					star.x = i;
-					star.y = j;
-				}
+/* Run of adjacent pixels above threshold in single row, runs of the same connected component are linked to the root run */
+
+typedef struct {
+	int start, end, y;
+	int parent;
+	int next;
+} star_run;
+
+typedef struct {
+	uint16_t peak;
+	int x, y;
+	int component;
+} star_candidate;
+
+static int find_star_run(star_run *runs, int index) {
+	while (runs[index].parent != index) {
+		runs[index].parent = runs[runs[index].parent].parent;
+		index = runs[index].parent;
+	}
+	return index;
+}
+
+static void merge_star_runs(star_run *runs, int a, int b) {
+	a = find_star_run(runs, a);
+	b = find_star_run(runs, b);
+	if (a < b)
+		runs[b].parent = a;
+	else if (b < a)
+		runs[a].parent = b;
+}
+
+/* Find the brightest pixel of the component above threshold, inside of clipped area and not being hot pixel or line, the first one in raster order wins */
+
+static bool find_component_peak(const uint16_t *buf, int width, int clip_edge, int clip_width, int clip_height, double threshold, const star_run *runs, int component, star_candidate *candidate) {
+	candidate->peak = 0;
+	for (int k = component; k >= 0; k = runs[k].next) {
+		int j = runs[k].y;
+		if (j < clip_edge || j >= clip_height)
+			continue;
+		int start = MAX(runs[k].start, clip_edge), end = MIN(runs[k].end, clip_width);
+		for (int i = start; i < end; i++) {
+			int off = j * width + i;
+			if (
+			    buf[off] > threshold && buf[off] > candidate->peak &&
+			    /* also check median of the neighbouring pixels to avoid hot pixels and lines */
+			    median3(buf[off - 1], buf[off], buf[off + 1]) > threshold &&
+			    median3(buf[off - width], buf[off], buf[off + width]) > threshold &&
+			    median3(buf[off - width - 1], buf[off], buf[off + width + 1]) > threshold &&
+			    median3(buf[off - width + 1], buf[off], buf[off + width - 1]) > threshold
+			) {
+				candidate->peak = buf[off];
+				candidate->x = i;
+				candidate->y = j;
 			}
 		}
-		if (lmax > threshold) {
-			double luminance = 0;
-			int min_i = MAX(0, star.x - star_size);
-			int max_i = MIN(width - 1, star.x + star_size);
-			int min_j = MAX(0, star.y - star_size);
-			int max_j = MIN(height - 1, star.y + star_size);
-			int star_x = (int)star.x;
-			int star_y = (int)star.y;
-			// clear +X, +Y quadrant
-			for (int j = star_y; j <= max_j; j++) {
-				if (buf[j * width + star_x] < threshold_hist) break;
-				for (int i = star_x; i <= max_i; i++) {
-					int off = j * width + i;
-					if (buf[off] > threshold_hist) {
-						luminance += buf[off] - threshold_hist;
-						buf[off] = 0;
-					} else {
-						break;
-					}
-				}
+	}
+	candidate->component = component;
+	return candidate->peak > 0;
+}
+
+static int star_candidate_comparator(const void *item_1, const void *item_2) {
+	const star_candidate *candidate_1 = item_1, *candidate_2 = item_2;
+	if (candidate_1->peak != candidate_2->peak)
+		return candidate_1->peak < candidate_2->peak ? 1 : -1;
+	if (candidate_1->y != candidate_2->y)
+		return candidate_1->y < candidate_2->y ? -1 : 1;
+	return candidate_1->x < candidate_2->x ? -1 : candidate_1->x > candidate_2->x;
+}
+
+/* Insert candidate to the sorted part of the list starting at first */
+
+static star_candidate *insert_star_candidate(star_candidate *candidates, int *count, int *capacity, int first, star_candidate *candidate) {
+	if (*count == *capacity) {
+		*capacity *= 2;
+		candidates = indigo_safe_realloc(candidates, *capacity * sizeof(star_candidate));
+	}
+	int position = first;
+	while (position < *count && star_candidate_comparator(candidates + position, candidate) < 0)
+		position++;
+	memmove(candidates + position + 1, candidates + position, (*count - position) * sizeof(star_candidate));
+	candidates[position] = *candidate;
+	(*count)++;
+	return candidates;
+}
+
+/* Clear star pixels above threshold_hist quadrant by quadrant starting at the peak and return star luminance */
+
+static double clear_star(uint16_t *buf, int width, int height, int star_x, int star_y, double threshold_hist) {
+	const int star_size = 100;
+	double luminance = 0;
+	int min_i = MAX(0, star_x - star_size);
+	int max_i = MIN(width - 1, star_x + star_size);
+	int min_j = MAX(0, star_y - star_size);
+	int max_j = MIN(height - 1, star_y + star_size);
+	// clear +X, +Y quadrant
+	for (int j = star_y; j <= max_j; j++) {
+		if (buf[j * width + star_x] < threshold_hist) break;
+		for (int i = star_x; i <= max_i; i++) {
+			int off = j * width + i;
+			if (buf[off] > threshold_hist) {
+				luminance += buf[off] - threshold_hist;
+				buf[off] = 0;
+			} else {
+				break;
 			}
-			// clear -X, +Y quadrant
-			for (int j = star_y; j <= max_j; j++) {
-				if (buf[j * width + star_x - 1] < threshold_hist) break;
-				for (int i = star_x - 1; i >= min_i; i--) {
-					int off = j * width + i;
-					if (buf[off] > threshold_hist) {
-						luminance += buf[off] - threshold_hist;
-						buf[off] = 0;
-					} else {
-						break;
-					}
-				}
+		}
+	}
+	// clear -X, +Y quadrant
+	for (int j = star_y; j <= max_j; j++) {
+		if (buf[j * width + star_x - 1] < threshold_hist) break;
+		for (int i = star_x - 1; i >= min_i; i--) {
+			int off = j * width + i;
+			if (buf[off] > threshold_hist) {
+				luminance += buf[off] - threshold_hist;
+				buf[off] = 0;
+			} else {
+				break;
 			}
-			// clear +X, -Y quadrant
-			for (int j = star_y - 1; j >= min_j; j--) {
-				if (buf[j * width + star_x] < threshold_hist) break;
-				for (int i = star_x; i <= max_i; i++) {
-					int off = j * width + i;
-					if (buf[off] > threshold_hist) {
-						luminance += buf[off] - threshold_hist;
-						buf[off] = 0;
-					} else {
-						break;
-					}
-				}
+		}
+	}
+	// clear +X, -Y quadrant
+	for (int j = star_y - 1; j >= min_j; j--) {
+		if (buf[j * width + star_x] < threshold_hist) break;
+		for (int i = star_x; i <= max_i; i++) {
+			int off = j * width + i;
+			if (buf[off] > threshold_hist) {
+				luminance += buf[off] - threshold_hist;
+				buf[off] = 0;
+			} else {
+				break;
 			}
-			// clear -X, -Y quadrant
-			for (int j = star_y - 1; j >= min_j; j--) {
-				if (buf[j * width + star_x - 1] < threshold_hist) break;
-				for (int i = star_x - 1; i >= min_i; i--) {
-					int off = j * width + i;
-					if (buf[off] > threshold_hist) {
-						luminance += buf[off] - threshold_hist;
-						buf[off] = 0;
-					} else {
-						break;
-					}
-				}
+		}
+	}
+	// clear -X, -Y quadrant
+	for (int j = star_y - 1; j >= min_j; j--) {
+		if (buf[j * width + star_x - 1] < threshold_hist) break;
+		for (int i = star_x - 1; i >= min_i; i--) {
+			int off = j * width + i;
+			if (buf[off] > threshold_hist) {
+				luminance += buf[off] - threshold_hist;
+				buf[off] = 0;
+			} else {
+				break;
 			}
+		}
+	}
+	return luminance;
+}
 
-			indigo_result res = INDIGO_FAILED;
-			if (radius >= 3) {
-				indigo_frame_digest center = {0};
-				res = indigo_selection_frame_digest_iterative(raw_type, data, &star.x, &star.y, radius, width, height, &center, 2);
-				star.x = center.centroid_x;
-				star.y = center.centroid_y;
-				star.close_to_other = false;
-				if(res == INDIGO_OK) {
-					indigo_delete_frame_digest(&center);
-				}
-			}
+/* Stars are detected above FIND_STAR_DETECTION_SIGMA and segmented above FIND_STAR_SEGMENTATION_SIGMA of the local noise over the local background */
 
-			/* Check if the star is a duplicate (probably artifact) or is in close proximity to another one.
-			   In both cses these stars should not be used */
-			if (res == INDIGO_OK || radius < 3) {
-				for (int i = 0; i < found; i++) {
-					double dx = fabs(star_list[i].x - star.x);
-					double dy = fabs(star_list[i].y - star.y);
-					if (dx < 1 && dy < 1) {
-						/* The star (probably artifact) is a duplicate of another star.
-						   We mark the other star as being close to another one, so it
-						   won't be used automatically, and we skip the duplicate. */
-						indigo_debug("indigo_find_stars(): star (%lf, %lf) skipped, duplicate of #%u = (%lf, %lf)", star.x, star.y, i + 1, star_list[i].x, star_list[i].y);
-						star_list[i].close_to_other = true;
-						res = INDIGO_FAILED;
-						break;
-					} else if (dx < radius && dy < radius) {
-						/* The star is too close to another star.
-						   We mark both star as being close to another one, so they
-						   won't be used automatically but we keep both stars in the list. */
-						indigo_debug("indigo_find_stars(): star (%lf, %lf), too close to #%u = (%lf, %lf)", star.x, star.y, i + 1, star_list[i].x, star_list[i].y);
-						star.close_to_other = true;
-						star_list[i].close_to_other = true;
-						break;
-					}
+#define FIND_STAR_DETECTION_SIGMA 4.5
+#define FIND_STAR_SEGMENTATION_SIGMA 3.0
+
+static double component_threshold(const indigo_background_mesh *mesh, const star_run *runs, int component, double sigma) {
+	double background, noise;
+	indigo_background_at(mesh, (runs[component].start + runs[component].end) / 2.0, runs[component].y, &background, &noise);
+	return background + sigma * noise;
+}
+
+/* With radius < 3, no precise star positins will be determined */
+indigo_result indigo_find_stars_precise(indigo_raw_type raw_type, const void *data, const uint16_t radius, const int width, const int height, const int stars_max, indigo_star_detection star_list[], int *stars_found) {
+	return indigo_find_stars_with_background(raw_type, data, radius, width, height, NULL, stars_max, star_list, stars_found);
+}
+
+indigo_result indigo_find_stars_with_background(indigo_raw_type raw_type, const void *data, const uint16_t radius, const int width, const int height, const indigo_background_mesh *background_mesh, const int stars_max, indigo_star_detection star_list[], int *stars_found) {
+	if (data == NULL || star_list == NULL || stars_found == NULL) return INDIGO_FAILED;
+
+	const int clip_edge = height >= FIND_STAR_EDGE_CLIPPING * 4 ? FIND_STAR_EDGE_CLIPPING : (height / 4);
+	int clip_width  = width - clip_edge;
+	int clip_height = height - clip_edge;
+	uint16_t max_luminance = 0;
+	uint16_t *buf = luminance_buffer(raw_type, data, width, height, &max_luminance);
+
+	/* Background and noise are estimated locally, so gradients, moonlight and vignetting do not shift the detection threshold
+	   and bright stars do not inflate the noise estimate */
+	indigo_background_mesh mesh = { 0 };
+	if (background_mesh == NULL || background_mesh->background == NULL || background_mesh->width != width || background_mesh->height != height) {
+		make_background_mesh(buf, width, height, INDIGO_BACKGROUND_MESH_CELL, &mesh);
+		background_mesh = &mesh;
+	}
+	double center_background, center_noise;
+	indigo_background_at(background_mesh, width / 2, height / 2, &center_background, &center_noise);
+	indigo_debug("%s(): background mesh %dx%d, background = %.2f, noise = %.2f at the center", __FUNCTION__, background_mesh->columns, background_mesh->rows, center_background, center_noise);
+
+	/* Label connected components (4-connectivity) of pixels above segmentation threshold in single pass over runs of such pixels */
+	int run_count = 0, run_capacity = 1024;
+	star_run *runs = indigo_safe_malloc(run_capacity * sizeof(star_run));
+	float *column_levels = indigo_safe_malloc(background_mesh->columns * sizeof(float));
+	int *skip_levels = indigo_safe_malloc((background_mesh->columns + 1) * sizeof(int));
+	int *segment_ends = indigo_safe_malloc((background_mesh->columns + 1) * sizeof(int));
+	mesh_row_segments(background_mesh, segment_ends);
+	int previous_first = 0, previous_last = 0;
+	for (int j = 0; j < height; j++) {
+		int current_first = run_count;
+		const uint16_t *row = buf + j * width;
+		interpolate_mesh_row(background_mesh, FIND_STAR_SEGMENTATION_SIGMA, j, column_levels, skip_levels);
+		for (int segment = 0, i = 0; segment <= background_mesh->columns; segment++) {
+			const int segment_end = segment_ends[segment], skip_level = skip_levels[segment];
+			for (; i < segment_end; i++) {
+				while (i < segment_end && row[i] <= skip_level)
+					i++;
+				if (i == segment_end)
+					break;
+				if (row[i] <= mesh_row_level(background_mesh, column_levels, i))
+					continue;
+				if (run_count == run_capacity) {
+					run_capacity *= 2;
+					runs = indigo_safe_realloc(runs, run_capacity * sizeof(star_run));
+				}
+				star_run *run = runs + run_count;
+				run->start = i;
+				while (i < width && row[i] > mesh_row_level(background_mesh, column_levels, i))
+					i++;
+				run->end = i;
+				run->y = j;
+				run->parent = run_count++;
+				/* merge with overlapping runs of the previous row, both lists are sorted */
+				for (int k = previous_first; k < previous_last && runs[k].start < run->end; k++) {
+					if (runs[k].end > run->start)
+						merge_star_runs(runs, k, run_count - 1);
 				}
+				while (previous_first < previous_last && runs[previous_first].end <= run->end)
+					previous_first++;
 			}
+		}
+		previous_first = current_first;
+		previous_last = run_count;
+	}
+	indigo_safe_free(column_levels);
+	indigo_safe_free(skip_levels);
+	indigo_safe_free(segment_ends);
+	/* link runs of each component in raster order starting at the root run */
+	for (int k = 0; k < run_count; k++)
+		runs[k].next = -1;
+	for (int k = run_count - 1; k >= 0; k--) {
+		int root = find_star_run(runs, k);
+		if (k != root) {
+			runs[k].next = runs[root].next;
+			runs[root].next = k;
+		}
+	}
+	int candidate_count = 0, candidate_capacity = 64;
+	star_candidate *candidates = indigo_safe_malloc(candidate_capacity * sizeof(star_candidate));
+	for (int k = 0; k < run_count; k++) {
+		star_candidate candidate;
+		if (runs[k].parent == k && find_component_peak(buf, width, clip_edge, clip_width, clip_height, component_threshold(background_mesh, runs, k, FIND_STAR_DETECTION_SIGMA), runs, k, &candidate)) {
+			if (candidate_count == candidate_capacity) {
+				candidate_capacity *= 2;
+				candidates = indigo_safe_realloc(candidates, candidate_capacity * sizeof(star_candidate));
+			}
+			candidates[candidate_count++] = candidate;
+		}
+	}
+	qsort(candidates, candidate_count, sizeof(star_candidate), star_candidate_comparator);
 
-			if (res == INDIGO_OK || radius < 3) {
-				star.oversaturated = lmax == max_luminance;
-				star.nc_distance = sqrt((star.x - width2) * (star.x - width2) + (star.y - height2) * (star.y - height2));
-				star.nc_distance /= divider;
-				star.luminance = (luminance > 0) ? log(fabs(luminance)) : 0;
-				star_list[found++] = star;
+	int found = 0;
+	int width2 = width / 2;
+	int height2 = height / 2;
+	int divider = (width > height) ? height2 : width2;
+	/* Candidates are processed from the brightest one as the full frame scans did. Star is cleared and the rest of its component
+	   is searched for another peak, so blended stars are still detected as duplicates or close stars. */
+	for (int k = 0; k < candidate_count && found < stars_max; k++) {
+		star_candidate candidate = candidates[k];
+		const double threshold = component_threshold(background_mesh, runs, candidate.component, FIND_STAR_DETECTION_SIGMA);
+		if (buf[candidate.y * width + candidate.x] != candidate.peak) {
+			/* peak was cleared together with another star */
+			if (find_component_peak(buf, width, clip_edge, clip_width, clip_height, threshold, runs, candidate.component, &candidate))
+				candidates = insert_star_candidate(candidates, &candidate_count, &candidate_capacity, k + 1, &candidate);
+			continue;
+		}
+		double threshold_hist = component_threshold(background_mesh, runs, candidate.component, FIND_STAR_SEGMENTATION_SIGMA);
+		double luminance = clear_star(buf, width, height, candidate.x, candidate.y, threshold_hist);
+		star_candidate residual;
+		if (find_component_peak(buf, width, clip_edge, clip_width, clip_height, threshold, runs, candidate.component, &residual))
+			candidates = insert_star_candidate(candidates, &candidate_count, &candidate_capacity, k + 1, &residual);
+
+		indigo_star_detection star = { 0 };
+		star.x = candidate.x;
+		star.y = candidate.y;
+
+		indigo_result res = INDIGO_FAILED;
+		if (radius >= 3) {
+			indigo_frame_digest center = {0};
+			res = indigo_selection_frame_digest_iterative(raw_type, data, &star.x, &star.y, radius, width, height, &center, 2);
+			star.x = center.centroid_x;
+			star.y = center.centroid_y;
+			star.close_to_other = false;
+			if(res == INDIGO_OK) {
+				indigo_delete_frame_digest(&center);
+			}
+		}
+
+		/* Check if the star is a duplicate (probably artifact) or is in close proximity to another one.
+		   In both cses these stars should not be used */
+		if (res == INDIGO_OK || radius < 3) {
+			for (int i = 0; i < found; i++) {
+				double dx = fabs(star_list[i].x - star.x);
+				double dy = fabs(star_list[i].y - star.y);
+				if (dx < 1 && dy < 1) {
+					/* The star (probably artifact) is a duplicate of another star.
+					   We mark the other star as being close to another one, so it
+					   won't be used automatically, and we skip the duplicate. */
+					indigo_debug("indigo_find_stars(): star (%lf, %lf) skipped, duplicate of #%u = (%lf, %lf)", star.x, star.y, i + 1, star_list[i].x, star_list[i].y);
+					star_list[i].close_to_other = true;
+					res = INDIGO_FAILED;
+					break;
+				} else if (dx < radius && dy < radius) {
+					/* The star is too close to another star.
+					   We mark both star as being close to another one, so they
+					   won't be used automatically but we keep both stars in the list. */
+					indigo_debug("indigo_find_stars(): star (%lf, %lf), too close to #%u = (%lf, %lf)", star.x, star.y, i + 1, star_list[i].x, star_list[i].y);
+					star.close_to_other = true;
+					star_list[i].close_to_other = true;
+					break;
+				}
 			}
 		}
-		if (found >= stars_max) {
-			break;
+
+		if (res == INDIGO_OK || radius < 3) {
+			star.oversaturated = candidate.peak == max_luminance;
+			star.nc_distance = sqrt((star.x - width2) * (star.x - width2) + (star.y - height2) * (star.y - height2));
+			star.nc_distance /= divider;
+			star.luminance = (luminance > 0) ? log(fabs(luminance)) : 0;
+			star_list[found++] = star;
 		}
 	}
+	free(candidates);
+	free(runs);
 	free(buf);
+	indigo_delete_background_mesh(&mesh);
 
 	qsort(star_list, found, sizeof(indigo_star_detection), luminance_comparator);
 
@@ -2416,6 +2716,73 @@ static int nc_distance_comparator(const void *item_1, const void *item_2) {
 	return 0;
 }
 
+/* PSF of detected stars and PSF averages of map rows are computed in parallel, each value is computed by a single thread in fixed order so the map does not depend on the number of threads */
+
+typedef struct {
+	indigo_raw_type raw_type;
+	const void *data;
+	uint16_t radius;
+	int width;
+	int height;
+	indigo_psf_param map_type;
+	indigo_star_detection *stars;
+	double *values;
+} psf_stars_data;
+
+static void psf_stars(psf_stars_data *psf_data, int start, int end) {
+	for (int i = start; i < end; i++) {
+		indigo_star_detection *star = psf_data->stars + i;
+		if (star->oversaturated || star->close_to_other)
+			continue;
+		double star_fwhm = 0, star_hfd = 0, star_peak = 0;
+		indigo_selection_psf(psf_data->raw_type, psf_data->data, star->x, star->y, psf_data->radius, psf_data->width, psf_data->height, &star_fwhm, &star_hfd, &star_peak);
+		switch (psf_data->map_type) {
+			case fwhm:
+				psf_data->values[i] = star_fwhm;
+				break;
+			case hfd:
+				psf_data->values[i] = star_hfd;
+				break;
+			case peak:
+				psf_data->values[i] = star_peak;
+				break;
+		}
+	}
+}
+
+typedef struct {
+	const indigo_star_detection *stars;
+	int first_star;
+	int last_star;
+	int map_width;
+	double max_distance;
+	double *psfs;
+} psf_map_data;
+
+static void psf_map_rows(psf_map_data *map_data, int start, int end) {
+	const indigo_star_detection *stars = map_data->stars;
+	const int map_width = map_data->map_width;
+	const double max_distance = map_data->max_distance;
+	for (int j = start; j < end; j++) {
+		double *psfs = map_data->psfs + j * map_width;
+		for (int i = 0; i < map_width; i++) {
+			double avg = 0;
+			int count = 0;
+			for (int k = map_data->first_star; k < map_data->last_star; k++) {
+				const indigo_star_detection *star = stars + k;
+				double distance_x = i - star->x + 0.5;
+				double distance_y = j - star->y + 0.5;
+				double distance = sqrt(distance_x * distance_x + distance_y * distance_y);
+				if (distance <= max_distance) {
+					avg += star->nc_distance;
+					count++;
+				}
+			}
+			psfs[i] = count > 0 ? avg / count : NAN;
+		}
+	}
+}
+
 indigo_result indigo_make_psf_map(indigo_raw_type image_raw_type, const void *image_data, const uint16_t radius, const int image_width, const int image_height, const int stars_max, indigo_raw_type map_raw_type, indigo_psf_param map_type, int map_width, int map_height, unsigned char *map_data, double *psf_min, double *psf_max) {
 	int pixel_size = 0;
 	switch (map_raw_type) {
@@ -2430,74 +2797,53 @@ indigo_result indigo_make_psf_map(indigo_raw_type image_raw_type, const void *im
 			return INDIGO_FAILED;
 	}
 	char *label = "";
+	switch (map_type) {
+		case fwhm:
+			label = "FWHM";
+			break;
+		case hfd:
+			label = "HFD";
+			break;
+		case peak:
+			label = "peak";
+			break;
+	}
 	double map_scale = (double)image_width / (double)map_width;
 	// extract PSF to nc_distance
 	indigo_star_detection *stars = indigo_safe_malloc(stars_max * sizeof(indigo_star_detection));
+	double *values = indigo_safe_malloc(stars_max * sizeof(double));
 	int total_stars = 0, used_stars = 0;
 	indigo_find_stars_precise(image_raw_type, image_data, radius, image_width, image_height, stars_max, stars, &total_stars);
+	psf_stars_data psf_data = { image_raw_type, image_data, radius, image_width, image_height, map_type, stars, values };
+	indigo_parallel_for(total_stars, (void (*)(void *, int, int))psf_stars, &psf_data);
 	for (int i = 0; i < total_stars; i++) {
 		indigo_star_detection *star = stars + i;
 		if (star->oversaturated || star->close_to_other)
 			continue;
-		double star_fwhm, star_hfd, star_peak;
-		indigo_selection_psf(image_raw_type, image_data, star->x, star->y, radius, image_width, image_height, &star_fwhm, &star_hfd, &star_peak);
 		star->x /= map_scale; // scale to map coordimates
 		star->y /= map_scale;
-		switch (map_type) {
-			case fwhm:
-				star->nc_distance = star_fwhm;
-				label = "FWHM";
-				break;
-			case hfd:
-				star->nc_distance = star_hfd;
-				label = "HFD";
-				break;
-			case peak:
-				star->nc_distance = star_peak;
-				label = "peak";
-				break;
-		}
+		star->nc_distance = values[i];
 		if (i > used_stars)
 			memcpy(stars + used_stars, star, sizeof(indigo_star_detection));
 		used_stars++;
-		//INDIGO_DEBUG(indigo_debug("%g %g %g %g", star->x, star->y, fwhm, hfd, peak));
 	}
+	indigo_safe_free(values);
 	// clip top and bottom 10%
 	qsort(stars, used_stars, sizeof(indigo_star_detection), nc_distance_comparator);
 	int first_star = used_stars / 10;
 	int last_star = used_stars - first_star;
 	// compute PSF averages
 	double *psfs = indigo_safe_malloc(map_width * map_height * sizeof(double));
-	double max_distance = map_width / 4;
+	psf_map_data psf_map = { stars, first_star, last_star, map_width, map_width / 4, psfs };
+	indigo_parallel_for(map_height, (void (*)(void *, int, int))psf_map_rows, &psf_map);
 	double max_psf = 0, min_psf = 100000;
-	for (int j = 0; j < map_height; j++) {
-		int jj = j * map_width;
-		for (int i = 0; i < map_width; i++) {
-			double avg = 0;
-			int count = 0;
-			for (int k = first_star; k <= last_star; k++) {
-				indigo_star_detection *star = stars + k;
-				double distance_x = i - star->x + 0.5;
-				double distance_y = j - star->y + 0.5;
-				double distance = sqrt(distance_x * distance_x + distance_y * distance_y);
-				if (distance <= max_distance) {
-					avg += star->nc_distance;
-					count++;
-				}
-			}
-			int ii = jj +  i;
-			if (count > 0) {
-				avg = avg / count;
-				if (avg < min_psf)
-					min_psf = avg;
-				if (avg > max_psf)
-					max_psf = avg;
-				psfs[ii] = avg;
-			} else {
-				psfs[ii] = 0;
-			}
-			if (map_raw_type == INDIGO_RAW_RGBA32)
-				map_data[ii + 3] = 255;
+	for (int i = 0; i < map_width * map_height; i++) {
+		double avg = psfs[i];
+		if (!isnan(avg)) {
+			if (avg < min_psf)
+				min_psf = avg;
+			if (avg > max_psf)
+				max_psf = avg;
 		}
 	}
 	if (psf_min)
@@ -2527,7 +2873,7 @@ indigo_result indigo_make_psf_map(indigo_raw_type image_raw_type, const void *im
 		}
 	}
 // draw stars over PSF map
-//	for (int k = first_star; k <= last_star; k++) {
+//	for (int k = first_star; k < last_star; k++) {
 //		indigo_star_detection *star = stars + k;
 //		int i = round(star->x + 0.5);
 //		int j = round(star->y + 0.5);
@@ -34,6 +34,7 @@
 #include <signal.h>
 #include <stdarg.h>
 #include <fcntl.h>
+#include <time.h>
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -43,6 +44,9 @@
 
 #ifdef INDIGO_LINUX
 #include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <poll.h>
 #endif
 
 #if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
@@ -54,6 +58,8 @@
 #include <indigo/indigo_server_tcp.h>
 #include <indigo/indigo_driver_xml.h>
 #include <indigo/indigo_driver_json.h>
+#include <indigo/indigo_json.h>
+#include <indigo/indigo_driver_binary.h>
 #include <indigo/indigo_client_xml.h>
 #include <indigo/indigo_base64.h>
 #include <indigo/indigo_io.h>
@@ -80,6 +86,8 @@ bool indigo_use_bonjour = true;
 bool indigo_is_ephemeral_port = false;
 bool indigo_use_blob_buffering = true;
 bool indigo_use_blob_compression = false;
+int indigo_server_tcp_threads = 4;
+int indigo_server_tcp_workers = 32;
 
 static pthread_mutex_t resource_list_mutex = PTHREAD_MUTEX_INITIALIZER;
 
@@ -94,323 +102,1031 @@ static struct resource {
 } *resources = NULL;
 
 #define BUFFER_SIZE	1024
+#define LINGER_TIMEOUT	1
+#define REQUEST_TIMEOUT	5
+#define REQUEST_SIZE	(8 * BUFFER_SIZE)
 
-static void start_worker_thread(int *client_socket) {
-	int socket = *client_socket;
-	INDIGO_TRACE(indigo_trace("%d <- // Worker thread started", socket));
-	server_callback(++client_count);
-	int res = 0;
-	char c;
+typedef enum {
+	HTTP_KEEP_ALIVE,
+	HTTP_CLOSE,
+	HTTP_WEB_SOCKET
+} http_result;
+
+typedef struct {
+	char websocket_key[256];
+	bool use_gzip;
+	bool use_imagebytes;
+	bool keep_alive;
+} http_headers;
+
+typedef struct connection {
+	int socket;
+	bool http;							///< connection already served HTTP request
+	bool web_socket;				///< connection was upgraded to web socket
+	bool lingering;					///< write side was shut down, waiting for client to close
+	time_t deadline;				///< end of lingering or of waiting for complete request
+	char *request;					///< request collected by network thread
+	int request_length;
+	http_headers headers;
+	indigo_client *protocol_adapter;	///< adapter of JSON session served by network and request threads
+	indigo_json_parser *parser;
+	uint8_t frame[14];							///< header of web socket frame being collected
+	int frame_length;
+	char *message;									///< web socket frame payload or chunk of JSON session collected by network thread
+	long message_length;
+	long message_received;
+	struct connection *prev;
+	struct connection *next;
+} connection;
+
+static pthread_mutex_t client_count_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void update_client_count(int delta) {
+	pthread_mutex_lock(&client_count_mutex);
+	client_count += delta;
+	server_callback(client_count);
+	pthread_mutex_unlock(&client_count_mutex);
+}
+
+static void set_receive_timeout(int socket, int seconds) {
+	struct timeval timeout;
+	timeout.tv_sec = seconds;
+	timeout.tv_usec = 0;
+	if (setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout, sizeof(timeout)) < 0)
+		indigo_error("Can't set recv() timeout (%s)", strerror(errno));
+}
+
+/* close write side first and wait (limited time) for client to close the connection, so the response is not lost by RST on unread data */
+
+static void lingering_close(int socket) {
+	char buffer[BUFFER_SIZE];
+	time_t deadline = time(NULL) + LINGER_TIMEOUT;
+	shutdown(socket, SHUT_WR);
+	set_receive_timeout(socket, LINGER_TIMEOUT);
+	while (recv(socket, buffer, sizeof(buffer), 0) > 0 && time(NULL) <= deadline)
+		;
+	close(socket);
+}
+
+static void parse_http_header(http_headers *headers, const char *header) {
+	if (!strncasecmp(header, "Sec-WebSocket-Key: ", 19))
+		strncpy(headers->websocket_key, header + 19, sizeof(headers->websocket_key));
+	if (!strcasecmp(header, "Connection: close"))
+		headers->keep_alive = false;
+	if (!strncasecmp(header, "Accept-Encoding:", 16)) {
+		if (strstr(header + 16, "gzip"))
+			headers->use_gzip = true;
+	}
+	if (!strncasecmp(header, "Accept:", 7)) {
+		if (strstr(header + 7, "application/imagebytes"))
+			headers->use_imagebytes = true;
+	}
+}
+
+static void read_http_headers(int socket, http_headers *headers) {
+	char header[BUFFER_SIZE];
+	while (indigo_read_line(socket, header, BUFFER_SIZE) > 0)
+		parse_http_header(headers, header);
+}
+
+/* GET request headers are parsed by caller, PUT request headers are left in the socket for the handler */
+
+static http_result process_http_request(int socket, char *request, http_headers *headers) {
 	void *free_on_exit = NULL;
 	pthread_mutex_t *unlock_at_exit = NULL;
-
-	if (recv(socket, &c, 1, MSG_PEEK) == 1) {
-		if (c == '<') {
-			INDIGO_TRACE(indigo_trace("%d <- // Protocol switched to XML", socket));
-			indigo_client *protocol_adapter = indigo_xml_device_adapter(socket, socket);
-			assert(protocol_adapter != NULL);
-			indigo_attach_client(protocol_adapter);
-			indigo_xml_parse(NULL, protocol_adapter);
-			indigo_detach_client(protocol_adapter);
-			indigo_release_xml_device_adapter(protocol_adapter);
-		} else if (c == '{') {
-			INDIGO_TRACE(indigo_trace("%d <- // Protocol switched to JSON", socket));
-			indigo_client *protocol_adapter = indigo_json_device_adapter(socket, socket, false);
-			assert(protocol_adapter != NULL);
-			indigo_attach_client(protocol_adapter);
-			indigo_json_parse(NULL, protocol_adapter);
-			indigo_detach_client(protocol_adapter);
-			indigo_release_json_device_adapter(protocol_adapter);
-		} else if (c == 'G' || c == 'P') {
-			char request[BUFFER_SIZE];
-			char header[BUFFER_SIZE];
-			while ((res = indigo_read_line(socket, request, BUFFER_SIZE)) >= 0) {
-				bool keep_alive = true;
-				if (!strncmp(request, "GET /", 5)) {
-					char *path = request + 4;
-					char *space = strchr(path, ' ');
-					if (space)
-						*space = 0;
-					char *params = strchr(path, '?');
-					if (params)
-						*params++ = 0;
-					char websocket_key[256] = "";
-					bool use_gzip = false;
-					bool use_imagebytes = false;
-					while (indigo_read_line(socket, header, BUFFER_SIZE) > 0) {
-						if (!strncasecmp(header, "Sec-WebSocket-Key: ", 19))
-							strncpy(websocket_key, header + 19, sizeof(websocket_key));
-						if (!strcasecmp(header, "Connection: close"))
-							keep_alive = false;
-						if (!strncasecmp(header, "Accept-Encoding:", 16)) {
-							if (strstr(header + 16, "gzip"))
-								use_gzip = true;
-						}
-						if (!strncasecmp(header, "Accept:", 7)) {
-							if (strstr(header + 7, "application/imagebytes"))
-								use_imagebytes = true;
-						}
+	indigo_blob_buffer *release_at_exit = NULL;
+	bool keep_alive = true;
+	if (!strncmp(request, "GET /", 5)) {
+		char *path = request + 4;
+		char *space = strchr(path, ' ');
+		if (space)
+			*space = 0;
+		char *params = strchr(path, '?');
+		if (params)
+			*params++ = 0;
+		char *websocket_key = headers->websocket_key;
+		bool use_gzip = headers->use_gzip;
+		bool use_imagebytes = headers->use_imagebytes;
+		keep_alive = headers->keep_alive;
+		if (!strcmp(path, "/")) {
+			if (*websocket_key) {
+				unsigned char shaHash[SHA1_SIZE];
+				memset(shaHash, 0, sizeof(shaHash));
+				strcat(websocket_key, "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+				sha1(shaHash, websocket_key, strlen(websocket_key));
+				INDIGO_PRINTF(socket, "HTTP/1.1 101 Switching Protocols\r\n");
+				INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
+				INDIGO_PRINTF(socket, "Upgrade: websocket\r\n");
+				INDIGO_PRINTF(socket, "Connection: upgrade\r\n");
+				base64_encode((unsigned char *)websocket_key, shaHash, 20);
+				INDIGO_PRINTF(socket, "Sec-WebSocket-Accept: %s\r\n", websocket_key);
+				INDIGO_PRINTF(socket, "\r\n");
+				return HTTP_WEB_SOCKET;
+			} else {
+				INDIGO_PRINTF(socket, "HTTP/1.1 301 OK\r\n");
+				INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
+				INDIGO_PRINTF(socket, "Location: /mng.html\r\n");
+				INDIGO_PRINTF(socket, "Content-type: text/html\r\n");
+				INDIGO_PRINTF(socket, "\r\n");
+				INDIGO_PRINTF(socket, "<a href='/mng.html'>INDIGO Server Manager</a>");
+			}
+			keep_alive = false;
+		} else if (!strncmp(path, "/blob/", 6)) {
+			indigo_item *item;
+			indigo_blob_entry *entry;
+			if (sscanf(path, "/blob/%p.", &item) && (entry = indigo_validate_blob(item))) {
+				pthread_mutex_lock(unlock_at_exit = &entry->mutext);
+				if (entry->buffer == NULL) {
+					indigo_item item_copy = *item;
+					item_copy.blob.size = 0;
+					item_copy.blob.value = NULL;
+					item_copy.blob.buffer = NULL;
+					if (indigo_populate_http_blob_item(&item_copy)) {
+						entry->buffer = indigo_wrap_blob_buffer(item_copy.blob.value, item_copy.blob.size);
+						entry->content = entry->buffer->data;
+						entry->size = entry->buffer->size;
+					} else {
+						indigo_safe_free(item_copy.blob.value);
+						indigo_error("%d <- // Failed to populate BLOB", socket);
 					}
-					if (!strcmp(path, "/")) {
-						if (*websocket_key) {
-							unsigned char shaHash[SHA1_SIZE];
-							memset(shaHash, 0, sizeof(shaHash));
-							strcat(websocket_key, "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
-							sha1(shaHash, websocket_key, strlen(websocket_key));
-							INDIGO_PRINTF(socket, "HTTP/1.1 101 Switching Protocols\r\n");
-							INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
-							INDIGO_PRINTF(socket, "Upgrade: websocket\r\n");
-							INDIGO_PRINTF(socket, "Connection: upgrade\r\n");
-							base64_encode((unsigned char *)websocket_key, shaHash, 20);
-							INDIGO_PRINTF(socket, "Sec-WebSocket-Accept: %s\r\n", websocket_key);
-							INDIGO_PRINTF(socket, "\r\n");
-							INDIGO_TRACE(indigo_trace("%d <- // Protocol switched to JSON-over-WebSockets", socket));
-							indigo_client *protocol_adapter = indigo_json_device_adapter(socket, socket, true);
-							assert(protocol_adapter != NULL);
-							indigo_attach_client(protocol_adapter);
-							indigo_json_parse(NULL, protocol_adapter);
-							indigo_detach_client(protocol_adapter);
-							indigo_release_json_device_adapter(protocol_adapter);
-						} else {
-							INDIGO_PRINTF(socket, "HTTP/1.1 301 OK\r\n");
-							INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
-							INDIGO_PRINTF(socket, "Location: /mng.html\r\n");
-							INDIGO_PRINTF(socket, "Content-type: text/html\r\n");
-							INDIGO_PRINTF(socket, "\r\n");
-							INDIGO_PRINTF(socket, "<a href='/mng.html'>INDIGO Server Manager</a>");
-						}
-						keep_alive = false;
-					} else if (!strncmp(path, "/blob/", 6)) {
-						indigo_item *item;
-						indigo_blob_entry *entry;
-						if (sscanf(path, "/blob/%p.", &item) && (entry = indigo_validate_blob(item))) {
-							pthread_mutex_lock(unlock_at_exit = &entry->mutext);
-							long working_size = entry->size;
-							if (working_size == 0) {
-								assert(entry->content == NULL);
-								indigo_item item_copy = *item;
-								item_copy.blob.size = 0;
-								item_copy.blob.value = NULL;
-								if (indigo_populate_http_blob_item(&item_copy)) {
-									working_size = entry->size = item_copy.blob.size;
-									entry->content = item_copy.blob.value;
-								} else {
-									indigo_error("%d <- // Failed to populate BLOB", socket);
-								}
-							}
-							void *working_copy = indigo_use_blob_buffering ? (free_on_exit = malloc(working_size)) : entry->content;
-							if (working_copy) {
-								char working_format[INDIGO_NAME_SIZE];
-								strcpy(working_format, entry->format);
-								INDIGO_PRINTF(socket, "HTTP/1.1 200 OK\r\n");
-								if (indigo_use_blob_buffering) {
-									if (use_gzip && indigo_use_blob_compression && strcmp(entry->format, ".jpeg")) {
-										unsigned compressed_size = (unsigned)working_size;
-										indigo_compress("image", entry->content, (unsigned)working_size, working_copy, &compressed_size);
-										INDIGO_PRINTF(socket, "Content-Encoding: gzip\r\n");
-										INDIGO_PRINTF(socket, "X-Uncompressed-Content-Length: %ld\r\n", working_size);
-										working_size = compressed_size;
-									} else {
-										memcpy(working_copy, entry->content, working_size);
-									}
-									pthread_mutex_unlock(&entry->mutext);
-									unlock_at_exit = NULL;
-								}
-								INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
-								if (!strcmp(entry->format, ".jpeg")) {
-									INDIGO_PRINTF(socket, "Content-Type: image/jpeg\r\n");
-								} else {
-									INDIGO_PRINTF(socket, "Content-Type: application/octet-stream\r\n");
-									INDIGO_PRINTF(socket, "Content-Disposition: attachment; filename=\"%p%s\"\r\n", item, working_format);
-								}
-								if (keep_alive)
-									INDIGO_PRINTF(socket, "Connection: keep-alive\r\n");
-								INDIGO_PRINTF(socket, "Content-Length: %ld\r\n", working_size);
-								INDIGO_PRINTF(socket, "\r\n");
-								if (indigo_write(socket, working_copy, working_size)) {
-									INDIGO_TRACE(indigo_trace("%d <- // %ld bytes", socket, working_size));
-								} else {
-									indigo_error("%d <- // %s", socket, strerror(errno));
-									goto failure;
-								}
-								if (indigo_use_blob_buffering) {
-									free(working_copy);
-									free_on_exit = NULL;
-								} else {
-									pthread_mutex_unlock(&entry->mutext);
-									unlock_at_exit = NULL;
-								}
-							} else {
-								pthread_mutex_unlock(&entry->mutext);
-								unlock_at_exit = NULL;
-								INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
-								INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
-								INDIGO_PRINTF(socket, "\r\n");
-								INDIGO_PRINTF(socket, "Out of buffer memory!\r\n");
-								INDIGO_TRACE(indigo_trace("%d <- // Out of buffer memory", socket));
-								goto failure;
-							}
-						} else {
-							INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
-							INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
-							INDIGO_PRINTF(socket, "\r\n");
-							INDIGO_PRINTF(socket, "BLOB not found!\r\n");
-							INDIGO_TRACE(indigo_trace("%d <- // BLOB not found", socket));
-							goto failure;
-						}
+				}
+				/* buffer is immutable, it is enough to hold the reference while sending it */
+				indigo_blob_buffer *buffer = release_at_exit = indigo_retain_blob_buffer(entry->buffer);
+				char working_format[INDIGO_NAME_SIZE];
+				strcpy(working_format, entry->format);
+				pthread_mutex_unlock(&entry->mutext);
+				unlock_at_exit = NULL;
+				void *working_copy = NULL;
+				long working_size = 0;
+				bool compress = false;
+				if (buffer) {
+					working_size = buffer->size;
+					compress = indigo_use_blob_buffering && use_gzip && indigo_use_blob_compression && strcmp(working_format, ".jpeg");
+					working_copy = compress ? (free_on_exit = malloc(working_size)) : buffer->data;
+				}
+				if (working_copy) {
+					INDIGO_PRINTF(socket, "HTTP/1.1 200 OK\r\n");
+					if (compress) {
+						unsigned compressed_size = (unsigned)working_size;
+						indigo_compress("image", buffer->data, (unsigned)working_size, working_copy, &compressed_size);
+						INDIGO_PRINTF(socket, "Content-Encoding: gzip\r\n");
+						INDIGO_PRINTF(socket, "X-Uncompressed-Content-Length: %ld\r\n", working_size);
+						working_size = compressed_size;
+					}
+					INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
+					if (!strcmp(working_format, ".jpeg")) {
+						INDIGO_PRINTF(socket, "Content-Type: image/jpeg\r\n");
 					} else {
-						pthread_mutex_lock(&resource_list_mutex);
-						struct resource *resource = resources;
-						while (resource) {
-							if (!strncmp(resource->path, path, strlen(resource->path)))
-								break;
-							resource = resource->next;
-						}
-						pthread_mutex_unlock(&resource_list_mutex);
-						if (resource == NULL) {
-							INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
-							INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
-							INDIGO_PRINTF(socket, "\r\n");
-							INDIGO_PRINTF(socket, "%s not found!\r\n", path);
-							INDIGO_TRACE(indigo_trace("%d <- // %s not found", socket, path));
-							goto failure;
-						} else if (resource->handler) {
-							keep_alive = resource->handler(socket, use_imagebytes ? "GET/IMAGEBYTES" : (use_gzip ? "GET/GZIP" : "GET"), path, params);
-						} else if (resource->data) {
-							INDIGO_PRINTF(socket, "HTTP/1.1 200 OK\r\n");
-							INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
-							INDIGO_PRINTF(socket, "Content-Type: %s\r\n", resource->content_type);
-							INDIGO_PRINTF(socket, "Content-Length: %d\r\n", resource->length);
-							INDIGO_PRINTF(socket, "Content-Encoding: gzip\r\n");
-							INDIGO_PRINTF(socket, "\r\n");
-							indigo_write(socket, (const char *)resource->data, resource->length);
-							INDIGO_TRACE(indigo_trace("%d <- // %d bytes", socket, resource->length));
-						} else if (resource->file_name) {
-							char file_name[256];
-							struct stat file_stat;
-							int handle;
-							sprintf(file_name, "%s/%s", getenv("HOME"), resource->file_name);
-							if (stat(file_name, &file_stat) < 0 || (handle = open(file_name, O_RDONLY)) < 0) {
-								INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
-								INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
-								INDIGO_PRINTF(socket, "\r\n");
-								INDIGO_PRINTF(socket, "%s not found (%s)\r\n", file_name, strerror(errno));
-								INDIGO_TRACE(indigo_trace("%d <- // Failed to stat/open file (%s, %s)", socket, file_name, strerror(errno)));
-								goto failure;
-							} else {
-								INDIGO_PRINTF(socket, "HTTP/1.1 200 OK\r\n");
-								INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
-								INDIGO_PRINTF(socket, "Content-Type: %s\r\n", resource->content_type);
-								INDIGO_PRINTF(socket, "Content-Length: %d\r\n", file_stat.st_size);
-								INDIGO_PRINTF(socket, "\r\n");
-								long remaining = file_stat.st_size;
-								char buffer[128 * 1024];
-								while (remaining > 0) {
-									long count = read(handle, buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
-									if (count < 0) {
-										INDIGO_TRACE(indigo_trace("%d -> // %s", socket, strerror(errno)));
-										break;
-									}
-									if (indigo_write(socket, buffer, count)) {
-										INDIGO_TRACE(indigo_trace("%d <- // %ld bytes", socket, count));
-									} else {
-										INDIGO_TRACE(indigo_trace("%d <- // %s", socket, strerror(errno)));
-										goto failure;
-									}
-									remaining -= count;
-								}
-								close(handle);
-							}
-						}
+						INDIGO_PRINTF(socket, "Content-Type: application/octet-stream\r\n");
+						INDIGO_PRINTF(socket, "Content-Disposition: attachment; filename=\"%p%s\"\r\n", item, working_format);
 					}
-				} else if (!strncmp(request, "PUT /", 5)) {
-					char *path = request + 4;
-					char *space = strchr(path, ' ');
-					if (space)
-						*space = 0;
-					if (!strncmp(path, "/blob/", 6)) {
-						indigo_item *item;
-						indigo_blob_entry *entry;
-						if (sscanf(path, "/blob/%p.", &item) && (entry = indigo_validate_blob(item))) {
-							int content_length = 0;
-							char header[BUFFER_SIZE];
-							while (indigo_read_line(socket, header, INDIGO_BUFFER_SIZE) > 0) {
-								if (!strncasecmp(header, "Content-Length:", 15)) {
-									content_length = atoi(header + 15);
-								}
-							}
-							pthread_mutex_lock(unlock_at_exit = &entry->mutext);
-							entry->content = indigo_safe_realloc(entry->content, entry->size = content_length);
-							if (entry->content) {
-								if (!indigo_read(socket, entry->content, content_length))
-									goto failure;
-								pthread_mutex_unlock(&entry->mutext);
-								unlock_at_exit = NULL;
-								INDIGO_PRINTF(socket, "HTTP/1.1 200 OK\r\n");
-								INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
-								INDIGO_PRINTF(socket, "Content-Length: 0\r\n");
-								INDIGO_PRINTF(socket, "\r\n");
-							} else {
-								INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
-								INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
-								INDIGO_PRINTF(socket, "\r\n");
-								INDIGO_PRINTF(socket, "Out of buffer memory!\r\n");
-								INDIGO_TRACE(indigo_trace("%d <- // Out of buffer memory", socket));
-								goto failure;
-							}
-						} else {
-							INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
-							INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
-							INDIGO_PRINTF(socket, "\r\n");
-							INDIGO_PRINTF(socket, "BLOB not found!\r\n");
-							INDIGO_TRACE(indigo_trace("%d <- // BLOB not found", socket));
-							goto failure;
-						}
+					if (keep_alive)
+						INDIGO_PRINTF(socket, "Connection: keep-alive\r\n");
+					INDIGO_PRINTF(socket, "Content-Length: %ld\r\n", working_size);
+					INDIGO_PRINTF(socket, "\r\n");
+					if (indigo_write(socket, working_copy, working_size)) {
+						INDIGO_TRACE(indigo_trace("%d <- // %ld bytes", socket, working_size));
 					} else {
-						pthread_mutex_lock(&resource_list_mutex);
-						struct resource *resource = resources;
-						while (resource) {
-							if (!strncmp(resource->path, path, strlen(resource->path)))
-								break;
-							resource = resource->next;
+						indigo_error("%d <- // %s", socket, strerror(errno));
+						goto failure;
+					}
+					if (compress) {
+						free(working_copy);
+						free_on_exit = NULL;
+					}
+					indigo_release_blob_buffer(buffer);
+					release_at_exit = NULL;
+				} else {
+					indigo_release_blob_buffer(buffer);
+					release_at_exit = NULL;
+					INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
+					INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
+					INDIGO_PRINTF(socket, "\r\n");
+					INDIGO_PRINTF(socket, "Out of buffer memory!\r\n");
+					INDIGO_TRACE(indigo_trace("%d <- // Out of buffer memory", socket));
+					goto failure;
+				}
+			} else {
+				INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
+				INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
+				INDIGO_PRINTF(socket, "\r\n");
+				INDIGO_PRINTF(socket, "BLOB not found!\r\n");
+				INDIGO_TRACE(indigo_trace("%d <- // BLOB not found", socket));
+				goto failure;
+			}
+		} else {
+			pthread_mutex_lock(&resource_list_mutex);
+			struct resource *resource = resources;
+			while (resource) {
+				if (!strncmp(resource->path, path, strlen(resource->path)))
+					break;
+				resource = resource->next;
+			}
+			pthread_mutex_unlock(&resource_list_mutex);
+			if (resource == NULL) {
+				INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
+				INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
+				INDIGO_PRINTF(socket, "\r\n");
+				INDIGO_PRINTF(socket, "%s not found!\r\n", path);
+				INDIGO_TRACE(indigo_trace("%d <- // %s not found", socket, path));
+				goto failure;
+			} else if (resource->handler) {
+				keep_alive = resource->handler(socket, use_imagebytes ? "GET/IMAGEBYTES" : (use_gzip ? "GET/GZIP" : "GET"), path, params);
+			} else if (resource->data) {
+				INDIGO_PRINTF(socket, "HTTP/1.1 200 OK\r\n");
+				INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
+				INDIGO_PRINTF(socket, "Content-Type: %s\r\n", resource->content_type);
+				INDIGO_PRINTF(socket, "Content-Length: %d\r\n", resource->length);
+				INDIGO_PRINTF(socket, "Content-Encoding: gzip\r\n");
+				INDIGO_PRINTF(socket, "\r\n");
+				indigo_write(socket, (const char *)resource->data, resource->length);
+				INDIGO_TRACE(indigo_trace("%d <- // %d bytes", socket, resource->length));
+			} else if (resource->file_name) {
+				char file_name[256];
+				struct stat file_stat;
+				int handle;
+				sprintf(file_name, "%s/%s", getenv("HOME"), resource->file_name);
+				if (stat(file_name, &file_stat) < 0 || (handle = open(file_name, O_RDONLY)) < 0) {
+					INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
+					INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
+					INDIGO_PRINTF(socket, "\r\n");
+					INDIGO_PRINTF(socket, "%s not found (%s)\r\n", file_name, strerror(errno));
+					INDIGO_TRACE(indigo_trace("%d <- // Failed to stat/open file (%s, %s)", socket, file_name, strerror(errno)));
+					goto failure;
+				} else {
+					INDIGO_PRINTF(socket, "HTTP/1.1 200 OK\r\n");
+					INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
+					INDIGO_PRINTF(socket, "Content-Type: %s\r\n", resource->content_type);
+					INDIGO_PRINTF(socket, "Content-Length: %d\r\n", file_stat.st_size);
+					INDIGO_PRINTF(socket, "\r\n");
+					long remaining = file_stat.st_size;
+					char buffer[128 * 1024];
+					while (remaining > 0) {
+						long count = read(handle, buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+						if (count < 0) {
+							INDIGO_TRACE(indigo_trace("%d -> // %s", socket, strerror(errno)));
+							break;
 						}
-						pthread_mutex_unlock(&resource_list_mutex);
-						if (resource == NULL) {
-							INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
-							INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
-							INDIGO_PRINTF(socket, "\r\n");
-							INDIGO_PRINTF(socket, "%s not found!\r\n", path);
-							INDIGO_TRACE(indigo_trace("%d <- // %s not found", socket, path));
+						if (indigo_write(socket, buffer, count)) {
+							INDIGO_TRACE(indigo_trace("%d <- // %ld bytes", socket, count));
+						} else {
+							INDIGO_TRACE(indigo_trace("%d <- // %s", socket, strerror(errno)));
 							goto failure;
-						} else if (resource->handler) {
-							keep_alive = resource->handler(socket, "PUT", path, NULL);
 						}
+						remaining -= count;
 					}
+					close(handle);
 				}
-				if (!keep_alive) {
-					break;
+			}
+		}
+	} else if (!strncmp(request, "PUT /", 5)) {
+		char *path = request + 4;
+		char *space = strchr(path, ' ');
+		if (space)
+			*space = 0;
+		if (!strncmp(path, "/blob/", 6)) {
+			indigo_item *item;
+			indigo_blob_entry *entry;
+			if (sscanf(path, "/blob/%p.", &item) && (entry = indigo_validate_blob(item))) {
+				int content_length = 0;
+				char header[BUFFER_SIZE];
+				while (indigo_read_line(socket, header, INDIGO_BUFFER_SIZE) > 0) {
+					if (!strncasecmp(header, "Content-Length:", 15)) {
+						content_length = atoi(header + 15);
+					}
+				}
+				indigo_blob_buffer *buffer = release_at_exit = indigo_create_blob_buffer(content_length);
+				if (buffer) {
+					if (!indigo_read(socket, buffer->data, content_length))
+						goto failure;
+					pthread_mutex_lock(&entry->mutext);
+					indigo_blob_buffer *previous = entry->buffer;
+					entry->buffer = buffer;
+					entry->content = buffer->data;
+					entry->size = buffer->size;
+					pthread_mutex_unlock(&entry->mutext);
+					indigo_release_blob_buffer(previous);
+					release_at_exit = NULL;
+					INDIGO_PRINTF(socket, "HTTP/1.1 200 OK\r\n");
+					INDIGO_PRINTF(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
+					INDIGO_PRINTF(socket, "Content-Length: 0\r\n");
+					INDIGO_PRINTF(socket, "\r\n");
+				} else {
+					INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
+					INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
+					INDIGO_PRINTF(socket, "\r\n");
+					INDIGO_PRINTF(socket, "Out of buffer memory!\r\n");
+					INDIGO_TRACE(indigo_trace("%d <- // Out of buffer memory", socket));
+					goto failure;
 				}
+			} else {
+				INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
+				INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
+				INDIGO_PRINTF(socket, "\r\n");
+				INDIGO_PRINTF(socket, "BLOB not found!\r\n");
+				INDIGO_TRACE(indigo_trace("%d <- // BLOB not found", socket));
+				goto failure;
 			}
 		} else {
-			INDIGO_TRACE(indigo_trace("%d -> // Unrecognised protocol", socket));
+			pthread_mutex_lock(&resource_list_mutex);
+			struct resource *resource = resources;
+			while (resource) {
+				if (!strncmp(resource->path, path, strlen(resource->path)))
+					break;
+				resource = resource->next;
+			}
+			pthread_mutex_unlock(&resource_list_mutex);
+			if (resource == NULL) {
+				INDIGO_PRINTF(socket, "HTTP/1.1 404 Not found\r\n");
+				INDIGO_PRINTF(socket, "Content-Type: text/plain\r\n");
+				INDIGO_PRINTF(socket, "\r\n");
+				INDIGO_PRINTF(socket, "%s not found!\r\n", path);
+				INDIGO_TRACE(indigo_trace("%d <- // %s not found", socket, path));
+				goto failure;
+			} else if (resource->handler) {
+				keep_alive = resource->handler(socket, "PUT", path, NULL);
+			}
 		}
 	}
+	return keep_alive ? HTTP_KEEP_ALIVE : HTTP_CLOSE;
 failure:
-	shutdown(socket, SHUT_RDWR);
-	indigo_usleep(ONE_SECOND_DELAY); // ???
-	close(socket);
-	server_callback(--client_count);
-	free(client_socket);
 	if (free_on_exit)
 		free(free_on_exit);
 	if (unlock_at_exit)
 		pthread_mutex_unlock(unlock_at_exit);
+	indigo_release_blob_buffer(release_at_exit);
+	return HTTP_CLOSE;
+}
+
+static void xml_session(int socket) {
+	INDIGO_TRACE(indigo_trace("%d <- // Protocol switched to XML", socket));
+	indigo_client *protocol_adapter = indigo_xml_device_adapter(socket, socket);
+	assert(protocol_adapter != NULL);
+	indigo_attach_client(protocol_adapter);
+	indigo_xml_parse(NULL, protocol_adapter);
+	indigo_detach_client(protocol_adapter);
+	indigo_release_xml_device_adapter(protocol_adapter);
+}
+
+static void json_session(int socket, bool web_socket) {
+	INDIGO_TRACE(indigo_trace(web_socket ? "%d <- // Protocol switched to JSON-over-WebSockets" : "%d <- // Protocol switched to JSON", socket));
+	indigo_client *protocol_adapter = indigo_json_device_adapter(socket, socket, web_socket);
+	assert(protocol_adapter != NULL);
+	indigo_attach_client(protocol_adapter);
+	indigo_json_parse(NULL, protocol_adapter);
+	indigo_detach_client(protocol_adapter);
+	indigo_release_json_device_adapter(protocol_adapter);
+}
+
+static void binary_session(int socket) {
+	INDIGO_TRACE(indigo_trace("%d <- // Protocol switched to binary", socket));
+	indigo_client *protocol_adapter = indigo_binary_device_adapter(socket, socket);
+	assert(protocol_adapter != NULL);
+	indigo_attach_client(protocol_adapter);
+	indigo_binary_parse(NULL, protocol_adapter);
+	indigo_detach_client(protocol_adapter);
+	indigo_release_binary_device_adapter(protocol_adapter);
+}
+
+/* XML and binary parsers are blocking, so these sessions are served by dedicated thread, JSON sessions and HTTP requests are served by the same thread
+ in thread-per-connection mode only */
+
+static void start_worker_thread(connection *connection) {
+	int socket = connection->socket;
+	INDIGO_TRACE(indigo_trace("%d <- // Worker thread started", socket));
+	bool session = true;
+	char c = 0;
+	if (recv(socket, &c, 1, MSG_PEEK) == 1 && c == '<') {
+		xml_session(socket);
+	} else if (c == '{') {
+		json_session(socket, false);
+	} else if ((unsigned char)c == INDIGO_BINARY_MARKER) {
+		binary_session(socket);
+	} else {
+		session = false;
+		if (c == 'G' || c == 'P') {
+			char request[BUFFER_SIZE];
+			while (indigo_read_line(socket, request, BUFFER_SIZE) >= 0) {
+				http_headers headers = { "", false, false, true };
+				if (!strncmp(request, "GET /", 5))
+					read_http_headers(socket, &headers);
+				http_result result = process_http_request(socket, request, &headers);
+				if (result == HTTP_WEB_SOCKET)
+					json_session(socket, session = true);
+				if (result != HTTP_KEEP_ALIVE)
+					break;
+			}
+		} else {
+			INDIGO_TRACE(indigo_trace("%d -> // Unrecognised protocol", socket));
+		}
+	}
+	/* protocol parsers close the socket on exit */
+	if (!session)
+		lingering_close(socket);
+	update_client_count(-1);
+	free(connection);
 	INDIGO_TRACE(indigo_trace("%d <- // Worker thread finished", socket));
 }
 
+#ifdef INDIGO_LINUX
+
+/* Connections are accepted by the thread which started the server and served by fixed pool of network threads waiting on shared epoll handle,
+ each connection is armed as one-shot, so it is processed by single thread at a time and returned back to epoll between keep-alive requests.
+ Network threads only collect requests and JSON messages (web socket frames are unwrapped here) without blocking, the response (web applications,
+ Alpaca, BLOB downloads and uploads) and the message are served by bounded pool of request threads, so no network thread is blocked by slow
+ or stalled client. Collected requests are passed through bounded queue, if it is full, network thread waits for free slot and so it stops reading
+ from other connections until the request threads catch up, request not queued in time is rejected. */
+
+#define REQUEST_QUEUE_SIZE	256
+
+static int epoll_handle = -1;
+static int wakeup_handle = -1;
+static pthread_mutex_t connection_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+static connection *connections = NULL;
+
+static pthread_mutex_t request_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t request_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t request_taken = PTHREAD_COND_INITIALIZER;
+static connection *request_queue[REQUEST_QUEUE_SIZE];
+static int request_queue_head = 0;
+static int request_queue_count = 0;
+static pthread_t *request_threads = NULL;
+static int request_thread_limit = 0;
+static int request_thread_count = 0;
+static int idle_request_threads = 0;
+static bool stop_request_threads = false;
+
+static void link_connection(connection *connection) {
+	pthread_mutex_lock(&connection_list_mutex);
+	connection->prev = NULL;
+	connection->next = connections;
+	if (connections)
+		connections->prev = connection;
+	connections = connection;
+	pthread_mutex_unlock(&connection_list_mutex);
+}
+
+static void unlink_connection(connection *connection) {
+	pthread_mutex_lock(&connection_list_mutex);
+	if (connection->prev)
+		connection->prev->next = connection->next;
+	else
+		connections = connection->next;
+	if (connection->next)
+		connection->next->prev = connection->prev;
+	pthread_mutex_unlock(&connection_list_mutex);
+}
+
+static void set_deadline(connection *connection, time_t deadline) {
+	pthread_mutex_lock(&connection_list_mutex);
+	connection->deadline = deadline;
+	pthread_mutex_unlock(&connection_list_mutex);
+}
+
+static void release_request(connection *connection) {
+	indigo_safe_free(connection->request);
+	connection->request = NULL;
+	connection->request_length = 0;
+}
+
+static void release_message(connection *connection) {
+	indigo_safe_free(connection->message);
+	connection->message = NULL;
+	connection->message_length = 0;
+	connection->message_received = 0;
+	connection->frame_length = 0;
+}
+
+static void start_session(connection *connection, bool web_socket) {
+	int socket = connection->socket;
+	INDIGO_TRACE(indigo_trace(web_socket ? "%d <- // Protocol switched to JSON-over-WebSockets" : "%d <- // Protocol switched to JSON", socket));
+	connection->web_socket = web_socket;
+	connection->protocol_adapter = indigo_json_device_adapter(socket, socket, web_socket);
+	connection->parser = indigo_json_parser_create(NULL, connection->protocol_adapter);
+	indigo_attach_client(connection->protocol_adapter);
+}
+
+static void free_connection(connection *connection) {
+	if (connection->protocol_adapter) {
+		/* adapter writer thread is stopped before the socket is closed */
+		indigo_detach_client(connection->protocol_adapter);
+		indigo_release_json_device_adapter(connection->protocol_adapter);
+		indigo_json_parser_release(connection->parser);
+	}
+	close(connection->socket);
+	release_request(connection);
+	release_message(connection);
+	free(connection);
+	update_client_count(-1);
+}
+
+static void arm_connection(connection *connection, int operation) {
+	struct epoll_event event = { 0 };
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	event.data.ptr = connection;
+	if (epoll_ctl(epoll_handle, operation, connection->socket, &event) < 0)
+		indigo_error("%d <- // Can't arm connection (%s)", connection->socket, strerror(errno));
+}
+
+static void close_connection(connection *connection) {
+	unlink_connection(connection);
+	epoll_ctl(epoll_handle, EPOLL_CTL_DEL, connection->socket, NULL);
+	INDIGO_TRACE(indigo_trace("%d <- // Connection closed", connection->socket));
+	free_connection(connection);
+}
+
+static void linger_connection(connection *connection) {
+	shutdown(connection->socket, SHUT_WR);
+	connection->lingering = true;
+	set_deadline(connection, time(NULL) + LINGER_TIMEOUT);
+	arm_connection(connection, EPOLL_CTL_MOD);
+}
+
+static void detach_connection(connection *connection) {
+	unlink_connection(connection);
+	epoll_ctl(epoll_handle, EPOLL_CTL_DEL, connection->socket, NULL);
+	set_receive_timeout(connection->socket, 0);
+}
+
+static void hand_over_connection(connection *connection) {
+	detach_connection(connection);
+	if (!indigo_async((void *(*)(void *))&start_worker_thread, connection)) {
+		indigo_error("Can't create worker thread for connection (%s)", strerror(errno));
+		close(connection->socket);
+		free(connection);
+		update_client_count(-1);
+	}
+}
+
+static void expire_connections(void) {
+	static time_t next_check = 0;
+	time_t now = time(NULL);
+	pthread_mutex_lock(&connection_list_mutex);
+	if (now >= next_check) {
+		next_check = now + LINGER_TIMEOUT;
+		for (connection *connection = connections; connection; connection = connection->next) {
+			/* wakes up the connection, it is closed by the thread processing the event */
+			if (connection->deadline && now > connection->deadline)
+				shutdown(connection->socket, SHUT_RDWR);
+		}
+	}
+	pthread_mutex_unlock(&connection_list_mutex);
+}
+
+static void accept_connections(void) {
+	struct pollfd handles[2] = { { server_socket, POLLIN, 0 }, { wakeup_handle, POLLIN, 0 } };
+	while (!shutdown_initiated) {
+		if (poll(handles, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			indigo_error("Can't wait for connections (%s)", strerror(errno));
+			break;
+		}
+		if (handles[1].revents)
+			break;
+		while (true) {
+			int client_socket = accept(server_socket, NULL, NULL);
+			if (client_socket == -1) {
+				if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && !shutdown_initiated)
+					indigo_error("Can't accept connection (%s)", strerror(errno));
+				if (errno != EINTR)
+					break;
+				continue;
+			}
+			set_receive_timeout(client_socket, REQUEST_TIMEOUT);
+			struct timeval timeout;
+			timeout.tv_sec = 5;
+			timeout.tv_usec = 0;
+			if (setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, (char *)&timeout, sizeof(timeout)) < 0)
+				indigo_error("Can't set send() timeout (%s)", strerror(errno));
+			connection *connection = indigo_safe_malloc(sizeof(struct connection));
+			connection->socket = client_socket;
+			link_connection(connection);
+			update_client_count(1);
+			INDIGO_TRACE(indigo_trace("%d <- // Connection accepted", client_socket));
+			arm_connection(connection, EPOLL_CTL_ADD);
+		}
+	}
+}
+
+/* GET request is collected up to the empty line, PUT request up to the end of request line only, because its headers and body are read by the handler,
+ data are peeked first and only the collected part is consumed, so the body or the next keep-alive request is left in the socket */
+
+static int read_request(connection *connection) {
+	int socket = connection->socket;
+	if (connection->request == NULL) {
+		connection->request = indigo_safe_malloc(REQUEST_SIZE);
+		set_deadline(connection, time(NULL) + REQUEST_TIMEOUT);
+	}
+	char *request = connection->request;
+	int length = connection->request_length;
+	long bytes;
+	while (true) {
+		bytes = recv(socket, request + length, REQUEST_SIZE - 1 - length, MSG_PEEK | MSG_DONTWAIT);
+		if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+			return 0;
+		if (bytes <= 0)
+			return -1;
+		/* empty lines between requests are ignored */
+		if (length > 0 || (*request != '\r' && *request != '\n'))
+			break;
+		if (recv(socket, request, 1, MSG_DONTWAIT) != 1)
+			return -1;
+	}
+	bool complete = false;
+	long consumed = 0;
+	while (consumed < bytes && !complete) {
+		long i = length + consumed++;
+		if (request[i] == '\n')
+			complete = request[i - 1] == '\n' || (request[i - 1] == '\r' && i > 1 && request[i - 2] == '\n') || (!strncmp(request, "PUT ", 4) && memchr(request, '\n', i) == NULL);
+	}
+	if (recv(socket, request + length, consumed, MSG_DONTWAIT) != consumed)
+		return -1;
+	connection->request_length = length += consumed;
+	request[length] = 0;
+	if (complete)
+		return 1;
+	if (length >= REQUEST_SIZE - 1) {
+		INDIGO_TRACE(indigo_trace("%d -> // Request too large", socket));
+		return -1;
+	}
+	return 0;
+}
+
+static void parse_request(connection *connection) {
+	http_headers *headers = &connection->headers;
+	memset(headers, 0, sizeof(http_headers));
+	headers->keep_alive = true;
+	bool request_line = true;
+	char *line = connection->request;
+	char *end;
+	while ((end = strchr(line, '\n'))) {
+		*end = 0;
+		if (end > line && end[-1] == '\r')
+			end[-1] = 0;
+		if (request_line)
+			request_line = false;
+		else if (!strncmp(connection->request, "GET /", 5))
+			parse_http_header(headers, line);
+		line = end + 1;
+	}
+}
+
+static int frame_header_length(connection *connection) {
+	if (connection->frame_length < 2)
+		return 2;
+	int length = connection->frame[1] & 0x80 ? 6 : 2;
+	switch (connection->frame[1] & 0x7F) {
+		case 0x7E:
+			return length + 2;
+		case 0x7F:
+			return length + 8;
+	}
+	return length;
+}
+
+/* web socket frame is collected up to the end of its payload, raw JSON session passes on whatever is available, parser doesn't depend on message boundaries */
+
+static int read_message(connection *connection) {
+	int socket = connection->socket;
+	long bytes;
+	if (!connection->web_socket) {
+		connection->message = indigo_safe_malloc(REQUEST_SIZE + 1);
+		bytes = recv(socket, connection->message, REQUEST_SIZE, MSG_DONTWAIT);
+		if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+			release_message(connection);
+			return 0;
+		}
+		if (bytes <= 0)
+			return -1;
+		connection->message_length = connection->message_received = bytes;
+		return 1;
+	}
+	while (true) {
+		if (connection->message == NULL) {
+			int length = frame_header_length(connection);
+			if (connection->frame_length == length) {
+				uint8_t *frame = connection->frame;
+				uint64_t payload_length = frame[1] & 0x7F;
+				if (payload_length == 0x7E) {
+					uint16_t value;
+					memcpy(&value, frame + 2, sizeof(value));
+					payload_length = ntohs(value);
+				} else if (payload_length == 0x7F) {
+					uint64_t value;
+					memcpy(&value, frame + 2, sizeof(value));
+					payload_length = ntohll(value);
+				}
+				if (payload_length > JSON_BUFFER_SIZE) {
+					INDIGO_TRACE(indigo_trace("%d -> // Frame too large", socket));
+					return -1;
+				}
+				connection->message = indigo_safe_malloc(payload_length + 1);
+				connection->message_length = payload_length;
+				continue;
+			}
+			bytes = recv(socket, connection->frame + connection->frame_length, length - connection->frame_length, MSG_DONTWAIT);
+			if (bytes > 0)
+				connection->frame_length += bytes;
+		} else {
+			if (connection->message_received == connection->message_length)
+				return 1;
+			bytes = recv(socket, connection->message + connection->message_received, connection->message_length - connection->message_received, MSG_DONTWAIT);
+			if (bytes > 0)
+				connection->message_received += bytes;
+		}
+		if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+			return 0;
+		if (bytes <= 0)
+			return -1;
+	}
+}
+
+static void serve_request(connection *connection) {
+	http_result result = process_http_request(connection->socket, connection->request, &connection->headers);
+	release_request(connection);
+	switch (result) {
+		case HTTP_KEEP_ALIVE:
+			arm_connection(connection, EPOLL_CTL_MOD);
+			break;
+		case HTTP_CLOSE:
+			linger_connection(connection);
+			break;
+		case HTTP_WEB_SOCKET:
+			/* web socket session continues on the same connection, frames are collected by network threads */
+			start_session(connection, true);
+			arm_connection(connection, EPOLL_CTL_MOD);
+			break;
+	}
+}
+
+static void serve_message(connection *connection) {
+	int socket = connection->socket;
+	char *message = connection->message;
+	long length = connection->message_length;
+	int opcode = 0x1;
+	if (connection->web_socket) {
+		opcode = connection->frame[0] & 0x0F;
+		if (connection->frame[1] & 0x80) {
+			uint8_t *masking_key = connection->frame + connection->frame_length - 4;
+			for (long i = 0; i < length; i++)
+				message[i] ^= masking_key[i % 4];
+		}
+	}
+	message[length] = 0;
+	bool open = true;
+	switch (opcode) {
+		case 0x0:
+		case 0x1:
+		case 0x2:
+			INDIGO_TRACE_PROTOCOL(indigo_trace("%d -> %s", socket, message));
+			open = indigo_json_parser_parse(connection->parser, message, length);
+			break;
+		case 0x8:
+			INDIGO_TRACE(indigo_trace("%d -> // Web socket closed", socket));
+			open = false;
+			break;
+	}
+	release_message(connection);
+	if (open)
+		arm_connection(connection, EPOLL_CTL_MOD);
+	else
+		close_connection(connection);
+}
+
+static void *request_thread(void *data) {
+	pthread_mutex_lock(&request_queue_mutex);
+	while (true) {
+		if (request_queue_count == 0) {
+			if (stop_request_threads)
+				break;
+			idle_request_threads++;
+			pthread_cond_wait(&request_queued, &request_queue_mutex);
+			idle_request_threads--;
+			continue;
+		}
+		connection *connection = request_queue[request_queue_head];
+		request_queue_head = (request_queue_head + 1) % REQUEST_QUEUE_SIZE;
+		request_queue_count--;
+		pthread_cond_signal(&request_taken);
+		pthread_mutex_unlock(&request_queue_mutex);
+		if (connection->protocol_adapter)
+			serve_message(connection);
+		else
+			serve_request(connection);
+		pthread_mutex_lock(&request_queue_mutex);
+	}
+	pthread_mutex_unlock(&request_queue_mutex);
+	return NULL;
+}
+
+/* request threads are started on demand up to the limit, network thread waits for free slot in the queue at most for REQUEST_TIMEOUT */
+
+static bool submit_connection(connection *connection) {
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += REQUEST_TIMEOUT;
+	pthread_mutex_lock(&request_queue_mutex);
+	while (request_queue_count == REQUEST_QUEUE_SIZE && !shutdown_initiated) {
+		if (pthread_cond_timedwait(&request_taken, &request_queue_mutex, &deadline) == ETIMEDOUT)
+			break;
+	}
+	bool submitted = request_queue_count < REQUEST_QUEUE_SIZE && !shutdown_initiated;
+	if (submitted) {
+		request_queue[(request_queue_head + request_queue_count++) % REQUEST_QUEUE_SIZE] = connection;
+		if (request_queue_count > idle_request_threads && request_thread_count < request_thread_limit) {
+			if (pthread_create(request_threads + request_thread_count, NULL, request_thread, NULL))
+				indigo_error("Can't create request thread (%s)", strerror(errno));
+			else
+				request_thread_count++;
+		}
+		if (request_thread_count == 0) {
+			request_queue_count--;
+			submitted = false;
+		}
+		pthread_cond_signal(&request_queued);
+	}
+	pthread_mutex_unlock(&request_queue_mutex);
+	return submitted;
+}
+
+static void process_connection(connection *connection) {
+	int socket = connection->socket;
+	if (connection->lingering) {
+		char buffer[BUFFER_SIZE];
+		long bytes = recv(socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+		if (bytes > 0 || (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)))
+			arm_connection(connection, EPOLL_CTL_MOD);
+		else
+			close_connection(connection);
+		return;
+	}
+	if (!connection->http && !connection->protocol_adapter) {
+		char c;
+		long bytes = recv(socket, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+		if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			arm_connection(connection, EPOLL_CTL_MOD);
+			return;
+		} else if (bytes != 1) {
+			close_connection(connection);
+			return;
+		} else if (c == '{') {
+			set_deadline(connection, 0);
+			start_session(connection, false);
+		} else if (c == '<' || (unsigned char)c == INDIGO_BINARY_MARKER) {
+			hand_over_connection(connection);
+			return;
+		} else if (c != 'G' && c != 'P') {
+			INDIGO_TRACE(indigo_trace("%d -> // Unrecognised protocol", socket));
+			linger_connection(connection);
+			return;
+		} else {
+			connection->http = true;
+		}
+	}
+	if (connection->protocol_adapter) {
+		switch (read_message(connection)) {
+			case 0:
+				arm_connection(connection, EPOLL_CTL_MOD);
+				break;
+			case 1:
+				if (!submit_connection(connection)) {
+					indigo_error("%d -> // Request queue is full, session closed", socket);
+					close_connection(connection);
+				}
+				break;
+			default:
+				close_connection(connection);
+				break;
+		}
+		return;
+	}
+	switch (read_request(connection)) {
+		case 0:
+			if (time(NULL) > connection->deadline) {
+				INDIGO_TRACE(indigo_trace("%d -> // Request timeout", socket));
+				close_connection(connection);
+			} else {
+				arm_connection(connection, EPOLL_CTL_MOD);
+			}
+			break;
+		case 1:
+			parse_request(connection);
+			set_deadline(connection, 0);
+			if (!submit_connection(connection)) {
+				INDIGO_TRACE(indigo_trace("%d <- // Request queue is full", socket));
+				indigo_printf(socket, "HTTP/1.1 503 Service Unavailable\r\nRetry-After: %d\r\nContent-Length: 0\r\n\r\n", REQUEST_TIMEOUT);
+				release_request(connection);
+				linger_connection(connection);
+			}
+			break;
+		default:
+			close_connection(connection);
+			break;
+	}
+}
+
+static void *network_thread(void *data) {
+	struct epoll_event event;
+	while (!shutdown_initiated) {
+		int count = epoll_wait(epoll_handle, &event, 1, LINGER_TIMEOUT * 1000);
+		expire_connections();
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+			indigo_error("Can't wait for network events (%s)", strerror(errno));
+			break;
+		}
+		if (count == 0)
+			continue;
+		if (event.data.ptr == &wakeup_handle)
+			break;
+		process_connection(event.data.ptr);
+	}
+	return NULL;
+}
+
+static indigo_result run_network_threads(void) {
+	int count = indigo_server_tcp_threads;
+	pthread_t threads[count];
+	struct epoll_event event = { 0 };
+	fcntl(server_socket, F_SETFL, fcntl(server_socket, F_GETFL, 0) | O_NONBLOCK);
+	if ((epoll_handle = epoll_create1(EPOLL_CLOEXEC)) < 0 || (wakeup_handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+		indigo_error("Can't create epoll handle (%s)", strerror(errno));
+		if (epoll_handle >= 0)
+			close(epoll_handle);
+		epoll_handle = -1;
+		close(server_socket);
+		return INDIGO_CANT_START_SERVER;
+	}
+	/* wakeup handle is level triggered, so it stops all threads */
+	event.events = EPOLLIN;
+	event.data.ptr = &wakeup_handle;
+	epoll_ctl(epoll_handle, EPOLL_CTL_ADD, wakeup_handle, &event);
+	request_thread_limit = indigo_server_tcp_workers > 0 ? indigo_server_tcp_workers : 1;
+	request_threads = indigo_safe_malloc(request_thread_limit * sizeof(pthread_t));
+	stop_request_threads = false;
+	INDIGO_DEBUG(indigo_debug("Serving HTTP connections by %d network threads and up to %d request threads", count, request_thread_limit));
+	for (int i = 0; i < count; i++) {
+		if (pthread_create(threads + i, NULL, network_thread, NULL)) {
+			indigo_error("Can't create network thread (%s)", strerror(errno));
+			count = i;
+			break;
+		}
+	}
+	if (count > 0)
+		accept_connections();
+	eventfd_write(wakeup_handle, 1);
+	/* wakes up network threads waiting for free slot in the request queue */
+	pthread_mutex_lock(&request_queue_mutex);
+	pthread_cond_broadcast(&request_taken);
+	pthread_mutex_unlock(&request_queue_mutex);
+	for (int i = 0; i < count; i++)
+		pthread_join(threads[i], NULL);
+	pthread_mutex_lock(&connection_list_mutex);
+	/* wakes up request threads still serving requests */
+	for (connection *connection = connections; connection; connection = connection->next)
+		shutdown(connection->socket, SHUT_RDWR);
+	pthread_mutex_unlock(&connection_list_mutex);
+	/* request threads drain the queue before they finish */
+	pthread_mutex_lock(&request_queue_mutex);
+	stop_request_threads = true;
+	pthread_cond_broadcast(&request_queued);
+	pthread_mutex_unlock(&request_queue_mutex);
+	for (int i = 0; i < request_thread_count; i++)
+		pthread_join(request_threads[i], NULL);
+	indigo_safe_free(request_threads);
+	request_threads = NULL;
+	request_thread_count = 0;
+	pthread_mutex_lock(&connection_list_mutex);
+	connection *connection = connections;
+	connections = NULL;
+	pthread_mutex_unlock(&connection_list_mutex);
+	while (connection) {
+		struct connection *next = connection->next;
+		free_connection(connection);
+		connection = next;
+	}
+	close(server_socket);
+	close(epoll_handle);
+	epoll_handle = -1;
+	close(wakeup_handle);
+	wakeup_handle = -1;
+	return INDIGO_OK;
+}
+
+#endif
+
 void indigo_server_shutdown() {
 	if (!shutdown_initiated) {
 		shutdown_initiated = true;
+#ifdef INDIGO_LINUX
+		if (wakeup_handle >= 0) {
+			uint64_t value = 1;
+			if (write(wakeup_handle, &value, sizeof(value)) == sizeof(value))
+				return;
+		}
+#endif
 		shutdown(server_socket, SHUT_RDWR);
 		close(server_socket);
 	}
@@ -564,6 +1280,14 @@ indigo_result indigo_server_start(indigo_server_tcp_callback callback) {
 	server_callback(0);
 	startup_initiated = false;
 	signal(SIGPIPE, SIG_IGN);
+#ifdef INDIGO_LINUX
+	if (indigo_server_tcp_threads > 0) {
+		indigo_result result = run_network_threads();
+		shutdown_initiated = false;
+		server_callback(0);
+		return result;
+	}
+#endif
 	while (1) {
 		client_socket = accept(server_socket, (struct sockaddr *)&client_name, &name_len);
 		if (client_socket == -1) {
@@ -571,18 +1295,21 @@ indigo_result indigo_server_start(indigo_server_tcp_callback callback) {
 				break;
 			indigo_error("Can't accept connection (%s)", strerror(errno));
 		} else {
+			set_receive_timeout(client_socket, 0);
 			struct timeval timeout;
-			timeout.tv_sec = 0;
-			timeout.tv_usec = 0;
-			if (setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout, sizeof(timeout)) < 0)
-				indigo_error("Can't set recv() timeout (%s)", strerror(errno));
 			timeout.tv_sec = 5;
+			timeout.tv_usec = 0;
 			if (setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, (char *)&timeout, sizeof(timeout)) < 0)
 				indigo_error("Can't set send() timeout (%s)", strerror(errno));
-			int *pointer = indigo_safe_malloc(sizeof(int));
-			*pointer = client_socket;
-			if (!indigo_async((void *(*)(void *))&start_worker_thread, pointer))
+			connection *connection = indigo_safe_malloc(sizeof(struct connection));
+			connection->socket = client_socket;
+			update_client_count(1);
+			if (!indigo_async((void *(*)(void *))&start_worker_thread, connection)) {
 				indigo_error("Can't create worker thread for connection (%s)", strerror(errno));
+				close(client_socket);
+				free(connection);
+				update_client_count(-1);
+			}
 		}
 	}
 	shutdown_initiated = false;
@@ -23,18 +23,24 @@
 // and https://github.com/indigo-astronomy/indigo_imager/blob/master/common_src/stretcher.cpp
 
 #include <indigo/indigo_bus.h>
+#include <indigo/indigo_parallel.h>
 #include <indigo/indigo_stretch.h>
 
 #include <vector>
-#include <thread>
 #include <algorithm>
 #include <math.h>
-#include <unistd.h>
 
-#define INDIGO_DEFAULT_THREADS 4
 #define MIN_SIZE_TO_PARALLELIZE 0x3FFFF
 //#define HISTOGRAM_AWB
 
+// body - callable object, body(start, end) is called for contiguous chunks of 0..count-1 on shared worker pool
+
+template <typename F> static void parallel_for(int count, F body) {
+	indigo_parallel_for(count, [](void *data, int start, int end) {
+		(*(F *)data)(start, end);
+	}, &body);
+}
+
 // raw - raw pixels, any unsigned int
 // index - offset of the current pixel in raw
 // row, column - row, column of the current pixel (to skip line + to detect edges of the frame)
@@ -155,6 +161,96 @@ template <typename T> static inline void debayer(T *raw, int index, int row, int
 	}
 }
 
+// interior pixels (all four neighbours available) are debayered by specialized kernels without edge tests and with integer arithmetic,
+// red, green, blue - sums of neighbouring pixels scaled to 4 x mean value, sum / 4.0 is exactly the same float as mean computed by debayer()
+
+template <int PHASE, typename T> static inline void debayer_interior(const T *raw, int index, int width, int &red, int &green, int &blue) {
+	const int center = raw[index];
+	const int horizontal = raw[index - 1] + raw[index + 1];
+	const int vertical = raw[index - width] + raw[index + width];
+	switch (PHASE) {
+		case 0x00:
+			red = 4 * center;
+			green = horizontal + vertical;
+			blue = raw[index - width - 1] + raw[index - width + 1] + raw[index + width - 1] + raw[index + width + 1];
+			break;
+		case 0x10:
+			red = 2 * horizontal;
+			green = 4 * center;
+			blue = 2 * vertical;
+			break;
+		case 0x01:
+			red = 2 * vertical;
+			green = 4 * center;
+			blue = 2 * horizontal;
+			break;
+		case 0x11:
+			red = raw[index - width - 1] + raw[index - width + 1] + raw[index + width - 1] + raw[index + width + 1];
+			green = horizontal + vertical;
+			blue = 4 * center;
+			break;
+	}
+}
+
+// columns 1 .. width - 2 of the row starting at index, EVEN is phase of even columns, odd columns are processed first to keep phase of the loop body constant
+// store - store(index, red, green, blue) called with scaled sums
+
+template <int EVEN, typename T, typename S> static inline void debayer_interior_row(const T *raw, int index, int width, S store) {
+	int column = 1;
+	int red, green, blue;
+	for (; column + 1 < width - 1; column += 2) {
+		debayer_interior<EVEN ^ 0x10>(raw, index + column, width, red, green, blue);
+		store(index + column, red, green, blue);
+		debayer_interior<EVEN>(raw, index + column + 1, width, red, green, blue);
+		store(index + column + 1, red, green, blue);
+	}
+	if (column < width - 1) {
+		debayer_interior<EVEN ^ 0x10>(raw, index + column, width, red, green, blue);
+		store(index + column, red, green, blue);
+	}
+}
+
+// raw - raw pixels, any unsigned int
+// start, end - range of rows to debayer
+// width, height - width, height of the frame
+// offsets - 0x00 = RGGB, 0x01 = GBRG, 0x10 = GRBG, 0x11 = BGGR
+// store - store(index, red, green, blue) called for interior pixels with sums scaled to 4 x mean value
+// store_edge - store_edge(index, red, green, blue) called for edge pixels with mean value computed by debayer()
+
+template <typename T, typename S, typename E> static inline void debayer_rows(T *raw, int start, int end, int width, int height, int offsets, S store, E store_edge) {
+	float red, green, blue;
+	for (int row = start; row < end; row++) {
+		int index = row * width;
+		if (row == 0 || row == height - 1) {
+			for (int column = 0; column < width; column++) {
+				debayer(raw, index + column, row, column, width, height, offsets, red, green, blue);
+				store_edge(index + column, red, green, blue);
+			}
+			continue;
+		}
+		debayer(raw, index, row, 0, width, height, offsets, red, green, blue);
+		store_edge(index, red, green, blue);
+		switch (offsets ^ (row & 1)) {
+			case 0x00:
+				debayer_interior_row<0x00>(raw, index, width, store);
+				break;
+			case 0x01:
+				debayer_interior_row<0x01>(raw, index, width, store);
+				break;
+			case 0x10:
+				debayer_interior_row<0x10>(raw, index, width, store);
+				break;
+			case 0x11:
+				debayer_interior_row<0x11>(raw, index, width, store);
+				break;
+		}
+		if (width > 1) {
+			debayer(raw, index + width - 1, row, width - 1, width, height, offsets, red, green, blue);
+			store_edge(index + width - 1, red, green, blue);
+		}
+	}
+}
+
 // buffer - pixels, 8 or 16 bit unsigned int
 // width, height - width, height of the frame
 // sample_columns_by, sample_rows_by - to subsample buffer
@@ -244,6 +340,17 @@ inline static uint8_t stretch(float value, int native_shadows, int native_highli
 	}
 }
 
+// table - lookup table, table[i] is stretched value of i * scale / coef
+// entries - size of the table
+// scale - 1 for raw pixel values, 0.25 for debayered sums
+// other parameters - see stretch()
+
+static void stretch_table(uint8_t *table, int entries, float scale, float coef, int native_shadows, int native_highlights, float k1_k2, float midtones_k2) {
+	for (int i = 0; i < entries; i++) {
+		table[i] = stretch(i * scale / coef, native_shadows, native_highlights, k1_k2, midtones_k2);
+	}
+}
+
 // input_buffer - source data as 8 or 16 bit integer
 // step - 1 for mono or single channel, 3 for rgb
 // width, height - height, width of frame
@@ -261,27 +368,25 @@ template <typename T> void indigo_stretch(T *input_buffer, int step, int width,
 	const float k2 = ((2 * midtones) - 1) * hs_range_factor / max_input;
 	const float k1_k2 = k1 / k2;
 	const float midtones_k2 = midtones / k2;
-	if (size < MIN_SIZE_TO_PARALLELIZE) {
-		for (int i = 0; i < size; i++) {
-			output_buffer[i * step] = stretch(input_buffer[i * step] / coef, native_shadows, native_highlights, k1_k2, midtones_k2);
+	const int entries = (int)max_input + 1;
+	if (size > entries) {
+		// each pixel value is stretched once, then looked up
+		std::vector<uint8_t> table(entries);
+		stretch_table(table.data(), entries, 1.0f, coef, native_shadows, native_highlights, k1_k2, midtones_k2);
+		const uint8_t *lut = table.data();
+		auto stretch_pixels = [=](int start, int end) {
+			for (int i = start; i < end; i++) {
+				output_buffer[i * step] = lut[input_buffer[i * step]];
+			}
+		};
+		if (size < MIN_SIZE_TO_PARALLELIZE) {
+			stretch_pixels(0, size);
+		} else {
+			parallel_for(size, stretch_pixels);
 		}
 	} else {
-		int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
-		max_threads = (max_threads > 0) ? max_threads : INDIGO_DEFAULT_THREADS;
-		std::thread threads[max_threads];
-		for (int rank = 0; rank < max_threads; rank++) {
-			const int chunk = ceil(size / (double)max_threads);
-			threads[rank] = std::thread([=]() {
-				const int start = chunk * rank;
-				int end = start + chunk;
-				end = (end > size) ? size : end;
-				for (int i = start; i < end; i++) {
-					output_buffer[i * step] = stretch(input_buffer[i * step] / coef, native_shadows, native_highlights, k1_k2, midtones_k2);
-				}
-			});
-		}
-		for (int rank = 0; rank < max_threads; rank++) {
-			threads[rank].join();
+		for (int i = 0; i < size; i++) {
+			output_buffer[i * step] = stretch(input_buffer[i * step] / coef, native_shadows, native_highlights, k1_k2, midtones_k2);
 		}
 	}
 }
@@ -322,46 +427,25 @@ template <typename T> void indigo_debayer_stretch(T *input_buffer, int width, in
 	const float k2 = ((2 * midtones[reference]) - 1) * hs_range_factor / max_input;
 	const float k1_k2 = k1 / k2;
 	const float midtones_k2 = midtones[1] / k2;
+	auto store = [=](int index, int red, int green, int blue) {
+		uint8_t *output = output_buffer + 3 * index;
+		output[0] = stretch(red * 0.25f / redCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
+		output[1] = stretch(green * 0.25f / greenCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
+		output[2] = stretch(blue * 0.25f / blueCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
+	};
+	auto store_edge = [=](int index, float red, float green, float blue) {
+		uint8_t *output = output_buffer + 3 * index;
+		output[0] = stretch(red / redCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
+		output[1] = stretch(green / greenCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
+		output[2] = stretch(blue / blueCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
+	};
+	auto debayer_stretch_rows = [=](int start, int end) {
+		debayer_rows(input_buffer, start, end, width, height, offsets, store, store_edge);
+	};
 	if (size < MIN_SIZE_TO_PARALLELIZE) {
-		int input_index = 0;
-		for (int row_index = 0; row_index < height; row_index++) {
-			for (int column_index = 0; column_index < width; column_index++) {
-				float red = 0, green = 0, blue = 0;
-				int output_index = input_index * 3;
-				debayer(input_buffer, input_index, row_index, column_index, width, height, offsets, red, green, blue);
-				output_buffer[output_index] = stretch(red / redCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
-				output_buffer[output_index + 1] = stretch(green / greenCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
-				output_buffer[output_index + 2] = stretch(blue / blueCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
-				input_index++;
-			}
-		}
+		debayer_stretch_rows(0, height);
 	} else {
-		int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
-		max_threads = (max_threads > 0) ? max_threads : INDIGO_DEFAULT_THREADS;
-		std::thread threads[max_threads];
-		for (int rank = 0; rank < max_threads; rank++) {
-			const int chunk = ceil(height / (double)max_threads);
-			threads[rank] = std::thread([=]() {
-				const int start = chunk * rank;
-				int end = start + chunk;
-				end = (end > height) ? height : end;
-				int input_index = start * width;
-				for (int row_index = start; row_index < end; row_index++) {
-					for (int column_index = 0; column_index < width; column_index++) {
-						float red = 0, green = 0, blue = 0;
-						int output_index = input_index * 3;
-						debayer(input_buffer, input_index, row_index, column_index, width, height, offsets, red, green, blue);
-						output_buffer[output_index] = stretch(red / redCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
-						output_buffer[output_index + 1] = stretch(green / greenCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
-						output_buffer[output_index + 2] = stretch(blue / blueCoef, native_shadows, native_highlights, k1_k2, midtones_k2);
-						input_index++;
-					}
-				}
-			});
-		}
-		for (int rank = 0; rank < max_threads; rank++) {
-			threads[rank].join();
-		}
+		parallel_for(height, debayer_stretch_rows);
 	}
 }
 
@@ -398,46 +482,39 @@ template <typename T> void indigo_debayer_stretch(T *input_buffer, int width, in
 	const float blue_k2 = ((2 * midtones[2]) - 1) * blue_hs_range_factor / max_input;
 	const float blue_k1_k2 = blue_k1 / blue_k2;
 	const float blue_midtones_k2 = midtones[2] / blue_k2;
-	if (size < MIN_SIZE_TO_PARALLELIZE) {
-		int input_index = 0;
-		for (int row_index = 0; row_index < height; row_index++) {
-			for (int column_index = 0; column_index < width; column_index++) {
-				float red = 0, green = 0, blue = 0;
-				int output_index = input_index * 3;
-				debayer(input_buffer, input_index, row_index, column_index, width, height, offsets, red, green, blue);
-				output_buffer[output_index] = stretch(red, red_native_shadows, red_native_highlights, red_k1_k2, red_midtones_k2);
-				output_buffer[output_index + 1] = stretch(green, green_native_shadows, green_native_highlights, green_k1_k2, green_midtones_k2);
-				output_buffer[output_index + 2] = stretch(blue, blue_native_shadows, blue_native_highlights, blue_k1_k2, blue_midtones_k2);
-				input_index++;
-			}
+	auto store_edge = [=](int index, float red, float green, float blue) {
+		uint8_t *output = output_buffer + 3 * index;
+		output[0] = stretch(red, red_native_shadows, red_native_highlights, red_k1_k2, red_midtones_k2);
+		output[1] = stretch(green, green_native_shadows, green_native_highlights, green_k1_k2, green_midtones_k2);
+		output[2] = stretch(blue, blue_native_shadows, blue_native_highlights, blue_k1_k2, blue_midtones_k2);
+	};
+	// interior means are multiples of 0.25, so they are stretched once per possible value and looked up if frame is larger than lookup tables
+	const int entries = 4 * (int)max_input + 1;
+	if (size > entries) {
+		std::vector<uint8_t> table(3 * entries);
+		uint8_t *red_lut = table.data(), *green_lut = red_lut + entries, *blue_lut = green_lut + entries;
+		stretch_table(red_lut, entries, 0.25f, 1.0f, red_native_shadows, red_native_highlights, red_k1_k2, red_midtones_k2);
+		stretch_table(green_lut, entries, 0.25f, 1.0f, green_native_shadows, green_native_highlights, green_k1_k2, green_midtones_k2);
+		stretch_table(blue_lut, entries, 0.25f, 1.0f, blue_native_shadows, blue_native_highlights, blue_k1_k2, blue_midtones_k2);
+		auto store = [=](int index, int red, int green, int blue) {
+			uint8_t *output = output_buffer + 3 * index;
+			output[0] = red_lut[red];
+			output[1] = green_lut[green];
+			output[2] = blue_lut[blue];
+		};
+		auto debayer_stretch_rows = [=](int start, int end) {
+			debayer_rows(input_buffer, start, end, width, height, offsets, store, store_edge);
+		};
+		if (size < MIN_SIZE_TO_PARALLELIZE) {
+			debayer_stretch_rows(0, height);
+		} else {
+			parallel_for(height, debayer_stretch_rows);
 		}
 	} else {
-		int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
-		max_threads = (max_threads > 0) ? max_threads : INDIGO_DEFAULT_THREADS;
-		std::thread threads[max_threads];
-		for (int rank = 0; rank < max_threads; rank++) {
-			const int chunk = ceil(height / (double)max_threads);
-			threads[rank] = std::thread([=]() {
-				const int start = chunk * rank;
-				int end = start + chunk;
-				end = (end > height) ? height : end;
-				int input_index = start * width;
-				for (int row_index = start; row_index < end; row_index++) {
-					for (int column_index = 0; column_index < width; column_index++) {
-						float red = 0, green = 0, blue = 0;
-						int output_index = input_index * 3;
-						debayer(input_buffer, input_index, row_index, column_index, width, height, offsets, red, green, blue);
-						output_buffer[output_index] = stretch(red, red_native_shadows, red_native_highlights, red_k1_k2, red_midtones_k2);
-						output_buffer[output_index + 1] = stretch(green, green_native_shadows, green_native_highlights, green_k1_k2, green_midtones_k2);
-						output_buffer[output_index + 2] = stretch(blue, blue_native_shadows, blue_native_highlights, blue_k1_k2, blue_midtones_k2);
-						input_index++;
-					}
-				}
-			});
-		}
-		for (int rank = 0; rank < max_threads; rank++) {
-			threads[rank].join();
-		}
+		auto store = [=](int index, int red, int green, int blue) {
+			store_edge(index, red * 0.25f, green * 0.25f, blue * 0.25f);
+		};
+		debayer_rows(input_buffer, 0, height, width, height, offsets, store, store_edge);
 	}
 }
 
@@ -445,49 +522,149 @@ template <typename T> void indigo_debayer_stretch(T *input_buffer, int width, in
 
 template <typename T> void indigo_debayer(T *input_buffer, int width, int height, int offsets, uint8_t *output_buffer) {
 	const int size = width * height;
+	auto store = [=](int index, int red, int green, int blue) {
+		uint8_t *output = output_buffer + 3 * index;
+		output[0] = red >> 2;
+		output[1] = green >> 2;
+		output[2] = blue >> 2;
+	};
+	auto store_edge = [=](int index, float red, float green, float blue) {
+		uint8_t *output = output_buffer + 3 * index;
+		output[0] = red;
+		output[1] = green;
+		output[2] = blue;
+	};
+	auto debayer_pixels = [=](int start, int end) {
+		debayer_rows(input_buffer, start, end, width, height, offsets, store, store_edge);
+	};
 	if (size < MIN_SIZE_TO_PARALLELIZE) {
-		int input_index = 0;
-		for (int row_index = 0; row_index < height; row_index++) {
-			for (int column_index = 0; column_index < width; column_index++) {
-				float red = 0, green = 0, blue = 0;
-				int output_index = input_index * 3;
-				debayer(input_buffer, input_index, row_index, column_index, width, height, offsets, red, green, blue);
-				output_buffer[output_index] = red;
-				output_buffer[output_index + 1] = green;
-				output_buffer[output_index + 2] = blue;
-				input_index++;
+		debayer_pixels(0, height);
+	} else {
+		parallel_for(height, debayer_pixels);
+	}
+}
+
+// input_buffer - source data as 8 or 16 bit integer
+// width, height - width, height of the frame
+// components - 1 for mono, 3 for rgb
+// factor - binning factor, output frame is width / factor x height / factor, incomplete blocks on the right and bottom edge are ignored
+// output_buffer - binned frame, same type and number of components as input_buffer
+
+template <typename T> void indigo_bin(const T *input_buffer, int width, int height, int components, int factor, T *output_buffer) {
+	const int output_width = width / factor;
+	const int output_height = height / factor;
+	const int output_line = output_width * components;
+	const int block = factor * factor;
+	auto bin_rows = [=](int start, int end) {
+		std::vector<uint64_t> sums(output_line);
+		for (int row_index = start; row_index < end; row_index++) {
+			std::fill(sums.begin(), sums.end(), 0);
+			for (int i = 0; i < factor; i++) {
+				const T *line = input_buffer + ((size_t)row_index * factor + i) * width * components;
+				for (int column_index = 0; column_index < output_width; column_index++) {
+					uint64_t *sum = &sums[column_index * components];
+					for (int j = 0; j < factor; j++) {
+						for (int k = 0; k < components; k++) {
+							sum[k] += *line++;
+						}
+					}
+				}
+			}
+			T *output = output_buffer + (size_t)row_index * output_line;
+			for (int i = 0; i < output_line; i++) {
+				output[i] = sums[i] / block;
 			}
 		}
+	};
+	if (width * height < MIN_SIZE_TO_PARALLELIZE) {
+		bin_rows(0, output_height);
 	} else {
-		int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
-		max_threads = (max_threads > 0) ? max_threads : INDIGO_DEFAULT_THREADS;
-		std::thread threads[max_threads];
-		for (int rank = 0; rank < max_threads; rank++) {
-			const int chunk = ceil(height / (double)max_threads);
-			threads[rank] = std::thread([=]() {
-				const int start = chunk * rank;
-				int end = start + chunk;
-				end = (end > height) ? height : end;
-				int input_index = start * width;
-				for (int row_index = start; row_index < end; row_index++) {
-					for (int column_index = 0; column_index < width; column_index++) {
-						float red = 0, green = 0, blue = 0;
-						int output_index = input_index * 3;
-						debayer(input_buffer, input_index, row_index, column_index, width, height, offsets, red, green, blue);
-						output_buffer[output_index] = red;
-						output_buffer[output_index + 1] = green;
-						output_buffer[output_index + 2] = blue;
-						input_index++;
+		parallel_for(output_height, bin_rows);
+	}
+}
+
+// input_buffer - raw bayered data as 8 or 16 bit integer
+// width, height - width, height of the frame
+// offsets - 0x00 = RGGB, 0x01 = GBRG, 0x10 = GRBG, 0x11 = BGGR
+// factor - binning factor, must be even, output frame is width / factor x height / factor
+// output_buffer - binned rgb frame, each channel is a mean value of all pixels of the same color in the block
+
+template <typename T> void indigo_debayer_bin(const T *input_buffer, int width, int height, int offsets, int factor, T *output_buffer) {
+	const int output_width = width / factor;
+	const int output_height = height / factor;
+	const int output_line = output_width * 3;
+	// channel of even and odd column for even and odd row, same mapping as debayer()
+	int channels[2][2];
+	for (int row = 0; row < 2; row++) {
+		for (int column = 0; column < 2; column++) {
+			int pixel = offsets ^ (column << 4 | row);
+			channels[row][column] = pixel == 0x00 ? 0 : pixel == 0x11 ? 2 : 1;
+		}
+	}
+	const int quarter = factor * factor / 4;
+	const int counts[3] = { quarter, 2 * quarter, quarter };
+	auto bin_rows = [=](int start, int end) {
+		std::vector<uint64_t> sums(output_line);
+		for (int row_index = start; row_index < end; row_index++) {
+			std::fill(sums.begin(), sums.end(), 0);
+			for (int i = 0; i < factor; i++) {
+				const T *line = input_buffer + ((size_t)row_index * factor + i) * width;
+				const int even = channels[i & 1][0];
+				const int odd = channels[i & 1][1];
+				for (int column_index = 0; column_index < output_width; column_index++) {
+					uint64_t *sum = &sums[column_index * 3];
+					for (int j = 0; j < factor; j += 2) {
+						sum[even] += *line++;
+						sum[odd] += *line++;
 					}
 				}
-			});
-		}
-		for (int rank = 0; rank < max_threads; rank++) {
-			threads[rank].join();
+			}
+			T *output = output_buffer + (size_t)row_index * output_line;
+			for (int i = 0; i < output_line; i++) {
+				output[i] = sums[i] / counts[i % 3];
+			}
 		}
+	};
+	if (width * height < MIN_SIZE_TO_PARALLELIZE) {
+		bin_rows(0, output_height);
+	} else {
+		parallel_for(output_height, bin_rows);
 	}
 }
 
+// input_buffer - rgb data debayered by indigo_debayer_bin() as 8 or 16 bit integer
+// width, height - height, width of frame
+// output_buffer - JPEG conversion source buffer
+// shadows, midtones, highlights - per channel stretch thresholds
+// totals - sum of all pixels in subsample, used for AWB only
+
+template <typename T> void indigo_stretch_debayered(const T *input_buffer, int width, int height, uint8_t *output_buffer, double *shadows, double *midtones, double *highlights, unsigned long *totals) {
+#ifdef HISTOGRAM_AWB
+	int reference = 0;
+	float coef[3] = { 1, 1, 1 };
+	if (totals[0] > totals[1] && totals[0] > totals[2]) {
+		reference = 0;
+		coef[1] = (float)totals[1] / totals[0];
+		coef[2] = (float)totals[2] / totals[0];
+	} else if (totals[1] > totals[0] && totals[1] > totals[2]) {
+		reference = 1;
+		coef[0] = (float)totals[0] / totals[1];
+		coef[2] = (float)totals[2] / totals[1];
+	} else {
+		reference = 2;
+		coef[0] = (float)totals[0] / totals[2];
+		coef[1] = (float)totals[1] / totals[2];
+	}
+	for (int i = 0; i < 3; i++) {
+		indigo_stretch(input_buffer + i, 3, width, height, output_buffer + i, shadows[reference], midtones[reference], highlights[reference], coef[i]);
+	}
+#else
+	for (int i = 0; i < 3; i++) {
+		indigo_stretch(input_buffer + i, 3, width, height, output_buffer + i, shadows[i], midtones[i], highlights[i], 1);
+	}
+#endif
+}
+
 extern "C" void indigo_compute_stretch_params_8(const uint8_t *buffer, int width, int height, int sample_by, double *shadows, double *midtones, double *highlights, unsigned long **histogram, float B, float C) {
 	indigo_compute_stretch_params(buffer + 0, width, height, sample_by, 1, &shadows[0], &midtones[0], &highlights[0], histogram[0] = (unsigned long *)indigo_safe_malloc(sizeof(unsigned long) * 256), NULL, B, C);
 }
@@ -653,3 +830,51 @@ extern "C" void indigo_debayer_8_grbg(const uint8_t *input_buffer, int width, in
 extern "C" void indigo_debayer_8_bggr(const uint8_t *input_buffer, int width, int height, uint8_t *output_buffer) {
 	indigo_debayer(input_buffer, width, height, 0x11, output_buffer);
 }
+
+extern "C" void indigo_bin_8(const uint8_t *input_buffer, int width, int height, int components, int factor, uint8_t *output_buffer) {
+	indigo_bin(input_buffer, width, height, components, factor, output_buffer);
+}
+
+extern "C" void indigo_bin_16(const uint16_t *input_buffer, int width, int height, int components, int factor, uint16_t *output_buffer) {
+	indigo_bin(input_buffer, width, height, components, factor, output_buffer);
+}
+
+extern "C" void indigo_debayer_bin_8_rggb(const uint8_t *input_buffer, int width, int height, int factor, uint8_t *output_buffer) {
+	indigo_debayer_bin(input_buffer, width, height, 0x00, factor, output_buffer);
+}
+
+extern "C" void indigo_debayer_bin_8_gbrg(const uint8_t *input_buffer, int width, int height, int factor, uint8_t *output_buffer) {
+	indigo_debayer_bin(input_buffer, width, height, 0x01, factor, output_buffer);
+}
+
+extern "C" void indigo_debayer_bin_8_grbg(const uint8_t *input_buffer, int width, int height, int factor, uint8_t *output_buffer) {
+	indigo_debayer_bin(input_buffer, width, height, 0x10, factor, output_buffer);
+}
+
+extern "C" void indigo_debayer_bin_8_bggr(const uint8_t *input_buffer, int width, int height, int factor, uint8_t *output_buffer) {
+	indigo_debayer_bin(input_buffer, width, height, 0x11, factor, output_buffer);
+}
+
+extern "C" void indigo_debayer_bin_16_rggb(const uint16_t *input_buffer, int width, int height, int factor, uint16_t *output_buffer) {
+	indigo_debayer_bin(input_buffer, width, height, 0x00, factor, output_buffer);
+}
+
+extern "C" void indigo_debayer_bin_16_gbrg(const uint16_t *input_buffer, int width, int height, int factor, uint16_t *output_buffer) {
+	indigo_debayer_bin(input_buffer, width, height, 0x01, factor, output_buffer);
+}
+
+extern "C" void indigo_debayer_bin_16_grbg(const uint16_t *input_buffer, int width, int height, int factor, uint16_t *output_buffer) {
+	indigo_debayer_bin(input_buffer, width, height, 0x10, factor, output_buffer);
+}
+
+extern "C" void indigo_debayer_bin_16_bggr(const uint16_t *input_buffer, int width, int height, int factor, uint16_t *output_buffer) {
+	indigo_debayer_bin(input_buffer, width, height, 0x11, factor, output_buffer);
+}
+
+extern "C" void indigo_stretch_24_debayered(const uint8_t *input_buffer, int width, int height, uint8_t *output_buffer, double *shadows, double *midtones, double *highlights, unsigned long *totals) {
+	indigo_stretch_debayered(input_buffer, width, height, output_buffer, shadows, midtones, highlights, totals);
+}
+
+extern "C" void indigo_stretch_48_debayered(const uint16_t *input_buffer, int width, int height, uint8_t *output_buffer, double *shadows, double *midtones, double *highlights, unsigned long *totals) {
+	indigo_stretch_debayered(input_buffer, width, height, output_buffer, shadows, midtones, highlights, totals);
+}
@@ -27,30 +27,43 @@
 #include <time.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <errno.h>
 
 #include <indigo/indigo_timer.h>
 
 #include <indigo/indigo_driver.h>
 
+// timers are kept in hierarchical timer wheel driven by single scheduler thread on CLOCK_MONOTONIC,
+// expired timers are executed by pool of worker threads, extra workers are started if all of them are blocked
+// (callbacks may run for a long time, e.g. agent processes) and stopped when idle
 
-//#ifdef __MACH__ /* Mac OSX prior Sierra is missing clock_gettime() */
-//#include <mach/clock.h>
-//#include <mach/mach.h>
-//void utc_time(struct timespec *ts) {
-//	clock_serv_t cclock;
-//	mach_timespec_t mts;
-//	host_get_clock_service(mach_host_self(), CALENDAR_CLOCK, &cclock);
-//	clock_get_time(cclock, &mts);
-//	mach_port_deallocate(mach_task_self(), cclock);
-//	ts->tv_sec = mts.tv_sec;
-//	ts->tv_nsec = mts.tv_nsec;
-//}
-//#endif
+#define NANO	1000000000L
 
-#define utc_time(ts) clock_gettime(CLOCK_REALTIME, ts)
+#define TICK_NS									1000000L		// 1ms
+#define WHEEL_BITS							12
+#define WHEEL_SIZE							(1 << WHEEL_BITS)
+#define WHEEL_MASK							(WHEEL_SIZE - 1)
+#define LEVEL_BITS							6
+#define LEVEL_SIZE							(1 << LEVEL_BITS)
+#define LEVEL_MASK							(LEVEL_SIZE - 1)
+#define LEVEL_COUNT							3
+#define MAX_DELTA								((1LL << (WHEEL_BITS + LEVEL_COUNT * LEVEL_BITS)) - 1)
+#define WORKER_IDLE_TIMEOUT			5
+#define STARVATION_TICKS				10			// 10ms
+#define MAX_WORKERS							1024
 
-#define NANO	1000000000L
+#define LEVEL_SHIFT(level)			(WHEEL_BITS + (level) * LEVEL_BITS)
+#define LEVEL_INDEX(tick, level)	(((tick) >> LEVEL_SHIFT(level)) & LEVEL_MASK)
+
+typedef enum {
+	TIMER_IDLE = 0,
+	TIMER_PENDING,
+	TIMER_READY,
+	TIMER_RUNNING
+} timer_state;
+
+int indigo_timer_pool_size = 4;
 
 int timer_count = 0;
 indigo_timer *free_timer = NULL;
@@ -58,79 +71,352 @@ indigo_timer *free_timer = NULL;
 pthread_mutex_t free_timer_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t cancel_timer_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static void *timer_func(indigo_timer *timer) {
-	pthread_detach(pthread_self());
+static pthread_once_t scheduler_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t scheduler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t scheduler_cond;
+static pthread_cond_t worker_cond;
+
+static indigo_timer *wheel[WHEEL_SIZE];
+static uint64_t wheel_bitmap[WHEEL_SIZE / 64];
+static indigo_timer *levels[LEVEL_COUNT][LEVEL_SIZE];
+static uint64_t current_tick = 0;
+static uint64_t wake_tick = UINT64_MAX;
+static int pending_count = 0;
+
+static indigo_timer *ready_head = NULL;
+static indigo_timer *ready_tail = NULL;
+static int ready_count = 0;
+static int worker_count = 0;
+static int idle_count = 0;
+static int busy_count = 0;
+
+static long fired_count = 0;
+static double total_lateness = 0;
+static double max_lateness = 0;
+static double total_duration = 0;
+static double max_duration = 0;
+
+static uint64_t monotonic_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * NANO + ts.tv_nsec;
+}
+
+static void wheel_link(indigo_timer **slot, indigo_timer *timer) {
+	timer->slot = slot;
+	timer->wheel_prev = NULL;
+	timer->wheel_next = *slot;
+	if (*slot)
+		(*slot)->wheel_prev = timer;
+	*slot = timer;
+}
+
+static void wheel_insert(indigo_timer *timer) {
+	uint64_t expires = timer->expires < current_tick ? current_tick : timer->expires;
+	uint64_t delta = expires - current_tick;
+	if (delta < WHEEL_SIZE) {
+		int index = expires & WHEEL_MASK;
+		wheel_bitmap[index / 64] |= 1ULL << (index % 64);
+		wheel_link(wheel + index, timer);
+	} else {
+		if (delta > MAX_DELTA)
+			expires = current_tick + MAX_DELTA;
+		int level = 0;
+		while (level < LEVEL_COUNT - 1 && delta >= (1ULL << LEVEL_SHIFT(level + 1)))
+			level++;
+		wheel_link(levels[level] + LEVEL_INDEX(expires, level), timer);
+	}
+}
+
+static void wheel_remove(indigo_timer *timer) {
+	if (timer->wheel_prev)
+		timer->wheel_prev->wheel_next = timer->wheel_next;
+	else
+		*timer->slot = timer->wheel_next;
+	if (timer->wheel_next)
+		timer->wheel_next->wheel_prev = timer->wheel_prev;
+	if (timer->slot >= wheel && timer->slot < wheel + WHEEL_SIZE && *timer->slot == NULL) {
+		int index = (int)(timer->slot - wheel);
+		wheel_bitmap[index / 64] &= ~(1ULL << (index % 64));
+	}
+	timer->slot = NULL;
+}
+
+static void *worker_func(void *data);
+
+static void start_worker(void) {
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, worker_func, NULL) == 0) {
+		pthread_detach(thread);
+		worker_count++;
+	} else {
+		indigo_error("Can't create timer worker thread (%s)", strerror(errno));
+	}
+}
+
+static void make_ready(indigo_timer *timer) {
+	timer->state = TIMER_READY;
+	timer->wheel_next = NULL;
+	if (ready_tail)
+		ready_tail->wheel_next = timer;
+	else
+		ready_head = timer;
+	ready_tail = timer;
+	ready_count++;
+	if (ready_count <= idle_count) {
+		pthread_cond_signal(&worker_cond);
+	} else if (worker_count < indigo_timer_pool_size) {
+		start_worker();
+	} else if (idle_count == 0) {
+		/* let scheduler check for starvation */
+		pthread_cond_signal(&scheduler_cond);
+	}
+}
+
+static void advance(uint64_t now);
+
+static void schedule(indigo_timer *timer) {
+	uint64_t now = monotonic_ns();
+	/* wheel must be up to date before timer is placed relative to current tick */
+	advance(now / TICK_NS);
+	if (timer->delay <= 0) {
+		timer->due = now;
+		make_ready(timer);
+		return;
+	}
+	timer->due = now + (uint64_t)(timer->delay * NANO);
+	timer->expires = (timer->due + TICK_NS - 1) / TICK_NS;
+	timer->state = TIMER_PENDING;
+	pending_count++;
+	wheel_insert(timer);
+	if (timer->expires < wake_tick)
+		pthread_cond_signal(&scheduler_cond);
+}
+
+static void cascade(int level, int index) {
+	indigo_timer *timer = levels[level][index];
+	levels[level][index] = NULL;
+	while (timer) {
+		indigo_timer *next = timer->wheel_next;
+		wheel_insert(timer);
+		timer = next;
+	}
+}
+
+static bool wheel_empty_from(int index) {
+	for (int i = index / 64; i < WHEEL_SIZE / 64; i++) {
+		uint64_t bits = wheel_bitmap[i];
+		if (i == index / 64)
+			bits &= ~0ULL << (index % 64);
+		if (bits)
+			return false;
+	}
+	return true;
+}
+
+static void advance(uint64_t now) {
+	if (pending_count == 0) {
+		current_tick = now + 1;
+		return;
+	}
+	while (current_tick <= now) {
+		int index = current_tick & WHEEL_MASK;
+		if (index == 0) {
+			for (int level = 0; level < LEVEL_COUNT; level++) {
+				int level_index = LEVEL_INDEX(current_tick, level);
+				cascade(level, level_index);
+				if (level_index)
+					break;
+			}
+		} else if (wheel_empty_from(index)) {
+			/* nothing to fire in this revolution, skip to the next cascade */
+			uint64_t next = (current_tick | WHEEL_MASK) + 1;
+			current_tick = next <= now ? next : now + 1;
+			continue;
+		}
+		indigo_timer *timer = wheel[index];
+		wheel[index] = NULL;
+		wheel_bitmap[index / 64] &= ~(1ULL << (index % 64));
+		while (timer) {
+			indigo_timer *next = timer->wheel_next;
+			timer->slot = NULL;
+			pending_count--;
+			make_ready(timer);
+			timer = next;
+		}
+		current_tick++;
+	}
+}
+
+static uint64_t next_wake_tick(void) {
+	if (pending_count == 0)
+		return UINT64_MAX;
+	int index = current_tick & WHEEL_MASK;
+	for (int i = index / 64; i < WHEEL_SIZE / 64; i++) {
+		uint64_t bits = wheel_bitmap[i];
+		if (i == index / 64)
+			bits &= ~0ULL << (index % 64);
+		if (bits)
+			return (current_tick & ~(uint64_t)WHEEL_MASK) + i * 64 + __builtin_ctzll(bits);
+	}
+	return (current_tick | WHEEL_MASK) + 1;
+}
+
+static void *scheduler_func(void *data) {
+	pthread_mutex_lock(&scheduler_mutex);
 	while (true) {
-		while (timer->scheduled) {
-			INDIGO_TRACE(indigo_trace("timer #%d - sleep for %gs (%p)", timer->timer_id, timer->delay, timer->reference));
-			if (timer->delay > 0) {
-				struct timespec end;
-				utc_time(&end);
-				end.tv_sec += (int)timer->delay;
-				end.tv_nsec += NANO * (timer->delay - (int)timer->delay);
-				normalize_timespec(&end);
-				while (!timer->canceled) {
-					pthread_mutex_lock(&timer->mutex);
-					int rc = pthread_cond_timedwait(&timer->cond, &timer->mutex, &end);
-					pthread_mutex_unlock(&timer->mutex);
-					if (rc == ETIMEDOUT)
-						break;
-				}
+		uint64_t now = monotonic_ns() / TICK_NS;
+		advance(now);
+		wake_tick = next_wake_tick();
+		if (ready_head && idle_count == 0) {
+			/* all workers are busy (probably blocked in long callbacks), start extra one if the oldest timer waits too long */
+			if (ready_head->due / TICK_NS + STARVATION_TICKS <= now && worker_count < MAX_WORKERS)
+				start_worker();
+			if (now + STARVATION_TICKS < wake_tick)
+				wake_tick = now + STARVATION_TICKS;
+		}
+		if (wake_tick == UINT64_MAX) {
+			pthread_cond_wait(&scheduler_cond, &scheduler_mutex);
+		} else {
+#if defined(INDIGO_MACOS)
+			uint64_t start = monotonic_ns();
+			uint64_t end = wake_tick * TICK_NS;
+			if (end > start) {
+				struct timespec delay = { (end - start) / NANO, (end - start) % NANO };
+				pthread_cond_timedwait_relative_np(&scheduler_cond, &scheduler_mutex, &delay);
 			}
+#else
+			struct timespec end = { wake_tick * TICK_NS / NANO, wake_tick * TICK_NS % NANO };
+			pthread_cond_timedwait(&scheduler_cond, &scheduler_mutex, &end);
+#endif
+		}
+	}
+	return NULL;
+}
 
-			timer->scheduled = false;
-			if (!timer->canceled) {
-				pthread_mutex_lock(&timer->callback_mutex);
-				timer->callback_running = true;
-				INDIGO_TRACE(indigo_trace("timer #%d - callback %p started (%p)", timer->timer_id, timer->callback, timer->reference));
-				if (timer->data)
-					((indigo_timer_with_data_callback)timer->callback)(timer->device, timer->data);
-				else
-					((indigo_timer_callback)timer->callback)(timer->device);
-				timer->callback_running = false;
-				if (!timer->scheduled && timer->reference)
-					*timer->reference = NULL;
-				INDIGO_TRACE(indigo_trace("timer #%d - callback %p finished (%p)", timer->timer_id, timer->callback, timer->reference));
-				pthread_mutex_unlock(&timer->callback_mutex);
-			} else {
-				if (timer->reference)
-					*timer->reference = NULL;
-				INDIGO_TRACE(indigo_trace("timer #%d - canceled", timer->timer_id));
+static void start_scheduler(void) {
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+#if !defined(INDIGO_MACOS)
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+#endif
+	pthread_cond_init(&scheduler_cond, &attr);
+	pthread_cond_init(&worker_cond, &attr);
+	pthread_condattr_destroy(&attr);
+	current_tick = monotonic_ns() / TICK_NS;
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, scheduler_func, NULL) == 0)
+		pthread_detach(thread);
+	else
+		indigo_error("Can't create timer scheduler thread (%s)", strerror(errno));
+}
+
+static void unlink_device_timer(indigo_timer *timer) {
+	indigo_device *device = timer->device;
+	if (device != NULL && DEVICE_CONTEXT != NULL) {
+		indigo_timer **previous = &DEVICE_CONTEXT->timers;
+		while (*previous) {
+			if (*previous == timer) {
+				*previous = timer->next;
+				break;
 			}
+			previous = &(*previous)->next;
 		}
+	}
+}
 
-		INDIGO_TRACE(indigo_trace("timer #%d - done", timer->timer_id));
+static void release_timer(indigo_timer *timer) {
+	INDIGO_TRACE(indigo_trace("timer #%d - done", timer->timer_id));
+	pthread_mutex_lock(&free_timer_mutex);
+	timer->state = TIMER_IDLE;
+	timer->next = free_timer;
+	free_timer = timer;
+	pthread_mutex_unlock(&free_timer_mutex);
+	INDIGO_TRACE(indigo_trace("timer #%d - released", timer->timer_id));
+}
 
-		pthread_mutex_lock(&cancel_timer_mutex);
-		indigo_device *device = timer->device;
-		if (device != NULL) {
-			if (DEVICE_CONTEXT->timers == timer) {
-				DEVICE_CONTEXT->timers = timer->next;
-			} else {
-				indigo_timer *previous = DEVICE_CONTEXT->timers;
-				while (previous->next != NULL) {
-					if (previous->next == timer) {
-						previous->next = timer->next;
-						break;
-					}
-					previous = previous->next;
+static void run_timer(indigo_timer *timer) {
+	timer->scheduled = false;
+	if (!timer->canceled) {
+		pthread_mutex_lock(&timer->callback_mutex);
+		timer->callback_running = true;
+		INDIGO_TRACE(indigo_trace("timer #%d - callback %p started (%p)", timer->timer_id, timer->callback, timer->reference));
+		if (timer->data)
+			((indigo_timer_with_data_callback)timer->callback)(timer->device, timer->data);
+		else
+			((indigo_timer_callback)timer->callback)(timer->device);
+		timer->callback_running = false;
+		if (!timer->scheduled && timer->reference)
+			*timer->reference = NULL;
+		INDIGO_TRACE(indigo_trace("timer #%d - callback %p finished (%p)", timer->timer_id, timer->callback, timer->reference));
+		pthread_mutex_unlock(&timer->callback_mutex);
+	} else {
+		if (timer->reference)
+			*timer->reference = NULL;
+		INDIGO_TRACE(indigo_trace("timer #%d - canceled", timer->timer_id));
+	}
+	pthread_mutex_lock(&scheduler_mutex);
+	if (timer->scheduled && !timer->canceled) {
+		INDIGO_TRACE(indigo_trace("timer #%d - sleep for %gs (%p)", timer->timer_id, timer->delay, timer->reference));
+		schedule(timer);
+		pthread_mutex_unlock(&scheduler_mutex);
+		return;
+	}
+	timer->state = TIMER_IDLE;
+	pthread_mutex_unlock(&scheduler_mutex);
+	pthread_mutex_lock(&cancel_timer_mutex);
+	unlink_device_timer(timer);
+	pthread_mutex_unlock(&cancel_timer_mutex);
+	release_timer(timer);
+}
+
+static void *worker_func(void *data) {
+	pthread_mutex_lock(&scheduler_mutex);
+	while (true) {
+		while (ready_head == NULL) {
+			idle_count++;
+			if (worker_count > indigo_timer_pool_size) {
+				/* idle timeout is measured on CLOCK_MONOTONIC too, so wall-clock step doesn't stop or keep extra workers */
+#if defined(INDIGO_MACOS)
+				struct timespec delay = { WORKER_IDLE_TIMEOUT, 0 };
+				int rc = pthread_cond_timedwait_relative_np(&worker_cond, &scheduler_mutex, &delay);
+#else
+				struct timespec end;
+				clock_gettime(CLOCK_MONOTONIC, &end);
+				end.tv_sec += WORKER_IDLE_TIMEOUT;
+				int rc = pthread_cond_timedwait(&worker_cond, &scheduler_mutex, &end);
+#endif
+				idle_count--;
+				if (rc == ETIMEDOUT && ready_head == NULL && worker_count > indigo_timer_pool_size) {
+					worker_count--;
+					pthread_mutex_unlock(&scheduler_mutex);
+					return NULL;
 				}
+			} else {
+				pthread_cond_wait(&worker_cond, &scheduler_mutex);
+				idle_count--;
 			}
 		}
-		pthread_mutex_unlock(&cancel_timer_mutex);
-
-		pthread_mutex_lock(&free_timer_mutex);
-		timer->next = free_timer;
-		free_timer = timer;
-		timer->wake = false;
-		pthread_mutex_unlock(&free_timer_mutex);
-
-		INDIGO_TRACE(indigo_trace("timer #%d - released", timer->timer_id));
-		
-		pthread_mutex_lock(&timer->mutex);
-		while (!timer->wake)
-			pthread_cond_wait(&timer->cond, &timer->mutex);
-		pthread_mutex_unlock(&timer->mutex);
+		indigo_timer *timer = ready_head;
+		if ((ready_head = timer->wheel_next) == NULL)
+			ready_tail = NULL;
+		ready_count--;
+		timer->state = TIMER_RUNNING;
+		busy_count++;
+		uint64_t start = monotonic_ns();
+		double lateness = start > timer->due ? (double)(start - timer->due) / NANO : 0;
+		total_lateness += lateness;
+		if (lateness > max_lateness)
+			max_lateness = lateness;
+		pthread_mutex_unlock(&scheduler_mutex);
+		run_timer(timer);
+		double duration = (double)(monotonic_ns() - start) / NANO;
+		pthread_mutex_lock(&scheduler_mutex);
+		busy_count--;
+		fired_count++;
+		total_duration += duration;
+		if (duration > max_duration)
+			max_duration = duration;
 	}
 	return NULL;
 }
@@ -158,55 +444,40 @@ bool indigo_set_timer_with_data(indigo_device *device, double delay, indigo_time
 			delay = 0;
 		}
 	}
+	pthread_once(&scheduler_once, start_scheduler);
 	pthread_mutex_lock(&free_timer_mutex);
 	if (free_timer != NULL) {
 		t = free_timer;
-		INDIGO_TRACE(indigo_trace("timer #%d - reusing (%p)", t->timer_id, t));
 		free_timer = free_timer->next;
-		t->wake = true;
-		t->callback_running = false;
-		t->canceled = false;
-		t->scheduled = true;
-		t->delay = delay;
-		if ((t->device = device) != NULL) {
-			t->next = DEVICE_CONTEXT->timers;
-			DEVICE_CONTEXT->timers = t;
-		} else {
-			t->next = NULL;
-		}
-		t->callback = callback;
-		t->data = data;
-		pthread_mutex_lock(&t->mutex);
-		pthread_cond_signal(&t->cond);
-		pthread_mutex_unlock(&t->mutex);
+		INDIGO_TRACE(indigo_trace("timer #%d - reusing (%p)", t->timer_id, t));
 	} else {
 		t = indigo_safe_malloc(sizeof(indigo_timer));
 		t->timer_id = timer_count++;
 		INDIGO_TRACE(indigo_trace("timer #%d - allocating (%p)", t->timer_id, t));
-		pthread_mutex_init(&t->mutex, NULL);
 		pthread_mutex_init(&t->callback_mutex, NULL);
-		pthread_cond_init(&t->cond, NULL);
-		t->canceled = false;
-		t->callback_running = false;
-		t->scheduled = true;
-		if ((t->device = device) != NULL) {
-			t->next = DEVICE_CONTEXT->timers;
-			DEVICE_CONTEXT->timers = t;
-		} else {
-			t->next = NULL;
-		}
-		t->delay = delay;
-		t->callback = callback;
-		t->data = data;
-		pthread_create(&t->thread, NULL, (void * (*)(void*))timer_func, t);
 	}
-	if (timer) {
-		t->reference = timer;
+	pthread_mutex_unlock(&free_timer_mutex);
+	t->callback_running = false;
+	t->canceled = false;
+	t->scheduled = true;
+	t->delay = delay;
+	t->callback = callback;
+	t->data = data;
+	t->reference = timer;
+	if (timer)
 		*timer = t;
+	pthread_mutex_lock(&cancel_timer_mutex);
+	if ((t->device = device) != NULL) {
+		t->next = DEVICE_CONTEXT->timers;
+		DEVICE_CONTEXT->timers = t;
 	} else {
-		t->reference = NULL;
+		t->next = NULL;
 	}
-	pthread_mutex_unlock(&free_timer_mutex);
+	pthread_mutex_unlock(&cancel_timer_mutex);
+	INDIGO_TRACE(indigo_trace("timer #%d - sleep for %gs (%p)", t->timer_id, t->delay, t->reference));
+	pthread_mutex_lock(&scheduler_mutex);
+	schedule(t);
+	pthread_mutex_unlock(&scheduler_mutex);
 	return true;
 }
 
@@ -241,6 +512,27 @@ bool indigo_reschedule_timer_with_callback(indigo_device *device, double delay,
 	return result;
 }
 
+/* remove pending timer from the wheel, must be called with cancel_timer_mutex locked, returns true if timer was released */
+
+static bool cancel_pending_timer(indigo_timer *timer) {
+	pthread_mutex_lock(&scheduler_mutex);
+	bool pending = timer->state == TIMER_PENDING;
+	if (pending) {
+		wheel_remove(timer);
+		pending_count--;
+		timer->state = TIMER_IDLE;
+	}
+	pthread_mutex_unlock(&scheduler_mutex);
+	if (pending) {
+		INDIGO_TRACE(indigo_trace("timer #%d - canceled", timer->timer_id));
+		if (timer->reference)
+			*timer->reference = NULL;
+		unlink_device_timer(timer);
+		release_timer(timer);
+	}
+	return pending;
+}
+
 // TODO: do we need device?
 
 bool indigo_cancel_timer(indigo_device *device, indigo_timer **timer) {
@@ -254,9 +546,7 @@ bool indigo_cancel_timer(indigo_device *device, indigo_timer **timer) {
 			(*timer)->canceled = true;
 			(*timer)->scheduled = false;
 			(*timer)->reference = NULL; // as far as it is cancel and forget we can't clear reference by timer_func
-			pthread_mutex_lock(&(*timer)->mutex);
-			pthread_cond_signal(&(*timer)->cond);
-			pthread_mutex_unlock(&(*timer)->mutex);
+			cancel_pending_timer(*timer);
 			*timer = NULL;
 			result = true;
 		}
@@ -276,13 +566,15 @@ bool indigo_cancel_timer_sync(indigo_device *device, indigo_timer **timer) {
 			INDIGO_TRACE(indigo_trace("timer #%d - cancel requested", (*timer)->timer_id));
 			(*timer)->canceled = true;
 			(*timer)->scheduled = false;
-      timer_buffer = *timer;
-      must_wait = true;
-			pthread_mutex_lock(&(*timer)->mutex);
-			pthread_cond_signal(&(*timer)->cond);
-			pthread_mutex_unlock(&(*timer)->mutex);
 			/* Save a local copy of the timer instance as *timer can be set
-			 to NULL by *timer_func() after cancel_timer_mutex is released */
+			 to NULL by run_timer() after cancel_timer_mutex is released */
+			timer_buffer = *timer;
+			must_wait = !cancel_pending_timer(timer_buffer);
+			if (!must_wait) {
+				*timer = NULL;
+				pthread_mutex_unlock(&cancel_timer_mutex);
+				return true;
+			}
 		}
 	}
 	pthread_mutex_unlock(&cancel_timer_mutex);
@@ -311,3 +603,18 @@ void indigo_cancel_all_timers(indigo_device *device) {
 		indigo_cancel_timer_sync(device, &timer);
 	}
 }
+
+void indigo_get_timer_stats(indigo_timer_stats *stats) {
+	pthread_mutex_lock(&scheduler_mutex);
+	stats->allocated = timer_count;
+	stats->pending = pending_count;
+	stats->ready = ready_count;
+	stats->workers = worker_count;
+	stats->busy_workers = busy_count;
+	stats->fired = fired_count;
+	stats->max_lateness = max_lateness;
+	stats->avg_lateness = fired_count ? total_lateness / fired_count : 0;
+	stats->max_duration = max_duration;
+	stats->avg_duration = fired_count ? total_duration / fired_count : 0;
+	pthread_mutex_unlock(&scheduler_mutex);
+}
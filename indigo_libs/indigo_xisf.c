@@ -0,0 +1,300 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO XISF block compression
+ \file indigo_xisf.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <zlib.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_parallel.h>
+#include <indigo/indigo_xisf.h>
+
+#define XISF_SIGNATURE				"XISF0100"
+#define XISF_BLOCK_ALIGNMENT	2880
+
+// LZ4 block format encoder
+
+#define LZ4_MIN_MATCH			4
+#define LZ4_LAST_LITERALS	5
+#define LZ4_MF_LIMIT			12
+#define LZ4_MAX_OFFSET		65535
+#define LZ4_HASH_LOG			16
+#define LZ4_HC_ATTEMPTS		64
+
+static inline uint32_t lz4_read32(const uint8_t *data) {
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static inline uint32_t lz4_hash(const uint8_t *data) {
+	return (lz4_read32(data) * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+static inline uint8_t *lz4_length(uint8_t *output, long length) {
+	for (; length >= 255; length -= 255)
+		*output++ = 255;
+	*output++ = (uint8_t)length;
+	return output;
+}
+
+static uint8_t *lz4_sequence(uint8_t *output, const uint8_t *end, const uint8_t *literals, long literal_length, long offset, long match_length) {
+	if (output + 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1 > end)
+		return NULL;
+	uint8_t *token = output++;
+	*token = (uint8_t)((literal_length < 15 ? literal_length : 15) << 4);
+	if (literal_length >= 15)
+		output = lz4_length(output, literal_length - 15);
+	memcpy(output, literals, literal_length);
+	output += literal_length;
+	if (match_length > 0) {
+		*output++ = (uint8_t)offset;
+		*output++ = (uint8_t)(offset >> 8);
+		match_length -= LZ4_MIN_MATCH;
+		*token |= match_length < 15 ? match_length : 15;
+		if (match_length >= 15)
+			output = lz4_length(output, match_length - 15);
+	}
+	return output;
+}
+
+/* greedy parser, fast encoder probes single position per hash and skips faster over incompressible data, HC encoder searches hash chains */
+
+static long lz4_compress(const uint8_t *data, long size, uint8_t *output, long capacity, bool hc) {
+	int32_t *head = malloc(sizeof(int32_t) << LZ4_HASH_LOG);
+	uint16_t *chain = hc ? malloc(sizeof(uint16_t) * (LZ4_MAX_OFFSET + 1)) : NULL;
+	if (head == NULL || (hc && chain == NULL)) {
+		free(head);
+		free(chain);
+		return -1;
+	}
+	memset(head, 0xFF, sizeof(int32_t) << LZ4_HASH_LOG);
+	const uint8_t *end = output + capacity;
+	uint8_t *current = output;
+	long anchor = 0, position = 0, inserted = 0, misses = 0;
+	while (current != NULL && position + LZ4_MF_LIMIT <= size && size > LZ4_MF_LIMIT) {
+		for (; hc && inserted < position; inserted++) {
+			uint32_t hash = lz4_hash(data + inserted);
+			long delta = inserted - head[hash];
+			chain[inserted & LZ4_MAX_OFFSET] = head[hash] < 0 || delta > LZ4_MAX_OFFSET ? 0 : (uint16_t)delta;
+			head[hash] = (int32_t)inserted;
+		}
+		uint32_t hash = lz4_hash(data + position);
+		long candidate = head[hash], best_length = 0, best_offset = 0;
+		for (int attempt = 0; candidate >= 0 && position - candidate <= LZ4_MAX_OFFSET && attempt < (hc ? LZ4_HC_ATTEMPTS : 1); attempt++) {
+			if (lz4_read32(data + candidate) == lz4_read32(data + position)) {
+				long length = LZ4_MIN_MATCH;
+				while (position + length < size - LZ4_LAST_LITERALS && data[candidate + length] == data[position + length])
+					length++;
+				if (length > best_length) {
+					best_length = length;
+					best_offset = position - candidate;
+				}
+			}
+			if (!hc || chain[candidate & LZ4_MAX_OFFSET] == 0)
+				break;
+			candidate -= chain[candidate & LZ4_MAX_OFFSET];
+		}
+		if (hc) {
+			long delta = position - head[hash];
+			chain[position & LZ4_MAX_OFFSET] = head[hash] < 0 || delta > LZ4_MAX_OFFSET ? 0 : (uint16_t)delta;
+			inserted = position + 1;
+		}
+		head[hash] = (int32_t)position;
+		if (best_length == 0) {
+			position += hc ? 1 : 1 + (misses++ >> 6);
+			continue;
+		}
+		current = lz4_sequence(current, end, data + anchor, position - anchor, best_offset, best_length);
+		position += best_length;
+		anchor = position;
+		misses = 0;
+	}
+	if (current != NULL)
+		current = lz4_sequence(current, end, data + anchor, size - anchor, 0, 0);
+	free(head);
+	free(chain);
+	return current == NULL ? -1 : current - output;
+}
+
+static long zlib_compress(const uint8_t *data, long size, uint8_t *output, long capacity) {
+	uLongf length = (uLongf)capacity;
+	if (compress2(output, &length, data, (uLong)size, Z_DEFAULT_COMPRESSION) != Z_OK)
+		return -1;
+	return (long)length;
+}
+
+// parallel shuffling and compression
+
+typedef struct {
+	const uint8_t *data;
+	long size;
+	int item_size;
+	uint8_t *shuffled;
+	indigo_xisf_codec codec;
+	uint8_t *output;
+	long capacity;
+	long *sizes;
+} block_compression;
+
+/* byte j of item i goes to j * items + i, remaining bytes that do not form complete item are kept at the end */
+
+static void shuffle_items(block_compression *job, int start, int end) {
+	long items = job->size / job->item_size;
+	long first = (long)start * INDIGO_XISF_SUBBLOCK_SIZE / job->item_size, last = (long)end * INDIGO_XISF_SUBBLOCK_SIZE / job->item_size;
+	if (last > items)
+		last = items;
+	for (int j = 0; j < job->item_size; j++) {
+		const uint8_t *input = job->data + j;
+		uint8_t *output = job->shuffled + j * items;
+		for (long i = first; i < last; i++)
+			output[i] = input[i * job->item_size];
+	}
+	if (last == items)
+		memcpy(job->shuffled + items * job->item_size, job->data + items * job->item_size, job->size - items * job->item_size);
+}
+
+static void compress_subblocks(block_compression *job, int start, int end) {
+	const uint8_t *data = job->shuffled ? job->shuffled : job->data;
+	for (int subblock = start; subblock < end; subblock++) {
+		long offset = (long)subblock * INDIGO_XISF_SUBBLOCK_SIZE;
+		long size = job->size - offset < INDIGO_XISF_SUBBLOCK_SIZE ? job->size - offset : INDIGO_XISF_SUBBLOCK_SIZE;
+		uint8_t *output = job->output + subblock * job->capacity;
+		if (job->codec == INDIGO_XISF_ZLIB)
+			job->sizes[subblock] = zlib_compress(data + offset, size, output, job->capacity);
+		else
+			job->sizes[subblock] = lz4_compress(data + offset, size, output, job->capacity, job->codec == INDIGO_XISF_LZ4HC);
+	}
+}
+
+static int sample_size(const char *header, const char *header_end) {
+	const char *format = strstr(header, "sampleFormat='");
+	if (format == NULL || format > header_end)
+		return 1;
+	format += 14;
+	if (!strncmp(format, "UInt16", 6) || !strncmp(format, "Int16", 5))
+		return 2;
+	if (!strncmp(format, "UInt32", 6) || !strncmp(format, "Int32", 5) || !strncmp(format, "Float32", 7))
+		return 4;
+	if (!strncmp(format, "UInt64", 6) || !strncmp(format, "Int64", 5) || !strncmp(format, "Float64", 7))
+		return 8;
+	return 1;
+}
+
+indigo_blob_buffer *indigo_xisf_compress(const void *xisf, long size, indigo_xisf_codec codec, bool shuffle) {
+	const char *header = (const char *)xisf + 16;
+	if (size < 16 || memcmp(xisf, XISF_SIGNATURE, 8))
+		return NULL;
+	const uint8_t *length_bytes = (const uint8_t *)xisf + 8;
+	long header_length = length_bytes[0] | length_bytes[1] << 8 | length_bytes[2] << 16 | (long)length_bytes[3] << 24;
+	if (16 + header_length > size)
+		return NULL;
+	/* header is copied to make sure it is terminated */
+	char *source = indigo_safe_malloc(header_length + 1);
+	memcpy(source, header, header_length);
+	const char *source_end = source + header_length;
+	char *location = strstr(source, "location='attachment:");
+	long position = 0, block_size = 0;
+	if (location == NULL || strstr(source, "compression='") != NULL || sscanf(location + 21, "%ld:%ld", &position, &block_size) != 2 || position < 16 + header_length || position + block_size > size || block_size <= 0) {
+		indigo_safe_free(source);
+		return NULL;
+	}
+	const char *location_end = strchr(location + 21, '\'');
+	block_compression job = { (const uint8_t *)xisf + position, block_size, shuffle ? sample_size(source, source_end) : 1, NULL, codec };
+	int subblocks = (int)((block_size + INDIGO_XISF_SUBBLOCK_SIZE - 1) / INDIGO_XISF_SUBBLOCK_SIZE);
+	long subblock_size = block_size < INDIGO_XISF_SUBBLOCK_SIZE ? block_size : INDIGO_XISF_SUBBLOCK_SIZE;
+	job.capacity = codec == INDIGO_XISF_ZLIB ? (long)compressBound((uLong)subblock_size) : subblock_size + subblock_size / 255 + 16;
+	job.output = malloc(job.capacity * subblocks);
+	if (job.item_size > 1)
+		job.shuffled = malloc(block_size);
+	if (job.output == NULL || (job.item_size > 1 && job.shuffled == NULL)) {
+		free(job.output);
+		free(job.shuffled);
+		indigo_safe_free(source);
+		return NULL;
+	}
+	job.sizes = indigo_safe_malloc(subblocks * sizeof(long));
+	if (job.shuffled)
+		indigo_parallel_for(subblocks, (void (*)(void *, int, int))shuffle_items, &job);
+	indigo_parallel_for(subblocks, (void (*)(void *, int, int))compress_subblocks, &job);
+	long compressed_size = 0;
+	for (int subblock = 0; subblock < subblocks; subblock++) {
+		if (job.sizes[subblock] < 0) {
+			compressed_size = -1;
+			break;
+		}
+		compressed_size += job.sizes[subblock];
+	}
+	indigo_blob_buffer *buffer = NULL;
+	if (compressed_size > 0) {
+		char *attributes = indigo_safe_malloc(128 + subblocks * 48L), *attribute = attributes;
+		static const char *codecs[] = { NULL, "zlib", "lz4", "lz4hc" };
+		attribute += sprintf(attribute, " compression='%s%s:%ld", codecs[codec], job.item_size > 1 ? "+sh" : "", block_size);
+		if (job.item_size > 1)
+			attribute += sprintf(attribute, ":%d", job.item_size);
+		attribute += sprintf(attribute, "' subblocks='");
+		for (int subblock = 0; subblock < subblocks; subblock++) {
+			long uncompressed = block_size - (long)subblock * INDIGO_XISF_SUBBLOCK_SIZE;
+			attribute += sprintf(attribute, "%s%ld,%ld", subblock ? ":" : "", job.sizes[subblock], uncompressed < INDIGO_XISF_SUBBLOCK_SIZE ? uncompressed : INDIGO_XISF_SUBBLOCK_SIZE);
+		}
+		strcpy(attribute, "'");
+		/* length of location attribute depends on aligned position of attachment and vice versa */
+		long prefix_length = location + 21 - source, suffix_length = source_end - location_end - 1;
+		long new_position = XISF_BLOCK_ALIGNMENT, new_length;
+		char location_value[64];
+		while (true) {
+			snprintf(location_value, sizeof(location_value), "%ld:%ld'", new_position, compressed_size);
+			new_length = prefix_length + strlen(location_value) + strlen(attributes) + suffix_length;
+			if (16 + new_length <= new_position)
+				break;
+			new_position = (16 + new_length + XISF_BLOCK_ALIGNMENT - 1) / XISF_BLOCK_ALIGNMENT * XISF_BLOCK_ALIGNMENT;
+		}
+		buffer = indigo_create_blob_buffer(new_position + compressed_size);
+		uint8_t *data = buffer->data;
+		memset(data, 0, new_position);
+		memcpy(data, XISF_SIGNATURE, 8);
+		for (int i = 0; i < 4; i++)
+			data[8 + i] = (uint8_t)(new_length >> (8 * i));
+		char *target = (char *)data + 16;
+		memcpy(target, source, prefix_length);
+		target += prefix_length;
+		target += sprintf(target, "%s%s", location_value, attributes);
+		memcpy(target, location_end + 1, suffix_length);
+		data += new_position;
+		for (int subblock = 0; subblock < subblocks; subblock++) {
+			memcpy(data, job.output + subblock * job.capacity, job.sizes[subblock]);
+			data += job.sizes[subblock];
+		}
+		indigo_safe_free(attributes);
+	}
+	free(job.output);
+	free(job.shuffled);
+	indigo_safe_free(job.sizes);
+	indigo_safe_free(source);
+	return buffer;
+}
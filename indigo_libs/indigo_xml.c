@@ -37,6 +37,7 @@
 
 #if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
 #include <unistd.h>
+#include <poll.h>
 #endif
 #if defined(INDIGO_WINDOWS)
 #include <io.h>
@@ -51,8 +52,13 @@
 #include <indigo/indigo_io.h>
 #include <indigo/indigo_version.h>
 #include <indigo/indigo_names.h>
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+#include <indigo/indigo_queue.h>
+#endif
 
 #define BUFFER_SIZE 524288  /* BUFFER_SIZE % 4 == 0, inportant for base64 */
+#define MIN_BUFFER_SIZE 4096  /* initial size of parser buffers, they grow up to BUFFER_SIZE on demand and shrink back when connection is idle */
+#define MIN_PREALLOCATED_COUNT 16
 
 typedef enum PARSE_STATES {
 	ERROR,
@@ -130,9 +136,11 @@ typedef struct {
 	int count;
 	indigo_property **properties;
 	pthread_mutex_t mutex;
+	double rate;
 } parser_context;
 
 bool indigo_use_blob_urls = true;
+int indigo_xml_idle_timeout = 5000;
 
 typedef void *(* parser_handler)(parser_state state, parser_context *context, char *name, char *value, char *message);
 
@@ -234,8 +242,15 @@ static void *get_properties_handler(parser_state state, parser_context *context,
 			indigo_copy_property_name(client->version, property, value);;
 		} else if (!strcmp(name, "client")) {
 			indigo_copy_name(client->name, value);
+		} else if (!strcmp(name, "rate")) {
+			context->rate = indigo_atod(value);
 		}
 	} else if (state == END_TAG) {
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+		indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+		if (context->rate >= 0 && client_context != NULL && client_context->queue != NULL)
+			indigo_queue_set_update_rate(client_context->queue, property->device, property->name, context->rate);
+#endif
 		indigo_enumerate_properties(client, property);
 		indigo_clear_property(property);
 		return top_level_handler;
@@ -1236,8 +1251,10 @@ static void *top_level_handler(parser_state state, parser_context *context, char
 		*message = 0;
 		if (!strcmp(name, "enableBLOB"))
 			return enable_blob_handler;
-		if (!strcmp(name, "getProperties") && client != NULL)
+		if (!strcmp(name, "getProperties") && client != NULL) {
+			context->rate = -1;
 			return get_properties_handler;
+		}
 		if (!strcmp(name, "newTextVector")) {
 			property->type = INDIGO_TEXT_VECTOR;
 			return new_text_vector_handler;
@@ -1304,14 +1321,27 @@ static void *top_level_handler(parser_state state, parser_context *context, char
 	return top_level_handler;
 }
 
+/* Double value buffer size up to BUFFER_SIZE, pointer into the buffer is moved accordingly */
+
+static bool grow_value_buffer(char **value_buffer, long *value_size, char **value_pointer) {
+	if (*value_size >= BUFFER_SIZE)
+		return false;
+	long offset = *value_pointer - *value_buffer;
+	*value_size *= 2;
+	*value_buffer = indigo_safe_realloc(*value_buffer, *value_size + 1);
+	*value_pointer = *value_buffer + offset;
+	return true;
+}
+
 void indigo_xml_parse(indigo_device *device, indigo_client *client) {
-	char *buffer = indigo_safe_malloc(BUFFER_SIZE + 3); /* BUFFER_SIZE % 4 == 0 and keep always +3 for base64 alignmet */
-	char *value_buffer = indigo_safe_malloc(BUFFER_SIZE + 1); /* +1 to accomodate \0" */
+	long buffer_size = MIN_BUFFER_SIZE, value_size = MIN_BUFFER_SIZE;
+	char *buffer = indigo_safe_malloc(buffer_size + 3); /* buffer_size % 4 == 0 and keep always +3 for base64 alignmet */
+	char *value_buffer = indigo_safe_malloc(value_size + 1); /* +1 to accomodate \0" */
 	char *name_buffer = indigo_safe_malloc(INDIGO_NAME_SIZE);
 	char *message = indigo_safe_malloc(INDIGO_VALUE_SIZE);
 	unsigned char *blob_buffer = NULL;
 	char *pointer = buffer;
-	char *buffer_end = NULL;
+	char *buffer_end = buffer;
 	char *name_pointer = name_buffer;
 	char *value_pointer = value_buffer;
 	unsigned char *blob_pointer = NULL;
@@ -1340,8 +1370,8 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 		context->properties = NULL;
 	}
 
-	context->property = indigo_safe_malloc(sizeof(indigo_property) + INDIGO_PREALLOCATED_COUNT * sizeof(indigo_item));
-	context->property->allocated_count = INDIGO_PREALLOCATED_COUNT;
+	context->property = indigo_safe_malloc(sizeof(indigo_property) + MIN_PREALLOCATED_COUNT * sizeof(indigo_item));
+	context->property->allocated_count = MIN_PREALLOCATED_COUNT;
 
 	int handle = 0;
 	if (device != NULL) {
@@ -1352,18 +1382,41 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 	}
 	*pointer = 0;
 	while (true) {
-		assert(pointer - buffer <= BUFFER_SIZE);
-		assert(value_pointer - value_buffer <= BUFFER_SIZE);
+		assert(pointer - buffer <= buffer_size);
+		assert(value_pointer - value_buffer <= value_size);
 		assert(name_pointer - name_buffer <= INDIGO_NAME_SIZE);
 		if (state == ERROR) {
 			indigo_error("XML Parser: syntax error");
 			goto exit_loop;
 		}
 		while ((c = *pointer++) == 0) {
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+			if (indigo_xml_idle_timeout > 0 && depth == 0 && (buffer_size > MIN_BUFFER_SIZE || value_size > MIN_BUFFER_SIZE || blob_buffer != NULL || context->property->allocated_count > MIN_PREALLOCATED_COUNT)) {
+				struct pollfd fd = { handle, POLLIN, 0 };
+				if (poll(&fd, 1, indigo_xml_idle_timeout) == 0) {
+					/* connection is idle between messages, shrink buffers back to initial size */
+					INDIGO_TRACE_PARSER(indigo_trace("XML Parser: %d is idle, shrinking buffers", handle));
+					buffer_end = pointer = buffer = indigo_safe_realloc(buffer, (buffer_size = MIN_BUFFER_SIZE) + 3);
+					*pointer = 0;
+					value_pointer = value_buffer = indigo_safe_realloc(value_buffer, (value_size = MIN_BUFFER_SIZE) + 1);
+					indigo_safe_free(blob_buffer);
+					blob_buffer = NULL;
+					if (context->property->allocated_count > MIN_PREALLOCATED_COUNT && context->property->count <= MIN_PREALLOCATED_COUNT) {
+						context->property = indigo_safe_realloc(context->property, sizeof(indigo_property) + MIN_PREALLOCATED_COUNT * sizeof(indigo_item));
+						context->property->allocated_count = MIN_PREALLOCATED_COUNT;
+					}
+				}
+			}
+#endif
+			if (buffer_end - buffer == buffer_size && buffer_size < BUFFER_SIZE) {
+				/* last read filled the buffer, read more at once */
+				buffer_size *= 2;
+				buffer = indigo_safe_realloc(buffer, buffer_size + 3);
+			}
 #if defined(INDIGO_WINDOWS)
-			ssize_t count = indigo_recv(handle, (void *)buffer, (ssize_t)BUFFER_SIZE);
+			ssize_t count = indigo_recv(handle, (void *)buffer, (ssize_t)buffer_size);
 #else
-			ssize_t count = (int)read(handle, (void *)buffer, (ssize_t)BUFFER_SIZE);
+			ssize_t count = (int)read(handle, (void *)buffer, (ssize_t)buffer_size);
 #endif
 			if (count <= 0) {
 				goto exit_loop;
@@ -1513,7 +1566,7 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 					break;
 				} else {
 					if (depth == 2 || handler == enable_blob_handler) {
-						if (value_pointer - value_buffer < BUFFER_SIZE) {
+						if (value_pointer - value_buffer < value_size || grow_value_buffer(&value_buffer, &value_size, &value_pointer)) {
 							*value_pointer++ = c;
 						}
 					}
@@ -1564,8 +1617,14 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 					blob_pointer += base64_decode_fast((unsigned char*)blob_pointer, (unsigned char*)pointer, len);
 					pointer += len;
 					blob_len -= len;
+					if (blob_len > buffer_size && buffer_size < BUFFER_SIZE) {
+						/* buffered data are consumed, read the rest of BLOB in larger chunks */
+						while (blob_len > buffer_size && buffer_size < BUFFER_SIZE)
+							buffer_size *= 2;
+						buffer_end = buffer = indigo_safe_realloc(buffer, buffer_size + 3);
+					}
 					while (blob_len) {
-						len = ((BUFFER_SIZE) < blob_len) ? (BUFFER_SIZE) : blob_len;
+						len = (buffer_size < blob_len) ? buffer_size : blob_len;
 						ssize_t to_read = len;
 						char *ptr = buffer;
 						while(to_read) {
@@ -1601,7 +1660,7 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 						break;
 					} else if (c != '\n') {
 						if (depth == 2) {
-							if (value_pointer - value_buffer < BUFFER_SIZE) {
+							if (value_pointer - value_buffer < value_size) {
 								*value_pointer++ = c;
 							} else {
 								*value_pointer = 0;
@@ -1681,7 +1740,9 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 					handler = handler(ATTRIBUTE_VALUE, context, name_buffer, value_buffer, message);
 					INDIGO_TRACE_PARSER(indigo_trace("XML Parser: '%c' ATTRIBUTE_VALUE -> ATTRIBUTE_NAME1", c));
 				} else {
-					*value_pointer++ = c;
+					if (value_pointer - value_buffer < value_size || grow_value_buffer(&value_buffer, &value_size, &value_pointer)) {
+						*value_pointer++ = c;
+					}
 					INDIGO_TRACE_PARSER(indigo_trace("XML Parser: '%c' ATTRIBUTE_VALUE", c));
 				}
 				break;
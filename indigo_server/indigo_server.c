@@ -44,6 +44,8 @@
 
 #include <indigo/indigo_bus.h>
 #include <indigo/indigo_io.h>
+#include <indigo/indigo_queue.h>
+#include <indigo/indigo_parallel.h>
 #include <indigo/indigo_server_tcp.h>
 #include <indigo/indigo_driver.h>
 #include <indigo/indigo_client.h>
@@ -367,6 +369,9 @@ static indigo_property *log_level_property;
 static indigo_property *blob_buffering_property;
 static indigo_property *blob_proxy_property;
 static indigo_property *server_features_property;
+static indigo_property *timers_property;
+static indigo_property *queues_property;
+static indigo_timer *statistics_timer;
 
 #ifdef RPI_MANAGEMENT
 static indigo_property *wifi_country_code_property;
@@ -427,6 +432,28 @@ static bool runLoop = true;
 #define SERVER_CTRL_PANEL_ITEM										(SERVER_FEATURES_PROPERTY->items + 1)
 #define SERVER_WEB_APPS_ITEM											(SERVER_FEATURES_PROPERTY->items + 2)
 
+#define SERVER_TIMERS_PROPERTY										timers_property
+#define SERVER_TIMERS_ALLOCATED_ITEM							(SERVER_TIMERS_PROPERTY->items + 0)
+#define SERVER_TIMERS_PENDING_ITEM								(SERVER_TIMERS_PROPERTY->items + 1)
+#define SERVER_TIMERS_READY_ITEM									(SERVER_TIMERS_PROPERTY->items + 2)
+#define SERVER_TIMERS_WORKERS_ITEM								(SERVER_TIMERS_PROPERTY->items + 3)
+#define SERVER_TIMERS_BUSY_WORKERS_ITEM						(SERVER_TIMERS_PROPERTY->items + 4)
+#define SERVER_TIMERS_AVG_LATENESS_ITEM						(SERVER_TIMERS_PROPERTY->items + 5)
+#define SERVER_TIMERS_MAX_LATENESS_ITEM						(SERVER_TIMERS_PROPERTY->items + 6)
+#define SERVER_TIMERS_AVG_DURATION_ITEM						(SERVER_TIMERS_PROPERTY->items + 7)
+#define SERVER_TIMERS_MAX_DURATION_ITEM						(SERVER_TIMERS_PROPERTY->items + 8)
+
+#define SERVER_QUEUES_PROPERTY										queues_property
+#define SERVER_QUEUES_CLIENTS_ITEM								(SERVER_QUEUES_PROPERTY->items + 0)
+#define SERVER_QUEUES_DEPTH_ITEM									(SERVER_QUEUES_PROPERTY->items + 1)
+#define SERVER_QUEUES_BYTES_ITEM									(SERVER_QUEUES_PROPERTY->items + 2)
+#define SERVER_QUEUES_MAX_DEPTH_ITEM							(SERVER_QUEUES_PROPERTY->items + 3)
+#define SERVER_QUEUES_SENT_ITEM										(SERVER_QUEUES_PROPERTY->items + 4)
+#define SERVER_QUEUES_COALESCED_ITEM							(SERVER_QUEUES_PROPERTY->items + 5)
+#define SERVER_QUEUES_DROPPED_ITEM								(SERVER_QUEUES_PROPERTY->items + 6)
+
+#define STATISTICS_INTERVAL												5
+
 #define SERVER_WIFI_AP_PROPERTY										wifi_ap_property
 #define SERVER_WIFI_AP_SSID_ITEM									(SERVER_WIFI_AP_PROPERTY->items + 0)
 #define SERVER_WIFI_AP_PASSWORD_ITEM							(SERVER_WIFI_AP_PROPERTY->items + 1)
@@ -722,6 +749,33 @@ static void *indigo_add_constellations_lines_json_resource() {
 	return data;
 }
 
+static void update_statistics(indigo_device *device) {
+	// server device has no device context, so the timer is not bound to it
+	indigo_timer_stats timer_stats;
+	indigo_get_timer_stats(&timer_stats);
+	SERVER_TIMERS_ALLOCATED_ITEM->number.value = timer_stats.allocated;
+	SERVER_TIMERS_PENDING_ITEM->number.value = timer_stats.pending;
+	SERVER_TIMERS_READY_ITEM->number.value = timer_stats.ready;
+	SERVER_TIMERS_WORKERS_ITEM->number.value = timer_stats.workers;
+	SERVER_TIMERS_BUSY_WORKERS_ITEM->number.value = timer_stats.busy_workers;
+	SERVER_TIMERS_AVG_LATENESS_ITEM->number.value = timer_stats.avg_lateness * 1000;
+	SERVER_TIMERS_MAX_LATENESS_ITEM->number.value = timer_stats.max_lateness * 1000;
+	SERVER_TIMERS_AVG_DURATION_ITEM->number.value = timer_stats.avg_duration * 1000;
+	SERVER_TIMERS_MAX_DURATION_ITEM->number.value = timer_stats.max_duration * 1000;
+	indigo_update_property(&server_device, SERVER_TIMERS_PROPERTY, NULL);
+	indigo_queue_stats queue_stats;
+	SERVER_QUEUES_CLIENTS_ITEM->number.value = indigo_queue_get_total_stats(&queue_stats);
+	SERVER_QUEUES_DEPTH_ITEM->number.value = queue_stats.depth;
+	SERVER_QUEUES_BYTES_ITEM->number.value = queue_stats.bytes;
+	SERVER_QUEUES_MAX_DEPTH_ITEM->number.value = queue_stats.max_depth;
+	SERVER_QUEUES_SENT_ITEM->number.value = queue_stats.sent;
+	SERVER_QUEUES_COALESCED_ITEM->number.value = queue_stats.coalesced;
+	SERVER_QUEUES_DROPPED_ITEM->number.value = queue_stats.dropped;
+	indigo_update_property(&server_device, SERVER_QUEUES_PROPERTY, NULL);
+	INDIGO_DEBUG(indigo_debug("Timers: %d allocated, %d pending, %d ready, %d/%d workers busy, lateness %.1f/%.1fms, duration %.1f/%.1fms (avg/max)", timer_stats.allocated, timer_stats.pending, timer_stats.ready, timer_stats.busy_workers, timer_stats.workers, timer_stats.avg_lateness * 1000, timer_stats.max_lateness * 1000, timer_stats.avg_duration * 1000, timer_stats.max_duration * 1000));
+	indigo_reschedule_timer(NULL, STATISTICS_INTERVAL, &statistics_timer);
+}
+
 #ifdef RPI_MANAGEMENT
 
 static indigo_result execute_command(indigo_device *device, indigo_property *property, char *command, ...) {
@@ -987,6 +1041,28 @@ static indigo_result attach(indigo_device *device) {
 	indigo_init_switch_item(SERVER_BONJOUR_ITEM, SERVER_BONJOUR_ITEM_NAME, "Bonjour", indigo_use_bonjour);
 	indigo_init_switch_item(SERVER_CTRL_PANEL_ITEM, SERVER_CTRL_PANEL_ITEM_NAME, "Control panel / Server manager", use_ctrl_panel);
 	indigo_init_switch_item(SERVER_WEB_APPS_ITEM, SERVER_WEB_APPS_ITEM_NAME, "Web applications", use_web_apps);
+	SERVER_TIMERS_PROPERTY = indigo_init_number_property(NULL, device->name, SERVER_TIMERS_PROPERTY_NAME, MAIN_GROUP, "Timers", INDIGO_OK_STATE, INDIGO_RO_PERM, 9);
+	indigo_init_number_item(SERVER_TIMERS_ALLOCATED_ITEM, SERVER_TIMERS_ALLOCATED_ITEM_NAME, "Allocated timers", 0, 1000000, 0, 0);
+	indigo_init_number_item(SERVER_TIMERS_PENDING_ITEM, SERVER_TIMERS_PENDING_ITEM_NAME, "Pending timers", 0, 1000000, 0, 0);
+	indigo_init_number_item(SERVER_TIMERS_READY_ITEM, SERVER_TIMERS_READY_ITEM_NAME, "Timers waiting for worker", 0, 1000000, 0, 0);
+	indigo_init_number_item(SERVER_TIMERS_WORKERS_ITEM, SERVER_TIMERS_WORKERS_ITEM_NAME, "Worker threads", 0, 1000000, 0, 0);
+	indigo_init_number_item(SERVER_TIMERS_BUSY_WORKERS_ITEM, SERVER_TIMERS_BUSY_WORKERS_ITEM_NAME, "Busy worker threads", 0, 1000000, 0, 0);
+	indigo_init_number_item(SERVER_TIMERS_AVG_LATENESS_ITEM, SERVER_TIMERS_AVG_LATENESS_ITEM_NAME, "Average lateness (ms)", 0, 1000000, 0, 0);
+	indigo_init_number_item(SERVER_TIMERS_MAX_LATENESS_ITEM, SERVER_TIMERS_MAX_LATENESS_ITEM_NAME, "Maximal lateness (ms)", 0, 1000000, 0, 0);
+	indigo_init_number_item(SERVER_TIMERS_AVG_DURATION_ITEM, SERVER_TIMERS_AVG_DURATION_ITEM_NAME, "Average callback duration (ms)", 0, 1000000, 0, 0);
+	indigo_init_number_item(SERVER_TIMERS_MAX_DURATION_ITEM, SERVER_TIMERS_MAX_DURATION_ITEM_NAME, "Maximal callback duration (ms)", 0, 1000000, 0, 0);
+	for (indigo_item *item = SERVER_TIMERS_AVG_LATENESS_ITEM; item <= SERVER_TIMERS_MAX_DURATION_ITEM; item++)
+		strcpy(item->number.format, "%.1f");
+	SERVER_QUEUES_PROPERTY = indigo_init_number_property(NULL, device->name, SERVER_QUEUES_PROPERTY_NAME, MAIN_GROUP, "Client queues", INDIGO_OK_STATE, INDIGO_RO_PERM, 7);
+	indigo_init_number_item(SERVER_QUEUES_CLIENTS_ITEM, SERVER_QUEUES_CLIENTS_ITEM_NAME, "Clients", 0, 1000000, 0, 0);
+	indigo_init_number_item(SERVER_QUEUES_DEPTH_ITEM, SERVER_QUEUES_DEPTH_ITEM_NAME, "Queued messages", 0, 1000000000, 0, 0);
+	indigo_init_number_item(SERVER_QUEUES_BYTES_ITEM, SERVER_QUEUES_BYTES_ITEM_NAME, "Queued bytes", 0, 1e15, 0, 0);
+	indigo_init_number_item(SERVER_QUEUES_MAX_DEPTH_ITEM, SERVER_QUEUES_MAX_DEPTH_ITEM_NAME, "Highest high-water mark", 0, 1000000000, 0, 0);
+	indigo_init_number_item(SERVER_QUEUES_SENT_ITEM, SERVER_QUEUES_SENT_ITEM_NAME, "Sent messages", 0, 1e15, 0, 0);
+	indigo_init_number_item(SERVER_QUEUES_COALESCED_ITEM, SERVER_QUEUES_COALESCED_ITEM_NAME, "Coalesced updates", 0, 1e15, 0, 0);
+	indigo_init_number_item(SERVER_QUEUES_DROPPED_ITEM, SERVER_QUEUES_DROPPED_ITEM_NAME, "Dropped messages", 0, 1e15, 0, 0);
+	for (int i = 0; i < SERVER_QUEUES_PROPERTY->count; i++)
+		strcpy(SERVER_QUEUES_PROPERTY->items[i].number.format, "%.0f");
 #ifdef RPI_MANAGEMENT
 	if (use_rpi_management) {
 		SERVER_WIFI_AP_PROPERTY = indigo_init_text_property(NULL, server_device.name, SERVER_WIFI_AP_PROPERTY_NAME, MAIN_GROUP, "Configure access point WiFi mode", INDIGO_OK_STATE, INDIGO_RW_PERM, 2);
@@ -1055,6 +1131,7 @@ static indigo_result attach(indigo_device *device) {
 	}
 	if (!command_line_drivers)
 		indigo_load_properties(device, false);
+	indigo_set_timer(NULL, STATISTICS_INTERVAL, update_statistics, &statistics_timer);
 	INDIGO_LOG(indigo_log("%s attached", device->name));
 	return INDIGO_OK;
 }
@@ -1072,6 +1149,8 @@ static indigo_result enumerate_properties(indigo_device *device, indigo_client *
 	indigo_define_property(device, SERVER_BLOB_BUFFERING_PROPERTY, NULL);
 	indigo_define_property(device, SERVER_BLOB_PROXY_PROPERTY, NULL);
 	indigo_define_property(device, SERVER_FEATURES_PROPERTY, NULL);
+	indigo_define_property(device, SERVER_TIMERS_PROPERTY, NULL);
+	indigo_define_property(device, SERVER_QUEUES_PROPERTY, NULL);
 #ifdef RPI_MANAGEMENT
 	if (use_rpi_management) {
 		indigo_define_property(device, SERVER_WIFI_COUNTRY_CODE_PROPERTY, NULL);
@@ -1380,6 +1459,7 @@ static indigo_result change_property(indigo_device *device, indigo_client *clien
 
 static indigo_result detach(indigo_device *device) {
 	assert(device != NULL);
+	indigo_cancel_timer_sync(NULL, &statistics_timer);
 	indigo_delete_property(device, SERVER_INFO_PROPERTY, NULL);
 	indigo_delete_property(device, SERVER_DRIVERS_PROPERTY, NULL);
 	if (SERVER_SERVERS_PROPERTY->count > 0)
@@ -1391,6 +1471,8 @@ static indigo_result detach(indigo_device *device) {
 	indigo_delete_property(device, SERVER_BLOB_BUFFERING_PROPERTY, NULL);
 	indigo_delete_property(device, SERVER_BLOB_PROXY_PROPERTY, NULL);
 	indigo_delete_property(device, SERVER_FEATURES_PROPERTY, NULL);
+	indigo_delete_property(device, SERVER_TIMERS_PROPERTY, NULL);
+	indigo_delete_property(device, SERVER_QUEUES_PROPERTY, NULL);
 #ifdef RPI_MANAGEMENT
 	if (use_rpi_management) {
 		indigo_delete_property(device, SERVER_WIFI_COUNTRY_CODE_PROPERTY, NULL);
@@ -1414,6 +1496,8 @@ static indigo_result detach(indigo_device *device) {
 	indigo_release_property(SERVER_BLOB_BUFFERING_PROPERTY);
 	indigo_release_property(SERVER_BLOB_PROXY_PROPERTY);
 	indigo_release_property(SERVER_FEATURES_PROPERTY);
+	indigo_release_property(SERVER_TIMERS_PROPERTY);
+	indigo_release_property(SERVER_QUEUES_PROPERTY);
 #ifdef RPI_MANAGEMENT
 	indigo_release_property(SERVER_WIFI_COUNTRY_CODE_PROPERTY);
 	indigo_release_property(SERVER_WIFI_AP_PROPERTY);
@@ -1557,6 +1641,41 @@ static void server_main() {
 			indigo_use_blob_compression = true;
 		} else if (!strcmp(server_argv[i], "-x") || !strcmp(server_argv[i], "--enable-blob-proxy")) {
 			indigo_proxy_blob = true;
+		} else if ((!strcmp(server_argv[i], "-q") || !strcmp(server_argv[i], "--queue-size")) && i < server_argc - 1) {
+			indigo_queue_size = atoi(server_argv[i + 1]);
+			i++;
+		} else if ((!strcmp(server_argv[i], "-qb") || !strcmp(server_argv[i], "--queue-bytes")) && i < server_argc - 1) {
+			indigo_queue_max_bytes = atol(server_argv[i + 1]);
+			i++;
+		} else if ((!strcmp(server_argv[i], "-Q") || !strcmp(server_argv[i], "--queue-overflow")) && i < server_argc - 1) {
+			indigo_queue_policy = strcmp(server_argv[i + 1], "disconnect") ? INDIGO_QUEUE_DROP_STALE : INDIGO_QUEUE_DISCONNECT;
+			i++;
+		} else if ((!strcmp(server_argv[i], "-U") || !strcmp(server_argv[i], "--update-rate")) && i < server_argc - 1) {
+			char *rate = strchr(server_argv[i + 1], '=');
+			if (rate) {
+				char property[INDIGO_NAME_SIZE];
+				indigo_copy_name(property, server_argv[i + 1]);
+				if (rate - server_argv[i + 1] < INDIGO_NAME_SIZE)
+					property[rate - server_argv[i + 1]] = 0;
+				indigo_queue_set_update_rate(NULL, NULL, property, indigo_atod(rate + 1));
+			} else {
+				indigo_queue_update_rate = indigo_atod(server_argv[i + 1]);
+			}
+			i++;
+		} else if (!strcmp(server_argv[i], "-U-") || !strcmp(server_argv[i], "--disable-update-coalescing")) {
+			indigo_queue_coalesce = false;
+		} else if ((!strcmp(server_argv[i], "-n") || !strcmp(server_argv[i], "--network-threads")) && i < server_argc - 1) {
+			indigo_server_tcp_threads = atoi(server_argv[i + 1]);
+			i++;
+		} else if ((!strcmp(server_argv[i], "-R") || !strcmp(server_argv[i], "--request-threads")) && i < server_argc - 1) {
+			indigo_server_tcp_workers = atoi(server_argv[i + 1]);
+			i++;
+		} else if ((!strcmp(server_argv[i], "-W") || !strcmp(server_argv[i], "--worker-threads")) && i < server_argc - 1) {
+			indigo_parallel_threads = atoi(server_argv[i + 1]);
+			i++;
+		} else if ((!strcmp(server_argv[i], "-t") || !strcmp(server_argv[i], "--timer-threads")) && i < server_argc - 1) {
+			indigo_timer_pool_size = atoi(server_argv[i + 1]);
+			i++;
 #ifdef RPI_MANAGEMENT
 		} else if (!strcmp(server_argv[i], "-f") || !strcmp(server_argv[i], "--enable-rpi-management")) {
 			FILE *output = popen("which s_rpi_ctrl.sh", "r");
@@ -1837,6 +1956,15 @@ int main(int argc, const char * argv[]) {
 			       "       -vvv| --enable-trace\n"
 			       "       -r  | --remote-server host[:port]     (default port: 7624)\n"
 			       "       -x  | --enable-blob-proxy\n"
+			       "       -q  | --queue-size count              (messages queued per client, default: 1024)\n"
+			       "       -qb | --queue-bytes size              (bytes queued per client, default: 268435456)\n"
+			       "       -Q  | --queue-overflow drop|disconnect (default: drop)\n"
+			       "       -U  | --update-rate [property=]rate   (max. updates per second per property and client, default: unlimited)\n"
+			       "       -U- | --disable-update-coalescing\n"
+			       "       -n  | --network-threads count         (HTTP network threads, 0 = thread per connection, default: 4)\n"
+			       "       -R  | --request-threads count         (threads serving HTTP requests and JSON sessions, default: 32)\n"
+			       "       -W  | --worker-threads count          (image processing threads, default: 0 = number of CPUs)\n"
+			       "       -t  | --timer-threads count           (timer threads kept when idle, default: 4)\n"
 			       "       -i  | --indi-driver driver_executable\n"
 			);
 			return 0;
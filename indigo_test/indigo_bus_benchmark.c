@@ -0,0 +1,117 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO Bus routing micro-benchmark
+ \file indigo_bus_benchmark.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_names.h>
+
+#define LOCAL_DEVICES		60
+#define REMOTE_DEVICES	4
+#define ITERATIONS			200000
+#define MAX_DEVICES			256
+
+static indigo_device devices[LOCAL_DEVICES + REMOTE_DEVICES];
+static indigo_device *legacy_devices[MAX_DEVICES];
+static long change_count = 0;
+
+static indigo_result change_property(indigo_device *device, indigo_client *client, indigo_property *property) {
+	change_count++;
+	return INDIGO_OK;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// routing as it was done before the device registry, linear scan over all device slots
+
+static void legacy_change_property(indigo_client *client, indigo_property *property) {
+	for (int i = 0; i < MAX_DEVICES; i++) {
+		indigo_device *device = legacy_devices[i];
+		if (device != NULL && device->change_property != NULL) {
+			bool route = *property->device == 0;
+			route = route || !strcmp(property->device, device->name);
+			route = route || (indigo_use_host_suffix && *device->name == '@' && strstr(property->device, device->name));
+			route = route || (!indigo_use_host_suffix && *device->name == '@');
+			if (route)
+				device->last_result = device->change_property(device, client, property);
+		}
+	}
+}
+
+static void run(const char *label, const char *device_name, bool legacy) {
+	indigo_property *property = indigo_init_switch_property(NULL, device_name, CONNECTION_PROPERTY_NAME, NULL, NULL, INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 1);
+	indigo_init_switch_item(property->items, CONNECTION_CONNECTED_ITEM_NAME, NULL, true);
+	change_count = 0;
+	double start = now();
+	for (int i = 0; i < ITERATIONS; i++) {
+		if (legacy)
+			legacy_change_property(NULL, property);
+		else
+			indigo_change_property(NULL, property);
+	}
+	double elapsed = now() - start;
+	printf("%-8s %-32s %10.1f ns/request %8.2f calls/request\n", legacy ? "linear" : "registry", label, 1e9 * elapsed / ITERATIONS, (double)change_count / ITERATIONS);
+	indigo_release_property(property);
+}
+
+int main(int argc, const char * argv[]) {
+	indigo_main_argc = argc;
+	indigo_main_argv = argv;
+	indigo_start();
+	for (int i = 0; i < LOCAL_DEVICES + REMOTE_DEVICES; i++) {
+		indigo_device *device = &devices[i];
+		indigo_device template = INDIGO_DEVICE_INITIALIZER("", NULL, NULL, change_property, NULL, NULL);
+		*device = template;
+		if (i < LOCAL_DEVICES) {
+			snprintf(device->name, INDIGO_NAME_SIZE, "Benchmark Device #%d", i);
+		} else {
+			snprintf(device->name, INDIGO_NAME_SIZE, "@ remote-%d.local:7624", i - LOCAL_DEVICES);
+			device->is_remote = true;
+		}
+		indigo_attach_device(device);
+		legacy_devices[i] = device;
+	}
+	char local_name[INDIGO_NAME_SIZE], remote_name[INDIGO_NAME_SIZE];
+	snprintf(local_name, sizeof(local_name), "Benchmark Device #%d", LOCAL_DEVICES - 1);
+	snprintf(remote_name, sizeof(remote_name), "CCD Imager Simulator @ remote-%d.local:7624", REMOTE_DEVICES - 1);
+	printf("%d local devices, %d remote proxies, %d requests per case\n", LOCAL_DEVICES, REMOTE_DEVICES, ITERATIONS);
+	for (int legacy = 1; legacy >= 0; legacy--) {
+		run("addressed local device", local_name, legacy);
+		run("addressed remote device", remote_name, legacy);
+		run("unknown device", "No Such Device", legacy);
+		run("broadcast", "", legacy);
+	}
+	for (int i = 0; i < LOCAL_DEVICES + REMOTE_DEVICES; i++)
+		indigo_detach_device(&devices[i]);
+	indigo_stop();
+	return 0;
+}
@@ -0,0 +1,219 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO RMS contrast and PSF map test (results are compared with serial reference and must be bit-identical for any number of threads)
+ \file indigo_contrast_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_parallel.h>
+#include <indigo/indigo_raw_utils.h>
+
+#include "indigo_synthetic_frame.h"
+
+#define WIDTH						1021
+#define HEIGHT					763
+#define MAP_WIDTH				200
+#define MAP_HEIGHT			150
+#define STARS_MAX				200
+
+static const int thread_counts[] = { 1, 2, 3, 8 };
+
+static int failures = 0;
+
+/* star field with gradient background, saturated stars and a few hot pixels, 16 bit samples are scaled down for 8 bit frames */
+
+static void *create_frame(indigo_raw_type raw_type, int width, int height) {
+	int components = (raw_type == INDIGO_RAW_RGB24 || raw_type == INDIGO_RAW_RGB48) ? 3 : 1;
+	bool bytes = raw_type == INDIGO_RAW_MONO8 || raw_type == INDIGO_RAW_RGB24;
+	long size = (long)width * height * components;
+	uint16_t *raw = indigo_safe_malloc(size * sizeof(uint16_t));
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			for (int c = 0; c < components; c++)
+				raw[((long)y * width + x) * components + c] = 1000 + 2 * x + y + c * 300 + (rand() & 0x1FF);
+	for (int i = 0; i < width * height / 4000; i++) {
+		double cx = 10 + rand() % (width - 20) + rand() / (double)RAND_MAX;
+		double cy = 10 + rand() % (height - 20) + rand() / (double)RAND_MAX;
+		synthetic_render_star(raw, width, height, components, cx, cy, i % 10 == 0 ? 80000 : 3000 + rand() % 20000);
+	}
+	for (int i = 0; i < 20; i++)
+		raw[(rand() % ((long)width * height)) * components] = 0xFFFF;
+	if (!bytes)
+		return raw;
+	return synthetic_convert_to_8(raw, size, 8);
+}
+
+static uint8_t *create_mask(int width, int height) {
+	uint8_t *mask = indigo_safe_malloc((long)width * height);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			mask[y * width + x] = (x / 50 + y / 40) % 3 != 0;
+	return mask;
+}
+
+/* straightforward serial implementation, summed in long double */
+
+static double reference_contrast(indigo_raw_type raw_type, const void *data, const uint8_t *mask, int width, int height, bool *saturated) {
+	int components = (raw_type == INDIGO_RAW_RGB24 || raw_type == INDIGO_RAW_RGB48) ? 3 : 1;
+	bool bytes = raw_type == INDIGO_RAW_MONO8 || raw_type == INDIGO_RAW_RGB24;
+	int saturation = bytes ? 247 : 65407;
+	long double sum = 0;
+	long count = 0;
+	*saturated = false;
+	for (int pass = 0; pass < 2; pass++) {
+		double m = pass ? sum / (count * components) : 0;
+		double threshold = (saturation - m) * 0.3 + m;
+		sum = 0;
+		count = 0;
+		for (int y = 1; y < height - 1; y++) {
+			for (int x = 1; x < width - 1; x++) {
+				if (mask && !mask[y * width + x])
+					continue;
+				long i = ((long)y * width + x) * components;
+				bool over = false, median_over = false;
+				for (int c = 0; c < components; c++) {
+					int left = bytes ? ((uint8_t *)data)[i + c - components] : ((uint16_t *)data)[i + c - components];
+					int value = bytes ? ((uint8_t *)data)[i + c] : ((uint16_t *)data)[i + c];
+					int right = bytes ? ((uint8_t *)data)[i + c + components] : ((uint16_t *)data)[i + c + components];
+					int median = synthetic_median3(left, value, right);
+					over |= value > saturation;
+					median_over |= median > threshold;
+					sum += pass ? (value - m) * (value - m) : value;
+				}
+				if (pass && over && median_over)
+					*saturated = true;
+				count++;
+			}
+		}
+	}
+	return sqrtl(sum / count) / (bytes ? 255.0 : 65535.0);
+}
+
+static const char *type_name(indigo_raw_type raw_type) {
+	switch (raw_type) {
+		case INDIGO_RAW_MONO8:
+			return "mono8";
+		case INDIGO_RAW_MONO16:
+			return "mono16";
+		case INDIGO_RAW_RGB24:
+			return "rgb24";
+		default:
+			return "rgb48";
+	}
+}
+
+static uint64_t hash(const uint8_t *data, long size) {
+	uint64_t hash = 14695981039346656037ULL;
+	for (long i = 0; i < size; i++)
+		hash = (hash ^ data[i]) * 1099511628211ULL;
+	return hash;
+}
+
+/* results are printed with %a, so textual comparison of outputs is exact */
+
+static void print_results(FILE *output) {
+	static const indigo_raw_type types[] = { INDIGO_RAW_MONO8, INDIGO_RAW_MONO16, INDIGO_RAW_RGB24, INDIGO_RAW_RGB48 };
+	uint8_t *mask = create_mask(WIDTH, HEIGHT);
+	uint8_t *map = indigo_safe_malloc(MAP_WIDTH * MAP_HEIGHT * 4);
+	for (int t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+		srand(t + 1);
+		void *frame = create_frame(types[t], WIDTH, HEIGHT);
+		bool saturated = false;
+		double contrast = indigo_contrast(types[t], frame, NULL, WIDTH, HEIGHT, &saturated);
+		fprintf(output, "%s contrast %a %d\n", type_name(types[t]), contrast, saturated);
+		contrast = indigo_contrast(types[t], frame, mask, WIDTH, HEIGHT, &saturated);
+		fprintf(output, "%s masked contrast %a %d\n", type_name(types[t]), contrast, saturated);
+		if (types[t] == INDIGO_RAW_MONO8 || types[t] == INDIGO_RAW_MONO16) {
+			double psf_min = 0, psf_max = 0;
+			memset(map, 0, MAP_WIDTH * MAP_HEIGHT * 4);
+			indigo_make_psf_map(types[t], frame, 8, WIDTH, HEIGHT, STARS_MAX, INDIGO_RAW_RGBA32, hfd, MAP_WIDTH, MAP_HEIGHT, map, &psf_min, &psf_max);
+			fprintf(output, "%s psf map %016llx %a %a\n", type_name(types[t]), (unsigned long long)hash(map, MAP_WIDTH * MAP_HEIGHT * 4), psf_min, psf_max);
+		}
+		indigo_safe_free(frame);
+	}
+	indigo_safe_free(map);
+	indigo_safe_free(mask);
+}
+
+static void test_reference(void) {
+	static const indigo_raw_type types[] = { INDIGO_RAW_MONO8, INDIGO_RAW_MONO16, INDIGO_RAW_RGB24, INDIGO_RAW_RGB48 };
+	uint8_t *mask = create_mask(WIDTH, HEIGHT);
+	for (int t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+		srand(t + 1);
+		void *frame = create_frame(types[t], WIDTH, HEIGHT);
+		for (int masked = 0; masked < 2; masked++) {
+			bool saturated = false, expected_saturated = false;
+			double contrast = indigo_contrast(types[t], frame, masked ? mask : NULL, WIDTH, HEIGHT, &saturated);
+			double expected = reference_contrast(types[t], frame, masked ? mask : NULL, WIDTH, HEIGHT, &expected_saturated);
+			bool ok = fabs(contrast - expected) <= 1e-12 * expected && saturated == expected_saturated;
+			printf("%-6s %-8s contrast %.10f saturated %d (expected %.10f, %d) %s\n", type_name(types[t]), masked ? "masked" : "", contrast, saturated, expected, expected_saturated, ok ? "OK" : "FAILED");
+			if (!ok)
+				failures++;
+		}
+		indigo_safe_free(frame);
+	}
+	indigo_safe_free(mask);
+}
+
+/* thread pool size can't be changed once started, so each thread count is run in separate process */
+
+static void test_thread_counts(const char *path) {
+	char expected[4096] = "", output[4096];
+	for (int i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++) {
+		char command[1024];
+		snprintf(command, sizeof(command), "'%s' -t %d", path, thread_counts[i]);
+		FILE *pipe = popen(command, "r");
+		long length = pipe ? fread(output, 1, sizeof(output) - 1, pipe) : 0;
+		output[length] = 0;
+		bool ok = pipe != NULL && pclose(pipe) == 0 && length > 0;
+		if (i == 0)
+			strcpy(expected, output);
+		else
+			ok = ok && !strcmp(expected, output);
+		printf("%d threads %s\n", thread_counts[i], ok ? "OK" : "FAILED");
+		if (!ok) {
+			printf("%s", output);
+			failures++;
+		}
+	}
+	printf("%s", expected);
+}
+
+int main(int argc, const char * argv[]) {
+	if (argc == 3 && !strcmp(argv[1], "-t")) {
+		indigo_parallel_threads = atoi(argv[2]);
+		print_results(stdout);
+		return 0;
+	}
+	test_reference();
+	test_thread_counts(argv[0]);
+	printf("\n%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO donuts guiding test (frame digest spectra are compared with direct DFT, drift with the known frame shift)
+ \file indigo_donuts_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_raw_utils.h>
+
+#include "indigo_synthetic_frame.h"
+
+#define BG_RADIUS 5
+
+static int failures = 0;
+
+static void render_field(uint16_t *frame, int width, int height, double dx, double dy, unsigned seed) {
+	srand(seed);
+	synthetic_fill_background(frame, (long)width * height, 500, 0x3F);
+	for (int s = 0; s < 30; s++) {
+		double cx = 20 + rand() % (width - 40) + dx, cy = 20 + rand() % (height - 40) + dy;
+		synthetic_render_star(frame, width, height, 1, cx, cy, 2000 + rand() % 20000);
+	}
+}
+
+/* reference projection of RGB24 frame filtered by median as done by indigo_donuts_frame_digest() and its direct DFT */
+
+static double compare_spectrum(const uint8_t *rgb, int width, int height, bool columns, const double (*spectrum)[2], int n) {
+	double sum = 0;
+	for (int i = 0; i < width * height; i++)
+		sum += rgb[3 * i] + rgb[3 * i + 1] + rgb[3 * i + 2];
+	double threshold = 1.15 * sum / (width * height);
+	int size = columns ? width : height;
+	double *projection = calloc(size, sizeof(double)), *filtered = calloc(n, sizeof(double));
+	for (int j = 0; j < height; j++) {
+		for (int i = 0; i < width; i++) {
+			int offset = 3 * (j * width + i);
+			double value = rgb[offset] + rgb[offset + 1] + rgb[offset + 2] - threshold;
+			if (value > 0)
+				projection[columns ? i : j] += value;
+		}
+	}
+	for (int i = 0; i < size; i++)
+		filtered[i] = synthetic_median3(i > 0 ? projection[i - 1] : 0, projection[i], i < size - 1 ? projection[i + 1] : 0);
+	/* background removal, running minimum over 10 pixels is subtracted and edges are cleared */
+	double *minimums = calloc(size, sizeof(double));
+	for (int i = BG_RADIUS + 1; i < size - BG_RADIUS; i++) {
+		minimums[i] = filtered[i - BG_RADIUS];
+		for (int j = -BG_RADIUS + 1; j <= BG_RADIUS; j++)
+			minimums[i] = fmin(minimums[i], filtered[i + j]);
+	}
+	for (int i = 0; i < size; i++)
+		filtered[i] = (i <= BG_RADIUS || i >= size - BG_RADIUS) ? 0 : filtered[i] - minimums[i];
+	free(minimums);
+	double max_error = 0, max_value = 0;
+	for (int k = 0; k < n; k++) {
+		double re = 0, im = 0;
+		for (int t = 0; t < n; t++) {
+			double angle = 2 * M_PI * (((long)k * t) % n) / n;
+			re += filtered[t] * cos(angle);
+			im -= filtered[t] * sin(angle);
+		}
+		max_error = fmax(max_error, hypot(re - spectrum[k][0], im - spectrum[k][1]));
+		max_value = fmax(max_value, hypot(re, im));
+	}
+	free(projection);
+	free(filtered);
+	return max_error / max_value;
+}
+
+static void test_spectrum(int width, int height) {
+	uint16_t *frame = malloc(width * height * sizeof(uint16_t));
+	uint8_t *rgb = malloc(3 * width * height);
+	render_field(frame, width, height, 0, 0, 1);
+	for (int i = 0; i < width * height; i++)
+		rgb[3 * i] = rgb[3 * i + 1] = rgb[3 * i + 2] = frame[i] >> 8;
+	indigo_frame_digest digest = { 0 };
+	double error = 1;
+	if (indigo_donuts_frame_digest(INDIGO_RAW_RGB24, rgb, width, height, 0, &digest) == INDIGO_OK) {
+		error = fmax(compare_spectrum(rgb, width, height, true, digest.fft_x, digest.width), compare_spectrum(rgb, width, height, false, digest.fft_y, digest.height));
+		indigo_delete_frame_digest(&digest);
+	}
+	if (error < 1e-9) {
+		printf("%-36s %5dx%-5d OK\n", "digest spectrum", width, height);
+	} else {
+		printf("%-36s %5dx%-5d FAILED (relative error %g)\n", "digest spectrum", width, height, error);
+		failures++;
+	}
+	free(frame);
+	free(rgb);
+}
+
+static void test_drift(int width, int height, double shift_x, double shift_y) {
+	uint16_t *reference = malloc(width * height * sizeof(uint16_t));
+	uint16_t *shifted = malloc(width * height * sizeof(uint16_t));
+	render_field(reference, width, height, 0, 0, 2);
+	render_field(shifted, width, height, shift_x, shift_y, 2);
+	indigo_frame_digest reference_digest = { 0 }, shifted_digest = { 0 };
+	double drift_x = NAN, drift_y = NAN;
+	char label[64];
+	snprintf(label, sizeof(label), "drift %.2f, %.2f", shift_x, shift_y);
+	if (indigo_donuts_frame_digest(INDIGO_RAW_MONO16, reference, width, height, 16, &reference_digest) == INDIGO_OK && indigo_donuts_frame_digest(INDIGO_RAW_MONO16, shifted, width, height, 16, &shifted_digest) == INDIGO_OK)
+		indigo_calculate_drift(&reference_digest, &shifted_digest, &drift_x, &drift_y);
+	if (fabs(drift_x - shift_x) < 0.05 && fabs(drift_y - shift_y) < 0.05) {
+		printf("%-36s %5dx%-5d OK\n", label, width, height);
+	} else {
+		printf("%-36s %5dx%-5d FAILED (%.3f, %.3f)\n", label, width, height, drift_x, drift_y);
+		failures++;
+	}
+	indigo_delete_frame_digest(&reference_digest);
+	indigo_delete_frame_digest(&shifted_digest);
+	free(reference);
+	free(shifted);
+}
+
+int main(int argc, const char * argv[]) {
+	test_spectrum(64, 48);
+	test_spectrum(200, 150);
+	test_spectrum(640, 480);
+	double shifts[][2] = { { 0, 0 }, { 1.3, -0.7 }, { -5.25, 3.5 }, { 12.6, -9.1 } };
+	for (int i = 0; i < sizeof(shifts) / sizeof(shifts[0]); i++) {
+		test_drift(1024, 768, shifts[i][0], shifts[i][1]);
+		test_drift(1280, 960, shifts[i][0], shifts[i][1]);
+	}
+	printf("\n%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
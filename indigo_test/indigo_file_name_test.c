@@ -0,0 +1,103 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO local save sequence numbering test
+ \file indigo_file_name_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_ccd_driver.h>
+
+#define WIDTH		64
+#define HEIGHT	48
+
+static bool passed = true;
+static char dir[] = "/tmp/indigo_file_name_XXXXXX";
+
+static indigo_result attach(indigo_device *device) {
+	device->device_context = NULL;
+	return indigo_ccd_attach(device, "Test", INDIGO_VERSION_CURRENT);
+}
+
+static indigo_device ccd = INDIGO_DEVICE_INITIALIZER("Test CCD", attach, indigo_ccd_enumerate_properties, indigo_ccd_change_property, NULL, indigo_ccd_detach);
+
+static void touch(const char *name) {
+	char file_name[PATH_MAX];
+	snprintf(file_name, sizeof(file_name), "%s/%s", dir, name);
+	close(open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+}
+
+static void save(indigo_device *device, const char *prefix, const char *expected) {
+	char file_name[PATH_MAX];
+	snprintf(file_name, sizeof(file_name), "%s/%s", dir, expected);
+	indigo_copy_value(CCD_LOCAL_MODE_PREFIX_ITEM->text.value, prefix);
+	void *frame = indigo_alloc_blob_buffer(FITS_HEADER_SIZE + WIDTH * HEIGHT * 2);
+	indigo_process_image(device, frame, WIDTH, HEIGHT, 16, true, true, NULL, false);
+	indigo_safe_free(frame);
+	bool result = CCD_IMAGE_FILE_PROPERTY->state == INDIGO_OK_STATE && !strcmp(CCD_IMAGE_FILE_ITEM->text.value, file_name) && access(file_name, F_OK) == 0;
+	printf("%-36s %-24s %s\n", prefix, expected, result ? "OK" : "FAILED");
+	if (!result)
+		printf("  got %s\n", CCD_IMAGE_FILE_ITEM->text.value);
+	passed = passed && result;
+}
+
+int main(int argc, const char * argv[]) {
+	if (mkdtemp(dir) == NULL) {
+		perror("mkdtemp");
+		return 1;
+	}
+	indigo_start();
+	indigo_attach_device(&ccd);
+	indigo_device *device = &ccd;
+	snprintf(CCD_LOCAL_MODE_DIR_ITEM->text.value, INDIGO_VALUE_SIZE, "%s/", dir);
+	indigo_set_switch(CCD_UPLOAD_MODE_PROPERTY, CCD_UPLOAD_MODE_LOCAL_ITEM, true);
+	indigo_set_switch(CCD_PREVIEW_PROPERTY, CCD_PREVIEW_DISABLED_ITEM, true);
+	indigo_set_switch(CCD_IMAGE_FORMAT_PROPERTY, CCD_IMAGE_FORMAT_FITS_ITEM, true);
+
+	touch("LIGHT_003.fits");
+	touch("LIGHT_017.fits");
+	touch("LIGHT_abc.fits");
+	touch("LIGHT_020.raw");
+	save(device, "LIGHT_XXX", "LIGHT_018.fits");
+	save(device, "LIGHT_XXX", "LIGHT_019.fits");
+	touch("LIGHT_020.fits");
+	touch("LIGHT_021.fits");
+	save(device, "LIGHT_XXX", "LIGHT_022.fits");
+	save(device, "DARK_XXXX", "DARK_0001.fits");
+	save(device, "DARK_XXXX", "DARK_0002.fits");
+	save(device, "LIGHT_XXX", "LIGHT_023.fits");
+	save(device, "FLAT_%3S_R", "FLAT_001_R.fits");
+
+	indigo_detach_device(&ccd);
+	indigo_stop();
+	char command[PATH_MAX];
+	snprintf(command, sizeof(command), "rm -rf %s", dir);
+	system(command);
+	printf("\n%s\n", passed ? "PASSED" : "FAILED");
+	return passed ? 0 : 1;
+}
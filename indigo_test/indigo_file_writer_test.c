@@ -0,0 +1,139 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO background file writer test
+ \file indigo_file_writer_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_file_writer.h>
+
+#define MB	(1024 * 1024)
+
+static bool passed = true;
+static int callbacks = 0;
+
+static void check(const char *label, bool result) {
+	printf("%-48s %s\n", label, result ? "OK" : "FAILED");
+	passed = passed && result;
+}
+
+static void callback(void *context, const char *file_name, int error) {
+	if (error == 0)
+		__sync_fetch_and_add(&callbacks, 1);
+}
+
+static indigo_blob_buffer *create_buffer(long size, int seed) {
+	indigo_blob_buffer *buffer = indigo_create_blob_buffer(size);
+	for (long i = 0; i < size; i++)
+		((unsigned char *)buffer->data)[i] = (unsigned char)(i * 31 + seed);
+	return buffer;
+}
+
+static bool verify_file(const char *file_name, indigo_blob_buffer *buffer) {
+	bool result = false;
+	int handle = open(file_name, O_RDONLY);
+	if (handle < 0)
+		return false;
+	struct stat st;
+	if (fstat(handle, &st) == 0 && st.st_size == buffer->size) {
+		void *data = indigo_safe_malloc(buffer->size);
+		result = read(handle, data, buffer->size) == buffer->size && memcmp(data, buffer->data, buffer->size) == 0;
+		indigo_safe_free(data);
+	}
+	close(handle);
+	return result;
+}
+
+// reader drains pipe slowly, so writer stays busy and queue can be filled
+
+static void *drain(int *handle) {
+	char data[65536];
+	while (read(*handle, data, sizeof(data)) > 0)
+		;
+	return NULL;
+}
+
+int main(int argc, const char * argv[]) {
+	char dir[] = "/tmp/indigo_file_writer_XXXXXX", file_name[PATH_MAX];
+	if (mkdtemp(dir) == NULL) {
+		perror("mkdtemp");
+		return 1;
+	}
+	indigo_file_writer *writer = indigo_file_writer_create(callback, NULL);
+	indigo_file_writer_configure(writer, 2 * MB, false, false);
+
+	indigo_blob_buffer *buffers[4];
+	for (int i = 0; i < 4; i++) {
+		buffers[i] = create_buffer(MB / 2 + i * 1000, i);
+		snprintf(file_name, sizeof(file_name), "%s/file_%d.raw", dir, i);
+		int handle = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		indigo_file_writer_push(writer, handle, file_name, buffers[i], true);
+	}
+	indigo_file_writer_flush(writer);
+	bool result = true;
+	for (int i = 0; i < 4; i++) {
+		snprintf(file_name, sizeof(file_name), "%s/file_%d.raw", dir, i);
+		result = result && verify_file(file_name, buffers[i]);
+		unlink(file_name);
+	}
+	check("Queued files written", result);
+
+	indigo_file_writer_stats stats;
+	indigo_file_writer_get_stats(writer, &stats);
+	check("Statistics after flush", stats.files == 0 && stats.bytes == 0 && stats.written == 4 && stats.failed == 0);
+
+	int pipe_handles[2];
+	pipe(pipe_handles);
+	indigo_blob_buffer *blocking = create_buffer(3 * MB, 7);
+	check("File larger than queue accepted", indigo_file_writer_push(writer, pipe_handles[1], "pipe", blocking, false));
+	indigo_file_writer_get_stats(writer, &stats);
+	check("Pending statistics", stats.files == 1 && stats.bytes == 3 * MB);
+	indigo_file_writer_configure(writer, 3 * MB, true, true);
+	snprintf(file_name, sizeof(file_name), "%s/synced.raw", dir);
+	int handle = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	check("Full queue rejected without wait", !indigo_file_writer_push(writer, handle, file_name, buffers[0], false));
+	pthread_t thread;
+	pthread_create(&thread, NULL, (void *(*)(void *))drain, &pipe_handles[0]);
+	check("Full queue accepted with wait", indigo_file_writer_push(writer, handle, file_name, buffers[0], true));
+	indigo_file_writer_release(writer);
+	pthread_join(thread, NULL);
+	close(pipe_handles[0]);
+	check("Synced and preallocated file written", verify_file(file_name, buffers[0]));
+	unlink(file_name);
+	check("Callbacks", callbacks == 6);
+
+	for (int i = 0; i < 4; i++)
+		indigo_release_blob_buffer(buffers[i]);
+	indigo_release_blob_buffer(blocking);
+	rmdir(dir);
+	printf("\n%s\n", passed ? "PASSED" : "FAILED");
+	return passed ? 0 : 1;
+}
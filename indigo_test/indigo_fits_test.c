@@ -0,0 +1,343 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO FITS payload conversion test (single pass conversion must be byte-identical with the previous multi pass conversion) and tile compression round-trip test
+ \file indigo_fits_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_fits.h>
+
+// reference implementation, byte order and channel order are normalized first, then BZERO, byte swap and split to planes are applied
+
+static void reference_conversion(const void *input, void *output, int width, int height, int bytes_per_sample, int components, bool little_endian, bool byte_order_rgb) {
+	int size = width * height;
+	int samples = size * components;
+	void *tmp = indigo_safe_malloc(samples * bytes_per_sample);
+	memcpy(tmp, input, samples * bytes_per_sample);
+	if (bytes_per_sample == 2 && !little_endian) {
+		uint16_t *raw = tmp;
+		for (int i = 0; i < samples; i++) {
+			uint16_t value = raw[i];
+			raw[i] = (value & 0xff) << 8 | (value & 0xff00) >> 8;
+		}
+	}
+	if (components == 3 && !byte_order_rgb) {
+		for (int i = 0; i < size; i++) {
+			if (bytes_per_sample == 1) {
+				uint8_t *pixel = (uint8_t *)tmp + 3 * i, b = pixel[0];
+				pixel[0] = pixel[2];
+				pixel[2] = b;
+			} else {
+				uint16_t *pixel = (uint16_t *)tmp + 3 * i, b = pixel[0];
+				pixel[0] = pixel[2];
+				pixel[2] = b;
+			}
+		}
+	}
+	if (bytes_per_sample == 1) {
+		uint8_t *in = tmp, *out = output;
+		for (int i = 0; i < size; i++) {
+			for (int c = 0; c < components; c++)
+				out[c * size + i] = *in++;
+		}
+	} else {
+		uint16_t *in = tmp, *out = output;
+		for (int i = 0; i < size; i++) {
+			for (int c = 0; c < components; c++) {
+				int value = *in++ - 32768;
+				out[c * size + i] = (value & 0xff) << 8 | (value & 0xff00) >> 8;
+			}
+		}
+	}
+	indigo_safe_free(tmp);
+}
+
+static int failures = 0;
+
+static void check(const char *label, int width, int height, const void *output, const void *expected, long size) {
+	if (memcmp(output, expected, size)) {
+		printf("%-36s %5dx%-5d FAILED\n", label, width, height);
+		failures++;
+	} else {
+		printf("%-36s %5dx%-5d OK\n", label, width, height);
+	}
+}
+
+static void test_conversion(int width, int height, int bytes_per_sample, int components, bool little_endian, bool byte_order_rgb) {
+	long length = (long)width * height * components * bytes_per_sample;
+	uint8_t *input = indigo_safe_malloc(length);
+	uint8_t *output = indigo_safe_malloc(length);
+	uint8_t *expected = indigo_safe_malloc(length);
+	for (long i = 0; i < length; i++)
+		input[i] = rand();
+	reference_conversion(input, expected, width, height, bytes_per_sample, components, little_endian, byte_order_rgb);
+	indigo_raw_to_fits_payload(input, output, width, height, bytes_per_sample, components, little_endian, byte_order_rgb);
+	char label[64];
+	snprintf(label, sizeof(label), "%s%d%s%s", components == 1 ? "MONO" : "RGB", 8 * bytes_per_sample * components, bytes_per_sample == 1 ? "" : little_endian ? " LE" : " BE", components == 1 ? "" : byte_order_rgb ? " RGB" : " BGR");
+	check(label, width, height, output, expected, length);
+	if (components == 1) {
+		indigo_raw_to_fits_payload(input, input, width, height, bytes_per_sample, components, little_endian, byte_order_rgb);
+		strcat(label, " in place");
+		check(label, width, height, input, expected, length);
+	}
+	indigo_safe_free(input);
+	indigo_safe_free(output);
+	indigo_safe_free(expected);
+}
+
+static void test_raw_to_fits(int width, int height, int bytes_per_sample, int components) {
+	long length = (long)width * height * components * bytes_per_sample;
+	char *raw = indigo_safe_malloc(sizeof(indigo_raw_header) + length);
+	indigo_raw_header *header = (indigo_raw_header *)raw;
+	header->signature = components == 1 ? (bytes_per_sample == 1 ? INDIGO_RAW_MONO8 : INDIGO_RAW_MONO16) : (bytes_per_sample == 1 ? INDIGO_RAW_RGB24 : INDIGO_RAW_RGB48);
+	header->width = width;
+	header->height = height;
+	for (long i = 0; i < length; i++)
+		raw[sizeof(indigo_raw_header) + i] = rand();
+	uint8_t *expected = indigo_safe_malloc(length);
+	reference_conversion(raw + sizeof(indigo_raw_header), expected, width, height, bytes_per_sample, components, true, true);
+	char *fits = NULL;
+	int fits_size = 0;
+	char label[64];
+	snprintf(label, sizeof(label), "indigo_raw_to_fits() %s%d", components == 1 ? "MONO" : "RGB", 8 * bytes_per_sample * components);
+	if (indigo_raw_to_fits(raw, (int)(sizeof(indigo_raw_header) + length), &fits, &fits_size, NULL) != INDIGO_OK || fits_size < FITS_RECORD_SIZE + length) {
+		printf("%-36s %5dx%-5d FAILED\n", label, width, height);
+		failures++;
+	} else {
+		check(label, width, height, fits + FITS_RECORD_SIZE, expected, length);
+	}
+	free(fits);
+	indigo_safe_free(raw);
+	indigo_safe_free(expected);
+}
+
+// reference tile decoder written from the tiled image convention (Pence et al.), independent of the encoder
+
+static const char *find_card(const char *header, const char *keyword) {
+	char name[9];
+	snprintf(name, sizeof(name), "%-8s", keyword);
+	for (const char *card = header; strncmp(card, "END     ", 8); card += 80)
+		if (!strncmp(card, name, 8))
+			return card;
+	return NULL;
+}
+
+static long card_value(const char *header, const char *keyword) {
+	const char *card = find_card(header, keyword);
+	return card ? atol(card + 10) : -1;
+}
+
+typedef struct {
+	const uint8_t *data;
+	const uint8_t *end;
+	long position;
+} bit_reader;
+
+static uint32_t read_bits(bit_reader *reader, int count) {
+	uint32_t value = 0;
+	for (int i = 0; i < count; i++, reader->position++) {
+		const uint8_t *byte = reader->data + reader->position / 8;
+		value = value << 1 | (byte < reader->end ? *byte >> (7 - reader->position % 8) & 1 : 0);
+	}
+	return value;
+}
+
+static bool rice_decode(const uint8_t *data, long size, int count, int bytepix, int block_size, uint8_t *output) {
+	const int fsbits = bytepix == 1 ? 3 : 4, fsmax = bytepix == 1 ? 6 : 14, bbits = 8 * bytepix;
+	const uint32_t mask = bytepix == 1 ? 0xff : 0xffff;
+	bit_reader reader = { data, data + size, 0 };
+	uint32_t lastpix = read_bits(&reader, bbits);
+	for (int i = 0; i < count; ) {
+		int fs = (int)read_bits(&reader, fsbits) - 1;
+		int end = i + block_size < count ? i + block_size : count;
+		for (; i < end; i++) {
+			uint32_t diff;
+			if (fs < 0) {
+				diff = 0;
+			} else if (fs == fsmax) {
+				diff = read_bits(&reader, bbits);
+			} else {
+				uint32_t top = 0;
+				while (read_bits(&reader, 1) == 0) {
+					if (reader.data + reader.position / 8 >= reader.end)
+						return false;
+					top++;
+				}
+				diff = top << fs | read_bits(&reader, fs);
+			}
+			/* zigzag mapped difference */
+			lastpix = (lastpix + ((diff & 1) ? ~(diff >> 1) : diff >> 1)) & mask;
+			if (bytepix == 1) {
+				output[i] = lastpix;
+			} else {
+				output[2 * i] = lastpix >> 8;
+				output[2 * i + 1] = lastpix;
+			}
+		}
+	}
+	return reader.position <= 8 * size;
+}
+
+static bool gzip_decode(const uint8_t *data, long size, uint8_t *output, long length) {
+	z_stream stream = { 0 };
+	if (inflateInit2(&stream, 15 + 16) != Z_OK)
+		return false;
+	stream.next_in = (Bytef *)data;
+	stream.avail_in = (uInt)size;
+	stream.next_out = output;
+	stream.avail_out = (uInt)length;
+	int result = inflate(&stream, Z_FINISH);
+	inflateEnd(&stream);
+	return result == Z_STREAM_END && stream.total_out == length;
+}
+
+static bool decompress_fits(const char *fits, long size, int width, int height, int bytes_per_sample, int components, const char *algorithm, uint8_t *output) {
+	char value[32];
+	if (size % FITS_RECORD_SIZE || card_value(fits, "NAXIS") != 0)
+		return false;
+	const char *header = fits + FITS_RECORD_SIZE;
+	const char *card = find_card(header, "ZCMPTYPE");
+	snprintf(value, sizeof(value), "'%s'", algorithm);
+	const char *zimage = find_card(header, "ZIMAGE");
+	if (strncmp(header, "XTENSION= 'BINTABLE'", 20) || zimage == NULL || zimage[29] != 'T' || card == NULL || strncmp(card + 10, value, strlen(value)))
+		return false;
+	if (card_value(header, "ZBITPIX") != 8 * bytes_per_sample || card_value(header, "ZNAXIS") != (components == 1 ? 2 : 3) || card_value(header, "ZNAXIS1") != width || card_value(header, "ZNAXIS2") != height || card_value(header, "ZTILE1") != width || card_value(header, "ZTILE2") != 1)
+		return false;
+	if (bytes_per_sample == 2 && card_value(header, "BZERO") != 32768)
+		return false;
+	int block_size = 32;
+	if (!strcmp(algorithm, "RICE_1")) {
+		card = find_card(header, "ZNAME1");
+		if (card == NULL || strncmp(card + 10, "'BLOCKSIZE'", 11) || card_value(header, "ZNAME2") == -1 || card_value(header, "ZVAL2") != bytes_per_sample)
+			return false;
+		block_size = (int)card_value(header, "ZVAL1");
+	}
+	long rows = card_value(header, "NAXIS2"), heap_size = card_value(header, "PCOUNT");
+	if (card_value(header, "NAXIS1") != 8 || rows != (long)height * components)
+		return false;
+	const char *end = header;
+	while (strncmp(end, "END     ", 8))
+		end += 80;
+	const uint8_t *table = (const uint8_t *)fits + FITS_RECORD_SIZE + ((end - header) / FITS_RECORD_SIZE + 1) * FITS_RECORD_SIZE;
+	const uint8_t *heap = table + 8 * rows;
+	if ((const char *)heap + heap_size > fits + size)
+		return false;
+	long tile_length = (long)width * bytes_per_sample;
+	for (long row = 0; row < rows; row++) {
+		const uint8_t *descriptor = table + 8 * row;
+		long length = (long)descriptor[0] << 24 | descriptor[1] << 16 | descriptor[2] << 8 | descriptor[3];
+		long offset = (long)descriptor[4] << 24 | descriptor[5] << 16 | descriptor[6] << 8 | descriptor[7];
+		if (offset + length > heap_size)
+			return false;
+		bool result;
+		if (!strcmp(algorithm, "RICE_1"))
+			result = rice_decode(heap + offset, length, width, bytes_per_sample, block_size, output + row * tile_length);
+		else
+			result = gzip_decode(heap + offset, length, output + row * tile_length, tile_length);
+		if (!result)
+			return false;
+	}
+	return true;
+}
+
+typedef enum {
+	RANDOM,
+	CONSTANT,
+	SKY
+} content;
+
+static void test_compression(int width, int height, int bytes_per_sample, int components, content content, indigo_fits_compression compression) {
+	long count = (long)width * height * components, length = count * bytes_per_sample;
+	char *raw = indigo_safe_malloc(sizeof(indigo_raw_header) + length);
+	indigo_raw_header *header = (indigo_raw_header *)raw;
+	header->signature = components == 1 ? (bytes_per_sample == 1 ? INDIGO_RAW_MONO8 : INDIGO_RAW_MONO16) : (bytes_per_sample == 1 ? INDIGO_RAW_RGB24 : INDIGO_RAW_RGB48);
+	header->width = width;
+	header->height = height;
+	uint8_t *pixels = (uint8_t *)raw + sizeof(indigo_raw_header);
+	for (long i = 0; i < count; i++) {
+		/* sky is background with gaussian-ish noise and occasional saturated stars */
+		int value = content == RANDOM ? rand() : content == CONSTANT ? 1000 : 1200 + (rand() % 64 + rand() % 64 + rand() % 64) / 3 + (rand() % 2000 == 0 ? 60000 : 0);
+		if (bytes_per_sample == 1) {
+			pixels[i] = content == SKY ? value >> 4 : value;
+		} else {
+			pixels[2 * i] = value;
+			pixels[2 * i + 1] = value >> 8;
+		}
+	}
+	char *fits = NULL;
+	int fits_size = 0;
+	indigo_raw_to_fits(raw, (int)(sizeof(indigo_raw_header) + length), &fits, &fits_size, NULL);
+	const char *names[] = { "random", "constant", "sky" };
+	const char *algorithm = compression == INDIGO_FITS_RICE ? "RICE_1" : "GZIP_1";
+	char label[64];
+	indigo_blob_buffer *compressed = indigo_fits_compress(fits, fits_size, compression);
+	uint8_t *output = indigo_safe_malloc(length);
+	if (compressed == NULL || !decompress_fits(compressed->data, compressed->size, width, height, bytes_per_sample, components, algorithm, output)) {
+		snprintf(label, sizeof(label), "%s %s%d %s", algorithm, components == 1 ? "MONO" : "RGB", 8 * bytes_per_sample * components, names[content]);
+		printf("%-36s %5dx%-5d FAILED\n", label, width, height);
+		failures++;
+	} else {
+		snprintf(label, sizeof(label), "%s %s%d %s %.2fx", algorithm, components == 1 ? "MONO" : "RGB", 8 * bytes_per_sample * components, names[content], (double)fits_size / compressed->size);
+		check(label, width, height, output, fits + FITS_RECORD_SIZE, length);
+	}
+	indigo_release_blob_buffer(compressed);
+	indigo_safe_free(output);
+	free(fits);
+	indigo_safe_free(raw);
+}
+
+int main(int argc, const char * argv[]) {
+	int sizes[][2] = { { 1, 1 }, { 7, 5 }, { 64, 48 }, { 1001, 701 } };
+	srand(1);
+	for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		int width = sizes[i][0], height = sizes[i][1];
+		test_conversion(width, height, 1, 1, true, true);
+		test_conversion(width, height, 2, 1, true, true);
+		test_conversion(width, height, 2, 1, false, true);
+		test_conversion(width, height, 1, 3, true, true);
+		test_conversion(width, height, 1, 3, true, false);
+		test_conversion(width, height, 2, 3, true, true);
+		test_conversion(width, height, 2, 3, true, false);
+		test_conversion(width, height, 2, 3, false, true);
+		test_conversion(width, height, 2, 3, false, false);
+		test_raw_to_fits(width, height, 1, 1);
+		test_raw_to_fits(width, height, 2, 1);
+		test_raw_to_fits(width, height, 1, 3);
+		test_raw_to_fits(width, height, 2, 3);
+		for (content content = RANDOM; content <= SKY; content++) {
+			for (indigo_fits_compression compression = INDIGO_FITS_RICE; compression <= INDIGO_FITS_GZIP; compression++) {
+				test_compression(width, height, 1, 1, content, compression);
+				test_compression(width, height, 2, 1, content, compression);
+				test_compression(width, height, 2, 3, content, compression);
+			}
+		}
+	}
+	printf("\n%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
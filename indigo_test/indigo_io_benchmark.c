@@ -0,0 +1,154 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO line reader micro-benchmark (syscalls per request)
+ \file indigo_io_benchmark.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_io.h>
+
+#define REQUESTS	20000
+
+static const char *http_request = "GET /blob/0x7f1234567890.fits HTTP/1.1\r\nHost: localhost:7624\r\nUser-Agent: INDIGO\r\nAccept: */*\r\nAccept-Encoding: gzip\r\nConnection: keep-alive\r\n\r\n";
+static const char *serial_reply = "PS:12.2:0.5:6.1:28.3:0:0:1111:0:0:0:0:0:0:0:0:0:0\n";
+
+static long syscalls = 0;
+
+// read() and recv() are interposed to count syscalls issued by libindigo
+
+ssize_t read(int handle, void *buffer, size_t length) {
+	syscalls++;
+	return syscall(SYS_read, handle, buffer, length);
+}
+
+ssize_t recv(int handle, void *buffer, size_t length, int flags) {
+	syscalls++;
+	return syscall(SYS_recvfrom, handle, buffer, length, flags, NULL, NULL);
+}
+
+// line reading as it was done before, one read() per byte
+
+static int legacy_read_line(int handle, char *buffer, int length) {
+	char c = '\0';
+	long total_bytes = 0;
+	while (total_bytes < length) {
+		long bytes_read = read(handle, &c, 1);
+		if (bytes_read > 0) {
+			if (c == '\r')
+				;
+			else if (c != '\n')
+				buffer[total_bytes++] = c;
+			else
+				break;
+		} else {
+			return -1;
+		}
+	}
+	buffer[total_bytes] = '\0';
+	return (int)total_bytes;
+}
+
+typedef struct {
+	int handle;
+	const char *message;
+} writer_args;
+
+static void *writer(writer_args *args) {
+	long length = strlen(args->message);
+	for (int i = 0; i < REQUESTS; i++)
+		indigo_write(args->handle, args->message, length);
+	close(args->handle);
+	return NULL;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef enum {
+	LEGACY,
+	READ_LINE,
+	READER
+} method;
+
+static void run(const char *label, bool socket, const char *message, method method) {
+	int handles[2];
+	if (socket)
+		socketpair(AF_UNIX, SOCK_STREAM, 0, handles);
+	else
+		pipe(handles);
+	writer_args args = { handles[1], message };
+	pthread_t thread;
+	pthread_create(&thread, NULL, (void *(*)(void *))writer, &args);
+	indigo_reader *reader = indigo_safe_malloc(sizeof(indigo_reader));
+	indigo_init_reader(reader, handles[0]);
+	char line[1024];
+	int requests = 0;
+	syscalls = 0;
+	double start = now();
+	while (true) {
+		int result;
+		switch (method) {
+			case LEGACY:
+				result = legacy_read_line(handles[0], line, sizeof(line) - 1);
+				break;
+			case READ_LINE:
+				result = indigo_read_line(handles[0], line, sizeof(line) - 1);
+				break;
+			default:
+				result = indigo_reader_read_line(reader, line, sizeof(line) - 1);
+				break;
+		}
+		if (result < 0)
+			break;
+		/* HTTP request ends with empty line, serial reply is single line */
+		if (result == 0 || !socket)
+			requests++;
+	}
+	double elapsed = now() - start;
+	pthread_join(thread, NULL);
+	close(handles[0]);
+	indigo_safe_free(reader);
+	printf("%-48s %8.2f syscalls/request %8.3f us/request\n", label, (double)syscalls / requests, elapsed * 1e6 / requests);
+}
+
+int main(int argc, const char * argv[]) {
+	printf("%d requests\n\n", REQUESTS);
+	run("HTTP request, socket, byte by byte (legacy)", true, http_request, LEGACY);
+	run("HTTP request, socket, indigo_read_line()", true, http_request, READ_LINE);
+	run("HTTP request, socket, indigo_reader", true, http_request, READER);
+	run("Serial reply, pipe, byte by byte (legacy)", false, serial_reply, LEGACY);
+	run("Serial reply, pipe, indigo_read_line()", false, serial_reply, READ_LINE);
+	run("Serial reply, pipe, indigo_reader", false, serial_reply, READER);
+	return 0;
+}
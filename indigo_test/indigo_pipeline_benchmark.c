@@ -0,0 +1,384 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO CCD image pipeline benchmark (synthetic mono, bayer and RGB frames, no hardware needed)
+ \file indigo_pipeline_benchmark.c
+
+ Results are written as CSV to stdout, one row per frame format, size and stage:
+ build,frame,width,height,stage,best_ms,median_ms,mpixels_per_s,output
+ where output is number of bytes produced by the stage, number of stars found by find_stars, number of background_mesh cells
+ or number of stars selected by guider_cycle.
+ Guider_cycle runs on the same star field with sky gradient and vignetting and does what guider agent does to select stars:
+ up to 3 attempts of star detection, stars which are oversaturated, close to other or near the edge are skipped and selection
+ digest is computed for the rest of them, next attempt is made only if no star is selected.
+ Parallel stages use indigo_parallel_threads threads (-t option), speedup is ratio of runs with -t 1 and -t N.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_ccd_driver.h>
+#include <indigo/indigo_parallel.h>
+#include <indigo/indigo_stretch.h>
+#include <indigo/indigo_raw_utils.h>
+
+#include "indigo_synthetic_frame.h"
+
+#define MAX_REPEAT				100
+#define MAX_SIZES					8
+#define STAR_DENSITY			2000
+#define PREVIEW_SIZE			1024
+#define STRETCH_SAMPLE		0x1FF
+#define PSF_MAP_SIZE			256
+#define PSF_MAP_STARS			500
+#define GUIDER_STARS			50
+#define GUIDER_SELECTION	5
+#define GUIDER_ATTEMPTS		3
+#define GUIDER_ITERATIONS	3
+
+typedef enum {
+	MONO,
+	BAYER,
+	RGB
+} frame_kind;
+
+typedef struct {
+	const char *name;
+	frame_kind kind;
+	int bpp;
+} frame_format;
+
+static frame_format formats[] = {
+	{ "mono8", MONO, 8 },
+	{ "mono16", MONO, 16 },
+	{ "rggb8", BAYER, 8 },
+	{ "rggb16", BAYER, 16 },
+	{ "rgb24", RGB, 24 },
+	{ "rgb48", RGB, 48 }
+};
+
+typedef struct {
+	indigo_device *device;
+	frame_format *format;
+	int width, height;
+	long size;
+	void *frame;
+	void *gradient;
+	uint8_t *buffer;
+	uint8_t *output;
+	double shadows[3], midtones[3], highlights[3];
+	unsigned long totals[3];
+} benchmark;
+
+typedef double (*stage_function)(benchmark *benchmark, long *output);
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int sample_by(benchmark *benchmark) {
+	return benchmark->width < STRETCH_SAMPLE ? 1 : benchmark->width / STRETCH_SAMPLE;
+}
+
+static void free_histogram(unsigned long **histogram) {
+	for (int i = 0; i < 3; i++) {
+		indigo_safe_free(histogram[i]);
+		histogram[i] = NULL;
+	}
+}
+
+// pipeline stages, each returns elapsed time and sets size of produced output
+
+static double stretch_params(benchmark *benchmark, long *output) {
+	unsigned long *histogram[3] = { NULL, NULL, NULL };
+	int width = benchmark->width, height = benchmark->height;
+	double start = now();
+	switch (benchmark->format->bpp + benchmark->format->kind) {
+		case 8 + MONO:
+			indigo_compute_stretch_params_8(benchmark->frame, width, height, sample_by(benchmark), benchmark->shadows, benchmark->midtones, benchmark->highlights, histogram, 0.25, -2.8);
+			break;
+		case 16 + MONO:
+			indigo_compute_stretch_params_16(benchmark->frame, width, height, sample_by(benchmark), benchmark->shadows, benchmark->midtones, benchmark->highlights, histogram, 0.25, -2.8);
+			break;
+		case 8 + BAYER:
+			indigo_compute_stretch_params_8_rggb(benchmark->frame, width, height, sample_by(benchmark), benchmark->shadows, benchmark->midtones, benchmark->highlights, histogram, benchmark->totals, 0.25, -2.8);
+			break;
+		case 16 + BAYER:
+			indigo_compute_stretch_params_16_rggb(benchmark->frame, width, height, sample_by(benchmark), benchmark->shadows, benchmark->midtones, benchmark->highlights, histogram, benchmark->totals, 0.25, -2.8);
+			break;
+		case 24 + RGB:
+			indigo_compute_stretch_params_24(benchmark->frame, width, height, sample_by(benchmark), benchmark->shadows, benchmark->midtones, benchmark->highlights, histogram, benchmark->totals, 0.25, -2.8);
+			break;
+		case 48 + RGB:
+			indigo_compute_stretch_params_48(benchmark->frame, width, height, sample_by(benchmark), benchmark->shadows, benchmark->midtones, benchmark->highlights, histogram, benchmark->totals, 0.25, -2.8);
+			break;
+	}
+	double elapsed = now() - start;
+	free_histogram(histogram);
+	*output = 0;
+	return elapsed;
+}
+
+static double stretch(benchmark *benchmark, long *output) {
+	int width = benchmark->width, height = benchmark->height;
+	double start = now();
+	switch (benchmark->format->bpp + benchmark->format->kind) {
+		case 8 + MONO:
+			indigo_stretch_8(benchmark->frame, width, height, benchmark->output, benchmark->shadows, benchmark->midtones, benchmark->highlights);
+			break;
+		case 16 + MONO:
+			indigo_stretch_16(benchmark->frame, width, height, benchmark->output, benchmark->shadows, benchmark->midtones, benchmark->highlights);
+			break;
+		case 8 + BAYER:
+			indigo_stretch_8_rggb(benchmark->frame, width, height, benchmark->output, benchmark->shadows, benchmark->midtones, benchmark->highlights, benchmark->totals);
+			break;
+		case 16 + BAYER:
+			indigo_stretch_16_rggb(benchmark->frame, width, height, benchmark->output, benchmark->shadows, benchmark->midtones, benchmark->highlights, benchmark->totals);
+			break;
+		case 24 + RGB:
+			indigo_stretch_24(benchmark->frame, width, height, benchmark->output, benchmark->shadows, benchmark->midtones, benchmark->highlights, benchmark->totals);
+			break;
+		case 48 + RGB:
+			indigo_stretch_48(benchmark->frame, width, height, benchmark->output, benchmark->shadows, benchmark->midtones, benchmark->highlights, benchmark->totals);
+			break;
+	}
+	double elapsed = now() - start;
+	*output = (long)width * height * (benchmark->format->kind == MONO ? 1 : 3);
+	return elapsed;
+}
+
+static double jpeg(benchmark *benchmark, int max_size, long *output) {
+	void *data = NULL, *histogram = NULL;
+	unsigned long size = 0, histogram_size = 0;
+	double start = now();
+	indigo_raw_to_scaled_jpeg(benchmark->device, benchmark->frame, benchmark->width, benchmark->height, benchmark->format->bpp, benchmark->format->kind == BAYER ? "RGGB" : NULL, max_size, &data, &size, &histogram, &histogram_size, 0.25, -2.8);
+	double elapsed = now() - start;
+	free(data);
+	free(histogram);
+	*output = size;
+	return elapsed;
+}
+
+static double full_jpeg(benchmark *benchmark, long *output) {
+	return jpeg(benchmark, 0, output);
+}
+
+static double preview_jpeg(benchmark *benchmark, long *output) {
+	return jpeg(benchmark, PREVIEW_SIZE, output);
+}
+
+static const indigo_raw_type raw_types[] = { [8] = INDIGO_RAW_MONO8, [16] = INDIGO_RAW_MONO16, [24] = INDIGO_RAW_RGB24, [48] = INDIGO_RAW_RGB48 };
+
+static double find_stars(benchmark *benchmark, long *output) {
+	indigo_star_detection stars[100];
+	int found = 0;
+	double start = now();
+	indigo_find_stars_precise(raw_types[benchmark->format->bpp], benchmark->frame, 8, benchmark->width, benchmark->height, 100, stars, &found);
+	double elapsed = now() - start;
+	*output = found;
+	return elapsed;
+}
+
+static double guider_cycle(benchmark *benchmark, long *output) {
+	indigo_raw_type raw_type = raw_types[benchmark->format->bpp];
+	int width = benchmark->width, height = benchmark->height;
+	indigo_star_detection stars[GUIDER_STARS];
+	indigo_frame_digest digest;
+	int selected = 0;
+	double start = now();
+	for (int attempt = 0; attempt < GUIDER_ATTEMPTS && selected == 0; attempt++) {
+		int found = 0;
+		indigo_find_stars_precise(raw_type, benchmark->gradient, 8, width, height, GUIDER_STARS, stars, &found);
+		for (int i = 0; i < found && selected < GUIDER_SELECTION; i++) {
+			if (stars[i].oversaturated || stars[i].close_to_other || stars[i].x < width * 0.05 || stars[i].x > width * 0.95 || stars[i].y < height * 0.05 || stars[i].y > height * 0.95)
+				continue;
+			double x = stars[i].x, y = stars[i].y;
+			if (indigo_selection_frame_digest_iterative(raw_type, benchmark->gradient, &x, &y, 8, width, height, &digest, GUIDER_ITERATIONS) == INDIGO_OK)
+				selected++;
+		}
+	}
+	double elapsed = now() - start;
+	*output = selected;
+	return elapsed;
+}
+
+static double background_mesh(benchmark *benchmark, long *output) {
+	indigo_background_mesh mesh = { 0 };
+	double start = now();
+	indigo_make_background_mesh(raw_types[benchmark->format->bpp], benchmark->frame, benchmark->width, benchmark->height, INDIGO_BACKGROUND_MESH_CELL, &mesh);
+	double elapsed = now() - start;
+	*output = mesh.columns * mesh.rows;
+	indigo_delete_background_mesh(&mesh);
+	return elapsed;
+}
+
+static double contrast(benchmark *benchmark, long *output) {
+	bool saturated;
+	double start = now();
+	indigo_contrast(raw_types[benchmark->format->bpp], benchmark->frame, NULL, benchmark->width, benchmark->height, &saturated);
+	double elapsed = now() - start;
+	*output = 0;
+	return elapsed;
+}
+
+static double psf_map(benchmark *benchmark, long *output) {
+	int map_height = PSF_MAP_SIZE * benchmark->height / benchmark->width;
+	double start = now();
+	indigo_make_psf_map(raw_types[benchmark->format->bpp], benchmark->frame, 8, benchmark->width, benchmark->height, PSF_MAP_STARS, INDIGO_RAW_RGB24, hfd, PSF_MAP_SIZE, map_height, benchmark->output, NULL, NULL);
+	double elapsed = now() - start;
+	*output = PSF_MAP_SIZE * map_height * 3;
+	return elapsed;
+}
+
+/* frame is copied to fresh buffer for each run because conversion is done in place */
+
+static double process_image(benchmark *benchmark, long *output) {
+	indigo_device *device = benchmark->device;
+	char bayerpat[] = "RGGB";
+	indigo_fits_keyword keywords[] = {
+		{ INDIGO_FITS_STRING, "BAYERPAT", .string = bayerpat, "Bayer color pattern" },
+		{ 0 }
+	};
+	memcpy(benchmark->buffer + FITS_HEADER_SIZE, benchmark->frame, benchmark->size);
+	double start = now();
+	indigo_process_image(device, benchmark->buffer, benchmark->width, benchmark->height, benchmark->format->bpp, true, true, benchmark->format->kind == BAYER ? keywords : NULL, false);
+	double elapsed = now() - start;
+	*output = CCD_IMAGE_ITEM->blob.size;
+	return elapsed;
+}
+
+static int compare(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return x < y ? -1 : x > y;
+}
+
+static void run(benchmark *benchmark, const char *stage, stage_function function, int repeat) {
+	double times[MAX_REPEAT];
+	long output = 0;
+	for (int i = 0; i < repeat; i++)
+		times[i] = function(benchmark, &output);
+	qsort(times, repeat, sizeof(double), compare);
+	double median = repeat % 2 ? times[repeat / 2] : (times[repeat / 2 - 1] + times[repeat / 2]) / 2;
+	printf("%s,%s,%d,%d,%s,%.3f,%.3f,%.2f,%ld\n", INDIGO_BUILD, benchmark->format->name, benchmark->width, benchmark->height, stage, times[0] * 1000, median * 1000, benchmark->width * (double)benchmark->height / times[0] / 1e6, output);
+	fflush(stdout);
+}
+
+static void run_process_image(benchmark *benchmark, const char *stage, indigo_item *format, indigo_item *compression, bool preview, int repeat) {
+	indigo_device *device = benchmark->device;
+	indigo_set_switch(CCD_IMAGE_FORMAT_PROPERTY, format, true);
+	indigo_set_switch(CCD_FITS_COMPRESSION_PROPERTY, CCD_FITS_COMPRESSION_NONE_ITEM, true);
+	indigo_set_switch(CCD_XISF_COMPRESSION_PROPERTY, CCD_XISF_COMPRESSION_NONE_ITEM, true);
+	if (compression)
+		indigo_set_switch(format == CCD_IMAGE_FORMAT_FITS_ITEM ? CCD_FITS_COMPRESSION_PROPERTY : CCD_XISF_COMPRESSION_PROPERTY, compression, true);
+	indigo_set_switch(CCD_PREVIEW_PROPERTY, preview ? CCD_PREVIEW_ENABLED_WITH_HISTOGRAM_ITEM : CCD_PREVIEW_DISABLED_ITEM, true);
+	run(benchmark, stage, process_image, repeat);
+}
+
+static indigo_result attach(indigo_device *device) {
+	device->device_context = NULL;
+	return indigo_ccd_attach(device, "indigo_pipeline_benchmark", INDIGO_VERSION_CURRENT);
+}
+
+int main(int argc, const char * argv[]) {
+	int repeat = 3, size_count = 0, sizes[MAX_SIZES][2];
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+			repeat = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-s") && i + 1 < argc && size_count < MAX_SIZES && sscanf(argv[i + 1], "%dx%d", &sizes[size_count][0], &sizes[size_count][1]) == 2) {
+			size_count++;
+			i++;
+		} else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			indigo_parallel_threads = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-q")) {
+			repeat = 1;
+			sizes[0][0] = 640;
+			sizes[0][1] = 480;
+			size_count = 1;
+		} else {
+			fprintf(stderr, "usage: %s [-r repeat] [-s WIDTHxHEIGHT ...] [-t threads] [-q]\n", argv[0]);
+			fprintf(stderr, "  -r  number of runs of each stage, best and median time is reported (default 3)\n");
+			fprintf(stderr, "  -s  frame size, can be used more than once (default 1280x960, 3096x2080 and 6248x4176)\n");
+			fprintf(stderr, "  -t  number of threads used by parallel stages (default number of CPUs)\n");
+			fprintf(stderr, "  -q  quick run, single 640x480 frame of each format\n");
+			return 1;
+		}
+	}
+	if (repeat < 1 || repeat > MAX_REPEAT)
+		repeat = 3;
+	if (size_count == 0) {
+		int defaults[][2] = { { 1280, 960 }, { 3096, 2080 }, { 6248, 4176 } };
+		memcpy(sizes, defaults, sizeof(defaults));
+		size_count = 3;
+	}
+	indigo_main_argc = argc;
+	indigo_main_argv = argv;
+	indigo_start();
+	static indigo_device device_template = INDIGO_DEVICE_INITIALIZER("Pipeline Benchmark", attach, indigo_ccd_enumerate_properties, indigo_ccd_change_property, NULL, indigo_ccd_detach);
+	indigo_device *device = &device_template;
+	indigo_attach_device(device);
+	srand(1);
+	printf("build,frame,width,height,stage,best_ms,median_ms,mpixels_per_s,output\n");
+	for (int s = 0; s < size_count; s++) {
+		for (int f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+			benchmark benchmark = { device, formats + f, sizes[s][0], sizes[s][1] };
+			benchmark.size = (long)benchmark.width * benchmark.height * formats[f].bpp / 8;
+			/* star field rendered by the shared synthetic frame helper */
+			int count = (int)((long)benchmark.width * benchmark.height / STAR_DENSITY), bayer = formats[f].kind == BAYER ? SYNTHETIC_BAYER : 0;
+			benchmark.frame = synthetic_create_frame(benchmark.width, benchmark.height, formats[f].bpp, count, bayer);
+			benchmark.gradient = synthetic_create_frame(benchmark.width, benchmark.height, formats[f].bpp, count, bayer | SYNTHETIC_SKY_BACKGROUND);
+			benchmark.buffer = indigo_alloc_blob_buffer(FITS_HEADER_SIZE + benchmark.size + FITS_RECORD_SIZE);
+			benchmark.output = indigo_safe_malloc((long)benchmark.width * benchmark.height * 3);
+			run(&benchmark, "stretch_params", stretch_params, repeat);
+			run(&benchmark, "stretch", stretch, repeat);
+			run(&benchmark, "jpeg", full_jpeg, repeat);
+			run(&benchmark, "preview_jpeg", preview_jpeg, repeat);
+			run(&benchmark, "background_mesh", background_mesh, repeat);
+			run(&benchmark, "find_stars", find_stars, repeat);
+			run(&benchmark, "guider_cycle", guider_cycle, repeat);
+			run(&benchmark, "contrast", contrast, repeat);
+			run(&benchmark, "psf_map", psf_map, repeat);
+			run_process_image(&benchmark, "process_fits", CCD_IMAGE_FORMAT_FITS_ITEM, NULL, false, repeat);
+			run_process_image(&benchmark, "process_fits_preview", CCD_IMAGE_FORMAT_FITS_ITEM, NULL, true, repeat);
+			run_process_image(&benchmark, "process_fits_rice", CCD_IMAGE_FORMAT_FITS_ITEM, CCD_FITS_COMPRESSION_RICE_ITEM, false, repeat);
+			run_process_image(&benchmark, "process_xisf", CCD_IMAGE_FORMAT_XISF_ITEM, NULL, false, repeat);
+			run_process_image(&benchmark, "process_xisf_lz4", CCD_IMAGE_FORMAT_XISF_ITEM, CCD_XISF_COMPRESSION_LZ4_ITEM, false, repeat);
+			run_process_image(&benchmark, "process_raw", CCD_IMAGE_FORMAT_RAW_ITEM, NULL, false, repeat);
+			run_process_image(&benchmark, "process_jpeg", CCD_IMAGE_FORMAT_JPEG_ITEM, NULL, false, repeat);
+			run_process_image(&benchmark, "process_tiff", CCD_IMAGE_FORMAT_TIFF_ITEM, NULL, false, repeat);
+			indigo_safe_free(benchmark.frame);
+			indigo_safe_free(benchmark.gradient);
+			indigo_safe_free(benchmark.output);
+			/* image property may still point to the buffer until next image is processed */
+			CCD_IMAGE_ITEM->blob.value = NULL;
+			CCD_IMAGE_ITEM->blob.size = 0;
+			free(benchmark.buffer);
+		}
+	}
+	indigo_detach_device(device);
+	indigo_stop();
+	return 0;
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO CCD preview conversion benchmark (full resolution vs. binned preview)
+ \file indigo_preview_benchmark.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_ccd_driver.h>
+
+#include "indigo_synthetic_frame.h"
+
+#define WIDTH				9576
+#define HEIGHT			6388
+#define STARS				4000
+#define REPEAT			3
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run(indigo_device *device, const char *label, void *frame, int width, int height, int bpp, const char *bayerpat, int max_size) {
+	void *data = NULL, *histogram = NULL;
+	unsigned long size = 0, histogram_size = 0;
+	double best = 1e9;
+	for (int i = 0; i < REPEAT; i++) {
+		double start = now();
+		indigo_raw_to_scaled_jpeg(device, frame, width, height, bpp, bayerpat, max_size, &data, &size, &histogram, &histogram_size, 0.25, -2.8);
+		double elapsed = now() - start;
+		if (elapsed < best)
+			best = elapsed;
+		free(data);
+		free(histogram);
+	}
+	char limit[16] = "full";
+	if (max_size)
+		snprintf(limit, sizeof(limit), "%d", max_size);
+	printf("%-24s %6s %10.1f ms %10ld kB JPEG\n", label, limit, best * 1000, size / 1024);
+}
+
+int main(int argc, const char * argv[]) {
+	indigo_main_argc = argc;
+	indigo_main_argv = argv;
+	indigo_start();
+	indigo_device *device = indigo_safe_malloc(sizeof(indigo_device));
+	strcpy(device->name, "Preview Benchmark");
+	indigo_ccd_attach(device, "indigo_preview_benchmark", INDIGO_VERSION_CURRENT);
+	int sizes[] = { 0, 2000, 1024 };
+	struct {
+		const char *label;
+		int bpp;
+		const char *bayerpat;
+	} formats[] = {
+		{ "16 bit mono", 16, NULL },
+		{ "16 bit RGGB", 16, "RGGB" },
+		{ "8 bit RGGB", 8, "RGGB" },
+		{ "24 bit RGB", 24, NULL }
+	};
+	printf("%dx%d frame, best of %d conversions with histogram\n\n", WIDTH, HEIGHT, REPEAT);
+	for (int i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+		void *frame = synthetic_create_frame(WIDTH, HEIGHT, formats[i].bpp, STARS, 0);
+		for (int j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++)
+			run(device, formats[i].label, frame, WIDTH, HEIGHT, formats[i].bpp, formats[i].bayerpat, sizes[j]);
+		indigo_safe_free(frame);
+	}
+	indigo_ccd_detach(device);
+	indigo_safe_free(device);
+	indigo_stop();
+	return 0;
+}
@@ -0,0 +1,234 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO wire protocol throughput benchmark (XML vs. binary)
+ \file indigo_protocol_benchmark.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_io.h>
+#include <indigo/indigo_queue.h>
+#include <indigo/indigo_xml.h>
+#include <indigo/indigo_driver_xml.h>
+#include <indigo/indigo_client_xml.h>
+#include <indigo/indigo_driver_binary.h>
+#include <indigo/indigo_client_binary.h>
+
+#define UPDATES				100000
+#define BLOB_UPDATES	200
+#define BLOB_SIZE			(1024 * 1024)
+#define TIMEOUT				30
+
+static indigo_property *number_property;
+static indigo_property *blob_property;
+static indigo_property *remote_number_property;
+static indigo_property *remote_blob_property;
+static volatile long number_updates = 0;
+static volatile long blob_updates = 0;
+static int server_handle = -1;
+static volatile long bytes_written = 0;
+
+// write() is interposed to count bytes sent by server side adapter
+
+ssize_t write(int handle, const void *buffer, size_t length) {
+	ssize_t result = syscall(SYS_write, handle, buffer, length);
+	if (handle == server_handle && result > 0)
+		__sync_fetch_and_add(&bytes_written, result);
+	return result;
+}
+
+static indigo_result device_attach(indigo_device *device) {
+	indigo_define_property(device, number_property, NULL);
+	indigo_define_property(device, blob_property, NULL);
+	return INDIGO_OK;
+}
+
+static indigo_result device_enumerate_properties(indigo_device *device, indigo_client *client, indigo_property *property) {
+	if (indigo_property_match(number_property, property))
+		indigo_define_property(device, number_property, NULL);
+	if (indigo_property_match(blob_property, property))
+		indigo_define_property(device, blob_property, NULL);
+	return INDIGO_OK;
+}
+
+static indigo_device bench_device = INDIGO_DEVICE_INITIALIZER(
+	"Bench", device_attach, device_enumerate_properties, NULL, NULL, NULL
+);
+
+static indigo_result client_define_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	if (*property->device == *bench_device.name && strcmp(property->device, bench_device.name)) {
+		if (!strcmp(property->name, number_property->name))
+			remote_number_property = property;
+		else if (!strcmp(property->name, blob_property->name))
+			remote_blob_property = property;
+	}
+	return INDIGO_OK;
+}
+
+static indigo_result client_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	if (property == remote_number_property) {
+		number_updates++;
+	} else if (property == remote_blob_property && property->items[0].blob.size == BLOB_SIZE) {
+		blob_updates++;
+	}
+	return INDIGO_OK;
+}
+
+static indigo_client bench_client = {
+	"Bench client", false, NULL, INDIGO_OK, INDIGO_VERSION_CURRENT, NULL,
+	NULL,
+	client_define_property,
+	client_update_property,
+	NULL,
+	NULL,
+	NULL
+};
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool wait_for(volatile long *counter, long value) {
+	double timeout = now() + TIMEOUT;
+	while (*counter < value) {
+		if (now() > timeout)
+			return false;
+		indigo_usleep(100);
+	}
+	return true;
+}
+
+typedef struct {
+	indigo_device *device;
+	indigo_client *client;
+	bool binary;
+} parser_args;
+
+static void *parser_thread(parser_args *args) {
+	if (args->binary)
+		indigo_binary_parse(args->device, args->client);
+	else
+		indigo_xml_parse(args->device, args->client);
+	return NULL;
+}
+
+static void run(const char *label, bool binary) {
+	int handles[2];
+	socketpair(AF_UNIX, SOCK_STREAM, 0, handles);
+	server_handle = handles[0];
+	remote_number_property = remote_blob_property = NULL;
+	indigo_client *server_adapter = binary ? indigo_binary_device_adapter(handles[0], handles[0]) : indigo_xml_device_adapter(handles[0], handles[0]);
+	indigo_attach_client(server_adapter);
+	parser_args server_args = { NULL, server_adapter, binary };
+	pthread_t server_thread;
+	pthread_create(&server_thread, NULL, (void *(*)(void *))parser_thread, &server_args);
+	indigo_device *client_adapter = binary ? indigo_binary_client_adapter("bench", "", handles[1], handles[1]) : indigo_xml_client_adapter("bench", "", handles[1], handles[1]);
+	indigo_attach_device(client_adapter);
+	parser_args client_args = { client_adapter, NULL, binary };
+	pthread_t client_thread;
+	pthread_create(&client_thread, NULL, (void *(*)(void *))parser_thread, &client_args);
+	indigo_property *all_properties = indigo_init_text_property(NULL, "", "", "", "", INDIGO_OK_STATE, INDIGO_RO_PERM, 0);
+	indigo_enumerate_properties(&bench_client, all_properties);
+	double timeout = now() + TIMEOUT;
+	while ((remote_number_property == NULL || remote_blob_property == NULL) && now() < timeout)
+		indigo_usleep(1000);
+	if (remote_number_property == NULL || remote_blob_property == NULL) {
+		printf("%-8s properties not defined\n", label);
+		exit(1);
+	}
+	number_updates = blob_updates = 0;
+	bytes_written = 0;
+	double start = now();
+	for (int i = 0; i < UPDATES; i++) {
+		for (int j = 0; j < number_property->count; j++)
+			number_property->items[j].number.value = i + j / 10.0;
+		indigo_update_property(&bench_device, number_property, NULL);
+	}
+	bool delivered = wait_for(&number_updates, UPDATES);
+	double elapsed = now() - start;
+	printf("%-8s %6ld of %d number updates %9.0f updates/s %6.1f bytes/update%s\n", label, number_updates, UPDATES, number_updates / elapsed, (double)bytes_written / UPDATES, delivered ? "" : " (timeout)");
+	indigo_enable_blob(&bench_client, remote_blob_property, INDIGO_ENABLE_BLOB_ALSO);
+	indigo_usleep(100000);
+	bytes_written = 0;
+	start = now();
+	for (int i = 0; i < BLOB_UPDATES; i++) {
+		indigo_update_property(&bench_device, blob_property, NULL);
+		/* wait for delivery, so the queue never drops stale BLOB */
+		wait_for(&blob_updates, i + 1);
+	}
+	elapsed = now() - start;
+	printf("%-8s %6ld of %d 1MB BLOBs     %9.1f MB/s      %6.0f bytes/BLOB\n", label, blob_updates, BLOB_UPDATES, blob_updates / elapsed, (double)bytes_written / BLOB_UPDATES);
+	/* close() does not wake up blocked parser */
+	shutdown(handles[1], SHUT_RDWR);
+	indigo_detach_device(client_adapter);
+	pthread_join(client_thread, NULL);
+	pthread_join(server_thread, NULL);
+	indigo_detach_client(server_adapter);
+	if (binary)
+		indigo_release_binary_device_adapter(server_adapter);
+	else
+		indigo_release_xml_device_adapter(server_adapter);
+	free(client_adapter->device_context);
+	free(client_adapter);
+	indigo_release_property(all_properties);
+}
+
+int main(int argc, const char * argv[]) {
+	indigo_main_argc = argc;
+	indigo_main_argv = argv;
+	indigo_queue_size = UPDATES + 1024;
+	indigo_queue_max_bytes = 1L << 32;
+	indigo_queue_coalesce = false;
+	number_property = indigo_init_number_property(NULL, bench_device.name, "BENCH_NUMBERS", "Bench", "Numbers", INDIGO_OK_STATE, INDIGO_RO_PERM, 8);
+	for (int i = 0; i < number_property->count; i++) {
+		char name[INDIGO_NAME_SIZE];
+		snprintf(name, sizeof(name), "VALUE_%d", i);
+		indigo_init_number_item(number_property->items + i, name, name, -1e6, 1e6, 0, 0);
+	}
+	blob_property = indigo_init_blob_property(NULL, bench_device.name, "BENCH_BLOB", "Bench", "BLOB", INDIGO_OK_STATE, 1);
+	indigo_init_blob_item(blob_property->items, "IMAGE", "Image");
+	blob_property->items[0].blob.value = malloc(BLOB_SIZE);
+	blob_property->items[0].blob.size = BLOB_SIZE;
+	for (int i = 0; i < BLOB_SIZE; i++)
+		((unsigned char *)blob_property->items[0].blob.value)[i] = rand();
+	strcpy(blob_property->items[0].blob.format, ".raw");
+	indigo_start();
+	indigo_attach_device(&bench_device);
+	indigo_attach_client(&bench_client);
+	printf("%d updates of %d item number vector, %d BLOB updates\n\n", UPDATES, number_property->count, BLOB_UPDATES);
+	run("XML", false);
+	run("binary", true);
+	indigo_detach_client(&bench_client);
+	indigo_detach_device(&bench_device);
+	indigo_stop();
+	return 0;
+}
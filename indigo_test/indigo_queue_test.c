@@ -0,0 +1,203 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO outbound queue ordering test
+ \file indigo_queue_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_queue.h>
+
+#define RATE	2
+
+static char sent[4096];
+static pthread_mutex_t sent_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool passed = true;
+
+static bool record_write(int handle, const char *buffer, long length) {
+	pthread_mutex_lock(&sent_mutex);
+	long used = strlen(sent);
+	if (used + length < (long)sizeof(sent)) {
+		memcpy(sent + used, buffer, length);
+		sent[used + length] = 0;
+	}
+	pthread_mutex_unlock(&sent_mutex);
+	return true;
+}
+
+static void push_update(indigo_queue *queue, indigo_property *property, int value) {
+	indigo_queue_entry *entry = indigo_queue_entry_create_update(property, NULL);
+	indigo_queue_entry_printf(entry, "set %s.%s %d\n", property->device, property->name, value);
+	indigo_queue_push(queue, entry);
+}
+
+static void push_delete(indigo_queue *queue, indigo_property *property) {
+	indigo_queue_entry *entry = indigo_queue_entry_create_delete(property, property->device);
+	indigo_queue_entry_printf(entry, "del %s.%s\n", property->device, property->name);
+	indigo_queue_push(queue, entry);
+}
+
+static void check(const char *name, const char *expected) {
+	pthread_mutex_lock(&sent_mutex);
+	bool result = !strcmp(sent, expected);
+	printf("%-40s %s\n", name, result ? "OK" : "FAILED");
+	if (!result)
+		printf("expected:\n%sgot:\n%s", expected, sent);
+	*sent = 0;
+	pthread_mutex_unlock(&sent_mutex);
+	passed = passed && result;
+}
+
+int main(int argc, const char * argv[]) {
+	indigo_adapter_context context = { 0 };
+	context.input = context.output = open("/dev/null", O_WRONLY);
+	indigo_queue *queue = indigo_queue_create(&context, record_write, true);
+	indigo_queue_set_update_rate(queue, NULL, NULL, RATE);
+	indigo_property *mount = indigo_init_number_property(NULL, "Mount", "POSITION", "", "", INDIGO_OK_STATE, INDIGO_RO_PERM, 1);
+	indigo_property *focuser = indigo_init_number_property(NULL, "Focuser", "POSITION", "", "", INDIGO_OK_STATE, INDIGO_RO_PERM, 1);
+	indigo_property *mount_all = indigo_init_text_property(NULL, "Mount", "", "", "", INDIGO_OK_STATE, INDIGO_RO_PERM, 0);
+
+	// the first updates are sent immediately, the next ones are delayed by rate limit
+
+	push_update(queue, mount, 1);
+	push_update(queue, focuser, 1);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	push_update(queue, mount, 2);
+	push_update(queue, focuser, 2);
+	push_delete(queue, mount_all);
+	indigo_usleep(2 * ONE_SECOND_DELAY / RATE);
+	check("device deletion after delayed update", "set Mount.POSITION 1\nset Focuser.POSITION 1\nset Mount.POSITION 2\ndel Mount.\nset Focuser.POSITION 2\n");
+
+	// named deletion flushes delayed update of the same property only
+
+	push_update(queue, focuser, 3);
+	push_update(queue, mount, 3);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	push_update(queue, focuser, 4);
+	push_update(queue, mount, 4);
+	push_delete(queue, focuser);
+	indigo_usleep(2 * ONE_SECOND_DELAY / RATE);
+	check("property deletion after delayed update", "set Focuser.POSITION 3\nset Mount.POSITION 3\nset Focuser.POSITION 4\ndel Focuser.POSITION\nset Mount.POSITION 4\n");
+
+	// several pending updates are merged into one delayed update
+
+	indigo_property *ra = indigo_init_number_property(NULL, "Mount", "RA", "", "", INDIGO_OK_STATE, INDIGO_RO_PERM, 1);
+	push_update(queue, ra, 1);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	push_update(queue, ra, 2);
+	push_update(queue, ra, 3);
+	push_update(queue, ra, 4);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	check("coalescing before rate limit", "set Mount.RA 1\n");
+	indigo_usleep(2 * ONE_SECOND_DELAY / RATE);
+	check("coalescing after rate limit", "set Mount.RA 4\n");
+
+	// state transitions are never delayed, pending update is flushed before them
+
+	indigo_property *dec = indigo_init_number_property(NULL, "Mount", "DEC", "", "", INDIGO_OK_STATE, INDIGO_RO_PERM, 1);
+	push_update(queue, dec, 1);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	dec->state = INDIGO_BUSY_STATE;
+	push_update(queue, dec, 2);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	push_update(queue, dec, 3);
+	dec->state = INDIGO_OK_STATE;
+	push_update(queue, dec, 4);
+	dec->state = INDIGO_ALERT_STATE;
+	push_update(queue, dec, 5);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	check("state transitions", "set Mount.DEC 1\nset Mount.DEC 2\nset Mount.DEC 3\nset Mount.DEC 4\nset Mount.DEC 5\n");
+
+	// per property policy selected by name prefix
+
+	indigo_queue_set_update_rate(queue, "Guider", "STAT*", 0);
+	indigo_property *stats = indigo_init_number_property(NULL, "Guider", "STATS", "", "", INDIGO_OK_STATE, INDIGO_RO_PERM, 1);
+	indigo_property *settings = indigo_init_number_property(NULL, "Guider", "SETTINGS", "", "", INDIGO_OK_STATE, INDIGO_RO_PERM, 1);
+	push_update(queue, settings, 1);
+	push_update(queue, stats, 1);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	push_update(queue, settings, 2);
+	push_update(queue, stats, 2);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	push_update(queue, stats, 3);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	check("unlimited policy by pattern", "set Guider.SETTINGS 1\nset Guider.STATS 1\nset Guider.STATS 2\nset Guider.STATS 3\n");
+	indigo_usleep(2 * ONE_SECOND_DELAY / RATE);
+	check("default policy for other properties", "set Guider.SETTINGS 2\n");
+
+	// BLOBs are never delayed or coalesced
+
+	indigo_property *image = indigo_init_blob_property(NULL, "CCD", "IMAGE", "", "", INDIGO_OK_STATE, 1);
+	push_update(queue, image, 1);
+	push_update(queue, image, 2);
+	push_update(queue, image, 3);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	check("BLOB updates", "set CCD.IMAGE 1\nset CCD.IMAGE 2\nset CCD.IMAGE 3\n");
+
+	// live counters of all queues
+
+	indigo_queue_stats total;
+	int count = indigo_queue_get_total_stats(&total);
+	bool result = count == 1 && total.depth == 0 && total.bytes == 0 && total.sent == 25;
+	printf("%-40s %s\n", "total statistics", result ? "OK" : "FAILED");
+	if (!result)
+		printf("got %d queues, depth %d, bytes %ld, sent %ld\n", count, total.depth, total.bytes, total.sent);
+	passed = passed && result;
+
+	// queue served by shared writer pool keeps order and delays
+
+	indigo_queue *shared = indigo_queue_create_shared(&context, record_write);
+	indigo_queue_set_update_rate(shared, NULL, NULL, RATE);
+	push_update(shared, mount, 5);
+	push_update(shared, focuser, 5);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	push_update(shared, mount, 6);
+	push_update(shared, mount, 7);
+	push_delete(shared, focuser);
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	check("shared writer before rate limit", "set Mount.POSITION 5\nset Focuser.POSITION 5\ndel Focuser.POSITION\n");
+	indigo_usleep(2 * ONE_SECOND_DELAY / RATE);
+	check("shared writer after rate limit", "set Mount.POSITION 7\n");
+	indigo_queue_release(shared);
+
+	indigo_queue_release(queue);
+	result = indigo_queue_get_total_stats(&total) == 0;
+	printf("%-40s %s\n", "released queue statistics", result ? "OK" : "FAILED");
+	passed = passed && result;
+	close(context.output);
+	indigo_release_property(mount);
+	indigo_release_property(focuser);
+	indigo_release_property(mount_all);
+	indigo_release_property(ra);
+	indigo_release_property(dec);
+	indigo_release_property(stats);
+	indigo_release_property(settings);
+	indigo_release_property(image);
+	printf("\n%s\n", passed ? "PASSED" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,328 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO TCP server load test
+ \file indigo_server_load_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_io.h>
+#include <indigo/indigo_json.h>
+#include <indigo/indigo_server_tcp.h>
+#include <indigo/indigo_queue.h>
+
+#define CLIENTS		1000
+#define REQUESTS	5
+#define STALLED		16
+
+static const char *response = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nOK";
+static int sockets[CLIENTS];
+static int stalled[2 * STALLED];
+static int clients = 0;
+static bool started = false;
+static int threads = 0;
+static indigo_property *load_property;
+
+static void server_callback(int count) {
+	if (count == 0)
+		started = true;
+	clients = count;
+}
+
+static bool load_handler(int socket, char *method, char *path, char *params) {
+	return indigo_write(socket, response, strlen(response));
+}
+
+static bool slow_handler(int socket, char *method, char *path, char *params) {
+	indigo_usleep(2 * ONE_SECOND_DELAY);
+	return indigo_write(socket, response, strlen(response));
+}
+
+/* property is sent to the requesting client only, broadcast to 1000 web socket sessions would make the test quadratic */
+
+static indigo_result device_attach(indigo_device *device) {
+	load_property = indigo_init_text_property(NULL, device->name, "LOAD", "Main", "Load", INDIGO_OK_STATE, INDIGO_RO_PERM, 1);
+	indigo_init_text_item(load_property->items, "VALUE", "Value", "OK");
+	return INDIGO_OK;
+}
+
+static indigo_result device_enumerate_properties(indigo_device *device, indigo_client *client, indigo_property *property) {
+	if (client && client->define_property && indigo_property_match(load_property, property))
+		client->define_property(client, device, load_property, NULL);
+	return INDIGO_OK;
+}
+
+static indigo_device load_device = INDIGO_DEVICE_INITIALIZER(
+	"Load", device_attach, device_enumerate_properties, NULL, NULL, NULL
+);
+
+static void *server_thread(void *data) {
+	indigo_server_start(server_callback);
+	return NULL;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *label) {
+	char line[256];
+	long rss = 0;
+	FILE *file = fopen("/proc/self/status", "r");
+	if (file) {
+		while (fgets(line, sizeof(line), file)) {
+			sscanf(line, "Threads: %d", &threads);
+			sscanf(line, "VmRSS: %ld", &rss);
+		}
+		fclose(file);
+	}
+	printf("%-36s %6d connections %6d threads %8ld kB RSS\n", label, clients, threads, rss);
+}
+
+static bool request(int socket, bool keep_alive) {
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), "GET /load HTTP/1.1\r\nHost: localhost\r\n%s\r\n", keep_alive ? "" : "Connection: close\r\n");
+	if (!indigo_write(socket, buffer, strlen(buffer)))
+		return false;
+	long length = strlen(response);
+	return indigo_read(socket, buffer, length) == length && !strncmp(buffer, response, length);
+}
+
+static bool send_request(int socket, const char *path) {
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), "GET %s HTTP/1.1\r\nHost: localhost\r\n\r\n", path);
+	return indigo_write(socket, buffer, strlen(buffer));
+}
+
+static bool receive_response(int socket) {
+	char buffer[256];
+	long length = strlen(response);
+	return indigo_read(socket, buffer, length) == length && !strncmp(buffer, response, length);
+}
+
+static bool upgrade(int socket) {
+	char buffer[1024];
+	const char *request = "GET / HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+	if (!indigo_write(socket, request, strlen(request)))
+		return false;
+	int length = 0;
+	while (length < sizeof(buffer) - 1 && indigo_read(socket, buffer + length, 1) == 1) {
+		buffer[++length] = 0;
+		if (length >= 4 && !strcmp(buffer + length - 4, "\r\n\r\n"))
+			return !strncmp(buffer, "HTTP/1.1 101", 12);
+	}
+	return false;
+}
+
+/* client frames are masked, the message is split into two fragments to exercise frame reassembly */
+
+static bool send_frame(int socket, const char *message) {
+	uint8_t frame[256];
+	const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+	long length = strlen(message);
+	long split = length / 2;
+	for (int fragment = 0; fragment < 2; fragment++) {
+		const char *payload = message + (fragment ? split : 0);
+		long payload_length = fragment ? length - split : split;
+		frame[0] = fragment ? 0x80 : 0x01;
+		frame[1] = 0x80 | payload_length;
+		memcpy(frame + 2, mask, 4);
+		for (long i = 0; i < payload_length; i++)
+			frame[6 + i] = payload[i] ^ mask[i % 4];
+		if (!indigo_write(socket, (char *)frame, 6 + payload_length))
+			return false;
+	}
+	return true;
+}
+
+static bool receive_frame(int socket, const char *expected) {
+	uint8_t header[4];
+	char payload[4096];
+	if (indigo_read(socket, (char *)header, 2) != 2 || header[0] != 0x81)
+		return false;
+	long length = header[1] & 0x7F;
+	if (length == 0x7E) {
+		if (indigo_read(socket, (char *)header + 2, 2) != 2)
+			return false;
+		length = (header[2] << 8) | header[3];
+	}
+	if (length >= sizeof(payload) || indigo_read(socket, payload, length) != length)
+		return false;
+	payload[length] = 0;
+	return strstr(payload, expected) != NULL;
+}
+
+static void wait_for_clients(int count) {
+	double timeout = now() + 10;
+	while (clients != count && now() < timeout)
+		indigo_usleep(1000);
+}
+
+int main(int argc, const char * argv[]) {
+	indigo_main_argc = argc;
+	indigo_main_argv = argv;
+	struct rlimit limit;
+	getrlimit(RLIMIT_NOFILE, &limit);
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+	if (limit.rlim_cur < 2 * CLIENTS + 64) {
+		printf("Open file limit %ld is too low\n", (long)limit.rlim_cur);
+		return 1;
+	}
+	indigo_use_bonjour = false;
+	indigo_server_tcp_port = 0;
+	if (argc > 1)
+		indigo_server_tcp_threads = atoi(argv[1]);
+	indigo_start();
+	indigo_server_add_handler("/load", load_handler);
+	indigo_server_add_handler("/slow", slow_handler);
+	indigo_attach_device(&load_device);
+	pthread_t thread;
+	pthread_create(&thread, NULL, server_thread, NULL);
+	while (!started)
+		indigo_usleep(1000);
+	printf("%d network threads (0 = thread per connection)\n\n", indigo_server_tcp_threads);
+	report("idle");
+	int idle_threads = threads;
+	struct sockaddr_in address = { 0 };
+	address.sin_family = AF_INET;
+	address.sin_port = htons(indigo_server_tcp_port);
+	address.sin_addr.s_addr = inet_addr("127.0.0.1");
+	int failed = 0;
+	double start = now();
+	for (int i = 0; i < CLIENTS; i++) {
+		sockets[i] = socket(PF_INET, SOCK_STREAM, 0);
+		if (connect(sockets[i], (struct sockaddr *)&address, sizeof(address)) < 0 || !request(sockets[i], true))
+			failed++;
+	}
+	wait_for_clients(CLIENTS);
+	report("connected, first request served");
+	for (int r = 1; r < REQUESTS; r++) {
+		for (int i = 0; i < CLIENTS; i++) {
+			if (!request(sockets[i], true))
+				failed++;
+		}
+	}
+	double elapsed = now() - start;
+	report("keep-alive requests served");
+	printf("%d requests in %.3fs (%.0f requests/s), %d failed\n", CLIENTS * REQUESTS, elapsed, CLIENTS * REQUESTS / elapsed, failed);
+	/* all clients send request before any response is read, so the request queue overflows and network threads have to wait for request threads */
+	start = now();
+	for (int r = 0; r < REQUESTS; r++) {
+		for (int i = 0; i < CLIENTS; i++) {
+			if (!send_request(sockets[i], "/load"))
+				failed++;
+		}
+		for (int i = 0; i < CLIENTS; i++) {
+			if (!receive_response(sockets[i]))
+				failed++;
+		}
+	}
+	elapsed = now() - start;
+	report("concurrent requests served");
+	printf("%d requests in flight at once, %d requests in %.3fs (%.0f requests/s), %d failed\n", CLIENTS, CLIENTS * REQUESTS, elapsed, CLIENTS * REQUESTS / elapsed, failed);
+	if (indigo_server_tcp_threads > 0 && threads > idle_threads + indigo_server_tcp_workers) {
+		printf("%d threads exceed %d request threads limit\n", threads - idle_threads, indigo_server_tcp_workers);
+		failed++;
+	}
+	for (int i = 0; i < 2 * STALLED; i++) {
+		/* half of clients never complete request headers, the other half waits for slow handler */
+		const char *partial = i < STALLED ? "GET /load HTTP/1.1\r\nHost: loc" : "GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n";
+		stalled[i] = socket(PF_INET, SOCK_STREAM, 0);
+		if (connect(stalled[i], (struct sockaddr *)&address, sizeof(address)) < 0 || !indigo_write(stalled[i], partial, strlen(partial)))
+			failed++;
+	}
+	indigo_usleep(ONE_SECOND_DELAY / 10);
+	start = now();
+	int probe = socket(PF_INET, SOCK_STREAM, 0);
+	if (connect(probe, (struct sockaddr *)&address, sizeof(address)) < 0 || !request(probe, false))
+		failed++;
+	close(probe);
+	elapsed = now() - start;
+	printf("request served in %.3fs next to %d stalled clients\n", elapsed, 2 * STALLED);
+	if (elapsed > 1)
+		failed++;
+	for (int i = 0; i < 2 * STALLED; i++)
+		close(stalled[i]);
+	wait_for_clients(CLIENTS);
+	start = now();
+	for (int i = 0; i < CLIENTS; i++) {
+		if (!request(sockets[i], false))
+			failed++;
+		close(sockets[i]);
+	}
+	wait_for_clients(0);
+	elapsed = now() - start;
+	report("closed by server");
+	printf("%d closing requests and disconnects in %.3fs\n", CLIENTS, elapsed);
+	start = now();
+	for (int i = 0; i < CLIENTS; i++) {
+		sockets[i] = socket(PF_INET, SOCK_STREAM, 0);
+		if (connect(sockets[i], (struct sockaddr *)&address, sizeof(address)) < 0 || !upgrade(sockets[i]))
+			failed++;
+	}
+	wait_for_clients(CLIENTS);
+	elapsed = now() - start;
+	report("web socket sessions open");
+	printf("%d web socket sessions opened in %.3fs\n", CLIENTS, elapsed);
+	start = now();
+	for (int i = 0; i < CLIENTS; i++) {
+		if (!send_frame(sockets[i], "{ \"getProperties\": { \"version\": 512, \"device\": \"Load\", \"name\": \"LOAD\" } }"))
+			failed++;
+	}
+	for (int i = 0; i < CLIENTS; i++) {
+		if (!receive_frame(sockets[i], "\"defTextVector\""))
+			failed++;
+	}
+	elapsed = now() - start;
+	report("web socket messages served");
+	printf("%d web socket requests and responses in %.3fs, %d failed\n", CLIENTS, elapsed, failed);
+	if (indigo_server_tcp_threads > 0 && threads > idle_threads + indigo_server_tcp_workers + indigo_queue_shared_writers) {
+		printf("%d threads exceed %d request and %d shared writer threads limit\n", threads - idle_threads, indigo_server_tcp_workers, indigo_queue_shared_writers);
+		failed++;
+	}
+	start = now();
+	for (int i = 0; i < CLIENTS; i++)
+		close(sockets[i]);
+	wait_for_clients(0);
+	elapsed = now() - start;
+	report("web socket sessions closed");
+	printf("%d web socket sessions closed in %.3fs\n", CLIENTS, elapsed);
+	indigo_server_shutdown();
+	pthread_join(thread, NULL);
+	indigo_detach_device(&load_device);
+	indigo_release_property(load_property);
+	indigo_stop();
+	return failed || clients ? 1 : 0;
+}
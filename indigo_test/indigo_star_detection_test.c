@@ -0,0 +1,223 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO star detection test (detected positions are compared with stars rendered the same way as CCD simulator does)
+ \file indigo_star_detection_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_raw_utils.h>
+
+#include "indigo_synthetic_frame.h"
+
+#define MAX_STARS				64
+#define WIDTH						1280
+#define HEIGHT					960
+
+typedef struct {
+	double x, y;
+	int amplitude;
+} star;
+
+static int failures = 0;
+
+/* stars are placed to the grid cells with random subpixel offset, the brighter star the lower index */
+
+static int render_field(uint16_t *frame, int width, int height, int noise, int max_amplitude, int min_amplitude, star *stars) {
+	synthetic_fill_background(frame, (long)width * height, 0, noise);
+	int count = 0;
+	for (int y = 80; y < height - 80; y += 100) {
+		for (int x = 80; x < width - 80; x += 100) {
+			int amplitude = max_amplitude * pow(0.9, count);
+			if (count == MAX_STARS || amplitude < min_amplitude)
+				break;
+			stars[count].x = x + rand() % 40 + rand() / (double)RAND_MAX;
+			stars[count].y = y + rand() % 40 + rand() / (double)RAND_MAX;
+			stars[count].amplitude = amplitude;
+			count++;
+		}
+	}
+	for (int i = 0; i < count; i++)
+		synthetic_render_star(frame, width, height, 1, stars[i].x, stars[i].y, stars[i].amplitude);
+	return count;
+}
+
+/* frame digest uses pixel centre convention, rendered star at (x, y) is detected at (x + 0.5, y + 0.5) */
+
+static int match_star(indigo_star_detection *detection, star *stars, int count, double tolerance) {
+	for (int i = 0; i < count; i++) {
+		if (fabs(detection->x - stars[i].x - 0.5) <= tolerance && fabs(detection->y - stars[i].y - 0.5) <= tolerance)
+			return i;
+	}
+	return -1;
+}
+
+static void report(const char *label, bool ok, const char *message) {
+	if (ok)
+		printf("%-36s %5dx%-5d OK\n", label, WIDTH, HEIGHT);
+	else {
+		printf("%-36s %5dx%-5d FAILED (%s)\n", label, WIDTH, HEIGHT, message);
+		failures++;
+	}
+}
+
+/* all stars must be found exactly once, at the right position and without any false detection */
+
+static void check_all_found(const char *label, indigo_raw_type raw_type, void *data, int radius, star *stars, int count, double tolerance) {
+	indigo_star_detection detections[MAX_STARS * 2];
+	int found = 0;
+	bool matched[MAX_STARS] = { false };
+	char message[128] = "";
+	indigo_find_stars_precise(raw_type, data, radius, WIDTH, HEIGHT, MAX_STARS * 2, detections, &found);
+	if (found != count)
+		snprintf(message, sizeof(message), "found %d of %d stars", found, count);
+	for (int i = 0; i < found && *message == 0; i++) {
+		int index = match_star(detections + i, stars, count, tolerance);
+		if (index < 0 || matched[index])
+			snprintf(message, sizeof(message), "unexpected star at %.2f, %.2f", detections[i].x, detections[i].y);
+		else if (detections[i].close_to_other || detections[i].oversaturated)
+			snprintf(message, sizeof(message), "star at %.2f, %.2f flagged", detections[i].x, detections[i].y);
+		else
+			matched[index] = true;
+	}
+	for (int i = 1; i < found && *message == 0; i++) {
+		if (detections[i].luminance > detections[i - 1].luminance)
+			snprintf(message, sizeof(message), "stars are not sorted by luminance");
+	}
+	report(label, *message == 0, message);
+}
+
+static void test_mono16(void) {
+	uint16_t *frame = malloc(WIDTH * HEIGHT * sizeof(uint16_t));
+	star stars[MAX_STARS];
+	int count = render_field(frame, WIDTH, HEIGHT, 0x7F, 30000, 2000, stars);
+	check_all_found("mono 16 bit, radius 8", INDIGO_RAW_MONO16, frame, 8, stars, count, 0.15);
+	check_all_found("mono 16 bit, radius 0", INDIGO_RAW_MONO16, frame, 0, stars, count, 1.0);
+	// stars_max limit, the brightest stars must be returned
+	indigo_star_detection detections[MAX_STARS];
+	int found = 0;
+	char message[128] = "";
+	indigo_find_stars_precise(INDIGO_RAW_MONO16, frame, 8, WIDTH, HEIGHT, 10, detections, &found);
+	if (found != 10)
+		snprintf(message, sizeof(message), "found %d of 10 stars", found);
+	for (int i = 0; i < found && *message == 0; i++) {
+		int index = match_star(detections + i, stars, count, 0.15);
+		if (index < 0 || index >= 10)
+			snprintf(message, sizeof(message), "star at %.2f, %.2f is not one of the brightest", detections[i].x, detections[i].y);
+	}
+	report("mono 16 bit, stars_max 10", *message == 0, message);
+	// hot pixels and hot column must be ignored
+	for (int i = 0; i < 200; i++)
+		frame[(rand() % HEIGHT) * WIDTH + rand() % WIDTH] = 8000;
+	for (int y = 0; y < HEIGHT; y++)
+		frame[y * WIDTH + 1234] = 2000;
+	check_all_found("mono 16 bit, hot pixels and column", INDIGO_RAW_MONO16, frame, 8, stars, count, 0.15);
+	free(frame);
+}
+
+static void test_saturated_and_blended(void) {
+	uint16_t *frame = malloc(WIDTH * HEIGHT * sizeof(uint16_t));
+	for (int i = 0; i < WIDTH * HEIGHT; i++)
+		frame[i] = rand() & 0x7F;
+	synthetic_render_star(frame, WIDTH, HEIGHT, 1, 300.3, 300.6, 200000);
+	synthetic_render_star(frame, WIDTH, HEIGHT, 1, 800.4, 500.2, 20000);
+	synthetic_render_star(frame, WIDTH, HEIGHT, 1, 808.4, 500.5, 10000);
+	indigo_star_detection detections[MAX_STARS];
+	int found = 0;
+	indigo_find_stars_precise(INDIGO_RAW_MONO16, frame, 8, WIDTH, HEIGHT, MAX_STARS, detections, &found);
+	bool saturated = false, blended = false;
+	for (int i = 0; i < found; i++) {
+		if (fabs(detections[i].x - 300.8) < 1 && fabs(detections[i].y - 301.1) < 1)
+			saturated = detections[i].oversaturated;
+		if (fabs(detections[i].x - 804) < 6 && fabs(detections[i].y - 500.7) < 2)
+			blended = blended || detections[i].close_to_other;
+	}
+	report("mono 16 bit, saturated star", saturated, "not flagged as oversaturated");
+	report("mono 16 bit, blended stars", blended, "not flagged as close to other");
+	free(frame);
+}
+
+static void test_8bit(void) {
+	uint16_t *frame = malloc(WIDTH * HEIGHT * sizeof(uint16_t));
+	uint8_t *mono = malloc(WIDTH * HEIGHT);
+	uint8_t *rgb = malloc(3 * WIDTH * HEIGHT);
+	star stars[MAX_STARS];
+	int count = render_field(frame, WIDTH, HEIGHT, 0x0F, 200, 100, stars);
+	for (int i = 0; i < WIDTH * HEIGHT; i++) {
+		mono[i] = frame[i] > 0xFF ? 0xFF : frame[i];
+		rgb[3 * i] = rgb[3 * i + 1] = rgb[3 * i + 2] = mono[i];
+	}
+	free(frame);
+	check_all_found("mono 8 bit, radius 8", INDIGO_RAW_MONO8, mono, 8, stars, count, 0.2);
+	check_all_found("rgb 24 bit, radius 8", INDIGO_RAW_RGB24, rgb, 8, stars, count, 0.2);
+	free(mono);
+	free(rgb);
+}
+
+/* sky gradient (moonlight) and vignetting, uniform noise 0..127 adds 63.5 to the mean and has stddev 36.9, local gradient inside of mesh cell adds to the estimated noise */
+
+static void test_background(void) {
+	uint16_t *frame = malloc(WIDTH * HEIGHT * sizeof(uint16_t));
+	star stars[MAX_STARS];
+	int count = render_field(frame, WIDTH, HEIGHT, 0x7F, 30000, 2000, stars);
+	synthetic_add_sky_background(frame, WIDTH, HEIGHT, 1, 1);
+	indigo_background_mesh mesh = { 0 };
+	char message[128] = "";
+	indigo_make_background_mesh(INDIGO_RAW_MONO16, frame, WIDTH, HEIGHT, INDIGO_BACKGROUND_MESH_CELL, &mesh);
+	if (mesh.columns != WIDTH / INDIGO_BACKGROUND_MESH_CELL || mesh.rows != HEIGHT / INDIGO_BACKGROUND_MESH_CELL)
+		snprintf(message, sizeof(message), "mesh is %dx%d", mesh.columns, mesh.rows);
+	for (int y = 100; y < HEIGHT - 100 && *message == 0; y += 97) {
+		for (int x = 100; x < WIDTH - 100 && *message == 0; x += 101) {
+			double background, noise;
+			indigo_background_at(&mesh, x, y, &background, &noise);
+			double expected = synthetic_sky_background(x, y, WIDTH, HEIGHT) + 63.5;
+			if (fabs(background - expected) > 10 || noise < 36.9 * 0.9 || noise > 36.9 * 1.5)
+				snprintf(message, sizeof(message), "background %.1f, noise %.1f at %d, %d (expected %.1f, 36.9)", background, noise, x, y, expected);
+		}
+	}
+	report("background mesh, gradient", *message == 0, message);
+	check_all_found("mono 16 bit, gradient, mesh computed", INDIGO_RAW_MONO16, frame, 8, stars, count, 0.15);
+	indigo_star_detection detections[MAX_STARS * 2];
+	int found = 0;
+	indigo_find_stars_with_background(INDIGO_RAW_MONO16, frame, 8, WIDTH, HEIGHT, &mesh, MAX_STARS * 2, detections, &found);
+	snprintf(message, sizeof(message), "found %d of %d stars", found, count);
+	report("mono 16 bit, gradient, mesh given", found == count, message);
+	indigo_delete_background_mesh(&mesh);
+	free(frame);
+}
+
+int main(int argc, const char * argv[]) {
+	srand(1);
+	test_mono16();
+	test_saturated_and_blended();
+	test_8bit();
+	test_background();
+	printf("\n%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,376 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO debayer and stretch regression test (output must be bit-exact with the reference per-pixel implementation)
+ \file indigo_stretch_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_stretch.h>
+
+#include "indigo_synthetic_frame.h"
+
+// reference implementation, generic per-pixel code the optimized kernels must match
+
+static inline int px(const void *raw, int bpp, int index) {
+	return bpp == 8 ? ((const uint8_t *)raw)[index] : ((const uint16_t *)raw)[index];
+}
+
+static void reference_debayer(const void *raw, int bpp, int index, int row, int column, int width, int height, int offsets, float *red, float *green, float *blue) {
+	#define P(i) px(raw, bpp, i)
+	switch (offsets ^ ((column & 1) << 4 | (row & 1))) {
+		case 0x00:
+			*red = P(index);
+			if (column == 0) {
+				if (row == 0) {
+					*green = (P(index + 1) + P(index + width)) / 2.0;
+					*blue = P(index + width + 1);
+				} else if (row == height - 1) {
+					*green = (P(index + 1) + P(index - width)) / 2.0;
+					*blue = P(index - width + 1);
+				} else {
+					*green = (P(index + 1) + P(index + width) + P(index - width)) / 3.0;
+					*blue = (P(index - width + 1) + P(index + width + 1)) / 2.0;
+				}
+			} else if (column == width - 1) {
+				if (row == 0) {
+					*green = (P(index - 1) + P(index + width)) / 2.0;
+					*blue = (P(index + width - 1) + P(index + width + 1)) / 2.0;
+				} else if (row == height - 1) {
+					*green = (P(index - 1) + P(index - width)) / 2.0;
+					*blue = (P(index - width - 1) + P(index - width + 1)) / 2.0;
+				} else {
+					*green = (P(index - 1) + P(index + width) + P(index - width)) / 3.0;
+					*blue = (P(index - width - 1) + P(index + width - 1)) / 2.0;
+				}
+			} else {
+				if (row == 0) {
+					*green = (P(index + 1) + P(index - 1) + P(index + width)) / 3.0;
+					*blue = (P(index + width - 1) + P(index + width + 1)) / 2.0;
+				} else if (row == height - 1) {
+					*green = (P(index + 1) + P(index - 1) + P(index - width)) / 3.0;
+					*blue = (P(index - width - 1) + P(index - width + 1)) / 2.0;
+				} else {
+					*green = (P(index + 1) + P(index - 1) + P(index + width) + P(index - width)) / 4.0;
+					*blue = (P(index - width - 1) + P(index - width + 1) + P(index + width - 1) + P(index + width + 1)) / 4.0;
+				}
+			}
+			break;
+		case 0x10:
+			if (column == 0) {
+				*red = P(index + 1);
+			} else if (column == width - 1) {
+				*red = P(index - 1);
+			} else {
+				*red = (P(index - 1) + P(index + 1)) / 2.0;
+			}
+			*green = P(index);
+			if (row == 0) {
+				*blue = P(index + width);
+			} else if (row == height - 1) {
+				*blue = P(index - width);
+			} else {
+				*blue = (P(index - width) + P(index + width)) / 2.0;
+			}
+			break;
+		case 0x01:
+			if (row == 0) {
+				*red = P(index + width);
+			} else if (row == height - 1) {
+				*red = P(index - width);
+			} else {
+				*red = (P(index - width) + P(index + width)) / 2.0;
+			}
+			*green = P(index);
+			if (column == 0) {
+				*blue = P(index + 1);
+			} else if (column == width - 1) {
+				*blue = P(index - 1);
+			} else {
+				*blue = (P(index - 1) + P(index + 1)) / 2.0;
+			}
+			break;
+		case 0x11:
+			if (column == 0) {
+				if (row == 0) {
+					*red = P(index + width + 1);
+					*green = (P(index + 1) + P(index + width)) / 2.0;
+				} else if (row == height - 1) {
+					*red = P(index - width + 1);
+					*green = (P(index + 1) + P(index - width)) / 2.0;
+				} else {
+					*red = P(index - width + 1);
+					*green = (P(index + 1) + P(index + width) + P(index - width)) / 3.0;
+				}
+			} else if (column == width - 1) {
+				if (row == 0) {
+					*red = P(index + width - 1);
+					*green = (P(index - 1) + P(index + width)) / 2.0;
+				} else if (row == height - 1) {
+					*red = P(index - width - 1);
+					*green = (P(index - 1) + P(index - width)) / 2.0;
+				} else {
+					*red = (P(index - width - 1) + P(index + width - 1)) / 2.0;
+					*green = (P(index - 1) + P(index + width) + P(index - width)) / 3.0;
+				}
+			} else {
+				if (row == 0) {
+					*red = (P(index + width - 1) + P(index + width + 1)) / 2.0;
+					*green = (P(index + 1) + P(index - 1) + P(index + width)) / 3.0;
+				} else if (row == height - 1) {
+					*red = (P(index - width - 1) + P(index - width + 1)) / 2.0;
+					*green = (P(index + 1) + P(index - 1) + P(index - width)) / 3.0;
+				} else {
+					*red = (P(index - width - 1) + P(index - width + 1) + P(index + width - 1) + P(index + width + 1)) / 4.0;
+					*green = (P(index + 1) + P(index - 1) + P(index + width) + P(index - width)) / 4.0;
+				}
+			}
+			*blue = P(index);
+			break;
+	}
+	#undef P
+}
+
+typedef struct {
+	int native_shadows;
+	int native_highlights;
+	float k1_k2;
+	float midtones_k2;
+} reference_params;
+
+static void reference_init(reference_params *params, int bpp, double shadows, double midtones, double highlights) {
+	const double max_input = bpp == 8 ? 0xFF : 0xFFFF;
+	const float hs_range_factor = highlights == shadows ? 1.0f : 1.0f / (highlights - shadows);
+	params->native_shadows = shadows * max_input;
+	params->native_highlights = highlights * max_input;
+	const float k1 = (midtones - 1) * hs_range_factor * 0xFF / max_input;
+	const float k2 = ((2 * midtones) - 1) * hs_range_factor / max_input;
+	params->k1_k2 = k1 / k2;
+	params->midtones_k2 = midtones / k2;
+}
+
+static uint8_t reference_stretch(float value, reference_params *params) {
+	if (value < params->native_shadows) {
+		return 0;
+	} else if (value > params->native_highlights) {
+		return 0xFF;
+	} else {
+		const float input_floored = (value - params->native_shadows);
+		return params->k1_k2 * input_floored / (input_floored - params->midtones_k2);
+	}
+}
+
+// test data
+
+static const char *patterns[] = { "RGGB", "GBRG", "GRBG", "BGGR" };
+static const int offsets[] = { 0x00, 0x01, 0x10, 0x11 };
+
+typedef void (*debayer_8_function)(const uint8_t *, int, int, uint8_t *);
+typedef void (*compute_8_function)(const uint8_t *, int, int, int, double *, double *, double *, unsigned long **, unsigned long *, float, float);
+typedef void (*compute_16_function)(const uint16_t *, int, int, int, double *, double *, double *, unsigned long **, unsigned long *, float, float);
+typedef void (*stretch_8_function)(const uint8_t *, int, int, uint8_t *, double *, double *, double *, unsigned long *);
+typedef void (*stretch_16_function)(const uint16_t *, int, int, uint8_t *, double *, double *, double *, unsigned long *);
+
+static debayer_8_function debayer_8[] = { indigo_debayer_8_rggb, indigo_debayer_8_gbrg, indigo_debayer_8_grbg, indigo_debayer_8_bggr };
+static compute_8_function compute_8[] = { indigo_compute_stretch_params_8_rggb, indigo_compute_stretch_params_8_gbrg, indigo_compute_stretch_params_8_grbg, indigo_compute_stretch_params_8_bggr };
+static compute_16_function compute_16[] = { indigo_compute_stretch_params_16_rggb, indigo_compute_stretch_params_16_gbrg, indigo_compute_stretch_params_16_grbg, indigo_compute_stretch_params_16_bggr };
+static stretch_8_function stretch_8[] = { indigo_stretch_8_rggb, indigo_stretch_8_gbrg, indigo_stretch_8_grbg, indigo_stretch_8_bggr };
+static stretch_16_function stretch_16[] = { indigo_stretch_16_rggb, indigo_stretch_16_gbrg, indigo_stretch_16_grbg, indigo_stretch_16_bggr };
+
+/* star field on background covering 1/16 to 3/16 of the range, so that stretch parameters are not degenerate */
+
+static void *create_frame(int width, int height, int components, int bpp) {
+	long size = (long)width * height * components;
+	uint16_t *frame = indigo_safe_malloc(size * sizeof(uint16_t));
+	synthetic_fill_background(frame, size, 0x1000, 0x1FFF);
+	synthetic_render_stars(frame, width, height, components, 1 + width * height / 2000, 0x1000, 0xF000);
+	if (bpp == 8)
+		return synthetic_convert_to_8(frame, size, 8);
+	return frame;
+}
+
+static void free_histogram(unsigned long **histogram) {
+	for (int i = 0; i < 3; i++) {
+		indigo_safe_free(histogram[i]);
+		histogram[i] = NULL;
+	}
+}
+
+static int failures = 0;
+
+static void check(const char *label, int width, int height, const uint8_t *output, const uint8_t *expected, int size) {
+	for (int i = 0; i < size; i++) {
+		if (output[i] != expected[i]) {
+			printf("%-28s %5dx%-5d FAILED at %d (%d != %d)\n", label, width, height, i, output[i], expected[i]);
+			failures++;
+			return;
+		}
+	}
+	printf("%-28s %5dx%-5d OK\n", label, width, height);
+}
+
+static void test_debayer(int width, int height) {
+	int size = width * height;
+	uint8_t *raw = create_frame(width, height, 1, 8);
+	uint8_t *output = indigo_safe_malloc(3 * size);
+	uint8_t *expected = indigo_safe_malloc(3 * size);
+	for (int p = 0; p < 4; p++) {
+		for (int row = 0, index = 0; row < height; row++) {
+			for (int column = 0; column < width; column++, index++) {
+				float red = 0, green = 0, blue = 0;
+				reference_debayer(raw, 8, index, row, column, width, height, offsets[p], &red, &green, &blue);
+				expected[3 * index] = red;
+				expected[3 * index + 1] = green;
+				expected[3 * index + 2] = blue;
+			}
+		}
+		memset(output, 0, 3 * size);
+		debayer_8[p](raw, width, height, output);
+		char label[64];
+		snprintf(label, sizeof(label), "debayer 8 bit %s", patterns[p]);
+		check(label, width, height, output, expected, 3 * size);
+	}
+	indigo_safe_free(raw);
+	indigo_safe_free(output);
+	indigo_safe_free(expected);
+}
+
+static void test_debayer_stretch(int width, int height, int bpp) {
+	int size = width * height;
+	int sample_by = width < 0x1FF ? 1 : width / 0x1FF;
+	void *raw = create_frame(width, height, 1, bpp);
+	uint8_t *output = indigo_safe_malloc(3 * size);
+	uint8_t *expected = indigo_safe_malloc(3 * size);
+	for (int p = 0; p < 4; p++) {
+		double shadows[3], midtones[3], highlights[3];
+		unsigned long *histogram[3] = { NULL, NULL, NULL }, totals[3] = { 0, 0, 0 };
+		if (bpp == 8)
+			compute_8[p](raw, width, height, sample_by, shadows, midtones, highlights, histogram, totals, 0.25, -2.8);
+		else
+			compute_16[p](raw, width, height, sample_by, shadows, midtones, highlights, histogram, totals, 0.25, -2.8);
+		free_histogram(histogram);
+		reference_params params[3];
+		for (int c = 0; c < 3; c++)
+			reference_init(&params[c], bpp, shadows[c], midtones[c], highlights[c]);
+		for (int row = 0, index = 0; row < height; row++) {
+			for (int column = 0; column < width; column++, index++) {
+				float red = 0, green = 0, blue = 0;
+				reference_debayer(raw, bpp, index, row, column, width, height, offsets[p], &red, &green, &blue);
+				expected[3 * index] = reference_stretch(red, &params[0]);
+				expected[3 * index + 1] = reference_stretch(green, &params[1]);
+				expected[3 * index + 2] = reference_stretch(blue, &params[2]);
+			}
+		}
+		memset(output, 0, 3 * size);
+		if (bpp == 8)
+			stretch_8[p](raw, width, height, output, shadows, midtones, highlights, totals);
+		else
+			stretch_16[p](raw, width, height, output, shadows, midtones, highlights, totals);
+		char label[64];
+		snprintf(label, sizeof(label), "debayer stretch %d bit %s", bpp, patterns[p]);
+		check(label, width, height, output, expected, 3 * size);
+	}
+	indigo_safe_free(raw);
+	indigo_safe_free(output);
+	indigo_safe_free(expected);
+}
+
+static void test_stretch(int width, int height, int bpp) {
+	int size = width * height;
+	int components = (bpp == 24 || bpp == 48) ? 3 : 1;
+	int depth = (bpp == 8 || bpp == 24) ? 8 : 16;
+	int sample_by = width < 0x1FF ? 1 : width / 0x1FF;
+	void *raw = create_frame(width, height, components, depth);
+	uint8_t *output = indigo_safe_malloc(components * size);
+	uint8_t *expected = indigo_safe_malloc(components * size);
+	double shadows[3], midtones[3], highlights[3];
+	unsigned long *histogram[3] = { NULL, NULL, NULL }, totals[3] = { 0, 0, 0 };
+	switch (bpp) {
+		case 8:
+			indigo_compute_stretch_params_8(raw, width, height, sample_by, shadows, midtones, highlights, histogram, 0.25, -2.8);
+			indigo_stretch_8(raw, width, height, output, shadows, midtones, highlights);
+			break;
+		case 16:
+			indigo_compute_stretch_params_16(raw, width, height, sample_by, shadows, midtones, highlights, histogram, 0.25, -2.8);
+			indigo_stretch_16(raw, width, height, output, shadows, midtones, highlights);
+			break;
+		case 24:
+			indigo_compute_stretch_params_24(raw, width, height, sample_by, shadows, midtones, highlights, histogram, totals, 0.25, -2.8);
+			indigo_stretch_24(raw, width, height, output, shadows, midtones, highlights, totals);
+			break;
+		case 48:
+			indigo_compute_stretch_params_48(raw, width, height, sample_by, shadows, midtones, highlights, histogram, totals, 0.25, -2.8);
+			indigo_stretch_48(raw, width, height, output, shadows, midtones, highlights, totals);
+			break;
+	}
+	free_histogram(histogram);
+	int reference = 0;
+	float coef[3] = { 1, 1, 1 };
+	if (components == 3) {
+		if (totals[0] > totals[1] && totals[0] > totals[2]) {
+			reference = 0;
+			coef[1] = (float)totals[1] / totals[0];
+			coef[2] = (float)totals[2] / totals[0];
+		} else if (totals[1] > totals[0] && totals[1] > totals[2]) {
+			reference = 1;
+			coef[0] = (float)totals[0] / totals[1];
+			coef[2] = (float)totals[2] / totals[1];
+		} else {
+			reference = 2;
+			coef[0] = (float)totals[0] / totals[2];
+			coef[1] = (float)totals[1] / totals[2];
+		}
+	}
+	reference_params params;
+	reference_init(&params, depth, shadows[reference], midtones[reference], highlights[reference]);
+	for (int i = 0; i < components * size; i++)
+		expected[i] = reference_stretch(px(raw, depth, i) / coef[i % components], &params);
+	char label[64];
+	snprintf(label, sizeof(label), "stretch %d bit", bpp);
+	check(label, width, height, output, expected, components * size);
+	indigo_safe_free(raw);
+	indigo_safe_free(output);
+	indigo_safe_free(expected);
+}
+
+int main(int argc, const char * argv[]) {
+	// odd and even sizes, tiny frames with edges only, frames large enough for parallel processing
+	int sizes[][2] = { { 2, 2 }, { 3, 3 }, { 7, 5 }, { 64, 48 }, { 65, 47 }, { 1001, 701 }, { 1024, 768 } };
+	srand(1);
+	for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		int width = sizes[i][0], height = sizes[i][1];
+		test_debayer(width, height);
+		test_debayer_stretch(width, height, 8);
+		test_debayer_stretch(width, height, 16);
+		test_stretch(width, height, 8);
+		test_stretch(width, height, 16);
+		test_stretch(width, height, 24);
+		test_stretch(width, height, 48);
+	}
+	printf("\n%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
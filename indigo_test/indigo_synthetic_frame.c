@@ -0,0 +1,131 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO synthetic star field frames shared by tests and benchmarks
+ \file indigo_synthetic_frame.c
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include <indigo/indigo_bus.h>
+
+#include "indigo_synthetic_frame.h"
+
+void synthetic_fill_background(uint16_t *frame, long size, int background, int noise) {
+	for (long i = 0; i < size; i++) {
+		int value = background + (rand() & noise);
+		frame[i] = value > 0xFFFF ? 0xFFFF : value;
+	}
+}
+
+void synthetic_render_star(uint16_t *frame, int width, int height, int components, double center_x, double center_y, int amplitude) {
+	int x_max = (int)round(center_x) + 8;
+	int y_max = (int)round(center_y) + 8;
+	for (int y = y_max - 16; y <= y_max; y++) {
+		if (y < 0 || y >= height)
+			continue;
+		double yy = center_y - y;
+		for (int x = x_max - 16; x <= x_max; x++) {
+			if (x < 0 || x >= width)
+				continue;
+			double xx = center_x - x;
+			int v = (int)(amplitude * exp(-(xx * xx / 4 + yy * yy / 4)));
+			for (int c = 0; c < components; c++) {
+				long index = ((long)y * width + x) * components + c;
+				int value = frame[index] + v;
+				frame[index] = value > 0xFFFF ? 0xFFFF : value;
+			}
+		}
+	}
+}
+
+void synthetic_render_stars(uint16_t *frame, int width, int height, int components, int count, int min_amplitude, int amplitude_range) {
+	for (int i = 0; i < count; i++) {
+		double center_x = rand() % width + rand() / (double)RAND_MAX;
+		double center_y = rand() % height + rand() / (double)RAND_MAX;
+		synthetic_render_star(frame, width, height, components, center_x, center_y, min_amplitude + rand() % amplitude_range);
+	}
+}
+
+double synthetic_sky_background(int x, int y, int width, int height) {
+	double r2 = ((x - width / 2.0) * (x - width / 2.0) + (y - height / 2.0) * (y - height / 2.0)) / (width * width / 4.0);
+	return 2000 + 800.0 * x / width + 300.0 * y / height - 300 * r2;
+}
+
+void synthetic_add_sky_background(uint16_t *frame, int width, int height, int components, int divider) {
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			int background = (int)synthetic_sky_background(x, y, width, height) / divider;
+			for (int c = 0; c < components; c++) {
+				long index = ((long)y * width + x) * components + c;
+				int value = frame[index] + background;
+				frame[index] = value > 0xFFFF ? 0xFFFF : value;
+			}
+		}
+	}
+}
+
+uint16_t *synthetic_create_star_field(int width, int height, int components, int noise, int count, int min_amplitude, int amplitude_range) {
+	long size = (long)width * height * components;
+	uint16_t *frame = indigo_safe_malloc(size * sizeof(uint16_t));
+	synthetic_fill_background(frame, size, 0, noise);
+	synthetic_render_stars(frame, width, height, components, count, min_amplitude, amplitude_range);
+	return frame;
+}
+
+uint8_t *synthetic_convert_to_8(uint16_t *frame, long size, int shift) {
+	uint8_t *frame8 = indigo_safe_malloc(size);
+	for (long i = 0; i < size; i++) {
+		int value = frame[i] >> shift;
+		frame8[i] = value > 0xFF ? 0xFF : value;
+	}
+	indigo_safe_free(frame);
+	return frame8;
+}
+
+void *synthetic_create_frame(int width, int height, int bpp, int count, int flags) {
+	int components = bpp == 24 || bpp == 48 ? 3 : 1;
+	bool bytes = bpp == 8 || bpp == 24;
+	bool sky = flags & SYNTHETIC_SKY_BACKGROUND;
+	long size = (long)width * height * components;
+	/* stars on 8 bit frame with sky background are dimmer, so they are not all saturated */
+	uint16_t *raw = synthetic_create_star_field(width, height, components, bytes ? 0x0F : 0x7F, count, 100, bytes ? (sky ? 90 : 150) : 30000);
+	if (sky)
+		synthetic_add_sky_background(raw, width, height, components, bytes ? 64 : 1);
+	if (flags & SYNTHETIC_BAYER) {
+		/* R and B sites see about half of the flux of G sites */
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++)
+				if ((x & 1) == (y & 1))
+					raw[(long)y * width + x] = (y & 1) ? raw[(long)y * width + x] * 3 / 5 : raw[(long)y * width + x] / 2;
+	}
+	if (bytes)
+		return synthetic_convert_to_8(raw, size, 0);
+	return raw;
+}
+
+int synthetic_median3(int a, int b, int c) {
+	if (a > b)
+		return b > c ? b : (a > c ? c : a);
+	return a > c ? a : (b > c ? c : b);
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO synthetic star field frames shared by tests and benchmarks
+ \file indigo_synthetic_frame.h
+
+ Stars and noise are rendered the same way as CCD simulator renders guider frames. Frames are rendered as 16 bit samples,
+ interleaved if there are more components, and converted to 8 bit samples if needed.
+ */
+
+#ifndef indigo_synthetic_frame_h
+#define indigo_synthetic_frame_h
+
+#include <stdint.h>
+
+/** Set samples to background level with random noise (background + (rand() & noise)), noise is a bit mask.
+ */
+extern void synthetic_fill_background(uint16_t *frame, long size, int background, int noise);
+
+/** Add star with CCD simulator profile (amplitude * exp(-r^2 / 4) over 17x17 pixels around rounded centre) to all components, samples are clamped to 0xFFFF.
+ */
+extern void synthetic_render_star(uint16_t *frame, int width, int height, int components, double center_x, double center_y, int amplitude);
+
+/** Add stars at random subpixel positions with amplitude min_amplitude + rand() % amplitude_range.
+ */
+extern void synthetic_render_stars(uint16_t *frame, int width, int height, int components, int count, int min_amplitude, int amplitude_range);
+
+/** Sky background with gradient (moonlight) and vignetting, 2000 + 800 * x / width + 300 * y / height - 300 * r^2, r is relative to half of the width.
+ */
+extern double synthetic_sky_background(int x, int y, int width, int height);
+
+/** Add sky background divided by divider to all components, samples are clamped to 0xFFFF.
+ */
+extern void synthetic_add_sky_background(uint16_t *frame, int width, int height, int components, int divider);
+
+/** Allocate star field frame with background noise and random stars.
+ */
+extern uint16_t *synthetic_create_star_field(int width, int height, int components, int noise, int count, int min_amplitude, int amplitude_range);
+
+/** Sky background is added to the frame created by synthetic_create_frame().
+ */
+#define SYNTHETIC_SKY_BACKGROUND	1
+
+/** Frame created by synthetic_create_frame() is modulated by RGGB filter response.
+ */
+#define SYNTHETIC_BAYER						2
+
+/** Allocate star field frame with count random stars, bpp is 8 or 16 for mono (or raw bayer) frames and 24 or 48 for RGB frames.
+ 8 bit samples use DSLR noise level and star amplitudes, flags are combination of SYNTHETIC_SKY_BACKGROUND and SYNTHETIC_BAYER.
+ */
+extern void *synthetic_create_frame(int width, int height, int bpp, int count, int flags);
+
+/** Convert 16 bit frame to 8 bit frame (samples shifted right by shift and clamped to 0xFF) and free 16 bit frame.
+ */
+extern uint8_t *synthetic_convert_to_8(uint16_t *frame, long size, int shift);
+
+/** Median of three values, reference for median filters of the library.
+ */
+extern int synthetic_median3(int a, int b, int c);
+
+#endif /* indigo_synthetic_frame_h */
@@ -0,0 +1,317 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO timer scheduler test
+ \file indigo_timer_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_timer.h>
+
+#define WORKER_IDLE_TIMEOUT	5		// see indigo_timer.c
+#define LOAD_TIMERS					500
+#define LOAD_PERIOD					0.02
+#define MAX_LATENESS				0.02
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t condition = PTHREAD_COND_INITIALIZER;
+static bool passed = true;
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int thread_count(void) {
+	int threads = -1;
+	FILE *file = fopen("/proc/self/status", "r");
+	if (file) {
+		char line[256];
+		while (fgets(line, sizeof(line), file))
+			sscanf(line, "Threads: %d", &threads);
+		fclose(file);
+	}
+	return threads;
+}
+
+static void check(const char *name, bool result, const char *format, ...) {
+	char message[128] = "";
+	va_list args;
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+	printf("%-40s %-36s %s\n", name, message, result ? "OK" : "FAILED");
+	passed = passed && result;
+}
+
+static void print_stats(const char *name) {
+	indigo_timer_stats stats;
+	indigo_get_timer_stats(&stats);
+	printf("%s: %d allocated, %d pending, %d ready, %d workers (%d busy), %ld fired, lateness %.3fms avg %.3fms max, duration %.3fms avg %.3fms max\n", name, stats.allocated, stats.pending, stats.ready, stats.workers, stats.busy_workers, stats.fired, stats.avg_lateness * 1000, stats.max_lateness * 1000, stats.avg_duration * 1000, stats.max_duration * 1000);
+}
+
+static void wait_for(volatile int *counter, int value, double timeout) {
+	double end = now() + timeout;
+	pthread_mutex_lock(&mutex);
+	while (*counter < value && now() < end) {
+		pthread_mutex_unlock(&mutex);
+		indigo_usleep(1000);
+		pthread_mutex_lock(&mutex);
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+// delay and ordering
+
+typedef struct {
+	double delay;
+	double fired;
+	int order;
+} ordered_timer;
+
+static int fired = 0;
+
+static void ordered_callback(indigo_device *device, void *data) {
+	ordered_timer *timer = data;
+	pthread_mutex_lock(&mutex);
+	timer->fired = now();
+	timer->order = fired++;
+	pthread_mutex_unlock(&mutex);
+}
+
+static void test_ordering(void) {
+	ordered_timer timers[] = { { 0.15 }, { 0.05 }, { 0.10 }, { 0.02 }, { 0.20 }, { 0.08 }, { 0 } };
+	int count = sizeof(timers) / sizeof(ordered_timer);
+	fired = 0;
+	double start = now();
+	for (int i = 0; i < count; i++)
+		indigo_set_timer_with_data(NULL, timers[i].delay, ordered_callback, NULL, timers + i);
+	wait_for(&fired, count, 1);
+	bool ordered = fired == count;
+	double worst = 0, earliest = 0;
+	for (int i = 0; i < count; i++) {
+		for (int j = 0; j < count; j++) {
+			if (timers[j].delay < timers[i].delay && timers[j].order > timers[i].order)
+				ordered = false;
+		}
+		double lateness = timers[i].fired - start - timers[i].delay;
+		if (lateness > worst)
+			worst = lateness;
+		if (lateness < earliest)
+			earliest = lateness;
+	}
+	check("delay ordering", ordered, "%d of %d timers in order", ordered ? count : 0, count);
+	check("delay accuracy", earliest >= 0 && worst < MAX_LATENESS, "%.3fms max lateness", worst * 1000);
+}
+
+// cancel of pending timer
+
+static int canceled_fired = 0;
+
+static void canceled_callback(indigo_device *device) {
+	pthread_mutex_lock(&mutex);
+	canceled_fired++;
+	pthread_mutex_unlock(&mutex);
+}
+
+static void test_cancel(void) {
+	indigo_timer *timer = NULL;
+	indigo_set_timer(NULL, 0.1, canceled_callback, &timer);
+	bool result = indigo_cancel_timer(NULL, &timer) && timer == NULL;
+	indigo_usleep(ONE_SECOND_DELAY / 5);
+	check("cancel pending timer", result && canceled_fired == 0, "%d callbacks", canceled_fired);
+}
+
+// synchronous cancel of running callback
+
+static int sync_started = 0;
+static int sync_finished = 0;
+
+static void sync_callback(indigo_device *device) {
+	pthread_mutex_lock(&mutex);
+	sync_started++;
+	pthread_mutex_unlock(&mutex);
+	indigo_usleep(ONE_SECOND_DELAY / 5);
+	pthread_mutex_lock(&mutex);
+	sync_finished++;
+	pthread_mutex_unlock(&mutex);
+}
+
+static void test_cancel_sync(void) {
+	indigo_timer *timer = NULL;
+	indigo_set_timer(NULL, 0, sync_callback, &timer);
+	wait_for(&sync_started, 1, 1);
+	bool result = indigo_cancel_timer_sync(NULL, &timer);
+	pthread_mutex_lock(&mutex);
+	int finished = sync_finished;
+	pthread_mutex_unlock(&mutex);
+	check("cancel running timer synchronously", result && finished == 1 && timer == NULL, "%s", finished ? "waited for callback" : "returned while running");
+}
+
+// rescheduling from callback
+
+static indigo_timer *rescheduled_timer = NULL;
+static int rescheduled_count = 0;
+static double rescheduled_times[3];
+
+static void rescheduled_callback(indigo_device *device) {
+	pthread_mutex_lock(&mutex);
+	rescheduled_times[rescheduled_count] = now();
+	bool again = ++rescheduled_count < 3;
+	pthread_mutex_unlock(&mutex);
+	if (again)
+		indigo_reschedule_timer(NULL, 0.05, &rescheduled_timer);
+}
+
+static void test_reschedule(void) {
+	indigo_set_timer(NULL, 0.05, rescheduled_callback, &rescheduled_timer);
+	wait_for(&rescheduled_count, 3, 1);
+	indigo_usleep(ONE_SECOND_DELAY / 5);
+	double interval = rescheduled_count == 3 ? (rescheduled_times[2] - rescheduled_times[0]) / 2 : 0;
+	check("reschedule from callback", rescheduled_count == 3 && rescheduled_timer == NULL && interval >= 0.05 && interval < 0.05 + MAX_LATENESS, "%d callbacks, %.3fms interval", rescheduled_count, interval * 1000);
+}
+
+// many periodic timers are served by fixed pool
+
+static indigo_timer *load_timers[LOAD_TIMERS];
+static bool load_stop = false;
+
+static void load_callback(indigo_device *device, void *data) {
+	indigo_timer **timer = data;
+	if (!load_stop)
+		indigo_reschedule_timer(NULL, LOAD_PERIOD, timer);
+}
+
+static void test_load(void) {
+	indigo_timer_stats before, after;
+	indigo_get_timer_stats(&before);
+	for (int i = 0; i < LOAD_TIMERS; i++)
+		indigo_set_timer_with_data(NULL, LOAD_PERIOD * i / LOAD_TIMERS, load_callback, load_timers + i, load_timers + i);
+	indigo_usleep(ONE_SECOND_DELAY);
+	int threads = thread_count();
+	load_stop = true;
+	indigo_usleep(ONE_SECOND_DELAY / 5);
+	indigo_get_timer_stats(&after);
+	bool stopped = true;
+	for (int i = 0; i < LOAD_TIMERS; i++)
+		stopped = stopped && load_timers[i] == NULL;
+	long count = after.fired - before.fired;
+	double lateness = count ? (after.avg_lateness * after.fired - before.avg_lateness * before.fired) / count : 0;
+	print_stats("periodic timers");
+	check("periodic timers", stopped && count > LOAD_TIMERS / LOAD_PERIOD / 2, "%d timers, %ld callbacks", LOAD_TIMERS, count);
+	/* main thread, scheduler and worker pool */
+	check("periodic timers threads", threads <= indigo_timer_pool_size + 2, "%d threads", threads);
+	check("periodic timers lateness", lateness < MAX_LATENESS / 4, "%.3fms avg", lateness * 1000);
+}
+
+// extra workers are started if all of them are blocked and stop when idle
+
+static int blocked = 0;
+static bool released = false;
+static double quick_fired = 0;
+
+static void blocking_callback(indigo_device *device) {
+	pthread_mutex_lock(&mutex);
+	blocked++;
+	while (!released)
+		pthread_cond_wait(&condition, &mutex);
+	pthread_mutex_unlock(&mutex);
+}
+
+static void quick_callback(indigo_device *device) {
+	pthread_mutex_lock(&mutex);
+	quick_fired = now();
+	pthread_mutex_unlock(&mutex);
+}
+
+static void test_starvation(void) {
+	int blocking = indigo_timer_pool_size + 2;
+	for (int i = 0; i < blocking; i++)
+		indigo_set_timer(NULL, 0, blocking_callback, NULL);
+	double start = now();
+	indigo_set_timer(NULL, 0.01, quick_callback, NULL);
+	wait_for(&blocked, blocking, 1);
+	indigo_usleep(ONE_SECOND_DELAY / 5);
+	indigo_timer_stats stats;
+	indigo_get_timer_stats(&stats);
+	print_stats("blocked workers");
+	pthread_mutex_lock(&mutex);
+	double lateness = quick_fired ? quick_fired - start - 0.01 : -1;
+	check("extra workers under starvation", blocked == blocking && stats.workers > indigo_timer_pool_size, "%d blocked, %d workers", blocked, stats.workers);
+	check("timer next to blocked workers", lateness >= 0 && lateness < 0.1, "%.3fms lateness", lateness * 1000);
+	released = true;
+	pthread_cond_broadcast(&condition);
+	pthread_mutex_unlock(&mutex);
+	indigo_usleep((WORKER_IDLE_TIMEOUT + 2) * ONE_SECOND_DELAY);
+	indigo_get_timer_stats(&stats);
+	check("extra workers stopped when idle", stats.workers == indigo_timer_pool_size, "%d workers", stats.workers);
+}
+
+// timers are driven by monotonic clock, wall-clock step must not fire or delay them
+
+static void test_clock_step(bool enabled) {
+	if (!enabled) {
+		printf("%-40s %-36s %s\n", "wall-clock step", "run with --step-clock as root", "SKIPPED");
+		return;
+	}
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += 3600;
+	fired = 0;
+	ordered_timer timer = { 0.2 };
+	double start = now();
+	indigo_set_timer_with_data(NULL, timer.delay, ordered_callback, NULL, &timer);
+	if (clock_settime(CLOCK_REALTIME, &ts)) {
+		wait_for(&fired, 1, 1);
+		printf("%-40s %-36s %s\n", "wall-clock step", "clock_settime() failed", "SKIPPED");
+		return;
+	}
+	indigo_usleep(ONE_SECOND_DELAY / 20);
+	bool early = fired > 0;
+	wait_for(&fired, 1, 1);
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec -= 3600;
+	clock_settime(CLOCK_REALTIME, &ts);
+	double lateness = timer.fired - start - timer.delay;
+	check("wall-clock step", !early && fired == 1 && lateness >= 0 && lateness < MAX_LATENESS, "%.3fms lateness", lateness * 1000);
+}
+
+int main(int argc, const char * argv[]) {
+	bool step_clock = argc > 1 && !strcmp(argv[1], "--step-clock");
+	test_ordering();
+	test_cancel();
+	test_cancel_sync();
+	test_reschedule();
+	test_load();
+	test_starvation();
+	test_clock_step(step_clock);
+	print_stats("total");
+	printf("\n%s\n", passed ? "PASSED" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+/** INDIGO XISF block compression round-trip test
+ \file indigo_xisf_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_xisf.h>
+
+#define XISF_HEADER_SIZE	2880
+
+static int failures = 0;
+
+// independent decoder
+
+static bool lz4_decode(const uint8_t *data, long size, uint8_t *output, long length) {
+	const uint8_t *end = data + size;
+	long written = 0;
+	while (data < end) {
+		int token = *data++;
+		long literals = token >> 4;
+		if (literals == 15)
+			for (int byte = 255; byte == 255 && data < end; literals += byte)
+				byte = *data++;
+		if (literals > end - data || written + literals > length)
+			return false;
+		memcpy(output + written, data, literals);
+		data += literals;
+		written += literals;
+		if (data == end)
+			break;
+		if (end - data < 2)
+			return false;
+		long offset = data[0] | data[1] << 8, match = (token & 15) + 4;
+		data += 2;
+		if ((token & 15) == 15)
+			for (int byte = 255; byte == 255 && data < end; match += byte)
+				byte = *data++;
+		if (offset == 0 || offset > written || written + match > length)
+			return false;
+		for (long i = 0; i < match; i++, written++)
+			output[written] = output[written - offset];
+	}
+	return written == length;
+}
+
+static bool zlib_decode(const uint8_t *data, long size, uint8_t *output, long length) {
+	uLongf output_length = (uLongf)length;
+	return uncompress(output, &output_length, data, (uLong)size) == Z_OK && output_length == (uLongf)length;
+}
+
+static bool decompress_xisf(const uint8_t *xisf, long size, const char *codec, int item_size, uint8_t *output, long length) {
+	if (memcmp(xisf, "XISF0100", 8))
+		return false;
+	long header_length = xisf[8] | xisf[9] << 8 | xisf[10] << 16 | (long)xisf[11] << 24;
+	char *header = indigo_safe_malloc(header_length + 1);
+	memcpy(header, xisf + 16, header_length);
+	char *location = strstr(header, "location='attachment:"), *compression = strstr(header, "compression='"), *subblocks = strstr(header, "subblocks='");
+	long position = 0, block_size = 0, uncompressed = 0;
+	int items = 1;
+	char name[16] = "";
+	bool result = location && compression && subblocks && strstr(header, "</xisf>") && sscanf(location + 21, "%ld:%ld", &position, &block_size) == 2 && position % 2880 == 0 && position >= 16 + header_length && position + block_size == size;
+	if (result) {
+		int fields = sscanf(compression + 13, "%15[^:]:%ld:%d", name, &uncompressed, &items);
+		result = fields >= 2 && uncompressed == length && !strcmp(name, codec) && (strstr(codec, "+sh") ? fields == 3 && items == item_size : fields == 2);
+	}
+	uint8_t *block = indigo_safe_malloc(length);
+	const uint8_t *data = xisf + position;
+	long total = 0, written = 0;
+	for (char *subblock = subblocks + 11; result && *subblock != '\'';) {
+		long compressed_size, uncompressed_size;
+		int consumed;
+		if (sscanf(subblock, "%ld,%ld%n", &compressed_size, &uncompressed_size, &consumed) != 2 || total + compressed_size > block_size || written + uncompressed_size > length)
+			result = false;
+		else if (!strncmp(codec, "zlib", 4))
+			result = zlib_decode(data + total, compressed_size, block + written, uncompressed_size);
+		else
+			result = lz4_decode(data + total, compressed_size, block + written, uncompressed_size);
+		total += compressed_size;
+		written += uncompressed_size;
+		subblock += consumed;
+		if (*subblock == ':')
+			subblock++;
+	}
+	result = result && total == block_size && written == length;
+	if (result) {
+		/* byte j of item i is stored at j * items + i */
+		long count = length / items;
+		for (long i = 0; i < count; i++)
+			for (int j = 0; j < items; j++)
+				output[i * items + j] = block[j * count + i];
+		memcpy(output + count * items, block + count * items, length - count * items);
+	}
+	indigo_safe_free(block);
+	indigo_safe_free(header);
+	return result;
+}
+
+typedef enum {
+	RANDOM,
+	CONSTANT,
+	SKY
+} content;
+
+static void test_compression(int width, int height, int bytes_per_sample, int components, content content, indigo_xisf_codec codec, bool shuffle) {
+	long count = (long)width * height * components, length = count * bytes_per_sample;
+	uint8_t *xisf = indigo_safe_malloc(XISF_HEADER_SIZE + length);
+	strcpy((char *)xisf, "XISF0100");
+	int header_length = sprintf((char *)xisf + 16, "<?xml version='1.0' encoding='UTF-8'?><xisf version='1.0'><Image geometry='%d:%d:%d' sampleFormat='%s' colorSpace='%s' location='attachment:%d:%ld'><FITSKeyword name='IMAGETYP' value='Light' comment='Frame type'/></Image></xisf>", width, height, components, bytes_per_sample == 1 ? "UInt8" : "UInt16", components == 1 ? "Gray" : "RGB", XISF_HEADER_SIZE, length);
+	for (int i = 0; i < 4; i++)
+		xisf[8 + i] = (uint8_t)(header_length >> (8 * i));
+	uint8_t *pixels = xisf + XISF_HEADER_SIZE;
+	for (long i = 0; i < count; i++) {
+		/* sky is background with gaussian-ish noise and occasional saturated stars */
+		int value = content == RANDOM ? rand() : content == CONSTANT ? 1000 : 1200 + (rand() % 64 + rand() % 64 + rand() % 64) / 3 + (rand() % 2000 == 0 ? 60000 : 0);
+		if (bytes_per_sample == 1) {
+			pixels[i] = content == SKY ? value >> 4 : value;
+		} else {
+			pixels[2 * i] = value;
+			pixels[2 * i + 1] = value >> 8;
+		}
+	}
+	const char *names[] = { "random", "constant", "sky" };
+	const char *codecs[] = { NULL, "zlib", "lz4", "lz4hc" };
+	char codec_name[16], label[64];
+	snprintf(codec_name, sizeof(codec_name), "%s%s", codecs[codec], shuffle && bytes_per_sample > 1 ? "+sh" : "");
+	indigo_blob_buffer *compressed = indigo_xisf_compress(xisf, XISF_HEADER_SIZE + length, codec, shuffle);
+	uint8_t *output = indigo_safe_malloc(length);
+	if (compressed == NULL || !decompress_xisf(compressed->data, compressed->size, codec_name, bytes_per_sample, output, length)) {
+		snprintf(label, sizeof(label), "%s %s%d %s", codec_name, components == 1 ? "MONO" : "RGB", 8 * bytes_per_sample * components, names[content]);
+		printf("%-36s %5dx%-5d FAILED\n", label, width, height);
+		failures++;
+	} else {
+		snprintf(label, sizeof(label), "%s %s%d %s %.2fx", codec_name, components == 1 ? "MONO" : "RGB", 8 * bytes_per_sample * components, names[content], (double)length / (compressed->size - XISF_HEADER_SIZE));
+		if (memcmp(output, pixels, length)) {
+			printf("%-36s %5dx%-5d FAILED\n", label, width, height);
+			failures++;
+		} else {
+			printf("%-36s %5dx%-5d OK\n", label, width, height);
+		}
+	}
+	indigo_release_blob_buffer(compressed);
+	indigo_safe_free(output);
+	indigo_safe_free(xisf);
+}
+
+int main(int argc, const char * argv[]) {
+	int sizes[][2] = { { 1, 1 }, { 7, 5 }, { 64, 48 }, { 1001, 701 } };
+	srand(1);
+	for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		int width = sizes[i][0], height = sizes[i][1];
+		for (content content = RANDOM; content <= SKY; content++) {
+			for (indigo_xisf_codec codec = INDIGO_XISF_ZLIB; codec <= INDIGO_XISF_LZ4HC; codec++) {
+				test_compression(width, height, 1, 1, content, codec, true);
+				test_compression(width, height, 2, 1, content, codec, false);
+				test_compression(width, height, 2, 1, content, codec, true);
+				test_compression(width, height, 2, 3, content, codec, true);
+			}
+		}
+	}
+	printf("\n%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,267 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 by CloudMakers, s. r. o.
+
+
+/** INDIGO XML parser test (memory per idle connection, buffer growth for long values and BLOBs and shrinking after idle period)
+ \file indigo_xml_parser_test.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_xml.h>
+#include <indigo/indigo_driver_xml.h>
+#include <indigo/indigo_client_xml.h>
+#include <indigo/indigo_base64.h>
+
+#define CONNECTIONS				64
+#define LONG_TEXT_SIZE		300000
+#define BLOB_SIZE					1500000
+#define IDLE_TIMEOUT			200
+#define MAX_IDLE_MEMORY		(128 * 1024)
+
+static int failures = 0;
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t condition = PTHREAD_COND_INITIALIZER;
+static int text_changes = 0;
+static long text_length = 0;
+static int blob_updates = 0;
+static bool blob_ok = false;
+static unsigned char *blob_data;
+
+static long heap_used(void) {
+#if defined(__APPLE__)
+	return mstats().bytes_used;
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+#elif defined(__GLIBC__)
+	struct mallinfo info = mallinfo();
+	return info.uordblks + info.hblkhd;
+#else
+	return -1;
+#endif
+}
+
+static void report(const char *label, bool ok, const char *format, ...) {
+	char message[128] = "";
+	va_list args;
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+	printf("%-36s %-24s %s\n", label, message, ok ? "OK" : "FAILED");
+	if (!ok)
+		failures++;
+}
+
+static void wait_for(int *counter, int value) {
+	pthread_mutex_lock(&mutex);
+	while (*counter < value)
+		pthread_cond_wait(&condition, &mutex);
+	pthread_mutex_unlock(&mutex);
+}
+
+static void write_all(int handle, const char *data, long length) {
+	while (length > 0) {
+		long count = write(handle, data, length);
+		if (count <= 0)
+			break;
+		data += count;
+		length -= count;
+	}
+}
+
+// device receiving text vectors parsed on server side
+
+static indigo_property *text_property;
+
+static indigo_result test_attach(indigo_device *device) {
+	text_property = indigo_init_text_property(NULL, device->name, "TEXT", "Main", "Text", INDIGO_OK_STATE, INDIGO_RW_PERM, 1);
+	indigo_init_text_item(text_property->items, "VALUE", "Value", "");
+	return INDIGO_OK;
+}
+
+static indigo_result test_enumerate_properties(indigo_device *device, indigo_client *client, indigo_property *property) {
+	indigo_define_property(device, text_property, NULL);
+	return INDIGO_OK;
+}
+
+static indigo_result test_change_property(indigo_device *device, indigo_client *client, indigo_property *property) {
+	if (indigo_property_match(text_property, property)) {
+		pthread_mutex_lock(&mutex);
+		text_length = property->items[0].text.long_value ? strlen(property->items[0].text.long_value) : strlen(property->items[0].text.value);
+		text_changes++;
+		pthread_cond_broadcast(&condition);
+		pthread_mutex_unlock(&mutex);
+	}
+	return INDIGO_OK;
+}
+
+static indigo_result test_detach(indigo_device *device) {
+	indigo_release_property(text_property);
+	return INDIGO_OK;
+}
+
+// client receiving BLOBs parsed on client side
+
+static indigo_result test_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	if (property->type == INDIGO_BLOB_VECTOR && !strcmp(property->name, "IMAGE")) {
+		pthread_mutex_lock(&mutex);
+		indigo_item *item = property->items;
+		blob_ok = item->blob.size == BLOB_SIZE && item->blob.value && !memcmp(item->blob.value, blob_data, BLOB_SIZE);
+		blob_updates++;
+		pthread_cond_broadcast(&condition);
+		pthread_mutex_unlock(&mutex);
+	}
+	return INDIGO_OK;
+}
+
+static indigo_device test_device = INDIGO_DEVICE_INITIALIZER("Parser Test", test_attach, test_enumerate_properties, test_change_property, NULL, test_detach);
+static indigo_client test_client = { "Parser Test Client", false, NULL, INDIGO_OK, INDIGO_VERSION_CURRENT, NULL, NULL, NULL, test_update_property, NULL, NULL, NULL };
+
+static void *server_parser(void *data) {
+	indigo_client *adapter = data;
+	indigo_attach_client(adapter);
+	indigo_xml_parse(NULL, adapter);
+	indigo_detach_client(adapter);
+	indigo_release_xml_device_adapter(adapter);
+	return NULL;
+}
+
+static void *client_parser(void *data) {
+	indigo_device *adapter = data;
+	indigo_attach_device(adapter);
+	indigo_xml_parse(adapter, NULL);
+	indigo_detach_device(adapter);
+	free(adapter->device_context);
+	free(adapter);
+	return NULL;
+}
+
+static void send_text(int handle, long length) {
+	char *message = malloc(length + 256);
+	int offset = sprintf(message, "<newTextVector device='Parser Test' name='TEXT'><oneText name='VALUE'>");
+	memset(message + offset, 'x', length);
+	offset += length;
+	offset += sprintf(message + offset, "</oneText></newTextVector>\n");
+	write_all(handle, message, offset);
+	free(message);
+}
+
+static void test_server_connections(void) {
+	int null = open("/dev/null", O_WRONLY);
+	int handles[CONNECTIONS];
+	pthread_t threads[CONNECTIONS];
+	long baseline = heap_used();
+	for (int i = 0; i < CONNECTIONS; i++) {
+		int fds[2];
+		if (pipe(fds)) {
+			report("idle connection memory", false, "pipe() failed");
+			return;
+		}
+		handles[i] = fds[1];
+		pthread_create(&threads[i], NULL, server_parser, indigo_xml_device_adapter(fds[0], null));
+		const char *hello = "<getProperties version='2.0' device='Parser Test'/>\n";
+		write_all(handles[i], hello, strlen(hello));
+		send_text(handles[i], 10);
+	}
+	wait_for(&text_changes, CONNECTIONS);
+	indigo_usleep(100000);
+	long memory = heap_used();
+	if (baseline >= 0)
+		report("idle connection memory", (memory - baseline) / CONNECTIONS < MAX_IDLE_MEMORY, "%ld bytes", (memory - baseline) / CONNECTIONS);
+	send_text(handles[0], LONG_TEXT_SIZE);
+	wait_for(&text_changes, CONNECTIONS + 1);
+	report("long text value", text_length == LONG_TEXT_SIZE, "%ld bytes", text_length);
+	send_text(handles[0], 10);
+	wait_for(&text_changes, CONNECTIONS + 2);
+	long grown = heap_used();
+	indigo_usleep(4 * IDLE_TIMEOUT * 1000);
+	long shrunk = heap_used();
+	if (baseline >= 0)
+		report("memory after idle period", shrunk - memory < MAX_IDLE_MEMORY, "%ld -> %ld bytes", grown - memory, shrunk - memory);
+	for (int i = 0; i < CONNECTIONS; i++) {
+		close(handles[i]);
+		pthread_join(threads[i], NULL);
+	}
+	close(null);
+}
+
+static void test_client_connection(short version) {
+	int null = open("/dev/null", O_WRONLY);
+	int fds[2];
+	if (pipe(fds)) {
+		report("BLOB", false, "pipe() failed");
+		return;
+	}
+	indigo_device *adapter = indigo_xml_client_adapter("Parser Test", "", fds[0], null);
+	adapter->version = version;
+	pthread_mutex_lock(&mutex);
+	int updates = blob_updates;
+	pthread_mutex_unlock(&mutex);
+	pthread_t thread;
+	pthread_create(&thread, NULL, client_parser, adapter);
+	char *encoded = malloc(BLOB_SIZE * 4 / 3 + 16);
+	long encoded_length = base64_encode((unsigned char *)encoded, blob_data, BLOB_SIZE);
+	char header[512];
+	int length = sprintf(header, "<defBLOBVector device='Remote' name='IMAGE' state='Idle' perm='ro' group='Main' label='Image'><defBLOB name='IMAGE' label='Image'/></defBLOBVector>\n<setBLOBVector device='Remote' name='IMAGE' state='Ok'><oneBLOB name='IMAGE' format='.raw' size='%d'>", BLOB_SIZE);
+	write_all(fds[1], header, length);
+	write_all(fds[1], encoded, encoded_length);
+	const char *footer = "</oneBLOB></setBLOBVector>\n";
+	write_all(fds[1], footer, strlen(footer));
+	wait_for(&blob_updates, updates + 1);
+	report(version == INDIGO_VERSION_2_0 ? "BLOB, protocol 2.0" : "BLOB, legacy protocol", blob_ok, "%d bytes", BLOB_SIZE);
+	close(fds[1]);
+	pthread_join(thread, NULL);
+	free(encoded);
+	close(null);
+}
+
+int main(int argc, const char * argv[]) {
+	indigo_xml_idle_timeout = IDLE_TIMEOUT;
+	blob_data = malloc(BLOB_SIZE);
+	for (int i = 0; i < BLOB_SIZE; i++)
+		blob_data[i] = rand();
+	indigo_start();
+	indigo_attach_device(&test_device);
+	indigo_attach_client(&test_client);
+	test_server_connections();
+	test_client_connection(INDIGO_VERSION_LEGACY);
+	test_client_connection(INDIGO_VERSION_2_0);
+	indigo_detach_client(&test_client);
+	indigo_detach_device(&test_device);
+	indigo_stop();
+	free(blob_data);
+	printf("\n%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
@@ -22,7 +22,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <libgen.h>
+#include <zlib.h>
 
 void *memfind(const char *haystack, size_t haystacklen, const char *needle, size_t needlelen) {
 	for(int offset = 0; offset < haystacklen-needlelen; offset++) {
@@ -49,16 +52,151 @@ int read_file(char *filename, char **data) {
 	return count;
 }
 
+bool lz4_decompress(const uint8_t *data, long size, uint8_t *output, long length) {
+	const uint8_t *end = data + size;
+	long written = 0;
+	while (data < end) {
+		int token = *data++;
+		long literals = token >> 4;
+		if (literals == 15)
+			for (int byte = 255; byte == 255 && data < end; literals += byte)
+				byte = *data++;
+		if (literals > end - data || written + literals > length)
+			return false;
+		memcpy(output + written, data, literals);
+		data += literals;
+		written += literals;
+		if (data == end)
+			break;
+		if (end - data < 2)
+			return false;
+		long offset = data[0] | data[1] << 8, match = (token & 15) + 4;
+		data += 2;
+		if ((token & 15) == 15)
+			for (int byte = 255; byte == 255 && data < end; match += byte)
+				byte = *data++;
+		if (offset == 0 || offset > written || written + match > length)
+			return false;
+		for (long i = 0; i < match; i++, written++)
+			output[written] = output[written - offset];
+	}
+	return written == length;
+}
+
+bool validate(char *data, int size) {
+	if (size < 16 || memcmp(data, "XISF0100", 8)) {
+		printf("invalid signature\n");
+		return false;
+	}
+	uint8_t *length_bytes = (uint8_t *)data + 8;
+	long header_length = length_bytes[0] | length_bytes[1] << 8 | length_bytes[2] << 16 | (long)length_bytes[3] << 24;
+	if (16 + header_length > size) {
+		printf("invalid header length %ld\n", header_length);
+		return false;
+	}
+	char *header = malloc(header_length + 1);
+	memcpy(header, data + 16, header_length);
+	header[header_length] = 0;
+	bool result = false;
+	char *geometry = strstr(header, "geometry='"), *format = strstr(header, "sampleFormat='"), *location = strstr(header, "location='attachment:");
+	char *compression = strstr(header, "compression='"), *subblocks = strstr(header, "subblocks='");
+	long width = 0, height = 0, channels = 0, position = 0, block_size = 0;
+	int sample_size = 1;
+	if (geometry == NULL || sscanf(geometry + 10, "%ld:%ld:%ld", &width, &height, &channels) != 3 || location == NULL || sscanf(location + 21, "%ld:%ld", &position, &block_size) != 2) {
+		printf("can not find image geometry or attachment\n");
+	} else if (position < 16 + header_length || position + block_size > size) {
+		printf("attachment %ld:%ld is outside of the file or overlaps the header\n", position, block_size);
+	} else {
+		if (format && (!strncmp(format + 14, "UInt16", 6) || !strncmp(format + 14, "Int16", 5)))
+			sample_size = 2;
+		else if (format && (!strncmp(format + 14, "UInt32", 6) || !strncmp(format + 14, "Int32", 5) || !strncmp(format + 14, "Float32", 7)))
+			sample_size = 4;
+		else if (format && !strncmp(format + 14, "Float64", 7))
+			sample_size = 8;
+		long expected = width * height * channels * sample_size;
+		if (compression == NULL) {
+			result = block_size == expected;
+			if (!result)
+				printf("attachment size %ld does not match image size %ld\n", block_size, expected);
+		} else {
+			char codec[16] = "";
+			long uncompressed = 0;
+			int item_size = 0;
+			int fields = sscanf(compression + 13, "%15[^:]:%ld:%d", codec, &uncompressed, &item_size);
+			bool shuffled = strstr(codec, "+sh") != NULL, zlib = !strncmp(codec, "zlib", 4), lz4 = !strncmp(codec, "lz4", 3);
+			if (fields < 2 || (!zlib && !lz4) || (shuffled && (fields != 3 || item_size != sample_size))) {
+				printf("unsupported compression '%s'\n", codec);
+			} else if (uncompressed != expected) {
+				printf("uncompressed size %ld does not match image size %ld\n", uncompressed, expected);
+			} else {
+				/* attachment is either single compressed block or sequence of subblocks */
+				uint8_t *output = malloc(uncompressed);
+				long total = 0, written = 0;
+				char single[64], *subblock = single;
+				if (subblocks == NULL)
+					snprintf(single, sizeof(single), "%ld,%ld'", block_size, uncompressed);
+				else
+					subblock = subblocks + 11;
+				result = true;
+				while (result && *subblock != '\'') {
+					long compressed_size, uncompressed_size;
+					int consumed;
+					if (sscanf(subblock, "%ld,%ld%n", &compressed_size, &uncompressed_size, &consumed) != 2 || total + compressed_size > block_size || written + uncompressed_size > uncompressed) {
+						printf("invalid subblock list\n");
+						result = false;
+						break;
+					}
+					if (zlib) {
+						uLongf output_length = uncompressed_size;
+						result = uncompress(output + written, &output_length, (uint8_t *)data + position + total, compressed_size) == Z_OK && output_length == uncompressed_size;
+					} else {
+						result = lz4_decompress((uint8_t *)data + position + total, compressed_size, output + written, uncompressed_size);
+					}
+					if (!result)
+						printf("can not decompress subblock at %ld\n", position + total);
+					total += compressed_size;
+					written += uncompressed_size;
+					subblock += consumed;
+					if (*subblock == ':')
+						subblock++;
+				}
+				if (result && (total != block_size || written != uncompressed)) {
+					printf("subblocks cover %ld:%ld bytes instead of %ld:%ld\n", total, written, block_size, uncompressed);
+					result = false;
+				}
+				if (result)
+					printf("%s compressed attachment, %ld bytes (%.2fx)\n", codec, block_size, (double)uncompressed / block_size);
+				free(output);
+			}
+		}
+	}
+	free(header);
+	return result;
+}
+
 int main(int argc, char *argv[]) {
 	char *data;
-	if (argc != 2) {
+	bool check = argc == 3 && !strcmp(argv[1], "-c");
+	if (argc != 2 && !check) {
 		printf("Please specify a broken XISF file to be fixed. The orifinal file will be overwriten, make sure you have a backup copy!\n");
-		printf("usage: %s filename.xisf\n", basename(argv[0]));
+		printf("usage: %s [-c] filename.xisf\n", basename(argv[0]));
+		printf("  -c validate image attachment (including zlib, lz4 and lz4hc compressed and byte shuffled blocks) without fixing the file\n");
 		return 1;
 	}
-	int size = read_file(argv[1], &data);
+	char *file_name = argv[argc - 1];
+	int size = read_file(file_name, &data);
 	if (size < 0) {
-		printf("error reading: %s\n", argv[1]);
+		printf("error reading: %s\n", file_name);
+		return 1;
+	}
+	if (validate(data, size)) {
+		printf("valid: %s\n", file_name);
+		free(data);
+		return 0;
+	}
+	if (check) {
+		printf("invalid: %s\n", file_name);
+		free(data);
 		return 1;
 	}
 
@@ -82,9 +220,9 @@ int main(int argc, char *argv[]) {
 	ptr[13] = '6';
 	ptr[14] = '0';
 
-	FILE *f = fopen(argv[1], "wb");
+	FILE *f = fopen(file_name, "wb");
 	if (f == 0) {
-		printf("can not overwrite: %s\n", argv[1]);
+		printf("can not overwrite: %s\n", file_name);
 		return 1;
 	}
 	fwrite(data, header_len, 1, f);
@@ -96,7 +234,7 @@ int main(int argc, char *argv[]) {
 	int data_len = size - header_len;
 	fwrite(data + 2880, 1, size - 2880, f);
 
-	printf("fixed: %s\n", argv[1]);
+	printf("fixed: %s\n", file_name);
 	fclose(f);
 	free(data);
 	return 0;